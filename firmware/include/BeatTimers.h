@@ -0,0 +1,72 @@
+#ifndef BEAT_TIMERS_H
+#define BEAT_TIMERS_H
+
+#include <stdint.h>
+#include "TimingWheel.h"
+#include "ClockFollower.h"
+
+#define BEATS_PER_BAR 4
+
+enum ClockSource : uint8_t {
+    CLOCK_SOURCE_INTERNAL,   // ClockGenerator
+    CLOCK_SOURCE_EXTERNAL    // ClockFollower
+};
+
+/**
+ * A TimingWheel counting MIDI clock ticks (24 PPQN) of whichever clock
+ * leads: the external one while it is present, the internal one otherwise.
+ *
+ * follow() is called every pass with the leading clock's tick counter and
+ * song position, and moves the wheel on by the ticks since the last pass.
+ * On a hand-over the new clock's counter becomes the reference, so timers
+ * keep counting (losing at most that one pass) instead of jumping.
+ *
+ * ticksToNext() lines work up with the song: the ticks from the last one
+ * seen to the next beat or bar boundary. Timers fire in the pass that sees
+ * their tick, so within a pass (1 ms) of it going out or coming in.
+ */
+class BeatTimers {
+public:
+    void follow(ClockSource source, uint32_t ticks, uint32_t position, bool running) {
+        if (source != _source) {
+            _source = source;
+            _lastTicks = ticks;
+        }
+        uint32_t elapsed = ticks - _lastTicks;
+        _lastTicks = ticks;
+        _position = position;
+        _running = running;
+        _wheel.advance(elapsed);
+    }
+
+    /**
+     * Ticks until the next multiple of unit (CLOCK_PPQN for a beat), 1..unit.
+     * 0 while the song isn't running: there is no beat to wait for.
+     */
+    uint32_t ticksToNext(uint32_t unit) const {
+        if (!_running || unit == 0) return 0;
+        return unit - _position % unit;
+    }
+
+    /**
+     * Run callback on the next multiple of unit.
+     * @return 0 if it couldn't be deferred (song stopped, wheel full); run it now
+     */
+    WheelTimer scheduleOnNext(uint32_t unit, WheelCallback callback, void* context, uint32_t arg = 0) {
+        uint32_t delay = ticksToNext(unit);
+        return delay ? _wheel.schedule(delay, callback, context, arg) : 0;
+    }
+
+    TimingWheel& wheel() { return _wheel; }
+    const TimingWheel& wheel() const { return _wheel; }
+    bool running() const { return _running; }
+
+private:
+    TimingWheel _wheel;
+    ClockSource _source = static_cast<ClockSource>(0xFF);   // None yet
+    uint32_t _lastTicks = 0;
+    uint32_t _position = 0;
+    bool _running = false;
+};
+
+#endif // BEAT_TIMERS_H
@@ -1,6 +1,32 @@
 #ifndef BIQUAD_FILTER_H
 #define BIQUAD_FILTER_H
 
+#include <stdint.h>
+#include <math.h>
+
+#define BIQUAD_MAX_SECTIONS 4            // Up to 48 dB/octave
+#define BIQUAD_DEFAULT_RAMP_SAMPLES 10   // Retune glide: one 50 ms LED tick at the 200 Hz control rate
+
+/**
+ * Normalized biquad coefficients (a0 = 1):
+ *   H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+ */
+struct BiquadCoefficients {
+    float b0, b1, b2;   // Feedforward
+    float a1, a2;       // Feedback
+};
+
+/**
+ * RBJ cookbook biquad, run as transposed direct form II, optionally as a
+ * cascade of identical sections (12 dB/octave each).
+ *
+ * configure() takes the rate process() is actually called at. The first
+ * configure() (or one after reset()) applies at once; after that a retune
+ * glides linearly from the current coefficients to the new ones over
+ * rampSamples() samples, so a knob sweep doesn't step the filter. Every
+ * point on a straight line between two stable (a1, a2) pairs is stable
+ * too (the stability triangle is convex), so the glide can't blow up.
+ */
 class BiquadFilter {
 public:
     enum FilterType {
@@ -9,63 +35,166 @@ public:
         BANDPASS   // Allows frequencies around a center frequency to pass
     };
 
-    BiquadFilter() : a0(0), a1(0), a2(0), b1(0), b2(0), z1(0), z2(0) {}
+    BiquadFilter() : _sections(1), _rampSamples(BIQUAD_DEFAULT_RAMP_SAMPLES) { reset(); }
+
+    /**
+     * Clear the filter state and drop any glide; the next configure() applies at once.
+     */
+    void reset() {
+        _current = BiquadCoefficients{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        _target = _current;
+        _step = _current;
+        _rampLeft = 0;
+        _configured = false;
+        for (uint8_t k = 0; k < BIQUAD_MAX_SECTIONS; k++) {
+            _s1[k] = 0.0f;
+            _s2[k] = 0.0f;
+        }
+    }
 
     /**
      * Configure the filter coefficients based on the desired type, frequency, Q factor, and sampling rate.
      */
     void configure(FilterType type, float frequency, float sampleRate, float q = 0.707) {
+        setTarget(design(type, frequency, sampleRate, q));
+    }
+
+    /**
+     * Coefficients for one section. Frequency is clamped to 20 Hz..20 kHz
+     * and below Nyquist, Q to a small positive minimum.
+     */
+    static BiquadCoefficients design(FilterType type, float frequency, float sampleRate, float q = 0.707) {
         // Constrain frequency to a valid range (e.g., 20 Hz to 20 kHz)
-        frequency = constrain(frequency, 20.0f, 20000.0f);
+        if (frequency < 20.0f) frequency = 20.0f;
+        if (frequency > 20000.0f) frequency = 20000.0f;
+        // Keep the cutoff below Nyquist, or the coefficients blow up
+        if (frequency > 0.45f * sampleRate) {
+            frequency = 0.45f * sampleRate;
+        }
+        if (q < 0.1f) q = 0.1f;
 
-        float omega = 2.0f * PI * frequency / sampleRate;
-        float cos_omega = cos(omega);
-        float sin_omega = sin(omega);
+        float omega = 2.0f * static_cast<float>(M_PI) * frequency / sampleRate;
+        float cos_omega = cosf(omega);
+        float sin_omega = sinf(omega);
         float alpha = sin_omega / (2.0f * q);
 
+        BiquadCoefficients c;
         switch (type) {
-            case LOWPASS:
-                a0 = (1 - cos_omega) / 2.0f;
-                a1 = 1 - cos_omega;
-                a2 = (1 - cos_omega) / 2.0f;
-                b1 = -2.0f * cos_omega;
-                b2 = 1.0f - alpha;
-                break;
             case HIGHPASS:
-                a0 = (1 + cos_omega) / 2.0f;
-                a1 = -(1 + cos_omega);
-                a2 = (1 + cos_omega) / 2.0f;
-                b1 = -2.0f * cos_omega;
-                b2 = 1.0f - alpha;
+                c.b0 = (1.0f + cos_omega) / 2.0f;
+                c.b1 = -(1.0f + cos_omega);
+                c.b2 = (1.0f + cos_omega) / 2.0f;
                 break;
             case BANDPASS:
-                a0 = alpha;
-                a1 = 0.0f;
-                a2 = -alpha;
-                b1 = -2.0f * cos_omega;
-                b2 = 1.0f - alpha;
+                c.b0 = alpha;
+                c.b1 = 0.0f;
+                c.b2 = -alpha;
+                break;
+            case LOWPASS:
+            default:
+                c.b0 = (1.0f - cos_omega) / 2.0f;
+                c.b1 = 1.0f - cos_omega;
+                c.b2 = (1.0f - cos_omega) / 2.0f;
                 break;
         }
+        c.a1 = -2.0f * cos_omega;
+        c.a2 = 1.0f - alpha;
+
+        float norm = 1.0f / (1.0f + alpha);
+        c.b0 *= norm;
+        c.b1 *= norm;
+        c.b2 *= norm;
+        c.a1 *= norm;
+        c.a2 *= norm;
+        return c;
+    }
+
+    /**
+     * Start gliding to new coefficients (or jump there if nothing was configured yet).
+     */
+    void setTarget(const BiquadCoefficients& target) {
+        _target = target;
+        if (!_configured || _rampSamples == 0) {
+            _current = target;
+            _rampLeft = 0;
+            _configured = true;
+            return;
+        }
+        float n = static_cast<float>(_rampSamples);
+        _step.b0 = (target.b0 - _current.b0) / n;
+        _step.b1 = (target.b1 - _current.b1) / n;
+        _step.b2 = (target.b2 - _current.b2) / n;
+        _step.a1 = (target.a1 - _current.a1) / n;
+        _step.a2 = (target.a2 - _current.a2) / n;
+        _rampLeft = _rampSamples;
+    }
 
-        float norm = 1.0f + alpha;
-        a0 /= norm;
-        a1 /= norm;
-        a2 /= norm;
-        b1 /= norm;
-        b2 /= norm;
+    /**
+     * Number of cascaded sections (1..BIQUAD_MAX_SECTIONS). Sections added
+     * here start from silence.
+     */
+    void setSections(uint8_t sections) {
+        if (sections < 1) sections = 1;
+        if (sections > BIQUAD_MAX_SECTIONS) sections = BIQUAD_MAX_SECTIONS;
+        for (uint8_t k = _sections; k < sections; k++) {
+            _s1[k] = 0.0f;
+            _s2[k] = 0.0f;
+        }
+        _sections = sections;
     }
+    uint8_t sections() const { return _sections; }
+
+    // Glide length for retunes, in samples (0 = jump)
+    void setRampSamples(uint16_t samples) { _rampSamples = samples; }
+    uint16_t rampSamples() const { return _rampSamples; }
+
+    // Where the coefficients are heading (equal to current() once a glide ends)
+    const BiquadCoefficients& coefficients() const { return _target; }
+    // What process() is using right now
+    const BiquadCoefficients& current() const { return _current; }
 
     float process(float input) {
-        float output = a0 * input + a1 * z1 + a2 * z2 - b1 * z1 - b2 * z2;
-        z2 = z1;
-        z1 = output;
-        return output;
+        if (_rampLeft) {
+            advanceRamp();
+        }
+        float x = input;
+        for (uint8_t k = 0; k < _sections; k++) {
+            float y = _current.b0 * x + _s1[k];
+            _s1[k] = _current.b1 * x - _current.a1 * y + _s2[k];
+            _s2[k] = _current.b2 * x - _current.a2 * y;
+            x = y;
+        }
+        return x;
+    }
+
+    void processBlock(const float* input, float* output, uint16_t count) {
+        for (uint16_t n = 0; n < count; n++) {
+            output[n] = process(input[n]);
+        }
     }
 
 private:
-    float a0, a1, a2;
-    float b1, b2;
-    float z1, z2;
+    BiquadCoefficients _current;
+    BiquadCoefficients _target;
+    BiquadCoefficients _step;
+    uint16_t _rampLeft;
+    bool _configured;
+    uint8_t _sections;
+    uint16_t _rampSamples;
+    float _s1[BIQUAD_MAX_SECTIONS];
+    float _s2[BIQUAD_MAX_SECTIONS];
+
+    void advanceRamp() {
+        if (--_rampLeft == 0) {
+            _current = _target;   // Land exactly, whatever the rounding on the way
+            return;
+        }
+        _current.b0 += _step.b0;
+        _current.b1 += _step.b1;
+        _current.b2 += _step.b2;
+        _current.a1 += _step.a1;
+        _current.a2 += _step.a2;
+    }
 };
 
 #endif // BIQUAD_FILTER_H
@@ -0,0 +1,231 @@
+#ifndef BUTTON_ACTIONS_H
+#define BUTTON_ACTIONS_H
+
+#include <stdint.h>
+#include <string.h>
+#include "ButtonGestures.h"
+
+#define ACTION_SLOT_BUTTONS 42  // Virtual slot buttons; they all share ACTION_ROW_SLOT
+
+/**
+ * One row per kind of input. Every slot button uses the SLOT row and acts on
+ * the slot it belongs to; control buttons and chords act on the active slot.
+ */
+enum ActionRow : uint8_t {
+    ACTION_ROW_SLOT,
+    ACTION_ROW_CTRL0,
+    ACTION_ROW_CTRL1,
+    ACTION_ROW_CTRL2,
+    ACTION_ROW_CTRL3,
+    ACTION_ROW_CTRL4,
+    ACTION_ROW_CTRL5,
+    ACTION_ROW_CHORD0,  // Rows follow the chord table in ButtonManager.cpp
+    ACTION_ROW_CHORD1,
+    ACTION_ROW_CHORD2,
+    ACTION_ROW_CHORD3,
+    ACTION_ROW_COUNT
+};
+
+// Same order as GESTURE_LONG..GESTURE_DOUBLE. Chords only use the SINGLE column.
+enum ActionColumn : uint8_t {
+    ACTION_COL_LONG,
+    ACTION_COL_SINGLE,
+    ACTION_COL_DOUBLE,
+    ACTION_COL_COUNT
+};
+
+enum ActionId : uint8_t {
+    ACTION_NONE,
+    ACTION_SELECT_SLOT,     // param >= 0: that slot, otherwise the target slot
+    ACTION_NEXT_SLOT,       // param: step
+    ACTION_TOGGLE_EF,       // EF mode on/off
+    ACTION_CYCLE_EF,        // Next EF for the target slot; param 1 = only while EF mode is on
+    ACTION_CYCLE_FILTER,    // param: step through the filter types of the target slot's EF
+    ACTION_CYCLE_CHANNEL,   // param: step through MIDI channels 1..16
+    ACTION_CYCLE_CC,        // param: step through CC numbers 0..127
+    ACTION_TAP_TEMPO,
+    ACTION_RELOAD_CONFIG,   // Drop unsaved changes
+    ACTION_SAVE_CONFIG,
+    ACTION_ARG_METHOD,      // Enter ARG mode, then cycle ARG methods
+    ACTION_LIGHT_MODE,
+    ACTION_RANDOM_EF,       // EF mode on + random EF for the target slot
+    ACTION_ARG_PAIR,        // Next (A, B) input pair for the target slot's EF
+    ACTION_COUNT
+};
+
+struct ButtonAction {
+    uint8_t id;
+    int8_t param;
+};
+
+// When an action takes effect: straight away, or on the next beat / bar of the leading clock
+enum ActionQuantize : uint8_t {
+    QUANTIZE_NOW,
+    QUANTIZE_BEAT,
+    QUANTIZE_BAR,
+    QUANTIZE_COUNT
+};
+
+static const char* const ACTION_ROW_NAMES[ACTION_ROW_COUNT] = {
+    "SLOT", "CTRL0", "CTRL1", "CTRL2", "CTRL3", "CTRL4", "CTRL5",
+    "CHORD0", "CHORD1", "CHORD2", "CHORD3"
+};
+static const char* const ACTION_COLUMN_NAMES[ACTION_COL_COUNT] = { "LONG", "SINGLE", "DOUBLE" };
+static const char* const ACTION_NAMES[ACTION_COUNT] = {
+    "NONE", "SELECT_SLOT", "NEXT_SLOT", "TOGGLE_EF", "CYCLE_EF", "CYCLE_FILTER",
+    "CYCLE_CHANNEL", "CYCLE_CC", "TAP_TEMPO", "RELOAD_CONFIG", "SAVE_CONFIG",
+    "ARG_METHOD", "LIGHT_MODE", "RANDOM_EF", "ARG_PAIR"
+};
+static const char* const QUANTIZE_NAMES[QUANTIZE_COUNT] = { "NOW", "BEAT", "BAR" };
+
+// Factory layout
+constexpr ButtonAction DEFAULT_BUTTON_ACTIONS[ACTION_ROW_COUNT][ACTION_COL_COUNT] = {
+    //  LONG                        SINGLE                        DOUBLE
+    { { ACTION_CYCLE_EF, 0 },     { ACTION_SELECT_SLOT, -1 },   { ACTION_CYCLE_FILTER, 1 } },   // SLOT
+    { { ACTION_NONE, 0 },         { ACTION_TOGGLE_EF, 0 },      { ACTION_CYCLE_FILTER, 1 } },   // CTRL0
+    { { ACTION_NONE, 0 },         { ACTION_NEXT_SLOT, 1 },      { ACTION_CYCLE_FILTER, -1 } },  // CTRL1
+    { { ACTION_NONE, 0 },         { ACTION_CYCLE_EF, 1 },       { ACTION_NONE, 0 } },           // CTRL2
+    { { ACTION_NONE, 0 },         { ACTION_CYCLE_CHANNEL, 1 },  { ACTION_NONE, 0 } },           // CTRL3
+    { { ACTION_NONE, 0 },         { ACTION_CYCLE_CC, 1 },       { ACTION_RELOAD_CONFIG, 0 } },  // CTRL4
+    { { ACTION_NONE, 0 },         { ACTION_TAP_TEMPO, 0 },      { ACTION_SAVE_CONFIG, 0 } },    // CTRL5
+    { { ACTION_NONE, 0 },         { ACTION_ARG_METHOD, 0 },     { ACTION_NONE, 0 } },           // CHORD0: Ctrl0 + Ctrl1
+    { { ACTION_NONE, 0 },         { ACTION_LIGHT_MODE, 0 },     { ACTION_NONE, 0 } },           // CHORD1: Ctrl2 + Ctrl3
+    { { ACTION_NONE, 0 },         { ACTION_RANDOM_EF, 0 },      { ACTION_NONE, 0 } },           // CHORD2: Ctrl4 + Ctrl5
+    { { ACTION_NONE, 0 },         { ACTION_ARG_PAIR, 0 },       { ACTION_NONE, 0 } },           // CHORD3: Ctrl2 + Ctrl5
+};
+
+// Bytes needed to store the whole table (id + param per entry)
+#define ACTION_TABLE_BYTES (ACTION_ROW_COUNT * ACTION_COL_COUNT * 2)
+// Bytes for the quantize setting of every action, 2 bits each
+#define ACTION_QUANTIZE_BYTES ((ACTION_COUNT * 2 + 7) / 8)
+
+/**
+ * The live (button, gesture) -> action table. Starts as a copy of
+ * DEFAULT_BUTTON_ACTIONS; entries can be remapped at runtime (SET_ACTION)
+ * and stored in EEPROM by ConfigManager.
+ *
+ * Each action also has a quantize setting (SET_QUANTIZE), whichever
+ * gesture triggers it. Everything starts at QUANTIZE_NOW.
+ */
+class ButtonActionMap {
+public:
+    ButtonActionMap() { reset(); }
+
+    void reset() {
+        memcpy(_table, DEFAULT_BUTTON_ACTIONS, sizeof(_table));
+        memset(_quantize, QUANTIZE_NOW, sizeof(_quantize));
+    }
+
+    /**
+     * Action for one gesture. Button is the chord index for GESTURE_CHORD.
+     * Press/release and anything out of range map to ACTION_NONE.
+     */
+    ButtonAction lookup(uint8_t button, ButtonGesture gesture) const {
+        uint8_t row;
+        uint8_t column;
+        if (gesture == GESTURE_CHORD) {
+            row = ACTION_ROW_CHORD0 + button;
+            column = ACTION_COL_SINGLE;
+        } else {
+            row = (button < ACTION_SLOT_BUTTONS) ? ACTION_ROW_SLOT
+                                                 : ACTION_ROW_CTRL0 + (button - ACTION_SLOT_BUTTONS);
+            column = static_cast<uint8_t>(gesture - GESTURE_LONG);
+        }
+        if (row >= ACTION_ROW_COUNT || column >= ACTION_COL_COUNT) return ButtonAction{ ACTION_NONE, 0 };
+        return _table[row][column];
+    }
+
+    const ButtonAction& get(uint8_t row, uint8_t column) const { return _table[row][column]; }
+
+    bool set(uint8_t row, uint8_t column, uint8_t id, int8_t param) {
+        if (row >= ACTION_ROW_COUNT || column >= ACTION_COL_COUNT || id >= ACTION_COUNT) return false;
+        _table[row][column] = ButtonAction{ id, param };
+        return true;
+    }
+
+    // Same as set(), with the names used by the SET_ACTION command
+    bool set(const char* row, const char* column, const char* action, int param) {
+        int r = findName(ACTION_ROW_NAMES, ACTION_ROW_COUNT, row);
+        int c = findName(ACTION_COLUMN_NAMES, ACTION_COL_COUNT, column);
+        int id = findName(ACTION_NAMES, ACTION_COUNT, action);
+        if (r < 0 || c < 0 || id < 0 || param < -128 || param > 127) return false;
+        return set(r, c, id, static_cast<int8_t>(param));
+    }
+
+    ActionQuantize quantize(uint8_t id) const {
+        return id < ACTION_COUNT ? static_cast<ActionQuantize>(_quantize[id]) : QUANTIZE_NOW;
+    }
+
+    // Tap tempo is timed by the press itself, so it always runs straight away
+    bool setQuantize(uint8_t id, uint8_t quantize) {
+        if (id == ACTION_NONE || id >= ACTION_COUNT || quantize >= QUANTIZE_COUNT) return false;
+        if (id == ACTION_TAP_TEMPO && quantize != QUANTIZE_NOW) return false;
+        _quantize[id] = quantize;
+        return true;
+    }
+
+    // Same as setQuantize(), with the names used by the SET_QUANTIZE command
+    bool setQuantize(const char* action, const char* quantize) {
+        int id = findName(ACTION_NAMES, ACTION_COUNT, action);
+        int q = findName(QUANTIZE_NAMES, QUANTIZE_COUNT, quantize);
+        if (id < 0 || q < 0) return false;
+        return setQuantize(id, q);
+    }
+
+    // Flat ACTION_TABLE_BYTES image for EEPROM
+    void serialize(uint8_t* out) const {
+        for (uint8_t r = 0; r < ACTION_ROW_COUNT; r++) {
+            for (uint8_t c = 0; c < ACTION_COL_COUNT; c++) {
+                *out++ = _table[r][c].id;
+                *out++ = static_cast<uint8_t>(_table[r][c].param);
+            }
+        }
+    }
+
+    // Rejects (and ignores) an image holding an unknown action id
+    bool deserialize(const uint8_t* in) {
+        for (uint16_t i = 0; i < ACTION_TABLE_BYTES; i += 2) {
+            if (in[i] >= ACTION_COUNT) return false;
+        }
+        for (uint8_t r = 0; r < ACTION_ROW_COUNT; r++) {
+            for (uint8_t c = 0; c < ACTION_COL_COUNT; c++) {
+                _table[r][c].id = *in++;
+                _table[r][c].param = static_cast<int8_t>(*in++);
+            }
+        }
+        return true;
+    }
+
+    // ACTION_QUANTIZE_BYTES image for EEPROM, four actions per byte
+    void serializeQuantize(uint8_t* out) const {
+        memset(out, 0, ACTION_QUANTIZE_BYTES);
+        for (uint8_t id = 0; id < ACTION_COUNT; id++) {
+            out[id / 4] |= _quantize[id] << (2 * (id % 4));
+        }
+    }
+
+    // Rejects (and ignores) an image that setQuantize() wouldn't accept
+    bool deserializeQuantize(const uint8_t* in) {
+        uint8_t quantize[ACTION_COUNT];
+        for (uint8_t id = 0; id < ACTION_COUNT; id++) {
+            quantize[id] = (in[id / 4] >> (2 * (id % 4))) & 0x03;
+            if (quantize[id] >= QUANTIZE_COUNT) return false;
+            if ((id == ACTION_NONE || id == ACTION_TAP_TEMPO) && quantize[id] != QUANTIZE_NOW) return false;
+        }
+        memcpy(_quantize, quantize, sizeof(_quantize));
+        return true;
+    }
+
+private:
+    ButtonAction _table[ACTION_ROW_COUNT][ACTION_COL_COUNT];
+    uint8_t _quantize[ACTION_COUNT];   // ActionQuantize per ActionId
+
+    static int findName(const char* const* names, uint8_t count, const char* name) {
+        for (uint8_t i = 0; i < count; i++) {
+            if (strcmp(names[i], name) == 0) return i;
+        }
+        return -1;
+    }
+};
+
+#endif // BUTTON_ACTIONS_H
@@ -0,0 +1,181 @@
+#ifndef BUTTON_GESTURES_H
+#define BUTTON_GESTURES_H
+
+#include <stdint.h>
+
+#define GESTURE_MAX_BUTTONS 64
+#define GESTURE_LONG_PRESS_MS 500   // Held this long = long press
+#define GESTURE_DOUBLE_PRESS_MS 300 // Two short releases closer than this = double press
+#define GESTURE_CHORD_WINDOW_MS 80  // All buttons of a chord must go down within this window
+#define GESTURE_MAX_CHORDS 16
+
+enum ButtonGesture : uint8_t {
+    GESTURE_PRESS,    // Debounced press
+    GESTURE_RELEASE,  // Debounced release
+    GESTURE_LONG,     // Held for GESTURE_LONG_PRESS_MS (fires while still held)
+    GESTURE_SINGLE,   // Short press, on release
+    GESTURE_DOUBLE,   // Second short press within GESTURE_DOUBLE_PRESS_MS, on release
+    GESTURE_CHORD     // Several buttons pressed together; button holds the chord index
+};
+
+/**
+ * One detected gesture, queued between detection and the action handlers.
+ */
+struct ButtonEvent {
+    uint32_t timestamp; // millis() when the gesture was detected
+    uint8_t button;
+    ButtonGesture gesture;
+};
+
+typedef void (*ButtonGestureHandler)(void* context, uint8_t button, ButtonGesture gesture, uint32_t timestamp);
+
+/**
+ * Turns debounced button masks into press/long/single/double gestures.
+ *
+ * update() only walks the bits that changed and the buttons still waiting for
+ * their long-press time, so an idle pass costs a couple of mask tests no
+ * matter how many buttons there are.
+ *
+ * Semantics match the old per-button state machine: a long press fires once
+ * while held and its release is not a short press; every short release fires
+ * SINGLE, unless it comes within the double-press window of the previous short
+ * release, in which case it fires DOUBLE and the window is cleared.
+ *
+ * Chords come from a table of button masks. A chord fires (GESTURE_CHORD with
+ * the table index as the button) once every button in its mask is down and
+ * they all went down within the chord window. Its buttons then produce no
+ * long/single/double gestures until they are released. Matching only runs on
+ * passes with a new press, and then costs one mask test per table entry.
+ */
+class ButtonGestures {
+public:
+    void setHandler(ButtonGestureHandler handler, void* context) {
+        _handler = handler;
+        _context = context;
+    }
+
+    /**
+     * @param masks Chord button masks; earlier entries win when two match at once.
+     *              The table must outlive this object.
+     */
+    void setChords(const uint64_t* masks, uint8_t count, uint32_t windowMs = GESTURE_CHORD_WINDOW_MS) {
+        _chordMasks = masks;
+        _chordCount = (count <= GESTURE_MAX_CHORDS) ? count : GESTURE_MAX_CHORDS;
+        _chordWindowMs = windowMs;
+        _chordButtons = 0;
+        for (uint8_t c = 0; c < _chordCount; c++) _chordButtons |= masks[c];
+    }
+
+    /**
+     * @param changed Buttons whose debounced state changed since the last call
+     * @param pressed Debounced state of every button (1 = pressed)
+     * @param nowMs   Current time in milliseconds
+     */
+    void update(uint64_t changed, uint64_t pressed, uint32_t nowMs) {
+        uint64_t newPresses = changed & pressed;
+        uint64_t bits = changed;
+        while (bits) {
+            uint8_t button = __builtin_ctzll(bits);
+            uint64_t bit = 1ULL << button;
+            bits &= bits - 1;
+
+            if (pressed & bit) {
+                _pressedAt[button] = nowMs;
+                _longPending |= bit;
+                _longFired &= ~bit;
+                emit(button, GESTURE_PRESS, nowMs);
+            } else {
+                _longPending &= ~bit;
+                emit(button, GESTURE_RELEASE, nowMs);
+                if (_chordHeld & bit) {
+                    _chordHeld &= ~bit;     // Part of a chord: no single/double
+                    _shortArmed &= ~bit;
+                } else if (!(_longFired & bit)) {
+                    shortRelease(button, bit, nowMs);
+                }
+                _longFired &= ~bit;
+            }
+        }
+
+        if (newPresses & _chordButtons) {
+            matchChords(newPresses, pressed, nowMs);
+        }
+
+        bits = _longPending;
+        while (bits) {
+            uint8_t button = __builtin_ctzll(bits);
+            uint64_t bit = 1ULL << button;
+            bits &= bits - 1;
+
+            if (static_cast<uint32_t>(nowMs - _pressedAt[button]) >= GESTURE_LONG_PRESS_MS) {
+                _longPending &= ~bit;
+                _longFired |= bit;
+                emit(button, GESTURE_LONG, nowMs);
+            }
+        }
+    }
+
+    // Buttons that already fired a long press and are still held
+    uint64_t longHeld() const { return _longFired; }
+
+    // Buttons held as part of a chord that already fired
+    uint64_t chordHeld() const { return _chordHeld; }
+
+private:
+    ButtonGestureHandler _handler = nullptr;
+    void* _context = nullptr;
+
+    uint64_t _longPending = 0;  // Held, long press not fired yet
+    uint64_t _longFired = 0;    // Held, long press already fired
+    uint64_t _shortArmed = 0;   // A short release happened at _lastShortRelease
+    uint64_t _chordHeld = 0;    // Held, and part of a chord that fired
+
+    const uint64_t* _chordMasks = nullptr;
+    uint8_t _chordCount = 0;
+    uint32_t _chordWindowMs = GESTURE_CHORD_WINDOW_MS;
+    uint64_t _chordButtons = 0; // Union of all chord masks
+    uint32_t _pressedAt[GESTURE_MAX_BUTTONS] = {0};
+    uint32_t _lastShortRelease[GESTURE_MAX_BUTTONS] = {0};
+
+    void matchChords(uint64_t newPresses, uint64_t pressed, uint32_t nowMs) {
+        for (uint8_t c = 0; c < _chordCount; c++) {
+            uint64_t mask = _chordMasks[c];
+            // Complete, completed by this pass, and not sharing a button with a chord already fired
+            if ((pressed & mask) != mask || !(newPresses & mask) || (_chordHeld & mask)) continue;
+
+            bool inWindow = true;
+            uint64_t bits = mask;
+            while (bits) {
+                uint8_t button = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (static_cast<uint32_t>(nowMs - _pressedAt[button]) > _chordWindowMs) {
+                    inWindow = false;
+                    break;
+                }
+            }
+            if (!inWindow) continue;
+
+            _chordHeld |= mask;
+            _longPending &= ~mask;
+            emit(c, GESTURE_CHORD, nowMs);
+        }
+    }
+
+    void shortRelease(uint8_t button, uint64_t bit, uint32_t nowMs) {
+        if ((_shortArmed & bit) &&
+            static_cast<uint32_t>(nowMs - _lastShortRelease[button]) < GESTURE_DOUBLE_PRESS_MS) {
+            _shortArmed &= ~bit;
+            emit(button, GESTURE_DOUBLE, nowMs);
+        } else {
+            _shortArmed |= bit;
+            _lastShortRelease[button] = nowMs;
+            emit(button, GESTURE_SINGLE, nowMs);
+        }
+    }
+
+    void emit(uint8_t button, ButtonGesture gesture, uint32_t nowMs) {
+        if (_handler) _handler(_context, button, gesture, nowMs);
+    }
+};
+
+#endif // BUTTON_GESTURES_H
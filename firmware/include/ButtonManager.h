@@ -9,6 +9,12 @@
 #include "ConfigManager.h"
 #include "Utility.h"
 #include "PotentiometerManager.h"
+#include "MuxBus.h"
+#include "VerticalDebouncer.h"
+#include "ButtonGestures.h"
+#include "ButtonActions.h"
+#include "SpscRingBuffer.h"
+#include "TapTempo.h"
 
 // Optional: Enable detailed debug logging for development
 #define BUTTON_MANAGER_DEBUG 1
@@ -26,30 +32,27 @@
 #define NUM_CONTROL_BUTTONS 6
 // Debounce period in milliseconds
 #define DEBOUNCE_DELAY 50
+// The vertical counter needs 4 agreeing samples, so sample at a quarter of the debounce period
+#define DEBOUNCE_SAMPLE_MS (DEBOUNCE_DELAY / 4)
+// Gestures waiting for dispatchEvents(); must be a power of two
+#define BUTTON_EVENT_QUEUE_SIZE 32
+// Quantized actions whose beat has come, waiting for dispatchEvents(); must be a power of two,
+// and at least TIMING_WHEEL_CAPACITY so a bar where every pending timer comes due fits
+#define BUTTON_DUE_QUEUE_SIZE 32
 
 /**
- * States for each button in the debounce & press state machine.
+ * An action held back for the next beat or bar (SET_QUANTIZE). It goes on
+ * Utility::beatTimers packed into the timer's arg, and into the due queue
+ * when the beat comes.
  */
-enum class ButtonState {
-    IDLE,        // No press detected
-    PRESSED,     // Button is pressed (but not yet long-pressed)
-    LONG_PRESS,  // Long press threshold reached
-    RELEASED     // Button has been released
+struct DeferredAction {
+    uint8_t id;
+    uint8_t slot;
+    int8_t param;
 };
 
 /**
- * Tracks timing and flags for each individual button.
- */
-struct ButtonStateMachine {
-    ButtonState state = ButtonState::IDLE;
-    unsigned long pressTimestamp     = 0;  // When button first pressed
-    unsigned long releaseTimestamp   = 0;  // When button released
-    bool longPressFired              = false; // Ensures long-press event only fires once
-    unsigned long lastShortRelease   = 0;  // Timestamp of last release for double-press detection
-};
-
-/**
- * Aggregated context passed into processButtons(), containing all
+ * Aggregated context passed into dispatchEvents(), containing all
  * shared resources and state the ButtonManager needs to act.
  */
 struct ButtonManagerContext {
@@ -61,7 +64,7 @@ struct ButtonManagerContext {
     LEDManager& ledManager;                     // For updating visual feedback LEDs
     DisplayManager& displayManager;             // For writing status to OLED
     std::vector<EnvelopeFollower>& envelopes;   // List of envelope follower objects
-    std::map<int, int>& potToEnvelopeMap;       // Associative map: pot -> envelope index
+    SlotModMatrix& modMatrix;                   // Which EFs modulate which slot, and how deep
 };
 
 /**
@@ -76,15 +79,11 @@ class ButtonManager {
 public:
     /**
      * Constructor
-     * @param primaryMuxPins   Array of GPIO pins controlling primary mux select lines
-     * @param secondaryMuxPins Array of GPIO pins controlling secondary mux select lines
-     * @param muxAnalogPin     Analog pin reading the mux output
+     * @param muxBus           Shared mux scan; virtual buttons are read from its snapshots
      * @param controlPins      Array of direct GPIO pins for control buttons
      * @param potentiometerManager Pointer to PotentiometerManager (to sync mode changes)
      */
-    ButtonManager(const uint8_t* primaryMuxPins,
-                  const uint8_t* secondaryMuxPins,
-                  uint8_t muxAnalogPin,
+    ButtonManager(MuxBus* muxBus,
                   const uint8_t* controlPins,
                   PotentiometerManager* potentiometerManager);
 
@@ -94,26 +93,71 @@ public:
     void initButtons();
 
     /**
-     * Call in loop() to scan both virtual & control buttons,
-     * update state machines, and trigger press events.
-     * @param context    Aggregated references & state used for handling events
+     * Call in loop() to read both virtual & control buttons and
+     * detect gestures. Detected gestures are only queued here; no
+     * action handler (and no OLED write) runs inside the scan.
+     * Virtual buttons come from the latest MuxBus sweep, which
+     * PotentiometerManager::processPots() drives.
+     */
+    void processButtons();
+
+    /**
+     * Run the action handlers for queued gestures, oldest first, until the
+     * queue is empty or budgetMicros has passed. At least one event is
+     * handled per call, so a slow handler can't starve the queue.
+     * Quantized actions whose beat has come run first, within the same
+     * budget; they can't use it up before that one event.
      */
-    void processButtons(ButtonManagerContext& context);
+    void dispatchEvents(ButtonManagerContext& context, uint32_t budgetMicros);
+
+    // Gestures lost because the queue was full
+    uint32_t droppedEvents() const { return _events.dropped(); }
+    // Quantized actions waiting on Utility::beatTimers
+    uint8_t deferredActions() const { return _deferred; }
+    // Quantized actions lost because they came due faster than dispatchEvents() ran them
+    uint32_t droppedActions() const { return _dueActions.dropped(); }
     bool isMuxButtonPressed(uint8_t index);
 
+    /**
+     * Debounced state of all buttons: bits 0..41 are the virtual buttons,
+     * bits 42..47 the control buttons. 1 = pressed.
+     */
+    uint64_t pressedMask() const { return _debouncer.state(); }
+
+    /**
+     * Live (button, gesture) -> action table. Edit it through SET_ACTION;
+     * ConfigManager saves and loads it.
+     */
+    ButtonActionMap& actions() { return _actions; }
+
+    /**
+     * The TAP_TEMPO action's estimator. Each new estimate also sets
+     * g_tappedBPM; the internal clock picks up the beat from here.
+     */
+    const TapTempo& tapTempo() const { return _tapTempo; }
+
 private:
-    // Mux select pins & analog input for virtual buttons scan
-    const uint8_t* _primaryMuxPins;
-    const uint8_t* _secondaryMuxPins;
-    uint8_t _muxAnalogPin;
+    // Shared mux scan for virtual buttons
+    MuxBus* _muxBus;
     // Direct control button pins
     const uint8_t* _controlPins;
     // Link to PotentiometerManager for mode switching
     PotentiometerManager* _potentiometerManager;
 
-    // Debounce & last-press tracking for all buttons
-    bool buttonStates[NUM_VIRTUAL_BUTTONS + NUM_CONTROL_BUTTONS] = {false};
-    unsigned long lastDebounceTimes[NUM_VIRTUAL_BUTTONS + NUM_CONTROL_BUTTONS] = {0};
+    // Debounce & gesture detection for all buttons, one bit per button
+    VerticalDebouncer _debouncer;
+    ButtonGestures _gestures;
+    unsigned long _lastDebounceSample = 0;
+    SpscRingBuffer<ButtonEvent, BUTTON_EVENT_QUEUE_SIZE> _events;
+    SpscRingBuffer<DeferredAction, BUTTON_DUE_QUEUE_SIZE> _dueActions;
+    static_assert(BUTTON_DUE_QUEUE_SIZE >= TIMING_WHEEL_CAPACITY, "Every timer on the wheel may come due at once");
+    uint8_t _deferred = 0;
+    ButtonActionMap _actions;
+    TapTempo _tapTempo;
+    // When the button of the gesture being handled went down (a tap's beat), in millis()
+    uint8_t _lastPressButton = 0xFF;
+    uint32_t _lastPressMs = 0;
+    uint32_t _gesturePressedMs = 0;
 
     // Current UI mode (e.g., CC vs ENV vs ARG)
     uint8_t activeMode      = 0;
@@ -121,16 +165,8 @@ private:
     uint8_t argEnvelopeA    = 0;
     uint8_t argEnvelopeB    = 0;
 
-    // State machines for each button detection
-    ButtonStateMachine _buttonMachines[NUM_VIRTUAL_BUTTONS + NUM_CONTROL_BUTTONS];
-
-    /**
-     * Drive the mux select lines to read a specific row/column.
-     */
-    void selectMux(uint8_t row, uint8_t col);
-
     /**
-     * Read the analog value for a virtual button index via the mux.
+     * Read the latest swept value for a virtual button index.
      * @return HIGH (unpressed) or LOW (pressed)
      */
     uint8_t readMuxButton(uint8_t buttonIndex);
@@ -142,41 +178,54 @@ private:
     bool readControlButton(uint8_t buttonIndex);
 
     /**
-     * Handle a confirmed short press (single tap). Updates display and state.
-     */
-    void handleSingleButtonPress(uint8_t buttonIndex, ButtonManagerContext& context);
-
-    /**
-     * (Optional) handle combination presses, e.g. SHIFT+button
-     */
-    void handleMultiButtonPress(uint8_t pressedButtons, ButtonManagerContext& context);
-
-    /**
-     * Core state-machine logic for each button. Handles transitions between
-     * IDLE, PRESSED, LONG_PRESS, RELEASED, and fires appropriate callbacks.
+     * Raw (undebounced) state of all buttons, in pressedMask() bit order.
      */
-    void updateButtonStateMachine(uint8_t index, bool pressed, ButtonManagerContext& context);
+    uint64_t readRawButtons();
 
     /**
-     * Called once when a button transitions into LONG_PRESS state.
+     * Queues gestures from ButtonGestures for dispatchEvents().
      */
-    void onLongPress(uint8_t index, ButtonManagerContext& context);
+    static void onGesture(void* context, uint8_t index, ButtonGesture gesture, uint32_t timestamp);
 
     /**
-     * Called once when a button is released from PRESSED or LONG_PRESS.
+     * Looks up one queued gesture in the action table and runs its handler,
+     * or holds it for the next beat / bar if the action is quantized.
      */
-    void onRelease(uint8_t index, ButtonManagerContext& context);
+    void handleEvent(const ButtonEvent& event, ButtonManagerContext& context);
 
     /**
-     * Detect single vs double short-press based on release timing.
+     * Utility::beatTimers callback for a quantized action: only queues it
+     * (the clock task is no place for OLED or EEPROM writes).
      */
-    void handleShortPress(uint8_t index, ButtonManagerContext& context);
-    void handleDoublePress(uint8_t index, ButtonManagerContext& context);
+    static void onActionDue(void* context, uint32_t packed);
 
     /**
-     * Actual action for a single-press event, separate for clarity.
+     * Action handlers, indexed by ActionId. slot is the slot the gesture
+     * targets; param comes from the action table entry.
      */
-    void doSinglePressAction(uint8_t index, ButtonManagerContext& context);
+    typedef void (ButtonManager::*ActionHandler)(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    static const ActionHandler ACTION_HANDLERS[ACTION_COUNT];
+
+    void actionNone(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionSelectSlot(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionNextSlot(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionToggleEF(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionCycleEF(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionCycleFilter(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionCycleChannel(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionCycleCC(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionTapTempo(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionReloadConfig(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionSaveConfig(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionARGMethod(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionLightMode(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionRandomEF(uint8_t slot, int8_t param, ButtonManagerContext& context);
+    void actionARGPair(uint8_t slot, int8_t param, ButtonManagerContext& context);
+
+    // printf-style status line on the OLED
+    static void showStatus(ButtonManagerContext& context, int duration, const char* format, ...);
+    // EF assigned to a slot, or -1 after showing "No EF assigned"
+    static int assignedEnvelope(uint8_t slot, ButtonManagerContext& context);
 };
 
 #endif // BUTTON_MANAGER_H
@@ -0,0 +1,78 @@
+#ifndef CC_SLOT_INDEX_H
+#define CC_SLOT_INDEX_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define CC_INDEX_CHANNELS 16
+#define CC_INDEX_CONTROLLERS 128
+#define CC_INDEX_MAX_SLOTS 64   // One bit per slot in the masks
+
+/**
+ * The slot <-> (channel, CC) mapping, both ways, in one place: the
+ * channel and CC each slot sends on, and for every channel and CC number
+ * a bitmask of the slots sending it. ConfigManager keeps its pot mapping
+ * here and the pots send from it, so an incoming CC finds exactly the
+ * slots that would have sent it, with one table read however dense the
+ * automation. Several slots on the same CC all come back.
+ *
+ * Each slot remembers where it is in the table, so assign() moves it with
+ * two bit operations. A channel or CC out of range (raw EEPROM, say) is
+ * kept as given but takes the slot out of the lookup. 16 x 128 masks of
+ * 8 bytes: 16 KB of RAM.
+ */
+class CcSlotIndex {
+public:
+    CcSlotIndex() { clear(); }
+
+    void clear() {
+        memset(_slots, 0, sizeof(_slots));
+        memset(_channels, 0, sizeof(_channels));
+        memset(_ccs, 0, sizeof(_ccs));
+        for (uint8_t s = 0; s < CC_INDEX_MAX_SLOTS; s++) _keys[s] = UNMAPPED;
+    }
+
+    // The out-of-the-box mapping: channel 1, slot n on CC n
+    void assignDefaults(uint8_t slots) {
+        for (uint8_t s = 0; s < slots && s < CC_INDEX_MAX_SLOTS; s++) assign(s, 1, s % CC_INDEX_CONTROLLERS);
+    }
+
+    // Move slot to (channel 1..16, cc 0..127); anything out of range takes it out
+    void assign(uint8_t slot, uint8_t channel, uint8_t cc) {
+        if (slot >= CC_INDEX_MAX_SLOTS) return;
+        uint64_t bit = 1ULL << slot;
+        if (_keys[slot] != UNMAPPED) _slots[_keys[slot]] &= ~bit;
+        uint16_t key = keyOf(channel, cc);
+        if (key != UNMAPPED) _slots[key] |= bit;
+        _keys[slot] = key;
+        _channels[slot] = channel;
+        _ccs[slot] = cc;
+    }
+
+    // What the slot sends on, as last assigned (0 for a slot that doesn't exist)
+    uint8_t channel(uint8_t slot) const { return slot < CC_INDEX_MAX_SLOTS ? _channels[slot] : 0; }
+    uint8_t cc(uint8_t slot) const { return slot < CC_INDEX_MAX_SLOTS ? _ccs[slot] : 0; }
+
+    // Slots sending this CC (bit n = slot n), 0 if none
+    uint64_t slotsFor(uint8_t channel, uint8_t cc) const {
+        uint16_t key = keyOf(channel, cc);
+        return key == UNMAPPED ? 0 : _slots[key];
+    }
+
+    bool mapped(uint8_t slot) const { return slot < CC_INDEX_MAX_SLOTS && _keys[slot] != UNMAPPED; }
+
+private:
+    static const uint16_t UNMAPPED = 0xFFFF;
+
+    uint64_t _slots[CC_INDEX_CHANNELS * CC_INDEX_CONTROLLERS];
+    uint16_t _keys[CC_INDEX_MAX_SLOTS];   // Where each slot's bit is, UNMAPPED = nowhere
+    uint8_t _channels[CC_INDEX_MAX_SLOTS];
+    uint8_t _ccs[CC_INDEX_MAX_SLOTS];
+
+    static uint16_t keyOf(uint8_t channel, uint8_t cc) {
+        if (channel < 1 || channel > CC_INDEX_CHANNELS || cc >= CC_INDEX_CONTROLLERS) return UNMAPPED;
+        return (channel - 1) * CC_INDEX_CONTROLLERS + cc;
+    }
+};
+
+#endif // CC_SLOT_INDEX_H
@@ -0,0 +1,188 @@
+#ifndef CLOCK_FOLLOWER_H
+#define CLOCK_FOLLOWER_H
+
+#include <stdint.h>
+
+#define CLOCK_PPQN 24                  // MIDI clock ticks per quarter note
+#define CLOCK_PLL_ALPHA 0.2431f        // Phase correction per tick: 1 - 0.87^2
+#define CLOCK_PLL_BETA 0.0169f         // Period correction per tick: (1 - 0.87)^2
+#define CLOCK_LOCK_TICKS 12            // In-range ticks in a row before we call it locked
+#define CLOCK_MIN_PERIOD_US 6250.0f    // 400 BPM
+#define CLOCK_MAX_PERIOD_US 125000.0f  // 20 BPM
+
+/**
+ * Follows incoming MIDI clock: tempo, phase and song position.
+ *
+ * Every 0xF8 is timestamped in micros() when it is read, so each one
+ * carries up to a pass of read latency (1 ms) plus whatever jitter the
+ * sender and USB add. Instead of trusting each tick, this is an alpha-beta
+ * filter (the steady-state Kalman filter for constant tempo, i.e. a
+ * second-order PLL): it predicts the next tick from the filtered tick
+ * time and period, and nudges both by a fraction of the error. With the
+ * default gains (critically damped, discount 0.87) it settles within
+ * about a beat and a half of a tempo change, and tick times come out
+ * close to three times smoother than the raw timestamps.
+ *
+ * A tick more than half a period away from where it should be is not
+ * used to correct tempo. Two of those in a row (a real jump) re-seed the
+ * period from the raw interval. A gap of more than three periods means
+ * the clock went away, and the next tick starts over.
+ *
+ * Start / Stop / Continue / Song Position keep the song position in
+ * ticks. As the spec says, the first clock after Start (or after Song
+ * Position + Continue) is the position itself, and every later clock
+ * advances it by one. Clock keeps tracking tempo while stopped.
+ *
+ * beatPhase() is the cheap query for beat-synced features: the position
+ * inside the beat from the last filtered tick plus the time since it, in
+ * a couple of float operations.
+ */
+class ClockFollower {
+public:
+    ClockFollower() { reset(); }
+
+    void reset() {
+        _seen = 0;
+        _period = 0.0f;
+        _invPeriod = 0.0f;
+        _filtered = 0;
+        _frac = 0.0f;
+        _lastRaw = 0;
+        _outliers = 0;
+        _inRange = 0;
+        _jitter = 0.0f;
+        _ticks = 0;
+        _position = 0;
+        _positionPending = true;
+        _running = false;
+    }
+
+    void onClock(uint32_t nowMicros) {
+        _ticks++;
+        if (_seen && _period > 0.0f && static_cast<float>(nowMicros - _lastRaw) > 3.0f * _period) {
+            _seen = 0;   // The clock went away and came back
+        }
+        if (_seen == 0) {
+            seed(nowMicros);
+            _seen = 1;
+        } else if (_seen == 1) {
+            setPeriod(static_cast<float>(nowMicros - _lastRaw));
+            seed(nowMicros);
+            _seen = 2;
+        } else {
+            track(nowMicros);
+        }
+        _lastRaw = nowMicros;
+
+        if (_running) {
+            if (_positionPending) {
+                _positionPending = false;
+            } else {
+                _position++;
+            }
+        }
+    }
+
+    void onStart() {
+        _position = 0;
+        _positionPending = true;
+        _running = true;
+    }
+
+    void onStop() { _running = false; }
+
+    void onContinue() { _running = true; }
+
+    // Song Position Pointer: MIDI beats (sixteenth notes) since the start
+    void onSongPosition(uint16_t sixteenths) {
+        _position = static_cast<uint32_t>(sixteenths) * (CLOCK_PPQN / 4);
+        _positionPending = true;
+    }
+
+    bool running() const { return _running; }
+    bool locked() const { return _inRange >= CLOCK_LOCK_TICKS; }
+    bool present(uint32_t nowMicros, uint32_t timeoutMicros) const {
+        return _seen && nowMicros - _lastRaw <= timeoutMicros;
+    }
+
+    float periodMicros() const { return _period; }
+    float bpm() const { return _period > 0.0f ? 60000000.0f / (_period * CLOCK_PPQN) : 0.0f; }
+    uint32_t lastTickMicros() const { return _filtered; }   // Filtered, not the raw timestamp
+    float jitterMicros() const { return _jitter; }           // Smoothed |raw - predicted|
+    uint32_t ticks() const { return _ticks; }                // Every 0xF8 received
+
+    uint32_t position() const { return _position; }           // Ticks since Start / Song Position
+    uint32_t beat() const { return _position / CLOCK_PPQN; }
+
+    /**
+     * Where we are inside the current beat, 0..1. Between ticks it moves
+     * on with the filtered tempo, but never past the next tick.
+     */
+    float beatPhase(uint32_t nowMicros) const {
+        float tick = static_cast<float>(_position % CLOCK_PPQN);
+        if (_running && _seen >= 2 && !_positionPending) {
+            float into = static_cast<float>(static_cast<int32_t>(nowMicros - _filtered)) * _invPeriod;
+            if (into > 0.0f) tick += into < 0.999f ? into : 0.999f;
+        }
+        return tick * (1.0f / CLOCK_PPQN);
+    }
+
+private:
+    uint8_t _seen;          // 0 = nothing yet, 1 = one tick, 2 = tracking
+    float _period;          // Filtered tick period, µs
+    float _invPeriod;
+    uint32_t _filtered;     // Filtered time of the last tick...
+    float _frac;            // ...and its fraction of a µs
+    uint32_t _lastRaw;
+    uint8_t _outliers;
+    uint8_t _inRange;
+    float _jitter;
+    uint32_t _ticks;
+    uint32_t _position;
+    bool _positionPending;  // The next clock is _position itself
+    bool _running;
+
+    void setPeriod(float period) {
+        if (period < CLOCK_MIN_PERIOD_US) period = CLOCK_MIN_PERIOD_US;
+        if (period > CLOCK_MAX_PERIOD_US) period = CLOCK_MAX_PERIOD_US;
+        _period = period;
+        _invPeriod = 1.0f / period;
+    }
+
+    void seed(uint32_t nowMicros) {
+        _filtered = nowMicros;
+        _frac = 0.0f;
+        _outliers = 0;
+        _inRange = 0;
+    }
+
+    void track(uint32_t nowMicros) {
+        float error = static_cast<float>(static_cast<int32_t>(nowMicros - _filtered)) - _frac - _period;
+        float magnitude = error < 0.0f ? -error : error;
+        if (magnitude > 0.5f * _period) {
+            uint8_t outliers = _outliers + 1;
+            if (outliers >= 2) {
+                setPeriod(static_cast<float>(nowMicros - _lastRaw));
+                outliers = 0;
+            }
+            seed(nowMicros);
+            _outliers = outliers;
+            return;
+        }
+        _outliers = 0;
+        if (_inRange < 255) _inRange++;
+        _jitter += 0.05f * (magnitude - _jitter);
+
+        advance(_period + CLOCK_PLL_ALPHA * error);
+        setPeriod(_period + CLOCK_PLL_BETA * error);
+    }
+
+    void advance(float step) {
+        float s = step + _frac;
+        uint32_t whole = static_cast<uint32_t>(s);
+        _frac = s - static_cast<float>(whole);
+        _filtered += whole;
+    }
+};
+
+#endif // CLOCK_FOLLOWER_H
@@ -0,0 +1,229 @@
+#ifndef CLOCK_GENERATOR_H
+#define CLOCK_GENERATOR_H
+
+#include <stdint.h>
+#include "ClockFollower.h"
+
+#define CLOCK_GEN_FRAC_BITS 12             // Tick period kept in 1/4096 µs (20 BPM still fits 32 bits)
+#define CLOCK_GEN_MIN_BPM 20.0f
+#define CLOCK_GEN_MAX_BPM 400.0f
+#define CLOCK_GEN_DEFAULT_BPM 120.0f
+#define CLOCK_GEN_RAMP_TICKS CLOCK_PPQN   // A tempo change or beat re-sync is spread over at least a beat
+#define CLOCK_GEN_MAX_NUDGE 16             // ...and moves each tick by at most 1/16 of a period to get there
+
+/**
+ * Internal MIDI clock: 24 PPQN plus Start / Stop / Continue, timed by a
+ * hardware timer instead of a polled millis().
+ *
+ * The tick period is kept in fixed point (1/4096 µs). A periodic timer
+ * can only count whole microseconds, so nextInterval() hands out the
+ * whole part and carries the fraction into the next one: at 120 BPM the
+ * intervals go 20833, 20833, 20834, ... and every tick lands within a
+ * microsecond of where it should, with no drift however long it runs.
+ *
+ * With a Teensy IntervalTimer: begin() it with one nextInterval() and
+ * update() it with the next straight away; update() takes effect after
+ * the interval already running, so each tick() asks for the one after
+ * that. The interrupt calls tick() and writes the bytes it returns.
+ *
+ * start() / stop() / resume() only ask: the transport byte goes out
+ * right before the next clock, from the same interrupt, so it is always
+ * on the grid. As with ClockFollower, the clock after Start is position 0.
+ * Clock keeps ticking while stopped, so slaves can hold the tempo.
+ *
+ * Nothing is sent while disabled (an external clock is the master); the
+ * timer keeps running so taking over again needs no re-sync.
+ *
+ * rampTo() and syncTo() change tempo without a jump: the period moves
+ * linearly to the new one over the next beat or two, landing on a beat
+ * boundary. syncTo() also moves the beat grid onto a reference beat (a
+ * tap) by spreading the phase error over those same ticks, taking more
+ * beats if it would otherwise stretch a tick by more than
+ * 1/CLOCK_GEN_MAX_NUDGE. Both read and
+ * rewrite what the interrupt uses, so call them with it masked.
+ */
+class ClockGenerator {
+public:
+    ClockGenerator() {
+        _enabled = true;
+        _running = false;
+        _positionPending = false;
+        _transport = 0;
+        _residue = 0;
+        _rampLeft = 0;
+        _rampStep = 0;
+        _correction = 0;
+        _intervals[0] = _intervals[1] = 0;
+        _lastTickAt = 0;
+        _beatTick = 0;
+        _position = 0;
+        _ticks = 0;
+        _bpm = 0.0f;
+        setBpm(CLOCK_GEN_DEFAULT_BPM);
+    }
+
+    void setBpm(float bpm) {
+        if (bpm < CLOCK_GEN_MIN_BPM) bpm = CLOCK_GEN_MIN_BPM;
+        if (bpm > CLOCK_GEN_MAX_BPM) bpm = CLOCK_GEN_MAX_BPM;
+        if (bpm == _bpm && !_rampLeft) return;
+        _bpm = bpm;
+        _period = _target = periodFor(bpm);
+        _rampLeft = 0;
+        _correction = 0;
+    }
+
+    // Glide to a new tempo over the next beat or two, ending on a beat
+    void rampTo(float bpm) {
+        bpm = clampBpm(bpm);
+        if (bpm == _bpm) return;
+        _bpm = bpm;
+        plan(periodFor(bpm), false, 0);
+    }
+
+    /**
+     * Glide to a new tempo and put a beat boundary on the grid through
+     * beatAtMicros (a recent tap), every CLOCK_PPQN ticks of the new tempo.
+     */
+    void syncTo(float bpm, uint32_t beatAtMicros) {
+        _bpm = clampBpm(bpm);
+        plan(periodFor(_bpm), true, beatAtMicros);
+    }
+    bool ramping() const { return _rampLeft != 0; }
+    float bpm() const { return _bpm; }
+    float periodMicros() const { return static_cast<float>(_period) / (1 << CLOCK_GEN_FRAC_BITS); }
+
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    bool enabled() const { return _enabled; }
+
+    void start() { _transport = 0xFA; }
+    void stop() { _transport = 0xFC; }
+    void resume() { _transport = 0xFB; }   // MIDI Continue
+
+    // Whole µs until the tick after the one already scheduled
+    uint32_t nextInterval() {
+        uint32_t q;
+        if (_rampLeft) {
+            _period += _rampStep;
+            q = _period + _correction + _residue;
+            if (--_rampLeft == 0) {
+                _period = _target;   // Exactly, whatever the step rounding left
+                _correction = 0;
+            }
+        } else {
+            q = _period + _residue;
+        }
+        _residue = q & ((1u << CLOCK_GEN_FRAC_BITS) - 1);
+        uint32_t interval = q >> CLOCK_GEN_FRAC_BITS;
+        _intervals[0] = _intervals[1];
+        _intervals[1] = interval;
+        return interval;
+    }
+
+    /**
+     * One timer period is up (at nowMicros). Fills out with the real-time
+     * bytes to send now: a pending transport byte, then 0xF8.
+     * @return bytes in out (0..2)
+     */
+    uint8_t tick(uint32_t nowMicros, uint8_t out[2]) {
+        _lastTickAt = nowMicros;
+        if (++_beatTick >= CLOCK_PPQN) _beatTick = 0;
+        if (!_enabled) return 0;
+        uint8_t n = 0;
+        uint8_t transport = _transport;
+        _transport = 0;
+        if (transport == 0xFA) {
+            _beatTick = 0;   // Start is a downbeat
+            _position = 0;
+            _positionPending = true;
+            _running = true;
+        } else if (transport == 0xFB) {
+            _running = true;
+        } else if (transport == 0xFC) {
+            _running = false;
+        }
+        if (transport) out[n++] = transport;
+        out[n++] = 0xF8;
+
+        _ticks++;
+        if (_running) {
+            if (_positionPending) {
+                _positionPending = false;
+            } else {
+                _position++;
+            }
+        }
+        return n;
+    }
+
+    bool running() const { return _running; }
+    uint32_t ticks() const { return _ticks; }             // Every 0xF8 sent
+    uint32_t position() const { return _position; }       // Ticks since Start
+    uint32_t beat() const { return _position / CLOCK_PPQN; }
+
+private:
+    static float clampBpm(float bpm) {
+        if (bpm < CLOCK_GEN_MIN_BPM) return CLOCK_GEN_MIN_BPM;
+        if (bpm > CLOCK_GEN_MAX_BPM) return CLOCK_GEN_MAX_BPM;
+        return bpm;
+    }
+
+    static uint32_t periodFor(float bpm) {
+        return static_cast<uint32_t>(60000000.0 * (1 << CLOCK_GEN_FRAC_BITS) / (static_cast<double>(bpm) * CLOCK_PPQN) + 0.5);
+    }
+
+    /**
+     * The intervals up to tick L+2 are already with the timer (L = the
+     * last tick). The ramp covers the n after that, n chosen so tick
+     * L+2+n is a beat boundary and n >= CLOCK_GEN_RAMP_TICKS. Interval i
+     * of the ramp is P0 + (P1 - P0) * i / n + c; with phase, c is what
+     * makes them add up to the reference beat nearest where the ramp
+     * would otherwise end.
+     */
+    void plan(uint32_t target, bool phase, uint32_t beatAtMicros) {
+        const int64_t one = 1 << CLOCK_GEN_FRAC_BITS;
+        uint8_t beatAtL2 = (_beatTick + 2) % CLOCK_PPQN;
+        int32_t n = (CLOCK_PPQN - beatAtL2) % CLOCK_PPQN + CLOCK_GEN_RAMP_TICKS;
+        int64_t p0 = _period;
+        int64_t p1 = target;
+        int64_t correction = 0;
+        if (phase) {
+            uint32_t startAt = _lastTickAt + _intervals[0] + _intervals[1];   // Tick L+2
+            int64_t from = static_cast<int64_t>(static_cast<int32_t>(startAt - beatAtMicros)) * one;
+            int64_t beat = p1 * CLOCK_PPQN;
+            int64_t limit = p1 / CLOCK_GEN_MAX_NUDGE;
+            for (;;) {
+                // Where the ramp would end, measured from the reference beat
+                int64_t end = from + n * p0 + (p1 - p0) * (n + 1) / 2;
+                int64_t nearest = end + beat / 2;
+                int64_t beats = nearest / beat;
+                if (nearest % beat < 0) beats--;   // Floor, not truncate
+                correction = (beats * beat - end) / n;
+                if ((correction <= limit && correction >= -limit) || n > 16 * CLOCK_PPQN) break;
+                n += CLOCK_PPQN;
+            }
+        }
+        _target = target;
+        _rampStep = static_cast<int32_t>((p1 - p0) / n);
+        _correction = static_cast<int32_t>(correction);
+        _rampLeft = static_cast<uint16_t>(n);
+    }
+
+    volatile bool _enabled;
+    volatile bool _running;
+    bool _positionPending;
+    volatile uint8_t _transport;   // Start / Stop / Continue waiting for the next tick, 0 = none
+    volatile uint32_t _period;     // Tick period, 1/4096 µs
+    uint32_t _target;              // Where a ramp ends
+    uint32_t _residue;             // Fraction of a µs carried between intervals
+    volatile uint16_t _rampLeft;   // Ramp intervals still to hand out
+    int32_t _rampStep;             // Period change per ramp interval
+    int32_t _correction;           // Added to each ramp interval to land on the reference beat
+    uint32_t _intervals[2];        // The last two handed out: ticks L -> L+1 -> L+2
+    uint32_t _lastTickAt;
+    uint8_t _beatTick;             // Ticks since the last beat boundary
+    volatile uint32_t _position;
+    volatile uint32_t _ticks;
+    float _bpm;
+};
+
+#endif // CLOCK_GENERATOR_H
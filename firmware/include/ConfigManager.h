@@ -7,6 +7,7 @@
 #include <map>
 #include <vector>
 #include <FastLED.h>
+#include "CcSlotIndex.h"
 
 #define EEPROM_START_ADDRESS 0
 #define EEPROM_MAGIC_ADDRESS (EEPROM_START_ADDRESS + 200)  // Reserve space for config + magic number
@@ -25,7 +26,28 @@
 #define EEPROM_ARG_ENV_B    (EEPROM_ARG_ENV_A + 1)
 #define EEPROM_BACKUP_START (EEPROM_ARG_ENV_B + 1 + 50)  // Space after primary + buffer
 
+// Button action table: magic, then ACTION_TABLE_BYTES (66) of entries
+#define EEPROM_BUTTON_ACTIONS_MAGIC_ADDRESS 420  // Clear of the backup copy
+#define EEPROM_BUTTON_ACTIONS (EEPROM_BUTTON_ACTIONS_MAGIC_ADDRESS + 2)
+#define EEPROM_MAGIC_BUTTON_ACTIONS 0xBA01
+
+// Per-action quantize settings: magic, then ACTION_QUANTIZE_BYTES (4), in the gap before the curves
+#define EEPROM_ACTION_QUANTIZE_MAGIC_ADDRESS 488  // Right after the action table (422..487)
+#define EEPROM_ACTION_QUANTIZE (EEPROM_ACTION_QUANTIZE_MAGIC_ADDRESS + 2)
+#define EEPROM_MAGIC_ACTION_QUANTIZE 0xBE01
+
+// Custom response curves: magic, then CURVE_BREAKPOINTS (17) levels per EF
+#define EEPROM_CUSTOM_CURVES_MAGIC_ADDRESS 500  // After the action table (422..487)
+#define EEPROM_CUSTOM_CURVES (EEPROM_CUSTOM_CURVES_MAGIC_ADDRESS + 2)
+#define EEPROM_MAGIC_CUSTOM_CURVES 0xCC01
+
+// Modulation matrix: magic, then SlotModMatrix::BYTES (336) of depths, offsets and bipolar flags
+#define EEPROM_MOD_MATRIX_MAGIC_ADDRESS 620  // After the custom curves (502..603)
+#define EEPROM_MOD_MATRIX (EEPROM_MOD_MATRIX_MAGIC_ADDRESS + 2)  // Ends at 957, clear of the filter freq/Q
+#define EEPROM_MAGIC_MOD_MATRIX 0x3D01
+
 class EnvelopeFollower;
+class ButtonActionMap;
 
 class ConfigManager {
 public:
@@ -41,6 +63,8 @@ public:
     uint8_t getPotCCNumber(uint8_t potIndex) const;
     void setPotChannel(uint8_t potIndex, uint8_t channel);
     void setPotCCNumber(uint8_t potIndex, uint8_t ccNumber);
+    // The same mapping both ways: what each pot sends on, and (channel, CC) -> slots for incoming CCs
+    const CcSlotIndex& ccIndex() const { return _ccIndex; }
 
     // Save and load configurations from EEPROM
     void saveConfiguration();
@@ -53,9 +77,17 @@ public:
     // Reset configuration to defaults
     void resetConfiguration(std::vector<uint8_t>& potChannels);
 
-    // Envelope Follower configuration
-    void saveEnvelopeSettings(const std::map<int, int>& potToEnvelopeMap, const std::vector<EnvelopeFollower>& envelopes);
-    void loadEnvelopeSettings(std::map<int, int>& potToEnvelopeMap, std::vector<EnvelopeFollower>& envelopes);
+    // Slot x EF modulation matrix (replaces the one-EF-per-slot assignments)
+    void saveModulationMatrix(const SlotModMatrix& matrix);
+    bool loadModulationMatrix(SlotModMatrix& matrix);  // false = nothing stored, old assignments migrated
+
+    // Button action table (remapped with SET_ACTION) and per-action quantize (SET_QUANTIZE)
+    void saveButtonActions(const ButtonActionMap& actions);
+    bool loadButtonActions(ButtonActionMap& actions);  // false = nothing stored, defaults kept
+
+    // Custom response curves, one per EF (uploaded with SET_CURVE)
+    void saveCustomCurves(const std::vector<EnvelopeFollower>& envelopes);
+    bool loadCustomCurves(std::vector<EnvelopeFollower>& envelopes);  // false = nothing stored
 
     // Utility method to get global constants
     uint8_t getNumPots() const { return _numPots; }
@@ -82,8 +114,7 @@ private:
     uint8_t _numButtons;
 
     // Configuration data (stored in RAM)
-    std::map<uint8_t, uint8_t> _potChannels;   // Potentiometer index -> MIDI Channel
-    std::map<uint8_t, uint8_t> _potCCNumbers; // Potentiometer index -> MIDI CC Number
+    CcSlotIndex _ccIndex;   // Potentiometer index <-> MIDI channel + CC number
 
     // Health‑check & backup support
     bool checkEEPROMHealth(bool backup);
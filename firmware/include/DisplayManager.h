@@ -6,6 +6,7 @@
 #include <Adafruit_SSD1306.h>
 #include <vector>
 #include "Globals.h"    // for SCREEN_WIDTH, SCREEN_HEIGHT
+#include "TimingWheel.h"
 
 struct ButtonManagerContext;
 
@@ -41,6 +42,7 @@ public:
   void setTemporaryMessage(const char* message, unsigned long duration);
   void showMIDIMessage(uint8_t cc, uint8_t value, uint8_t channel);
   void updateBeat(uint8_t beatPosition, bool clockRunning);
+  void showBeat(uint8_t beatInBar, bool running);
 
   // Advanced features
   void beginDraw();
@@ -69,7 +71,8 @@ private:
   uint8_t            _i2cAddress;
 
   String             _statusMessage;
-  unsigned long      _statusTimeout;
+  bool               _statusHeld = false;   // Status message on screen; the other draws wait
+  WheelTimer         _statusTimer = 0;
 
   bool               _isDrawing;
   unsigned long      _updateIntervalMs;
@@ -79,6 +82,8 @@ private:
   String             _activeMode;
 
   void drawBorder();
+  void holdStatus(unsigned long durationMs);
+  static void releaseStatus(void* context, uint32_t arg);
 };
 
 #endif // DISPLAYMANAGER_H
@@ -0,0 +1,306 @@
+#ifndef ENVELOPE_BANK_H
+#define ENVELOPE_BANK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "BiquadFilter.h"
+#include "ResponseCurve.h"
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#endif
+
+// Shape of an EF in SEF mode (EnvelopeFollower::FilterType: every curve is a
+// response table, LP/HP/BP fold into FILTER)
+enum EnvelopeShape : uint8_t {
+    SHAPE_CURVE,
+    SHAPE_RANDOM,
+    SHAPE_FILTER
+};
+
+// Same order as EnvelopeFollower::ARG_Method
+enum EnvelopeArgOp : uint8_t {
+    ARG_OP_PLUS,
+    ARG_OP_MIN,
+    ARG_OP_PECK,
+    ARG_OP_SHAV,
+    ARG_OP_SQAR,
+    ARG_OP_BABS,
+    ARG_OP_TABS
+};
+
+/**
+ * Processing engine for all envelope followers at once, stored as a
+ * struct of arrays: filter coefficients, filter state and settings for
+ * every EF sit in contiguous arrays, one slot per EF.
+ *
+ * process() takes one frame of control-rate input levels (one per
+ * envelope input, 0..127) and updates every EF in two passes:
+ *   1. conditioning: every active EF shapes its own input (response-table
+ *      read, random or filter; the biquads run in lockstep over the
+ *      coefficient arrays, transposed DF-II with the same arithmetic and
+ *      retune glide as BiquadFilter). The results form one conditioned
+ *      frame, indexed by input.
+ *   2. output: an SEF takes its own conditioned level, an ARG EF combines
+ *      the conditioned levels of its A and B inputs.
+ *
+ * So ARG math works on the same envelopes the SEFs put out (filtered,
+ * curved), all from the same frame, and an EF in ARG mode still shapes
+ * its input for any other ARG EF that reads it. An input without an
+ * active EF on it passes through unconditioned.
+ *
+ * Everything that EnvelopeFollower used to decide per sample (mode,
+ * filter type, ARG method, which pin is which input) is folded into one
+ * shape op, an output op and two input indices when the setting changes. Every curve
+ * (built-in or uploaded) is a CURVE_SIZE table per EF, so a curve costs
+ * one indexed load whatever its shape.
+ *
+ * Cortex-M7 has no float SIMD, so the float stage is a plain loop the
+ * dual-issue FPU can pipeline; where the DSP extension exists, the
+ * 0..127 clamps use one USAT instruction. Without it the same code
+ * builds natively with a scalar clamp.
+ */
+template <uint8_t NumEnvelopes>
+class EnvelopeBank {
+public:
+    EnvelopeBank() { reset(); }
+
+    void reset() {
+        for (uint8_t i = 0; i < NumEnvelopes; i++) {
+            _active[i] = false;
+            _argMode[i] = false;
+            _shape[i] = SHAPE_CURVE;
+            _shaped[i] = 0;
+            buildCurve(CURVE_LINEAR, _curve[i]);
+            _argOp[i] = ARG_OP_PLUS;
+            _input[i] = i;
+            _inputA[i] = NO_INPUT;
+            _inputB[i] = NO_INPUT;
+            _b0[i] = _b1[i] = _b2[i] = _a1[i] = _a2[i] = 0.0f;
+            _target[i] = BiquadCoefficients{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+            _step[i] = _target[i];
+            _rampLeft[i] = 0;
+            _sections[i] = 1;
+            clearFilterState(i, 0);
+            _level[i] = 0;
+            updateOp(i);
+        }
+        _random = 0x2545F491u;
+    }
+
+    // --- Per-EF settings ---
+
+    void setActive(uint8_t ef, bool active) { _active[ef] = active; updateOp(ef); }
+    void setInput(uint8_t ef, uint8_t input) { _input[ef] = input < NumEnvelopes ? input : NO_INPUT; }
+    void setShape(uint8_t ef, EnvelopeShape shape) { _shape[ef] = shape; updateOp(ef); }
+    void setArgMode(uint8_t ef, bool argMode) { _argMode[ef] = argMode; updateOp(ef); }
+    void setArgOp(uint8_t ef, EnvelopeArgOp op) { _argOp[ef] = op; updateOp(ef); }
+
+    // Response table (CURVE_SIZE entries, 0..127) used by SHAPE_CURVE
+    void setCurve(uint8_t ef, const uint8_t* table) { memcpy(_curve[ef], table, CURVE_SIZE); }
+
+    // Input indices for ARG mode (read from the conditioned frame); anything out of range reads as 0
+    void setArgInputs(uint8_t ef, int inputA, int inputB) {
+        _inputA[ef] = (inputA >= 0 && inputA < NumEnvelopes) ? inputA : NO_INPUT;
+        _inputB[ef] = (inputB >= 0 && inputB < NumEnvelopes) ? inputB : NO_INPUT;
+    }
+
+    /**
+     * Biquad coefficients (one section's worth) and cascade length. While
+     * the EF is already filtering, a change glides over rampSamples frames
+     * like BiquadFilter::setTarget(); otherwise it applies at once and the
+     * filter starts from silence.
+     */
+    void setFilter(uint8_t ef, const BiquadCoefficients& target, uint8_t sections, uint16_t rampSamples) {
+        if (sections < 1) sections = 1;
+        if (sections > BIQUAD_MAX_SECTIONS) sections = BIQUAD_MAX_SECTIONS;
+        bool running = (_op[ef] == OP_FILTER);
+        if (running && sections > _sections[ef]) clearFilterState(ef, _sections[ef]);
+        _sections[ef] = sections;
+
+        if (running && memcmp(&target, &_target[ef], sizeof(target)) == 0) return;
+        _target[ef] = target;
+        if (!running || rampSamples == 0) {
+            _b0[ef] = target.b0;
+            _b1[ef] = target.b1;
+            _b2[ef] = target.b2;
+            _a1[ef] = target.a1;
+            _a2[ef] = target.a2;
+            _rampLeft[ef] = 0;
+            if (!running) clearFilterState(ef, 0);
+            return;
+        }
+        float n = static_cast<float>(rampSamples);
+        _step[ef].b0 = (target.b0 - _b0[ef]) / n;
+        _step[ef].b1 = (target.b1 - _b1[ef]) / n;
+        _step[ef].b2 = (target.b2 - _b2[ef]) / n;
+        _step[ef].a1 = (target.a1 - _a1[ef]) / n;
+        _step[ef].a2 = (target.a2 - _a2[ef]) / n;
+        _rampLeft[ef] = rampSamples;
+    }
+
+    // --- Processing ---
+
+    /**
+     * Update every EF from one frame of input levels (NumEnvelopes entries,
+     * 0..127). Inactive EFs keep their last level.
+     */
+    void process(const uint8_t* levels) {
+        // Input NO_INPUT reads the zero pad at the end; the conditioned
+        // frame starts as the raw inputs and pass 1 overwrites its EFs' slots
+        int in[NumEnvelopes + 1];
+        int frame[NumEnvelopes + 1];
+        for (uint8_t i = 0; i < NumEnvelopes; i++) in[i] = frame[i] = levels[i] > 127 ? 127 : levels[i];
+        in[NO_INPUT] = frame[NO_INPUT] = 0;
+
+        // Pass 1a: every biquad in use, in lockstep
+        for (uint8_t i = 0; i < NumEnvelopes; i++) {
+            if (_op[i] != OP_FILTER) continue;
+            if (_rampLeft[i]) advanceRamp(i);
+            float b0 = _b0[i], b1 = _b1[i], b2 = _b2[i], a1 = _a1[i], a2 = _a2[i];
+            float x = static_cast<float>(in[_input[i]]);
+            for (uint8_t k = 0; k < _sections[i]; k++) {
+                float y = b0 * x + _s1[k][i];
+                _s1[k][i] = b1 * x - a1 * y + _s2[k][i];
+                _s2[k][i] = b2 * x - a2 * y;
+                x = y;
+            }
+            _shaped[i] = static_cast<int>(x);
+        }
+
+        // Pass 1b: the other shapes, then the conditioned frame
+        for (uint8_t i = 0; i < NumEnvelopes; i++) {
+            int x = in[_input[i]];
+            switch (_op[i]) {
+                case OP_CURVE:  _shaped[i] = _curve[i][x]; break;
+                case OP_RANDOM: _shaped[i] = randomBelow(x); break;
+                case OP_FILTER: break;           // Pass 1a
+                default: continue;               // OP_OFF: input passes through
+            }
+            frame[_input[i]] = clamp127(_shaped[i]);   // Filters can ring past 0..127
+        }
+
+        // Pass 2: one output operation per EF
+        for (uint8_t i = 0; i < NumEnvelopes; i++) {
+            int a = frame[_inputA[i]];
+            int b = frame[_inputB[i]];
+            switch (_out[i]) {
+                case OUT_SHAPED:     _level[i] = _shaped[i]; break;
+                case OUT_ARG_PLUS:   _level[i] = clamp127(a + b); break;
+                case OUT_ARG_MIN:    _level[i] = clamp127(a - b); break;
+                case OUT_ARG_PECK:   _level[i] = clamp127(b - a); break;
+                case OUT_ARG_SHAV:   _level[i] = clamp127((a - b) / 10); break;
+                case OUT_ARG_SQAR:   _level[i] = clamp127(static_cast<int>(sqrtf(static_cast<float>(a * a + b * b)))); break;
+                case OUT_ARG_BABS:   _level[i] = b ? clamp127(a / b) : 0; break;
+                case OUT_ARG_TABS:   _level[i] = b ? clamp127((10 * a) / b) : 0; break;
+                default: break;      // OUT_OFF
+            }
+        }
+    }
+
+    int level(uint8_t ef) const { return ef < NumEnvelopes ? _level[ef] : 0; }
+    const int* levels() const { return _level; }   // All NumEnvelopes, for the modulation matrix
+
+private:
+    static const uint8_t NO_INPUT = NumEnvelopes;
+
+    // Pass 1: how an EF conditions its input
+    enum Op : uint8_t {
+        OP_OFF,
+        OP_CURVE,
+        OP_RANDOM,
+        OP_FILTER
+    };
+
+    // Pass 2: what an EF puts out
+    enum Out : uint8_t {
+        OUT_OFF,
+        OUT_SHAPED,
+        OUT_ARG_PLUS,   // ARG ops in EnvelopeArgOp order
+        OUT_ARG_MIN,
+        OUT_ARG_PECK,
+        OUT_ARG_SHAV,
+        OUT_ARG_SQAR,
+        OUT_ARG_BABS,
+        OUT_ARG_TABS
+    };
+
+    // Settings (what EnvelopeFollower holds)
+    bool _active[NumEnvelopes];
+    bool _argMode[NumEnvelopes];
+    EnvelopeShape _shape[NumEnvelopes];
+    EnvelopeArgOp _argOp[NumEnvelopes];
+
+    // Hot-path data
+    uint8_t _op[NumEnvelopes];
+    uint8_t _out[NumEnvelopes];
+    uint8_t _input[NumEnvelopes];
+    uint8_t _inputA[NumEnvelopes];
+    uint8_t _inputB[NumEnvelopes];
+    uint8_t _curve[NumEnvelopes][CURVE_SIZE];
+    float _b0[NumEnvelopes], _b1[NumEnvelopes], _b2[NumEnvelopes];   // Coefficients in use
+    float _a1[NumEnvelopes], _a2[NumEnvelopes];
+    float _s1[BIQUAD_MAX_SECTIONS][NumEnvelopes];                     // TDF-II state, per section
+    float _s2[BIQUAD_MAX_SECTIONS][NumEnvelopes];
+    uint8_t _sections[NumEnvelopes];
+    uint16_t _rampLeft[NumEnvelopes];
+    BiquadCoefficients _step[NumEnvelopes];     // Only read while gliding
+    BiquadCoefficients _target[NumEnvelopes];
+    int _shaped[NumEnvelopes];                  // Pass 1 result (the EF's conditioned input)
+    int _level[NumEnvelopes];
+    uint32_t _random;
+
+    void updateOp(uint8_t ef) {
+        static const uint8_t SHAPE_OPS[] = { OP_CURVE, OP_RANDOM, OP_FILTER };
+        if (!_active[ef]) {
+            _op[ef] = OP_OFF;
+            _out[ef] = OUT_OFF;
+            return;
+        }
+        _op[ef] = SHAPE_OPS[_shape[ef]];
+        _out[ef] = _argMode[ef] ? OUT_ARG_PLUS + _argOp[ef] : OUT_SHAPED;
+    }
+
+    void clearFilterState(uint8_t ef, uint8_t fromSection) {
+        for (uint8_t k = fromSection; k < BIQUAD_MAX_SECTIONS; k++) {
+            _s1[k][ef] = 0.0f;
+            _s2[k][ef] = 0.0f;
+        }
+    }
+
+    // Same steps as BiquadFilter::advanceRamp(), so both land on identical values
+    void advanceRamp(uint8_t ef) {
+        if (--_rampLeft[ef] == 0) {
+            _b0[ef] = _target[ef].b0;
+            _b1[ef] = _target[ef].b1;
+            _b2[ef] = _target[ef].b2;
+            _a1[ef] = _target[ef].a1;
+            _a2[ef] = _target[ef].a2;
+            return;
+        }
+        _b0[ef] += _step[ef].b0;
+        _b1[ef] += _step[ef].b1;
+        _b2[ef] += _step[ef].b2;
+        _a1[ef] += _step[ef].a1;
+        _a2[ef] += _step[ef].a2;
+    }
+
+    static int clamp127(int x) {
+#if defined(__ARM_FEATURE_DSP)
+        return __usat(x, 7);
+#else
+        return x < 0 ? 0 : (x > 127 ? 127 : x);
+#endif
+    }
+
+    // Same contract as Arduino random(max): 0 for max <= 0, else [0, max)
+    int randomBelow(int max) {
+        if (max <= 0) return 0;
+        _random ^= _random << 13;
+        _random ^= _random >> 17;
+        _random ^= _random << 5;
+        return static_cast<int>(_random % static_cast<uint32_t>(max));
+    }
+};
+
+#endif // ENVELOPE_BANK_H
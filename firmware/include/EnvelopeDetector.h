@@ -0,0 +1,140 @@
+#ifndef ENVELOPE_DETECTOR_H
+#define ENVELOPE_DETECTOR_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define ENVELOPE_ATTACK_MS 5.0f       // Default rise time constant
+#define ENVELOPE_RELEASE_MS 150.0f    // Default fall time constant
+#define ENVELOPE_DC_CUTOFF_HZ 5.0f    // DC tracker corner; strips the mid-rail input bias
+#define ENVELOPE_RMS_WINDOW_MS 10.0f  // Mean-square averaging time in RMS mode
+#define ENVELOPE_ADC_MIDPOINT 512.0f  // 10-bit input biased at half supply
+#define ENVELOPE_FULL_SCALE 512.0f    // Largest swing around the midpoint
+
+enum EnvelopeDetectMode : uint8_t {
+    ENVELOPE_PEAK,  // Follows |x|
+    ENVELOPE_RMS    // Follows sqrt(mean(x^2)), sine-calibrated so a sine reads the same as PEAK
+};
+
+/**
+ * Audio-rate envelope detector for NumInputs inputs that are sampled
+ * together (one EnvelopeFrame).
+ *
+ * Every sample, for each input:
+ *   1. remove the DC bias with a slow one-pole tracker
+ *   2. rectify: |x| (peak), or the square root of a short symmetric
+ *      average of x^2 (RMS)
+ *   3. one-pole attack/release ballistics: the attack coefficient while
+ *      the rectified signal is above the envelope, release below it
+ *
+ * Every `decimation` samples a control-rate level (0..127) per input is
+ * published. The envelope is already smooth, so picking every Nth value
+ * doesn't alias the way point-sampling the raw waveform did.
+ *
+ * State is kept per input in flat arrays.
+ */
+template <uint8_t NumInputs>
+class EnvelopeDetector {
+public:
+    EnvelopeDetector(float sampleRate, uint16_t decimation)
+        : _sampleRate(sampleRate),
+          _decimation(decimation ? decimation : 1) {
+        _dcCoef = 1.0f - expf(-2.0f * static_cast<float>(M_PI) * ENVELOPE_DC_CUTOFF_HZ / _sampleRate);
+        _rmsCoef = ballisticCoef(ENVELOPE_RMS_WINDOW_MS);
+        setBallistics(ENVELOPE_ATTACK_MS, ENVELOPE_RELEASE_MS);
+        reset();
+    }
+
+    void reset() {
+        for (uint8_t i = 0; i < NumInputs; i++) {
+            _dc[i] = ENVELOPE_ADC_MIDPOINT;
+            _meanSquare[i] = 0.0f;
+            _envelope[i] = 0.0f;
+            _levels[i] = 0;
+        }
+        _phase = 0;
+    }
+
+    /**
+     * Time constants in milliseconds (time to reach ~63% of a step).
+     */
+    void setBallistics(float attackMs, float releaseMs) {
+        _attackCoef = ballisticCoef(attackMs);
+        _releaseCoef = ballisticCoef(releaseMs);
+    }
+
+    void setMode(EnvelopeDetectMode mode) {
+        if (mode != _mode) {
+            _mode = mode;
+            for (uint8_t i = 0; i < NumInputs; i++) {
+                _meanSquare[i] = 0.0f;
+                _envelope[i] = 0.0f;
+            }
+        }
+    }
+    EnvelopeDetectMode mode() const { return _mode; }
+
+    /**
+     * Run one audio-rate frame (raw ADC readings, one per input).
+     * @return true when a new set of control-rate levels is ready
+     */
+    bool process(const uint16_t* samples) {
+        for (uint8_t i = 0; i < NumInputs; i++) {
+            float x = samples[i] - _dc[i];
+            _dc[i] += _dcCoef * x;
+
+            float rectified;
+            if (_mode == ENVELOPE_PEAK) {
+                rectified = fabsf(x);
+            } else {
+                // Asymmetric ballistics on x^2 would bias high, so average it first
+                _meanSquare[i] = x * x + _rmsCoef * (_meanSquare[i] - x * x);
+                rectified = sqrtf(2.0f * _meanSquare[i]);
+            }
+            float coef = (rectified > _envelope[i]) ? _attackCoef : _releaseCoef;
+            _envelope[i] = rectified + coef * (_envelope[i] - rectified);
+        }
+
+        if (++_phase < _decimation) return false;
+        _phase = 0;
+        for (uint8_t i = 0; i < NumInputs; i++) {
+            _levels[i] = toLevel(_envelope[i]);
+        }
+        return true;
+    }
+
+    // Control-rate levels (0..127), one per input; updated when process() returns true
+    const uint8_t* levels() const { return _levels; }
+    uint8_t level(uint8_t input) const { return input < NumInputs ? _levels[input] : 0; }
+
+    float sampleRate() const { return _sampleRate; }
+    float controlRate() const { return _sampleRate / _decimation; }
+
+private:
+    const float _sampleRate;
+    const uint16_t _decimation;
+    EnvelopeDetectMode _mode = ENVELOPE_PEAK;
+
+    float _dcCoef;
+    float _attackCoef;
+    float _releaseCoef;
+    float _rmsCoef;
+
+    float _dc[NumInputs];
+    float _meanSquare[NumInputs];
+    float _envelope[NumInputs];
+    uint8_t _levels[NumInputs];
+    uint16_t _phase = 0;
+
+    float ballisticCoef(float ms) const {
+        return (ms > 0.0f) ? expf(-1000.0f / (ms * _sampleRate)) : 0.0f;
+    }
+
+    uint8_t toLevel(float envelope) const {
+        float level = envelope * (127.0f / ENVELOPE_FULL_SCALE);
+        if (level > 127.0f) level = 127.0f;
+        return static_cast<uint8_t>(level + 0.5f);
+    }
+};
+
+#endif // ENVELOPE_DETECTOR_H
@@ -4,9 +4,12 @@
 #include <Arduino.h>
 #include "PotentiometerManager.h"
 #include "BiquadFilter.h"
+#include "FilterTuningTable.h"
+#include "ResponseCurve.h"
+#include "EnvelopeBank.h"
 #include "Globals.h"
 
-// Forward declaration
+// Forward declarations
 class PotentiometerManager;
 
 class EnvelopeFollower {
@@ -21,7 +24,10 @@ public:
         RANDOM,
         LOWPASS,
         HIGHPASS,
-        BANDPASS
+        BANDPASS,
+        LOGARITHMIC,   // Curves added after the filters keep the old numbering
+        S_CURVE,
+        CUSTOM         // Curve from setCustomCurve() (SET_CURVE)
     };
 
     /**
@@ -48,8 +54,8 @@ public:
 
 private:
     int audioInputPin;            // Pin for audio input
+    uint8_t inputIndex;           // Which detector level belongs to this EF
     int currentEnvelopeLevel;     // Current envelope value
-    int modulationTargetCC;       // Target MIDI CC
     bool isActive;                // Is envelope follower active?
 
     // Existing filter type
@@ -63,13 +69,22 @@ private:
     int envelopeB;
 
     PotentiometerManager* potManager;
-    BiquadFilter filter;          // Existing custom filter
+    BiquadFilter filter;          // Existing custom filter (designs the bank's coefficients)
+    uint8_t curve[CURVE_SIZE];    // Response table for the curve types
+    uint8_t customCurve[CURVE_BREAKPOINTS];
+
+    // Shared engine that does the per-sample work once bound
+    EnvelopeBank<NUM_ENVELOPES>* bank;
+    uint8_t bankIndex;
 
     /**
      * Internal helpers (unchanged).
      */
     int readEnvelopeLevel();
-    int processEnvelopeLevel(int level);
+    int processEnvelopeLevel(int level, const uint8_t* levels);
+    int readARGInput(int pin, const uint8_t* levels);
+    void syncBank();
+    void rebuildCurve();
 
 public:
     /**
@@ -80,7 +95,6 @@ public:
     /**
      * Original methods (unchanged).
      */
-    void setModulationTarget(int cc);
     void toggleActive(bool state);
     bool getActiveState() const;
 
@@ -89,17 +103,38 @@ public:
      */
     void setFilterType(FilterType type);
     void configureFilter(float frequency, float q);
+    void tuneFilter(const FilterTuningTable& table, uint16_t freqStep, uint16_t qStep);
     FilterType getFilterType() const;
 
     /**
-     * Primary update cycle (unchanged).
+     * Response curves. Every curve type is a CURVE_SIZE lookup table;
+     * CUSTOM interpolates the CURVE_BREAKPOINTS points given here.
+     */
+    void setCustomCurve(const uint8_t* points);
+    const uint8_t* getCustomCurve() const {
+        return customCurve;
+    };
+    static CurveType curveForType(FilterType type);  // CURVE_COUNT for RANDOM and the filters
+    static FilterType typeForCurve(CurveType curve);
+
+    /**
+     * Point-sample the pin once (bench tests only; this aliases on audio).
      */
     void update();
 
     /**
-     * Original applyToCC method (unchanged).
+     * Hand processing over to slot `index` of a shared EnvelopeBank. From
+     * then on every setter below is mirrored into the bank, and
+     * getEnvelopeLevel() reads the bank's output. The bank is driven with
+     * the detector's control-rate levels (ENVELOPE_CONTROL_RATE); in ARG
+     * mode the EF combines the conditioned outputs of its A and B inputs.
+     */
+    void bind(EnvelopeBank<NUM_ENVELOPES>* envelopeBank, uint8_t index);
+
+    /**
+     * EF/detector index of an envelope input pin, or -1.
      */
-    void applyToCC(int potIndex, uint8_t& ccValue);
+    static int inputIndexForPin(int pin);
 
     /**
      * Get the current envelope level (unchanged).
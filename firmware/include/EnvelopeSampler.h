@@ -0,0 +1,64 @@
+#ifndef ENVELOPE_SAMPLER_H
+#define ENVELOPE_SAMPLER_H
+
+#include <Arduino.h>
+#include "Globals.h"
+#include "SpscRingBuffer.h"
+
+// Ring capacity in frames (power of two): 32 ms of headroom at 8 kHz
+#define ENVELOPE_FRAME_BUFFER 256
+
+/**
+ * One timestamped snapshot of all envelope inputs, taken in the same ISR pass.
+ */
+struct EnvelopeFrame {
+    uint32_t timestamp;                 // micros() when the frame was sampled
+    uint16_t samples[NUM_ENVELOPES];    // Raw 10-bit ADC readings, in EF index order
+};
+
+/**
+ * Timer-interrupt sampling front-end for the envelope follower inputs.
+ *
+ * Timer1 fires at a fixed period; the ISR converts every envelope input and
+ * pushes one EnvelopeFrame into a lock-free SPSC ring. The main loop drains
+ * the ring, so the filter math sees a constant sample rate no matter how long
+ * the display or serial work takes.
+ *
+ * The ISR talks to ADC2 directly. analogRead() in the main loop uses ADC1,
+ * so an interrupt landing mid-conversion can never corrupt a pot or button read.
+ */
+class EnvelopeSampler {
+public:
+    /**
+     * @param pins Analog pins to sample, NUM_ENVELOPES entries in EF index order
+     */
+    explicit EnvelopeSampler(const uint8_t* pins);
+
+    /**
+     * Start the timer interrupt.
+     * @param periodMicros Sampling period in microseconds
+     */
+    void begin(uint32_t periodMicros);
+
+    /**
+     * Pop the oldest frame (main loop only).
+     * @return false if no frame is waiting
+     */
+    bool read(EnvelopeFrame& frame);
+
+    uint16_t available() const { return _frames.size(); }
+    uint32_t droppedFrames() const { return _frames.dropped(); }
+    uint32_t periodMicros() const { return _periodMicros; }
+
+private:
+    static EnvelopeSampler* _instance;
+    static void timerISR();
+    void sampleFrame();
+
+    const uint8_t* _pins;
+    uint8_t _channels[NUM_ENVELOPES];   // ADC channel for each pin
+    uint32_t _periodMicros;
+    SpscRingBuffer<EnvelopeFrame, ENVELOPE_FRAME_BUFFER> _frames;
+};
+
+#endif // ENVELOPE_SAMPLER_H
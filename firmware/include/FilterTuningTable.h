@@ -0,0 +1,183 @@
+#ifndef FILTER_TUNING_TABLE_H
+#define FILTER_TUNING_TABLE_H
+
+#include <stdint.h>
+#include <math.h>
+#include "BiquadFilter.h"
+
+#define FILTER_TUNE_MIN_HZ 20.0f
+#define FILTER_TUNE_MAX_HZ 5000.0f
+#define FILTER_TUNE_MIN_Q 0.5f
+#define FILTER_TUNE_MAX_Q 4.0f
+#define FILTER_TUNE_FREQ_POINTS 48     // Grid points, log-spaced over the frequency range
+#define FILTER_TUNE_Q_POINTS 16        // Grid points, log-spaced over the Q range
+#define FILTER_TUNE_SUBSTEPS 8         // Pot steps between two grid points (interpolated)
+#define FILTER_TUNE_FREQ_STEPS ((FILTER_TUNE_FREQ_POINTS - 1) * FILTER_TUNE_SUBSTEPS)
+#define FILTER_TUNE_Q_STEPS ((FILTER_TUNE_Q_POINTS - 1) * FILTER_TUNE_SUBSTEPS)
+#define TUNING_POT_SMOOTHING 0.25f     // One-pole weight of each new reading
+#define TUNING_POT_DEADBAND 4.0f       // ADC counts the smoothed reading must move before it counts
+
+/**
+ * Biquad coefficients for the live freq/Q pots, designed once at boot for
+ * one sample rate on a log-spaced frequency x Q grid. The frequency range
+ * stops at what a biquad can do at that rate (BiquadFilter clamps at
+ * 0.45 x the sample rate), so the whole knob travel does something.
+ *
+ * LOWPASS, HIGHPASS and BANDPASS share a1/a2 and their numerators are one
+ * gain times a fixed pattern ({g, 2g, g}, {g, -2g, g}, {g, 0, -g}), so
+ * each grid point stores five floats for all three types (15 KB total).
+ *
+ * lookup() takes pot steps (FILTER_TUNE_SUBSTEPS per grid cell) and
+ * interpolates bilinearly between the four surrounding grid points: a
+ * few multiply-adds instead of cos/sin and a division. Interpolated
+ * coefficients are stable for the same reason BiquadFilter's retune
+ * glide is.
+ */
+class FilterTuningTable {
+public:
+    FilterTuningTable() : _maxHz(FILTER_TUNE_MAX_HZ) {}
+
+    /**
+     * Design every grid point for `sampleRate` (the rate the filters run at).
+     */
+    void build(float sampleRate) {
+        _maxHz = FILTER_TUNE_MAX_HZ;
+        if (_maxHz > 0.45f * sampleRate) _maxHz = 0.45f * sampleRate;
+        for (uint8_t f = 0; f < FILTER_TUNE_FREQ_POINTS; f++) {
+            float frequency = frequencyAt(f * FILTER_TUNE_SUBSTEPS);
+            for (uint8_t q = 0; q < FILTER_TUNE_Q_POINTS; q++) {
+                float resonance = qAt(q * FILTER_TUNE_SUBSTEPS);
+                Point& p = _points[f][q];
+                BiquadCoefficients lp = BiquadFilter::design(BiquadFilter::LOWPASS, frequency, sampleRate, resonance);
+                p.lowpass = lp.b0;
+                p.highpass = BiquadFilter::design(BiquadFilter::HIGHPASS, frequency, sampleRate, resonance).b0;
+                p.bandpass = BiquadFilter::design(BiquadFilter::BANDPASS, frequency, sampleRate, resonance).b0;
+                p.a1 = lp.a1;
+                p.a2 = lp.a2;
+            }
+        }
+    }
+
+    BiquadCoefficients lookup(BiquadFilter::FilterType type, uint16_t freqStep, uint16_t qStep) const {
+        uint16_t f;
+        uint16_t q;
+        float fw = cellWeight(freqStep, FILTER_TUNE_FREQ_POINTS, f);
+        float qw = cellWeight(qStep, FILTER_TUNE_Q_POINTS, q);
+        const Point& p00 = _points[f][q];
+        const Point& p10 = _points[f + 1][q];
+        const Point& p01 = _points[f][q + 1];
+        const Point& p11 = _points[f + 1][q + 1];
+        float w00 = (1.0f - fw) * (1.0f - qw);
+        float w10 = fw * (1.0f - qw);
+        float w01 = (1.0f - fw) * qw;
+        float w11 = fw * qw;
+
+        float a1 = w00 * p00.a1 + w10 * p10.a1 + w01 * p01.a1 + w11 * p11.a1;
+        float a2 = w00 * p00.a2 + w10 * p10.a2 + w01 * p01.a2 + w11 * p11.a2;
+        switch (type) {
+            case BiquadFilter::HIGHPASS: {
+                float g = w00 * p00.highpass + w10 * p10.highpass + w01 * p01.highpass + w11 * p11.highpass;
+                return BiquadCoefficients{ g, -2.0f * g, g, a1, a2 };
+            }
+            case BiquadFilter::BANDPASS: {
+                float g = w00 * p00.bandpass + w10 * p10.bandpass + w01 * p01.bandpass + w11 * p11.bandpass;
+                return BiquadCoefficients{ g, 0.0f, -g, a1, a2 };
+            }
+            case BiquadFilter::LOWPASS:
+            default: {
+                float g = w00 * p00.lowpass + w10 * p10.lowpass + w01 * p01.lowpass + w11 * p11.lowpass;
+                return BiquadCoefficients{ g, 2.0f * g, g, a1, a2 };
+            }
+        }
+    }
+
+    // Frequency (Hz) and Q at a pot step; for saving and display, not the hot path
+    float frequencyAt(uint16_t freqStep) const {
+        return FILTER_TUNE_MIN_HZ * powf(_maxHz / FILTER_TUNE_MIN_HZ,
+                                         static_cast<float>(freqStep) / FILTER_TUNE_FREQ_STEPS);
+    }
+    static float qAt(uint16_t qStep) {
+        return FILTER_TUNE_MIN_Q * powf(FILTER_TUNE_MAX_Q / FILTER_TUNE_MIN_Q,
+                                        static_cast<float>(qStep) / FILTER_TUNE_Q_STEPS);
+    }
+
+private:
+    struct Point {
+        float lowpass;    // b0 of each type
+        float highpass;
+        float bandpass;
+        float a1;         // Shared feedback coefficients
+        float a2;
+    };
+
+    Point _points[FILTER_TUNE_FREQ_POINTS][FILTER_TUNE_Q_POINTS];
+    float _maxHz;
+
+    // Split a step into a grid cell (lower point) and the weight of the upper point
+    static float cellWeight(uint16_t step, uint16_t points, uint16_t& cell) {
+        cell = step / FILTER_TUNE_SUBSTEPS;
+        if (cell >= points - 1) {
+            cell = points - 2;
+            return 1.0f;
+        }
+        return (step % FILTER_TUNE_SUBSTEPS) * (1.0f / FILTER_TUNE_SUBSTEPS);
+    }
+};
+
+/**
+ * One tuning pot: smooths the raw reading and quantizes it to `steps`
+ * steps with a deadband, so ADC noise on a still knob never retunes.
+ * A step is only a couple of ADC counts wide, so the deadband is in
+ * counts, not steps; the ends of travel always snap to 0 and `steps`.
+ */
+class TuningPot {
+public:
+    explicit TuningPot(uint16_t steps)
+        : _steps(steps), _scale(static_cast<float>(steps) / 1023.0f), _smoothed(0.0f), _anchor(0.0f), _step(0), _primed(false) {}
+
+    /**
+     * Feed one raw reading (0..1023).
+     * @return true when the quantized step changed (always on the first reading)
+     */
+    bool update(int raw) {
+        if (raw < 0) raw = 0;
+        if (raw > 1023) raw = 1023;
+        if (!_primed) {
+            _smoothed = static_cast<float>(raw);
+            _anchor = _smoothed;
+            _step = static_cast<uint16_t>(_anchor * _scale + 0.5f);
+            _primed = true;
+            return true;
+        }
+        _smoothed += TUNING_POT_SMOOTHING * (raw - _smoothed);
+
+        if (_smoothed < TUNING_POT_DEADBAND) {
+            _anchor = 0.0f;
+        } else if (_smoothed > 1023.0f - TUNING_POT_DEADBAND) {
+            _anchor = 1023.0f;
+        } else if (fabsf(_smoothed - _anchor) >= TUNING_POT_DEADBAND) {
+            _anchor = _smoothed;
+        } else {
+            return false;
+        }
+        uint16_t step = static_cast<uint16_t>(_anchor * _scale + 0.5f);
+        if (step > _steps) step = _steps;
+        if (step == _step) {
+            return false;
+        }
+        _step = step;
+        return true;
+    }
+
+    uint16_t step() const { return _step; }
+
+private:
+    const uint16_t _steps;
+    const float _scale;
+    float _smoothed;
+    float _anchor;      // Smoothed reading at the last accepted move
+    uint16_t _step;
+    bool _primed;
+};
+
+#endif // FILTER_TUNING_TABLE_H
@@ -4,6 +4,16 @@
 #include <Arduino.h>
 #include <vector>
 #include <map>
+
+// Envelope follower and slot counts; ahead of the includes because
+// EnvelopeFollower.h and ConfigManager.h need them
+#define NUM_ENVELOPES 6
+#define NUM_POTS 42
+
+#include "ModulationMatrix.h"
+// Per-slot EF modulation (depth per slot x EF)
+typedef ModulationMatrix<NUM_POTS, NUM_ENVELOPES> SlotModMatrix;
+
 #include "ConfigManager.h"
 #include "EnvelopeFollower.h"
 #include "LEDManager.h"
@@ -22,13 +32,22 @@ extern ConfigManager configManager;
 #define SERIAL_TASK_INTERVAL 10   // 10ms for Serial processing
 #define LED_TASK_INTERVAL 50      // 50ms for LED updates
 #define ENVELOPE_TASK_INTERVAL 5  // 5ms for Envelope processing
+#define DISPLAY_TASK_INTERVAL 100 // 100ms for OLED redraws
+#define BUTTON_EVENT_TASK_INTERVAL 5    // 5ms for running queued button gestures
+#define BUTTON_EVENT_BUDGET_US 500      // Stop dispatching gestures after this long
 #define EEPROM_FILTER_FREQ 1000
 #define EEPROM_FILTER_Q    1004
 #define POT_RANGE_MIN 10     // adjust to desired minimum acceptable delta value
 #define ENV_RANGE_MIN 5      // adjust based on your signal threshold requirements
 static const uint8_t buttonMuxAnalogPin = A4;
 static const uint8_t potMuxAnalogPin    = A5;
-#define NUM_POTS 42
+
+// Envelope follower audio inputs, in EF index order
+static const uint8_t ENVELOPE_INPUT_PINS[NUM_ENVELOPES] = {A0, A1, A2, A3, A6, A7};
+#define ENVELOPE_SAMPLE_PERIOD_US 125    // Timer ISR sampling period (8 kHz, audio rate)
+#define ENVELOPE_SAMPLE_RATE (1000000.0f / ENVELOPE_SAMPLE_PERIOD_US)
+#define ENVELOPE_DECIMATION 40           // Audio-rate samples per control-rate level
+#define ENVELOPE_CONTROL_RATE (ENVELOPE_SAMPLE_RATE / ENVELOPE_DECIMATION)  // 200 Hz, what the EFs run at
 
 //clock
 constexpr unsigned long CLOCK_TIMEOUT_MS = 2000; // 2 seconds without clock => fallback
@@ -4,8 +4,16 @@
 #include "Arduino.h"
 //#include "MIDI.h"
 #include "DisplayManager.h"
+#include "MidiOutQueue.h"
+#include "MidiDinTransmitter.h"
+#include "UsbMidiPacker.h"
+#include "MidiInputRouter.h"
+#include "ClockFollower.h"
+#include "ClockGenerator.h"
+#include "SpscRingBuffer.h"
 
 #define IS_USB_CONNECTED() (usbMIDI.connected())
+#define MIDI_USB_REALTIME_QUEUE 16   // Clock / transport bytes the timer has left for USB; power of two
 
 class MIDIHandler {
 public:
@@ -15,16 +23,57 @@ public:
     void sendControlChange(uint8_t control, uint8_t value, uint8_t channel);
     void sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel);
     void sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel);
+    // The send* calls only queue; this puts queued messages on the wire
+    // (DIN as fast as Serial1's TX buffer drains, USB in whole packets). Call it every tick.
+    void flushOutput();
+    // Everything queued for USB goes now, partial packet included
+    void flush();
+    // Clock / transport bytes the clock timer left for USB go out now. Call every loop pass.
+    void flushRealTime();
+    // Real-time bytes USB lost because loop() didn't get to them in time
+    uint32_t usbRealTimeDropped() const { return _usbRealTime.dropped(); }
+    const MidiOutQueue& dinQueue() const { return _dinOut; }
+    const MidiOutQueue& usbQueue() const { return _usbOut; }
+    const MidiDinTransmitter& dinTransmitter() const { return _dinTx; }
+    const MidiRateMeter& usbMeter() const { return _usbMeter; }
+    const UsbMidiPacker& usbPacker() const { return _usbPacker; }
+    void resetOutputStats();
+    // Reads everything pending on DIN and USB, then routes it (see MidiInputRouter)
     void processIncomingMIDI();
-    void handleMIDI(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2); // Process a generic MIDI message
+    // Add or replace handlers here; notes (thru), clock and transport are routed by default
+    MidiInputRouter& inputRouter() { return _input; }
+    const MidiInputRouter& inputRouter() const { return _input; }
     void handleNoteOn(uint8_t channel, uint8_t note, uint8_t velocity);
     void handleNoteOff(uint8_t channel, uint8_t note, uint8_t velocity);
-    bool isClockTick();
-    void clearClockTick();
+    // Incoming clock: tempo, song position and beatPhase()
+    const ClockFollower& clock() const { return _clock; }
+    // Internal clock, sent on DIN and USB from a timer interrupt (started by begin())
+    ClockGenerator& clockOut() { return _clockOut; }
+    const ClockGenerator& clockOut() const { return _clockOut; }
+    // Internal clock tempo: glides there over a beat or two instead of jumping
+    void setClockOutTempo(float bpm);
+    // Same, and moves the beat onto beatAtMicros (a tap)
+    void syncClockOut(float bpm, uint32_t beatAtMicros);
 
 private:
-    bool clockTick = false;
+    MidiInputRouter _input;
+    ClockFollower _clock;
+    ClockGenerator _clockOut;
     DisplayManager* _displayManager = nullptr;
+    MidiOutQueue _dinOut;   // Latest value wins per (channel, CC)
+    MidiOutQueue _usbOut;
+    MidiDinTransmitter _dinTx;   // Running status, paced by Serial1.availableForWrite()
+    UsbMidiPacker _usbPacker;    // 16 events per 64-byte USB packet
+    MidiRateMeter _usbMeter;
+    SpscRingBuffer<uint8_t, MIDI_USB_REALTIME_QUEUE> _usbRealTime;   // Clock timer -> loop()
+
+    void writeUsbPacket(const uint32_t* events, uint8_t count);
+    void sendRealTimeNow(uint8_t status);
+    static void onClockTimer();
+    void queueInput(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2, MidiInSource source, uint32_t now);
+    static void onNote(void* context, const MidiInEvent& event);
+    static void onClock(void* context, const MidiInEvent& event);
+    static void onTransport(void* context, const MidiInEvent& event);
 };
 
 #endif
@@ -0,0 +1,164 @@
+#ifndef MIDI_DIN_TRANSMITTER_H
+#define MIDI_DIN_TRANSMITTER_H
+
+#include <stdint.h>
+#include "MidiOutQueue.h"
+
+#define MIDI_DIN_BYTES_PER_SEC 3125               // 31250 baud, 10 bits on the wire per byte
+#define MIDI_DIN_TX_BUFFER 64                     // Serial1's transmit buffer; never write past it
+#define MIDI_DIN_TX_MIN_WRITE (MIDI_DIN_TX_BUFFER / 2)   // Wait for this much room: the rest is still 10 ms of wire time
+#define MIDI_RUNNING_STATUS_REFRESH_US 250000UL   // Re-send the status byte at least this often
+#define MIDI_DIN_REALTIME_RESERVE 4               // Left free for clock / transport bytes written from the clock timer
+
+/**
+ * Puts a MidiOutQueue on the 5-pin port as raw bytes, with running status.
+ *
+ * Once a status byte is on the wire, further channel messages with the
+ * same status only need their data bytes, so a stream of CCs on one
+ * channel costs 2 bytes each instead of 3. To get the most out of that,
+ * each service() pulls a batch and sends its CCs grouped by status
+ * (channel), starting with the one already running. Only CCs move:
+ * anything else (notes) keeps its place and splits the batch, so a Note
+ * Off can never overtake its Note On.
+ *
+ * service() writes no more than the UART's availableForWrite(), so it
+ * never blocks; whatever doesn't fit stays in the queue and keeps
+ * merging. While the line is busy it waits for MIDI_DIN_TX_MIN_WRITE
+ * bytes of room, so batches are big enough to group: topping the buffer
+ * up a byte at a time would send one message per batch. The status byte is sent again every
+ * MIDI_RUNNING_STATUS_REFRESH_US so a receiver plugged in mid-stream
+ * locks on.
+ *
+ * MIDI_DIN_REALTIME_RESERVE bytes of the buffer are never filled here:
+ * the internal clock writes its real-time bytes straight to the port
+ * from a timer interrupt, and those must not have to wait for room.
+ *
+ * Port is anything with availableForWrite() and write(const uint8_t*,
+ * size_t): Serial1 on the Teensy, a fake UART in the host tests.
+ */
+class MidiDinTransmitter {
+public:
+    MidiDinTransmitter() { reset(); }
+
+    void reset() {
+        _running = 0;
+        _lastStatusAt = 0;
+        _statusBytesSaved = 0;
+        _runningStatus = true;
+    }
+
+    // Off = every message carries its status byte (for gear that mishandles running status)
+    void setRunningStatus(bool enabled) {
+        _runningStatus = enabled;
+        _running = 0;
+    }
+    bool runningStatus() const { return _runningStatus; }
+
+    /**
+     * Move as much of the queue onto the port as its TX buffer takes.
+     * @return bytes written
+     */
+    template <typename Port>
+    uint16_t service(MidiOutQueue& queue, Port& port, uint32_t nowMicros) {
+        int room = port.availableForWrite();
+        if (room > MIDI_DIN_TX_BUFFER) room = MIDI_DIN_TX_BUFFER;
+        room -= MIDI_DIN_REALTIME_RESERVE;
+        if (room < MIDI_DIN_TX_MIN_WRITE) return 0;
+
+        // Pull what surely fits: each CC's data, plus one status per channel in its run
+        uint8_t count = 0;
+        uint16_t estimate = 0;
+        uint16_t runChannels = 0;
+        MidiOutMessage m;
+        while (count < BATCH_SIZE && queue.peek(m)) {
+            uint16_t cost;
+            if (isControlChange(m.status)) {
+                uint16_t bit = static_cast<uint16_t>(1u << (m.status & 0x0F));
+                cost = (_runningStatus && (runChannels & bit)) ? 2 : 3;
+                if (estimate + cost > room) break;
+                runChannels |= bit;
+            } else {
+                cost = m.size;
+                if (estimate + cost > room) break;
+                runChannels = 0;
+            }
+            estimate += cost;
+            _batch[count++] = m;
+            queue.pop();
+        }
+        if (!count) return 0;
+
+        // Group each run of CCs by status, the running one first; stable, so order within a channel holds
+        for (uint8_t start = 0; start < count;) {
+            if (!isControlChange(_batch[start].status)) {
+                start++;
+                continue;
+            }
+            uint8_t end = start;
+            while (end < count && isControlChange(_batch[end].status)) end++;
+            for (uint8_t i = start + 1; i < end; i++) {
+                MidiOutMessage x = _batch[i];
+                uint8_t k = i;
+                while (k > start && sortKey(_batch[k - 1].status) > sortKey(x.status)) {
+                    _batch[k] = _batch[k - 1];
+                    k--;
+                }
+                _batch[k] = x;
+            }
+            start = end;
+        }
+
+        uint16_t n = 0;
+        for (uint8_t i = 0; i < count; i++) n += encode(_batch[i], _bytes + n, nowMicros);
+        port.write(_bytes, n);
+        _meter.add(n, count);
+        return n;
+    }
+
+    // Call every tick so bytes/sec stays current
+    void update(uint32_t nowMicros) { _meter.update(nowMicros); }
+
+    const MidiRateMeter& meter() const { return _meter; }
+    uint32_t statusBytesSaved() const { return _statusBytesSaved; }
+    void resetStats(uint32_t nowMicros) {
+        _meter.reset(nowMicros);
+        _statusBytesSaved = 0;
+    }
+
+private:
+    static const uint8_t BATCH_SIZE = MIDI_DIN_TX_BUFFER / 2;   // Smallest message with running status
+
+    MidiOutMessage _batch[BATCH_SIZE];
+    uint8_t _bytes[MIDI_DIN_TX_BUFFER];
+    uint8_t _running;          // Status the receiver holds; 0 = none
+    uint32_t _lastStatusAt;
+    bool _runningStatus;
+    uint32_t _statusBytesSaved;
+    MidiRateMeter _meter;
+
+    static bool isControlChange(uint8_t status) { return (status & 0xF0) == 0xB0; }
+
+    uint8_t sortKey(uint8_t status) const { return status == _running ? 0 : status; }
+
+    uint8_t encode(const MidiOutMessage& m, uint8_t* out, uint32_t nowMicros) {
+        uint8_t n = 0;
+        if (m.status >= 0xF8) {
+            out[n++] = m.status;   // Real-time: doesn't touch running status
+            return n;
+        }
+        bool channelMessage = m.status < 0xF0;
+        if (_runningStatus && channelMessage && m.status == _running &&
+            nowMicros - _lastStatusAt < MIDI_RUNNING_STATUS_REFRESH_US) {
+            _statusBytesSaved++;
+        } else {
+            out[n++] = m.status;
+            _running = channelMessage ? m.status : 0;   // System common cancels it
+            _lastStatusAt = nowMicros;
+        }
+        if (m.size > 1) out[n++] = m.data1;
+        if (m.size > 2) out[n++] = m.data2;
+        return n;
+    }
+};
+
+#endif // MIDI_DIN_TRANSMITTER_H
@@ -0,0 +1,150 @@
+#ifndef MIDI_INPUT_ROUTER_H
+#define MIDI_INPUT_ROUTER_H
+
+#include <stdint.h>
+
+#define MIDI_IN_QUEUE_SIZE 128   // Parsed events held between read and dispatch; power of two
+
+enum MidiInSource : uint8_t {
+    MIDI_IN_DIN,
+    MIDI_IN_USB
+};
+
+struct MidiInEvent {
+    uint8_t status;      // Channel messages: type | (channel - 1). System messages: the status byte
+    uint8_t data1;       // SysEx: length, low 7 bits
+    uint8_t data2;       // SysEx: length, high 7 bits
+    uint8_t source;      // MidiInSource
+    uint32_t timestamp;  // micros() when it was read
+
+    uint8_t type() const { return status < 0xF0 ? (status & 0xF0) : status; }
+    uint8_t channel() const { return status < 0xF0 ? (status & 0x0F) + 1 : 0; }   // 1..16, 0 = system
+};
+
+// What the routing table is indexed by
+enum MidiInRoute : uint8_t {
+    MIDI_ROUTE_NOTE,        // Note On / Note Off
+    MIDI_ROUTE_CC,          // Control Change
+    MIDI_ROUTE_CLOCK,       // 0xF8
+    MIDI_ROUTE_TRANSPORT,   // Start / Continue / Stop / Song Position
+    MIDI_ROUTE_SYSEX,
+    MIDI_ROUTE_OTHER,       // Everything else (program change, pitch bend, active sensing, ...)
+    MIDI_ROUTE_COUNT
+};
+
+typedef void (*MidiInHandler)(void* context, const MidiInEvent& event);
+
+/**
+ * Incoming MIDI in two steps, with no allocation and no printing.
+ *
+ * The read step pushes every pending message from both ports into a
+ * fixed ring of parsed events, so the port buffers are emptied each pass
+ * however dense the stream is. dispatch() then hands each event to the
+ * handler registered for its route (clock, transport, CCs, notes,
+ * SysEx). An event without a handler is only counted.
+ *
+ * If the ring is full, new events are dropped and counted; at
+ * MIDI_IN_QUEUE_SIZE per pass that takes far more than both ports can
+ * deliver in a millisecond.
+ */
+class MidiInputRouter {
+public:
+    MidiInputRouter() {
+        for (uint8_t r = 0; r < MIDI_ROUTE_COUNT; r++) {
+            _handlers[r] = nullptr;
+            _contexts[r] = nullptr;
+            _routed[r] = 0;
+        }
+        _head = _tail = 0;
+        resetStats();
+    }
+
+    void setRoute(MidiInRoute route, MidiInHandler handler, void* context) {
+        if (route >= MIDI_ROUTE_COUNT) return;
+        _handlers[route] = handler;
+        _contexts[route] = context;
+    }
+
+    static MidiInRoute routeOf(uint8_t status) {
+        switch (status < 0xF0 ? (status & 0xF0) : status) {
+            case 0x80:
+            case 0x90: return MIDI_ROUTE_NOTE;
+            case 0xB0: return MIDI_ROUTE_CC;
+            case 0xF8: return MIDI_ROUTE_CLOCK;
+            case 0xF2:
+            case 0xFA:
+            case 0xFB:
+            case 0xFC: return MIDI_ROUTE_TRANSPORT;
+            case 0xF0: return MIDI_ROUTE_SYSEX;
+            default:   return MIDI_ROUTE_OTHER;
+        }
+    }
+
+    /**
+     * Queue one message as the MIDI libraries report it: type (0x80..0xFF,
+     * no channel) and channel 1..16 for channel messages.
+     * @return false if the ring was full and the message was dropped
+     */
+    bool push(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2, MidiInSource source, uint32_t nowMicros) {
+        if (type < 0x80) return false;
+        if (static_cast<uint8_t>(_tail - _head) >= MIDI_IN_QUEUE_SIZE) {
+            _dropped++;
+            return false;
+        }
+        MidiInEvent& e = _events[_tail & (MIDI_IN_QUEUE_SIZE - 1)];
+        e.status = type < 0xF0 ? static_cast<uint8_t>((type & 0xF0) | ((channel - 1) & 0x0F)) : type;
+        e.data1 = data1;
+        e.data2 = data2;
+        e.source = source;
+        e.timestamp = nowMicros;
+        _tail++;
+        _received++;
+        uint8_t backlog = static_cast<uint8_t>(_tail - _head);
+        if (backlog > _maxBacklog) _maxBacklog = backlog;
+        return true;
+    }
+
+    /**
+     * Hand every queued event to its route's handler, oldest first.
+     * @return events dispatched
+     */
+    uint16_t dispatch() {
+        uint16_t count = 0;
+        while (_head != _tail) {
+            const MidiInEvent& e = _events[_head & (MIDI_IN_QUEUE_SIZE - 1)];
+            MidiInRoute route = routeOf(e.status);
+            _routed[route]++;
+            if (_handlers[route]) {
+                _handlers[route](_contexts[route], e);
+            } else {
+                _ignored++;
+            }
+            _head++;
+            count++;
+        }
+        return count;
+    }
+
+    uint8_t backlog() const { return static_cast<uint8_t>(_tail - _head); }
+    uint8_t maxBacklog() const { return _maxBacklog; }
+    uint32_t received() const { return _received; }
+    uint32_t dropped() const { return _dropped; }
+    uint32_t ignored() const { return _ignored; }   // No handler for the route
+    uint32_t routed(MidiInRoute route) const { return route < MIDI_ROUTE_COUNT ? _routed[route] : 0; }
+    void resetStats() {
+        _received = _dropped = _ignored = 0;
+        _maxBacklog = backlog();
+        for (uint8_t r = 0; r < MIDI_ROUTE_COUNT; r++) _routed[r] = 0;
+    }
+
+private:
+    MidiInEvent _events[MIDI_IN_QUEUE_SIZE];
+    uint8_t _head, _tail;
+    MidiInHandler _handlers[MIDI_ROUTE_COUNT];
+    void* _contexts[MIDI_ROUTE_COUNT];
+    uint32_t _routed[MIDI_ROUTE_COUNT];
+    uint32_t _received, _dropped, _ignored;
+    uint8_t _maxBacklog;
+};
+
+#endif // MIDI_INPUT_ROUTER_H
@@ -0,0 +1,218 @@
+#ifndef MIDI_OUT_QUEUE_H
+#define MIDI_OUT_QUEUE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define MIDI_OUT_CC_QUEUE_SIZE 256     // Distinct (channel, CC) pairs waiting; power of two
+#define MIDI_OUT_MESSAGE_QUEUE_SIZE 32 // Notes and other messages that never merge; power of two
+
+struct MidiOutMessage {
+    uint8_t status;      // Status byte, channel included
+    uint8_t data1;
+    uint8_t data2;
+    uint8_t size;        // Bytes on the wire (1..3)
+    uint32_t queuedAt;   // micros() when it started waiting
+};
+
+/**
+ * Outbound MIDI for one transport, with latest-value-wins control changes.
+ *
+ * Every (channel, CC) has one pending value at most. A newer value
+ * overwrites the pending one in place and keeps its place in line, so a
+ * busy knob can't crowd out the others: pairs go out round-robin, in the
+ * order they first became pending. Under any load the queue holds at
+ * most one entry per pair in use, and the worst wait is that many
+ * messages at the line rate.
+ *
+ * Notes (and anything else where every message counts) go through a
+ * small FIFO that is never merged and drains ahead of the CCs.
+ *
+ * The queue doesn't pace anything itself: whatever takes messages off it
+ * does. On DIN that is MidiDinTransmitter, which only pulls what fits in
+ * the UART's TX buffer; USB drains it all into packets.
+ */
+class MidiOutQueue {
+public:
+    MidiOutQueue() { clear(); }
+
+    void clear() {
+        memset(_pending, 0, sizeof(_pending));
+        memset(_messages, 0, sizeof(_messages));
+        _ccHead = _ccTail = 0;
+        _messageHead = _messageTail = 0;
+        _sent = _merged = _dropped = 0;
+        _maxDepth = 0;
+    }
+
+    /**
+     * Queue a control change (channel 1..16). If the pair is already
+     * waiting, only its value changes.
+     */
+    void pushControlChange(uint8_t control, uint8_t value, uint8_t channel, uint32_t nowMicros) {
+        if (control > 127 || value > 127 || channel < 1 || channel > 16) return;
+        uint16_t key = static_cast<uint16_t>((channel - 1) << 7 | control);
+        if (_pending[key] & PENDING) {
+            _pending[key] = PENDING | value;
+            _merged++;
+            return;
+        }
+        if (static_cast<uint16_t>(_ccTail - _ccHead) >= MIDI_OUT_CC_QUEUE_SIZE) {
+            _dropped++;
+            return;
+        }
+        _pending[key] = PENDING | value;
+        CcEntry& entry = _cc[_ccTail & (MIDI_OUT_CC_QUEUE_SIZE - 1)];
+        entry.key = key;
+        entry.queuedAt = nowMicros;
+        _ccTail++;
+        noteDepth();
+    }
+
+    /**
+     * Queue a message that must not be merged (Note On/Off, ...).
+     * @return false if the FIFO was full and the message was dropped
+     */
+    bool pushMessage(uint8_t status, uint8_t data1, uint8_t data2, uint8_t size, uint32_t nowMicros) {
+        if (static_cast<uint8_t>(_messageTail - _messageHead) >= MIDI_OUT_MESSAGE_QUEUE_SIZE) {
+            _dropped++;
+            return false;
+        }
+        MidiOutMessage& m = _messages[_messageTail & (MIDI_OUT_MESSAGE_QUEUE_SIZE - 1)];
+        m.status = status;
+        m.data1 = data1;
+        m.data2 = data2;
+        m.size = size;
+        m.queuedAt = nowMicros;
+        _messageTail++;
+        noteDepth();
+        return true;
+    }
+
+    /**
+     * Hand every waiting message to `send(const MidiOutMessage&)`.
+     * @return messages sent
+     */
+    template <typename Sink>
+    uint16_t drain(Sink&& send) {
+        uint16_t count = 0;
+        MidiOutMessage m;
+        while (peek(m)) {
+            pop();
+            send(m);
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * The message drain() would send next, for callers that only take as
+     * much as their port has room for (the DIN transmitter). pop() it once
+     * it is on its way.
+     */
+    bool peek(MidiOutMessage& m) const {
+        if (_messageHead != _messageTail) {
+            m = _messages[_messageHead & (MIDI_OUT_MESSAGE_QUEUE_SIZE - 1)];
+            return true;
+        }
+        if (_ccHead == _ccTail) return false;
+        const CcEntry& entry = _cc[_ccHead & (MIDI_OUT_CC_QUEUE_SIZE - 1)];
+        m.status = static_cast<uint8_t>(0xB0 | (entry.key >> 7));
+        m.data1 = static_cast<uint8_t>(entry.key & 0x7F);
+        m.data2 = static_cast<uint8_t>(_pending[entry.key] & 0x7F);
+        m.size = 3;
+        m.queuedAt = entry.queuedAt;
+        return true;
+    }
+
+    void pop() {
+        if (_messageHead != _messageTail) {
+            _messageHead++;
+        } else if (_ccHead != _ccTail) {
+            _pending[_cc[_ccHead & (MIDI_OUT_CC_QUEUE_SIZE - 1)].key] = 0;
+            _ccHead++;
+        } else {
+            return;
+        }
+        _sent++;
+    }
+
+    uint16_t depth() const {
+        return static_cast<uint16_t>(_ccTail - _ccHead) + static_cast<uint8_t>(_messageTail - _messageHead);
+    }
+    uint16_t maxDepth() const { return _maxDepth; }
+    uint32_t sent() const { return _sent; }
+    uint32_t merged() const { return _merged; }     // CCs overwritten before they went out
+    uint32_t dropped() const { return _dropped; }   // Only when a queue is full
+    void resetStats() { _sent = _merged = _dropped = 0; _maxDepth = depth(); }
+
+private:
+    static const uint8_t PENDING = 0x80;   // Flag on a _pending entry; the low 7 bits are the value
+
+    struct CcEntry {
+        uint16_t key;        // (channel - 1) << 7 | control
+        uint32_t queuedAt;
+    };
+
+    uint8_t _pending[16 * 128];
+    CcEntry _cc[MIDI_OUT_CC_QUEUE_SIZE];
+    uint16_t _ccHead, _ccTail;
+    MidiOutMessage _messages[MIDI_OUT_MESSAGE_QUEUE_SIZE];
+    uint8_t _messageHead, _messageTail;
+
+    uint32_t _sent, _merged, _dropped;
+    uint16_t _maxDepth;
+
+    void noteDepth() {
+        uint16_t d = depth();
+        if (d > _maxDepth) _maxDepth = d;
+    }
+};
+
+/**
+ * Traffic counters for one transport: running totals, plus bytes and
+ * messages per second over the last full one-second window.
+ */
+class MidiRateMeter {
+public:
+    MidiRateMeter() { reset(0); }
+
+    void reset(uint32_t nowMicros) {
+        _bytes = _messages = 0;
+        _windowBytes = _windowMessages = 0;
+        _bytesPerSecond = _messagesPerSecond = _peakBytesPerSecond = 0;
+        _windowStart = nowMicros;
+    }
+
+    void add(uint16_t bytes, uint16_t messages) {
+        _bytes += bytes;
+        _messages += messages;
+        _windowBytes += bytes;
+        _windowMessages += messages;
+    }
+
+    // Closes the window once a second has passed; call every tick
+    void update(uint32_t nowMicros) {
+        uint32_t elapsed = nowMicros - _windowStart;
+        if (elapsed < 1000000UL) return;
+        _bytesPerSecond = static_cast<uint32_t>(static_cast<uint64_t>(_windowBytes) * 1000000UL / elapsed);
+        _messagesPerSecond = static_cast<uint32_t>(static_cast<uint64_t>(_windowMessages) * 1000000UL / elapsed);
+        if (_bytesPerSecond > _peakBytesPerSecond) _peakBytesPerSecond = _bytesPerSecond;
+        _windowBytes = _windowMessages = 0;
+        _windowStart = nowMicros;
+    }
+
+    uint32_t bytes() const { return _bytes; }
+    uint32_t messages() const { return _messages; }
+    uint32_t bytesPerSecond() const { return _bytesPerSecond; }
+    uint32_t messagesPerSecond() const { return _messagesPerSecond; }
+    uint32_t peakBytesPerSecond() const { return _peakBytesPerSecond; }
+
+private:
+    uint32_t _bytes, _messages;
+    uint32_t _windowBytes, _windowMessages;
+    uint32_t _bytesPerSecond, _messagesPerSecond, _peakBytesPerSecond;
+    uint32_t _windowStart;
+};
+
+#endif // MIDI_OUT_QUEUE_H
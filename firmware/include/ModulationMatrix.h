@@ -0,0 +1,205 @@
+#ifndef MODULATION_MATRIX_H
+#define MODULATION_MATRIX_H
+
+#include <stdint.h>
+#include <string.h>
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#endif
+
+#define MOD_DEPTH_SHIFT 6                      // Depth is signed Q6 fixed point
+#define MOD_DEPTH_FULL (1 << MOD_DEPTH_SHIFT)  // 64 = 100%: the EF level added as is
+#define MOD_BIPOLAR_CENTER 64                  // A bipolar source swings around this level
+
+/**
+ * Which envelope followers modulate which slot, and by how much: a dense
+ * NumSlots x NumSources grid of signed depths, plus a per-slot offset.
+ *
+ *   amount[slot] = offset + sum over EFs of depth * level / MOD_DEPTH_FULL
+ *
+ * Depth is int8 Q6 (-128..127 = -200%..+198%), so a slot can blend any
+ * number of EFs, and a negative depth modulates downwards. A cell marked
+ * bipolar reads the EF level as (level - MOD_BIPOLAR_CENTER) so it swings
+ * the slot both ways. That part is constant per cell, so it folds into a
+ * per-slot bias whenever a setting changes, and process() is one plain
+ * matrix-vector product over every slot, whatever is routed.
+ *
+ * Rows are int16 and padded to an even length; where the DSP extension
+ * exists each pair of cells is one SMLAD (dual 16-bit multiply-accumulate).
+ * Without it the same code builds natively as a scalar loop.
+ */
+template <uint8_t NumSlots, uint8_t NumSources>
+class ModulationMatrix {
+    static_assert(NumSources <= 8, "bipolar flags are one byte per slot");
+
+public:
+    // Flat image for EEPROM: depths row by row, then offsets, then bipolar masks
+    static const uint16_t BYTES = NumSlots * (NumSources + 2);
+
+    ModulationMatrix() { clear(); }
+
+    void clear() {
+        memset(_depth, 0, sizeof(_depth));
+        memset(_offset, 0, sizeof(_offset));
+        memset(_bipolar, 0, sizeof(_bipolar));
+        memset(_row, 0, sizeof(_row));
+        memset(_bias, 0, sizeof(_bias));
+        memset(_amount, 0, sizeof(_amount));
+    }
+
+    // --- Settings ---
+
+    void setDepth(uint8_t slot, uint8_t source, int8_t depth) {
+        if (slot >= NumSlots || source >= NumSources) return;
+        _depth[slot][source] = depth;
+        updateBias(slot);
+    }
+    int8_t depth(uint8_t slot, uint8_t source) const {
+        return (slot < NumSlots && source < NumSources) ? static_cast<int8_t>(_depth[slot][source]) : 0;
+    }
+
+    // Added to the slot's modulation whatever the EFs do (CC units)
+    void setOffset(uint8_t slot, int8_t offset) {
+        if (slot >= NumSlots) return;
+        _offset[slot] = offset;
+        updateBias(slot);
+    }
+    int8_t offset(uint8_t slot) const { return slot < NumSlots ? _offset[slot] : 0; }
+
+    void setBipolar(uint8_t slot, uint8_t source, bool bipolar) {
+        if (slot >= NumSlots || source >= NumSources) return;
+        if (bipolar) {
+            _bipolar[slot] |= (1u << source);
+        } else {
+            _bipolar[slot] &= ~(1u << source);
+        }
+        updateBias(slot);
+    }
+    bool bipolar(uint8_t slot, uint8_t source) const {
+        return slot < NumSlots && source < NumSources && (_bipolar[slot] & (1u << source));
+    }
+
+    // Nothing modulates the slot
+    void clearSlot(uint8_t slot) {
+        if (slot >= NumSlots) return;
+        memset(_depth[slot], 0, sizeof(_depth[slot]));
+        _offset[slot] = 0;
+        _bipolar[slot] = 0;
+        updateBias(slot);
+    }
+
+    // Just `source`, unipolar at full depth (what the slot buttons assign)
+    void route(uint8_t slot, uint8_t source) {
+        if (slot >= NumSlots || source >= NumSources) return;
+        clearSlot(slot);
+        setDepth(slot, source, MOD_DEPTH_FULL);
+    }
+
+    // Anything at all modulates the slot
+    bool routed(uint8_t slot) const {
+        if (slot >= NumSlots) return false;
+        if (_offset[slot]) return true;
+        for (uint8_t j = 0; j < NumSources; j++) {
+            if (_depth[slot][j]) return true;
+        }
+        return false;
+    }
+
+    // The EF with the largest |depth| on a slot (what the slot buttons edit), or -1
+    int primarySource(uint8_t slot) const {
+        if (slot >= NumSlots) return -1;
+        int best = -1;
+        int bestDepth = 0;
+        for (uint8_t j = 0; j < NumSources; j++) {
+            int d = _depth[slot][j] < 0 ? -_depth[slot][j] : _depth[slot][j];
+            if (d > bestDepth) {
+                best = j;
+                bestDepth = d;
+            }
+        }
+        return best;
+    }
+
+    // --- Processing ---
+
+    /**
+     * Compute every slot's modulation from one set of EF levels
+     * (NumSources entries, 0..127).
+     */
+    void process(const int* levels) {
+        int16_t level[ROW] __attribute__((aligned(4)));
+        for (uint8_t j = 0; j < ROW; j++) {
+            int x = j < NumSources ? levels[j] : 0;
+            level[j] = static_cast<int16_t>(x < 0 ? 0 : (x > 127 ? 127 : x));
+        }
+        for (uint8_t s = 0; s < NumSlots; s++) {
+            int32_t acc = _bias[s];
+            const int16_t* row = _row[s];
+            for (uint8_t j = 0; j < ROW; j += 2) {
+#if defined(__ARM_FEATURE_DSP)
+                uint32_t d, x;
+                memcpy(&d, row + j, sizeof(d));
+                memcpy(&x, level + j, sizeof(x));
+                acc = __smlad(d, x, acc);
+#else
+                acc += row[j] * level[j] + row[j + 1] * level[j + 1];
+#endif
+            }
+            _amount[s] = (acc + (MOD_DEPTH_FULL / 2)) >> MOD_DEPTH_SHIFT;
+        }
+    }
+
+    // Signed modulation for a slot from the last process() (CC units)
+    int amount(uint8_t slot) const { return slot < NumSlots ? _amount[slot] : 0; }
+
+    // The slot's base value (0..127) with its modulation applied
+    uint8_t apply(uint8_t slot, int base) const {
+        int value = base + amount(slot);
+        return static_cast<uint8_t>(value < 0 ? 0 : (value > 127 ? 127 : value));
+    }
+
+    // --- Persistence ---
+
+    void serialize(uint8_t* out) const {
+        for (uint8_t s = 0; s < NumSlots; s++) {
+            for (uint8_t j = 0; j < NumSources; j++) *out++ = static_cast<uint8_t>(_depth[s][j]);
+        }
+        for (uint8_t s = 0; s < NumSlots; s++) *out++ = static_cast<uint8_t>(_offset[s]);
+        for (uint8_t s = 0; s < NumSlots; s++) *out++ = _bipolar[s];
+    }
+
+    void deserialize(const uint8_t* in) {
+        for (uint8_t s = 0; s < NumSlots; s++) {
+            for (uint8_t j = 0; j < NumSources; j++) _depth[s][j] = static_cast<int8_t>(*in++);
+        }
+        for (uint8_t s = 0; s < NumSlots; s++) _offset[s] = static_cast<int8_t>(*in++);
+        for (uint8_t s = 0; s < NumSlots; s++) _bipolar[s] = *in++ & SOURCE_MASK;
+        for (uint8_t s = 0; s < NumSlots; s++) updateBias(s);
+    }
+
+private:
+    static const uint8_t ROW = (NumSources + 1) & ~1;   // Padded for pairwise MACs
+    static const uint8_t SOURCE_MASK = static_cast<uint8_t>((1u << NumSources) - 1);
+
+    // Settings
+    int8_t _depth[NumSlots][NumSources];
+    int8_t _offset[NumSlots];
+    uint8_t _bipolar[NumSlots];
+
+    // Hot-path data
+    int16_t _row[NumSlots][ROW] __attribute__((aligned(4)));   // Depths, zero-padded
+    int32_t _bias[NumSlots];       // Offset and bipolar centering, pre-scaled by MOD_DEPTH_FULL
+    int16_t _amount[NumSlots];
+
+    void updateBias(uint8_t slot) {
+        int32_t bias = static_cast<int32_t>(_offset[slot]) * MOD_DEPTH_FULL;
+        for (uint8_t j = 0; j < ROW; j++) {
+            int16_t d = j < NumSources ? _depth[slot][j] : 0;
+            _row[slot][j] = d;
+            if (j < NumSources && (_bipolar[slot] & (1u << j))) bias -= d * MOD_BIPOLAR_CENTER;
+        }
+        _bias[slot] = bias;
+    }
+};
+
+#endif // MODULATION_MATRIX_H
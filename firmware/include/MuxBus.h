@@ -0,0 +1,87 @@
+#ifndef MUX_BUS_H
+#define MUX_BUS_H
+
+#include <Arduino.h>
+#include "MuxScanner.h"
+
+#define PRIMARY_MUX_PINS 3
+#define SECONDARY_MUX_PINS 3
+#define MUX_BUS_ADDRESSES 42   // Pots and virtual buttons share these addresses
+#define MUX_BUS_BUDGET_US 100  // Default scan time per service() call
+
+/**
+ * Analog outputs sampled at every mux address.
+ */
+enum MuxBusChannel : uint8_t {
+    MUX_CHANNEL_POTS,
+    MUX_CHANNEL_BUTTONS,
+    MUX_CHANNEL_COUNT
+};
+
+/**
+ * Mux select lines plus non-blocking conversions on ADC1 for MuxScanner.
+ * Only select lines whose bit changed are written.
+ */
+struct MuxBusHal {
+    const uint8_t* primaryPins;
+    const uint8_t* secondaryPins;
+    uint8_t adcChannels[MUX_CHANNEL_COUNT];
+    uint8_t lastAddress;   // 0xFF until the first select
+
+    void select(uint8_t address) {
+        uint8_t changed = (lastAddress == 0xFF) ? 0xFF : (address ^ lastAddress);
+        for (int i = 0; i < SECONDARY_MUX_PINS; i++) {
+            if (changed & (1 << i)) {
+                digitalWrite(secondaryPins[i], (address >> i) & 1);
+            }
+        }
+        for (int i = 0; i < PRIMARY_MUX_PINS; i++) {
+            if (changed & (1 << (SECONDARY_MUX_PINS + i))) {
+                digitalWrite(primaryPins[i], (address >> (SECONDARY_MUX_PINS + i)) & 1);
+            }
+        }
+        lastAddress = address;
+    }
+    void startConversion(uint8_t channel) { ADC1_HC0 = adcChannels[channel]; }
+    bool conversionDone() { return ADC1_HS & ADC_HS_COCO0; }
+    uint16_t conversionResult() { return ADC1_R0; }
+    uint32_t micros() { return ::micros(); }
+};
+
+/**
+ * Owns the shared mux select lines. Each address is selected once per sweep
+ * and both the pot and button outputs are converted there; PotentiometerManager
+ * and ButtonManager read the results instead of driving the lines themselves.
+ */
+class MuxBus {
+public:
+    MuxBus(const uint8_t* primaryPins, const uint8_t* secondaryPins,
+           uint8_t potAnalogPin, uint8_t buttonAnalogPin);
+
+    // Configure select lines as outputs and the mux outputs as inputs
+    void begin();
+
+    // Advance the sweep for up to budgetMicros (see MuxScanner::service)
+    uint8_t service(uint32_t budgetMicros);
+
+    // Called after each address with the readings of every channel
+    void setSampleCallback(MuxSampleCallback callback, void* context);
+
+    // Latest reading from the sweep
+    uint16_t read(MuxBusChannel channel, uint8_t address) const;
+    uint32_t fullScans() const;
+
+    // Select, settle and read right now. For bench tests that poll one input.
+    int readBlocking(MuxBusChannel channel, uint8_t address);
+
+    // analogRead() of an ADC1 pin off the mux (the filter pots). Use this, not
+    // analogRead(), from the main loop: the sweep may have a conversion in flight.
+    int readPin(uint8_t pin);
+
+private:
+    MuxBusHal _hal;
+    MuxScanner<MuxBusHal, MUX_BUS_ADDRESSES, MUX_CHANNEL_COUNT> _scanner;
+    const uint8_t _analogPins[MUX_CHANNEL_COUNT];
+};
+
+#endif // MUX_BUS_H
@@ -0,0 +1,212 @@
+#ifndef MUX_SCANNER_H
+#define MUX_SCANNER_H
+
+#include <stdint.h>
+
+// Defaults for the 8x8 mux tree
+#define MUX_SCAN_SAMPLES_PER_ADDRESS 4   // Back-to-back conversions averaged per address
+#define MUX_SCAN_SETTLE_US 10            // Time the mux output needs after a select change
+#define MUX_SCAN_SAMPLE_WINDOW_US 2      // ADC sample-and-hold window after a conversion starts
+
+/**
+ * Called once per address with the averaged reading of every channel.
+ */
+typedef void (*MuxSampleCallback)(void* context, uint8_t address, const uint16_t* values);
+
+/**
+ * Incremental, non-blocking scan engine for one or more analog inputs that
+ * share the same mux select lines.
+ *
+ * The scan is a small state machine (settling, converting) that service()
+ * steps until its microsecond budget is spent, so loop() is never blocked
+ * for a full 42-address sweep. No step waits: a settle that ends after the
+ * budget makes service() return at once, and a conversion still running when
+ * the budget runs out is left in flight and collected on the next call.
+ * Within the budget, service() keeps polling rather than sleeping. Anything
+ * else that converts on the same ADC must call abortConversion() first.
+ *
+ * Each address is selected once and every channel (e.g. the pot and button
+ * mux outputs) is converted while it is selected. The latest reading per
+ * channel and address is kept in a snapshot array.
+ *
+ * The scan is pipelined: as soon as the last conversion at address N has
+ * passed its sample-and-hold window, the mux is switched to address N+1.
+ * N+1's settle time then overlaps N's conversion and the sample callback.
+ *
+ * Hal must provide:
+ *   void     select(uint8_t address);          // drive the mux select lines
+ *   void     startConversion(uint8_t channel); // start an ADC conversion of one mux output
+ *   bool     conversionDone();                 // true once the result is ready
+ *   uint16_t conversionResult();               // read (and clear) the result
+ *   uint32_t micros();                         // free-running microsecond clock
+ */
+template <typename Hal, uint8_t NumAddresses, uint8_t NumChannels = 1>
+class MuxScanner {
+public:
+    MuxScanner(Hal& hal,
+               uint16_t settleMicros = MUX_SCAN_SETTLE_US,
+               uint16_t sampleWindowMicros = MUX_SCAN_SAMPLE_WINDOW_US)
+        : _hal(hal),
+          _settleMicros(settleMicros),
+          _sampleWindowMicros(sampleWindowMicros) {
+        for (uint8_t c = 0; c < NumChannels; c++) {
+            _samples[c] = MUX_SCAN_SAMPLES_PER_ADDRESS;
+            for (uint8_t a = 0; a < NumAddresses; a++) _values[c][a] = 0;
+        }
+    }
+
+    void setCallback(MuxSampleCallback callback, void* context) {
+        _callback = callback;
+        _context = context;
+    }
+
+    // Conversions averaged per address for one channel (e.g. 1 for a button threshold)
+    void setSamples(uint8_t channel, uint8_t samples) {
+        if (channel < NumChannels) _samples[channel] = samples ? samples : 1;
+    }
+
+    /**
+     * Call after something else has moved the select lines; the current
+     * address is re-selected (and re-settled) on the next service() call.
+     */
+    void invalidateSelect() { _selected = false; }
+
+    /**
+     * Call after something else has used the ADC (an analogRead() on another
+     * pin). Its result cleared ours, so the conversion in flight is dropped and
+     * the current address starts over, re-selected, on the next service() call.
+     */
+    void abortConversion() {
+        _phase = PHASE_SETTLING;
+        _selected = false;
+    }
+
+    /**
+     * Advance the scan.
+     * @param budgetMicros Time allowed for this call. The budget is checked
+     *                     between steps, so a call runs over it by at most
+     *                     one step (a conversion start, a result, a callback).
+     * @return Number of addresses completed during this call
+     */
+    uint8_t service(uint32_t budgetMicros) {
+        const uint32_t start = _hal.micros();
+        uint8_t completed = 0;
+
+        if (!_selected) {
+            // Whatever was in flight belonged to the old select; start this address over
+            selectAddress(_address);
+            _phase = PHASE_SETTLING;
+        }
+
+        for (;;) {
+            // Waits are strict (>) because micros() can tick just after a timestamp
+            uint32_t now = _hal.micros();
+            uint32_t elapsed = now - start;
+            if (elapsed >= budgetMicros) break;
+
+            if (_phase == PHASE_SETTLING) {
+                uint32_t settled = now - _selectedAt;
+                if (settled <= _settleMicros) {
+                    // Not settled: poll on only if it settles inside this call
+                    if (_settleMicros + 1 - settled > budgetMicros - elapsed) break;
+                    continue;
+                }
+                _channel = 0;
+                _sample = 0;
+                _sum = 0;
+                _nextSelected = false;
+                startConversion();
+                _phase = PHASE_CONVERTING;
+                continue;
+            }
+
+            // PHASE_CONVERTING
+            uint8_t next = (_address + 1 < NumAddresses) ? _address + 1 : 0;
+            bool last = _channel + 1 == NumChannels && _sample + 1 == _samples[_channel];
+            if (last && !_nextSelected && static_cast<uint32_t>(now - _conversionAt) > _sampleWindowMicros) {
+                // Last conversion here and the input is held: start settling the next address
+                selectAddress(next);
+                _nextSelected = true;
+            }
+            if (!_hal.conversionDone()) continue;   // Still in flight; may be picked up next call
+            if (last && !_nextSelected) continue;   // Switch first: the next address settles while we finish here
+            _sum += _hal.conversionResult();
+
+            if (++_sample < _samples[_channel]) {
+                startConversion();
+                continue;
+            }
+            _values[_channel][_address] = static_cast<uint16_t>(_sum / _samples[_channel]);
+            _sum = 0;
+            _sample = 0;
+            if (++_channel < NumChannels) {
+                startConversion();
+                continue;
+            }
+
+            // Address done; the next one is already settling
+            uint8_t current = _address;
+            _address = next;
+            _phase = PHASE_SETTLING;
+            if (next == 0) _fullScans++;
+            completed++;
+
+            if (_callback) {
+                uint16_t values[NumChannels];
+                for (uint8_t c = 0; c < NumChannels; c++) values[c] = _values[c][current];
+                _callback(_context, current, values);
+            }
+        }
+        return completed;
+    }
+
+    // Latest averaged reading for one channel at one address
+    uint16_t value(uint8_t channel, uint8_t address) const {
+        return (channel < NumChannels && address < NumAddresses) ? _values[channel][address] : 0;
+    }
+
+    uint8_t currentAddress() const { return _address; }
+    uint32_t fullScans() const { return _fullScans; }
+
+private:
+    Hal& _hal;
+    const uint16_t _settleMicros;
+    const uint16_t _sampleWindowMicros;
+
+    MuxSampleCallback _callback = nullptr;
+    void* _context = nullptr;
+
+    uint8_t _samples[NumChannels];
+    uint16_t _values[NumChannels][NumAddresses];
+
+    enum Phase : uint8_t {
+        PHASE_SETTLING,     // Address selected, waiting out the settle time
+        PHASE_CONVERTING    // A conversion of _channel is in flight
+    };
+
+    uint8_t _address = 0;
+    bool _selected = false;
+    uint32_t _selectedAt = 0;
+    uint32_t _fullScans = 0;
+
+    // Where the scan stopped, so the next service() call carries on from there
+    Phase _phase = PHASE_SETTLING;
+    uint8_t _channel = 0;
+    uint8_t _sample = 0;
+    uint32_t _sum = 0;
+    uint32_t _conversionAt = 0;
+    bool _nextSelected = false;   // Last conversion held, next address already selected
+
+    void selectAddress(uint8_t address) {
+        _hal.select(address);
+        _selectedAt = _hal.micros();
+        _selected = true;
+    }
+
+    void startConversion() {
+        _hal.startConversion(_channel);
+        _conversionAt = _hal.micros();
+    }
+};
+
+#endif // MUX_SCANNER_H
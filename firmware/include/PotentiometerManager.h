@@ -7,44 +7,42 @@
 #include "LEDManager.h"
 #include "Utility.h"
 #include "ConfigManager.h"
+#include "MuxBus.h"
 
-// Forward declaration to avoid circular dependency
+// Forward declarations to avoid circular dependency
 class EnvelopeFollower;
+class ConfigManager;   // ConfigManager.h reaches this header through Globals.h
 
 #define NUM_POTS 42
-#define PRIMARY_MUX_PINS 3
-#define SECONDARY_MUX_PINS 3
+#define POT_SCAN_BUDGET_US MUX_BUS_BUDGET_US // Time processPots() may spend scanning per call
 
 class PotentiometerManager {
 private:
-    const uint8_t* primaryMuxPins;   // Pins for primary mux bank
-    const uint8_t* secondaryMuxPins; // Pins for secondary mux bank
-    const uint8_t analogPin;         // Analog pin for mux output
-    uint8_t potChannels[NUM_POTS];   // MIDI channel for each pot
-    uint8_t potCCNumbers[NUM_POTS];  // MIDI CC number for each pot
+    MuxBus* muxBus;                  // Shared mux scan (also feeds ButtonManager)
+    ConfigManager* configManager;    // Channel + CC each pot sends on (the map incoming CCs are looked up in)
     int potLastValues[NUM_POTS];     // Last read values for each pot
+    uint64_t takeoverArmed;          // Value set over MIDI; the knob is ignored until it gets there
+    uint64_t takeoverFromBelow;      // ...and it was below that value when armed
 
-    void selectMuxBank(uint8_t bank); // Select the primary mux bank
-    void selectPotBank(uint8_t pot);  // Select the secondary mux pot
+    // Incremental mux scan, a few addresses per processPots() call
+    uint32_t scanBudgetMicros;
+    LEDManager* scanLedManager;      // Valid only while processPots() runs
+
+    static void onMuxSample(void* context, uint8_t address, const uint16_t* values);
+    void handlePotSample(uint8_t potIndex, int rawValue);
 
     // Callback for sending MIDI messages
     std::function<void(uint8_t, uint8_t, uint8_t)> midiCallback;
 
-    // Helper for filtered analog reads
-    int readAnalogFiltered(uint8_t pin); // New function for analog filtering
-
     int argEnvA;
     int argEnvB;
 
 public:
-    PotentiometerManager(
-        const uint8_t* primaryPins, 
-        const uint8_t* secondaryPins, 
-        uint8_t analogPin
-    );
+    PotentiometerManager(MuxBus* muxBus, ConfigManager* configManager);
 
     void setMidiCallback(std::function<void(uint8_t, uint8_t, uint8_t)> callback);
 
+    // The pot mapping lives in ConfigManager; these load, save and reset it there
     void loadFromEEPROM();
     void saveToEEPROM();
     void resetEEPROM();
@@ -54,8 +52,19 @@ public:
     uint8_t getChannel(int potIndex);
     uint8_t getCCNumber(int potIndex);
 
-    // Updated to accept envelopes
-    void processPots(LEDManager& ledManager, std::vector<EnvelopeFollower>& envelopes);
+    /**
+     * An incoming CC for this pot (0..127) becomes its value. Soft takeover:
+     * the knob sends nothing until it passes that value, so it doesn't
+     * yank the parameter back to where the knob happens to be.
+     */
+    void takeOver(uint8_t potIndex, uint8_t midiValue);
+    bool isTakenOver(uint8_t potIndex) const { return potIndex < NUM_POTS && ((takeoverArmed >> potIndex) & 1); }
+
+    // Drives the shared mux sweep for at most the configured budget, then returns;
+    // the sweep resumes on the next call
+    void processPots(LEDManager& ledManager);
+    void setScanBudget(uint32_t micros);
+    uint32_t getFullScans() const;
 
     void setArgEnvelopePair(int a, int b);
     void getArgEnvelopePair(int &a, int &b) const;
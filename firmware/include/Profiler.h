@@ -0,0 +1,99 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+// Set to 0 to compile the profiler (and every PROFILE_SCOPE) out completely
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+/**
+ * One row in the profile table per scheduled task and per top-level loop() stage.
+ */
+enum ProfileSlot : uint8_t {
+    PROFILE_LOOP,            // Whole loop() pass
+    PROFILE_SERIAL_COMMANDS, // Command parsing at the top of loop()
+    PROFILE_SCHEDULER_HIGH,  // Utility::schedulerHigh.update()
+    PROFILE_SCHEDULER_MID,   // Utility::schedulerMid.update()
+    PROFILE_SCHEDULER_LOW,   // Utility::schedulerLow.update()
+    PROFILE_BUTTONS,         // buttonManager.processButtons()
+    PROFILE_POTS,            // potentiometerManager.processPots()
+    PROFILE_MIDI,            // processMIDI task
+    PROFILE_INTERNAL_CLOCK,  // processInternalClock task
+    PROFILE_SERIAL,          // processSerial task
+    PROFILE_ENVELOPES,       // processEnvelopes task
+    PROFILE_LEDS,            // LED update + filter tuning task
+    PROFILE_DISPLAY,         // OLED redraw task
+    PROFILE_BUTTON_EVENTS,   // Queued button gesture dispatch task
+    PROFILE_SLOT_COUNT
+};
+
+#if PROFILER_ENABLED
+
+// Histogram resolution: 4 buckets per octave of cycle counts, up to 2^24 cycles (~28ms)
+#define PROFILER_BUCKETS_PER_OCTAVE 4
+#define PROFILER_OCTAVES 24
+#define PROFILER_NUM_BUCKETS (PROFILER_BUCKETS_PER_OCTAVE * PROFILER_OCTAVES)
+
+/**
+ * Timing statistics for one slot, all in CPU cycles.
+ */
+struct ProfileStats {
+    uint32_t count = 0;
+    uint64_t totalCycles = 0;
+    uint32_t minCycles = 0xFFFFFFFF;
+    uint32_t maxCycles = 0;
+    uint32_t overruns = 0;       // Samples longer than budgetCycles
+    uint32_t budgetCycles = 0;   // 0 = no budget
+    uint32_t histogram[PROFILER_NUM_BUCKETS] = {0};
+};
+
+/**
+ * Fixed-size cycle-count profiler backed by the ARM DWT cycle counter.
+ */
+class Profiler {
+public:
+    // Enable the DWT cycle counter and clear all statistics
+    static void begin();
+    static void reset();
+
+    // Samples longer than the budget count as overruns
+    static void setBudgetMicros(ProfileSlot slot, uint32_t micros);
+
+    static inline uint32_t cycles() { return ARM_DWT_CYCCNT; }
+    static void record(ProfileSlot slot, uint32_t elapsedCycles);
+
+    // Human-readable table, or a compact binary frame (see Profiler.cpp for layout)
+    static void printReport(Print& out);
+    static void writeBinaryReport(Print& out);
+
+    static uint32_t percentileCycles(ProfileSlot slot, uint8_t percent);
+
+private:
+    static ProfileStats _stats[PROFILE_SLOT_COUNT];
+};
+
+/**
+ * Samples the cycle counter on construction and records the elapsed cycles on destruction.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileSlot slot) : _slot(slot), _start(Profiler::cycles()) {}
+    ~ProfileScope() { Profiler::record(_slot, Profiler::cycles() - _start); }
+private:
+    ProfileSlot _slot;
+    uint32_t _start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(slot) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(slot)
+
+#else
+
+#define PROFILE_SCOPE(slot) ((void)0)
+
+#endif // PROFILER_ENABLED
+
+#endif // PROFILER_H
@@ -0,0 +1,109 @@
+#ifndef RESPONSE_CURVE_H
+#define RESPONSE_CURVE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CURVE_SIZE 128          // One entry per envelope level (0..127)
+#define CURVE_BREAKPOINTS 17    // Custom curves: a point every 8 levels, the last at 127
+#define CURVE_BREAKPOINT_SPACING 8
+
+enum CurveType : uint8_t {
+    CURVE_LINEAR,
+    CURVE_INVERTED,
+    CURVE_EXPONENTIAL,   // x^2: quiet stays quiet
+    CURVE_LOGARITHMIC,   // log10(1 + 9x): opens up early
+    CURVE_S_CURVE,       // smoothstep: soft at both ends
+    CURVE_CUSTOM,        // Interpolated from CURVE_BREAKPOINTS points (SET_CURVE)
+    CURVE_COUNT
+};
+
+static const char* const CURVE_NAMES[CURVE_COUNT] = {
+    "LINEAR", "INVERTED", "EXPONENTIAL", "LOGARITHMIC", "S_CURVE", "CUSTOM"
+};
+
+// Level at custom breakpoint k
+static inline uint8_t curveBreakpointLevel(uint8_t k) {
+    uint8_t level = k * CURVE_BREAKPOINT_SPACING;
+    return level > CURVE_SIZE - 1 ? CURVE_SIZE - 1 : level;
+}
+
+/**
+ * Breakpoints of the straight line, the default custom curve.
+ */
+static inline void linearBreakpoints(uint8_t* points) {
+    for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) points[k] = curveBreakpointLevel(k);
+}
+
+/**
+ * Fill a CURVE_SIZE response table (level in -> level out, both 0..127).
+ * `breakpoints` (CURVE_BREAKPOINTS entries) is only read for CURVE_CUSTOM.
+ */
+static inline void buildCurve(CurveType type, uint8_t* table, const uint8_t* breakpoints = nullptr) {
+    for (uint8_t x = 0; x < CURVE_SIZE; x++) {
+        float t = x / 127.0f;
+        int y;
+        switch (type) {
+            case CURVE_INVERTED:
+                y = 127 - x;
+                break;
+            case CURVE_EXPONENTIAL:
+                y = (x * x) / 127;   // Truncates like the old pow(level / 127.0, 2) * 127
+                break;
+            case CURVE_LOGARITHMIC:
+                y = static_cast<int>(127.0f * log10f(1.0f + 9.0f * t) + 0.5f);
+                break;
+            case CURVE_S_CURVE:
+                y = static_cast<int>(127.0f * t * t * (3.0f - 2.0f * t) + 0.5f);
+                break;
+            case CURVE_CUSTOM:
+                if (breakpoints) {
+                    uint8_t k = x / CURVE_BREAKPOINT_SPACING;
+                    uint8_t lo = curveBreakpointLevel(k);
+                    uint8_t hi = curveBreakpointLevel(k + 1);
+                    int from = breakpoints[k];
+                    int to = breakpoints[k + 1];
+                    // Rounded integer interpolation between neighbouring points
+                    int span = hi - lo;
+                    y = from + ((to - from) * (x - lo) * 2 + (to >= from ? span : -span)) / (2 * span);
+                    break;
+                }
+                y = x;
+                break;
+            case CURVE_LINEAR:
+            default:
+                y = x;
+                break;
+        }
+        table[x] = static_cast<uint8_t>(y < 0 ? 0 : (y > 127 ? 127 : y));
+    }
+}
+
+/**
+ * Parse CURVE_BREAKPOINTS whitespace-separated levels (0..127) from a
+ * SET_CURVE argument string. Fails on anything missing, extra or out of range.
+ */
+static inline bool parseCurveBreakpoints(const char* text, uint8_t* points) {
+    const char* p = text;
+    for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) {
+        char* end;
+        long value = strtol(p, &end, 10);
+        if (end == p || value < 0 || value > 127) return false;
+        points[k] = static_cast<uint8_t>(value);
+        p = end;
+    }
+    while (*p == ' ' || *p == '\t') p++;
+    return *p == '\0';
+}
+
+// Built-in curve by name (SET_CURVE <ef> <name>); CURVE_COUNT if unknown
+static inline CurveType curveByName(const char* name) {
+    for (uint8_t i = 0; i < CURVE_COUNT; i++) {
+        if (strcmp(CURVE_NAMES[i], name) == 0) return static_cast<CurveType>(i);
+    }
+    return CURVE_COUNT;
+}
+
+#endif // RESPONSE_CURVE_H
@@ -0,0 +1,76 @@
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * Lock-free single-producer / single-consumer ring buffer.
+ *
+ * Exactly one context may call push() (e.g. a timer ISR) and exactly one may
+ * call pop() (e.g. the main loop). Head and tail are free-running counters, so
+ * all Capacity slots are usable; Capacity must be a power of two. When the
+ * buffer is full, push() drops the new item and counts it rather than
+ * overwriting data the consumer may be reading.
+ */
+template <typename T, uint16_t Capacity>
+class SpscRingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRingBuffer capacity must be a power of two");
+
+public:
+    // Producer side
+    bool push(const T& item) {
+        uint16_t head = _head.load(std::memory_order_relaxed);
+        uint16_t tail = _tail.load(std::memory_order_acquire);
+        if (static_cast<uint16_t>(head - tail) >= Capacity) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (Capacity - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        uint16_t tail = _tail.load(std::memory_order_relaxed);
+        uint16_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        item = _items[tail & (Capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: look at the oldest item without removing it
+    bool peek(T& item) const {
+        uint16_t tail = _tail.load(std::memory_order_relaxed);
+        uint16_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        item = _items[tail & (Capacity - 1)];
+        return true;
+    }
+
+    uint16_t size() const {
+        return static_cast<uint16_t>(_head.load(std::memory_order_acquire) -
+                                     _tail.load(std::memory_order_acquire));
+    }
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() >= Capacity; }
+    static constexpr uint16_t capacity() { return Capacity; }
+
+    // Items rejected by push() because the consumer fell behind
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    T _items[Capacity];
+    std::atomic<uint16_t> _head{0};
+    std::atomic<uint16_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
+
+#endif // SPSC_RING_BUFFER_H
@@ -0,0 +1,161 @@
+#ifndef TAP_TEMPO_H
+#define TAP_TEMPO_H
+
+#include <stdint.h>
+
+#define TAP_TEMPO_HISTORY 8             // Intervals kept for the estimate
+#define TAP_TEMPO_MIN_INTERVALS 3       // Four taps before there's a tempo
+#define TAP_TEMPO_MIN_US 150000UL       // 400 BPM; anything quicker is a bounce or a double hit
+#define TAP_TEMPO_MAX_US 3000000UL      // 20 BPM; a longer gap starts over
+#define TAP_TEMPO_MAD_LIMIT 3.0f        // Outlier: more than this many standard deviations (1.4826 MAD) from the median...
+#define TAP_TEMPO_MIN_TOLERANCE 0.04f   // ...and more than this fraction of the median, so tight tapping isn't all "outliers"
+
+enum TapResult : uint8_t {
+    TAP_FIRST,     // First tap of a run: nothing to measure yet
+    TAP_COUNTING,  // Not enough intervals yet
+    TAP_TEMPO,     // New tempo (bpm()) and beat (lastBeatMicros())
+    TAP_OUTLIER,   // Interval didn't fit the others: left out
+    TAP_IGNORED    // Too soon after the last tap
+};
+
+/**
+ * Tap tempo from a ring of recent tap intervals.
+ *
+ * Two taps give one interval, and a person's taps wander by 10-30 ms, so
+ * a tempo from the last two taps alone jumps by several BPM every tap.
+ * This keeps the last TAP_TEMPO_HISTORY intervals and estimates from all
+ * of them: take the median, drop anything further from it than the MAD
+ * (median absolute deviation) allows, and average the rest. One fluffed
+ * tap shifts neither the median nor the MAD, so it is simply left out.
+ *
+ * Two outliers in a row that agree with each other are a new tempo, not
+ * mistakes: the ring starts over from them, so the estimate follows in
+ * one more tap. A gap longer than TAP_TEMPO_MAX_US starts a new run.
+ *
+ * Every accepted tap is also the beat: lastBeatMicros() is its time, for
+ * putting the clock's beat back on the taps.
+ */
+class TapTempo {
+public:
+    TapTempo() { reset(); }
+
+    void reset() {
+        _count = 0;
+        _next = 0;
+        _taps = 0;
+        _lastTap = 0;
+        _pendingOutlier = 0;
+        _bpm = 0.0f;
+        _beatAt = 0;
+        _estimates = 0;
+        _rejected = 0;
+    }
+
+    TapResult tap(uint32_t nowMicros) {
+        uint32_t interval = nowMicros - _lastTap;
+        if (_taps == 0 || interval > TAP_TEMPO_MAX_US) {
+            _count = 0;
+            _next = 0;
+            _pendingOutlier = 0;
+            _taps = 1;
+            _lastTap = nowMicros;
+            return TAP_FIRST;
+        }
+        if (interval < TAP_TEMPO_MIN_US) return TAP_IGNORED;
+        _lastTap = nowMicros;   // Outlier or not, the next interval counts from here
+        if (_taps < 255) _taps++;
+
+        if (_count >= TAP_TEMPO_MIN_INTERVALS) {
+            float mid, band;
+            spread(mid, band);
+            float off = static_cast<float>(interval) - mid;
+            if (off > band || off < -band) {
+                _rejected++;
+                float pending = static_cast<float>(_pendingOutlier);
+                float gap = static_cast<float>(interval) - pending;
+                if (_pendingOutlier && gap <= band && gap >= -band) {
+                    // Two that agree: the tempo changed
+                    _count = 0;
+                    _next = 0;
+                    push(_pendingOutlier);
+                    push(interval);
+                    _pendingOutlier = 0;
+                    return TAP_COUNTING;
+                }
+                _pendingOutlier = interval;
+                return TAP_OUTLIER;
+            }
+        }
+        _pendingOutlier = 0;
+        push(interval);
+        if (_count < TAP_TEMPO_MIN_INTERVALS) return TAP_COUNTING;
+
+        float mid, band;
+        spread(mid, band);
+        float sum = 0.0f;
+        uint8_t used = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            float off = static_cast<float>(_intervals[i]) - mid;
+            if (off <= band && off >= -band) {
+                sum += static_cast<float>(_intervals[i]);
+                used++;
+            }
+        }
+        _bpm = 60000000.0f * used / sum;
+        _beatAt = nowMicros;
+        _estimates++;
+        return TAP_TEMPO;
+    }
+
+    float bpm() const { return _bpm; }                       // 0 until the first estimate
+    uint32_t lastBeatMicros() const { return _beatAt; }      // The tap the last estimate came from
+    uint32_t estimates() const { return _estimates; }        // Changes on every TAP_TEMPO
+    uint8_t taps() const { return _taps; }                   // In this run
+    uint8_t intervals() const { return _count; }
+    uint32_t rejected() const { return _rejected; }
+
+private:
+    uint32_t _intervals[TAP_TEMPO_HISTORY];
+    uint8_t _count;
+    uint8_t _next;
+    uint8_t _taps;
+    uint32_t _lastTap;
+    uint32_t _pendingOutlier;   // Last rejected interval, 0 = none
+    float _bpm;
+    uint32_t _beatAt;
+    uint32_t _estimates;
+    uint32_t _rejected;
+
+    void push(uint32_t interval) {
+        _intervals[_next] = interval;
+        _next = (_next + 1) % TAP_TEMPO_HISTORY;
+        if (_count < TAP_TEMPO_HISTORY) _count++;
+    }
+
+    // Median of a few values, by insertion sort
+    static float median(float* v, uint8_t n) {
+        for (uint8_t i = 1; i < n; i++) {
+            float x = v[i];
+            uint8_t k = i;
+            while (k > 0 && v[k - 1] > x) {
+                v[k] = v[k - 1];
+                k--;
+            }
+            v[k] = x;
+        }
+        return (n & 1) ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+    }
+
+    // Median interval and how far from it still counts as in line
+    void spread(float& mid, float& band) const {
+        float v[TAP_TEMPO_HISTORY] = {};
+        for (uint8_t i = 0; i < _count; i++) v[i] = static_cast<float>(_intervals[i]);
+        mid = median(v, _count);
+        for (uint8_t i = 0; i < _count; i++) v[i] = v[i] > mid ? v[i] - mid : mid - v[i];
+        band = TAP_TEMPO_MAD_LIMIT * 1.4826f * median(v, _count);
+        float minimum = TAP_TEMPO_MIN_TOLERANCE * mid;
+        if (band < minimum) band = minimum;
+    }
+};
+
+#endif // TAP_TEMPO_H
@@ -0,0 +1,160 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <stdint.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Maximum number of tasks a single scheduler can hold (no heap allocation)
+#ifndef TASK_SCHEDULER_CAPACITY
+#define TASK_SCHEDULER_CAPACITY 8
+#endif
+
+// If a task falls this many periods behind, skip the missed runs instead of bursting
+#ifndef TASK_SCHEDULER_MAX_LAG_PERIODS
+#define TASK_SCHEDULER_MAX_LAG_PERIODS 8
+#endif
+
+/**
+ * Plain callback signature for scheduled tasks. The context pointer is handed
+ * back unchanged, so a task can be bound to an object without std::function.
+ */
+typedef void (*TaskCallback)(void* context);
+
+/**
+ * One periodic task. Deadlines are absolute micros() timestamps.
+ */
+struct ScheduledTask {
+    TaskCallback callback = nullptr;
+    void* context          = nullptr;
+    uint32_t interval      = 0;  // Period in microseconds
+    uint32_t nextRun       = 0;  // Next deadline in microseconds
+    uint8_t order          = 0;  // Registration order, breaks deadline ties
+};
+
+/**
+ * Fixed-capacity, deadline-ordered scheduler.
+ *
+ * Tasks live in a binary min-heap keyed on their next deadline, so update()
+ * only touches tasks that are actually due. Deadlines advance by exactly one
+ * period per run (phase-locked), so a 1000 us task runs 1000 times a second
+ * regardless of how late each individual call to update() lands. All
+ * comparisons use wrap-safe signed differences, so micros() rollover is fine.
+ */
+class TaskScheduler {
+public:
+    /**
+     * Register a periodic task.
+     * @param callback       Function to call when the task is due
+     * @param context        Opaque pointer passed back to the callback
+     * @param intervalMicros Period in microseconds (must be > 0)
+     * @return false if the scheduler is full or the interval is invalid
+     */
+    bool addTask(TaskCallback callback, void* context, uint32_t intervalMicros) {
+        if (_count >= TASK_SCHEDULER_CAPACITY || callback == nullptr || intervalMicros == 0) {
+            return false;
+        }
+        ScheduledTask& task = _tasks[_count];
+        task.callback = callback;
+        task.context  = context;
+        task.interval = intervalMicros;
+        // Before the first update() deadlines are relative; they get rebased then
+        task.nextRun  = _started ? _lastUpdate : 0;
+        task.order    = _nextOrder++;
+        siftUp(_count++);
+        return true;
+    }
+
+    /**
+     * Run every task whose deadline has passed.
+     * @param nowMicros Current time in microseconds
+     */
+    void update(uint32_t nowMicros) {
+        if (!_started) {
+            for (uint8_t i = 0; i < _count; i++) {
+                _tasks[i].nextRun += nowMicros;
+            }
+            _started = true;
+        }
+        _lastUpdate = nowMicros;
+
+        while (_count > 0 && isDue(_tasks[0], nowMicros)) {
+            ScheduledTask& task = _tasks[0];
+            task.callback(task.context);
+
+            // Stay on the phase grid; only resync if we have fallen hopelessly behind
+            task.nextRun += task.interval;
+            uint32_t lag = nowMicros - task.nextRun;
+            if (isDue(task, nowMicros) && lag >= task.interval * TASK_SCHEDULER_MAX_LAG_PERIODS) {
+                uint32_t missed = lag / task.interval + 1;
+                task.nextRun += missed * task.interval;
+                _skippedRuns += missed;
+            }
+            siftDown(0);
+        }
+    }
+
+#ifdef ARDUINO
+    void update() { update(micros()); }
+#endif
+
+    uint8_t taskCount() const { return _count; }
+
+    /**
+     * Deadline of the task that will run next (only meaningful if taskCount() > 0).
+     */
+    uint32_t nextDeadline() const { return _tasks[0].nextRun; }
+
+    /**
+     * Total number of runs dropped because a task lagged too far behind.
+     */
+    uint32_t skippedRuns() const { return _skippedRuns; }
+
+private:
+    ScheduledTask _tasks[TASK_SCHEDULER_CAPACITY];
+    uint8_t _count        = 0;
+    uint8_t _nextOrder    = 0;
+    bool _started         = false;
+    uint32_t _lastUpdate  = 0;
+    uint32_t _skippedRuns = 0;
+
+    static bool isDue(const ScheduledTask& task, uint32_t now) {
+        return static_cast<int32_t>(now - task.nextRun) >= 0;
+    }
+
+    static bool runsBefore(const ScheduledTask& a, const ScheduledTask& b) {
+        int32_t diff = static_cast<int32_t>(a.nextRun - b.nextRun);
+        return diff < 0 || (diff == 0 && a.order < b.order);
+    }
+
+    void swapTasks(uint8_t a, uint8_t b) {
+        ScheduledTask tmp = _tasks[a];
+        _tasks[a] = _tasks[b];
+        _tasks[b] = tmp;
+    }
+
+    void siftUp(uint8_t index) {
+        while (index > 0) {
+            uint8_t parent = (index - 1) / 2;
+            if (!runsBefore(_tasks[index], _tasks[parent])) break;
+            swapTasks(index, parent);
+            index = parent;
+        }
+    }
+
+    void siftDown(uint8_t index) {
+        for (;;) {
+            uint8_t left = 2 * index + 1;
+            uint8_t right = left + 1;
+            uint8_t first = index;
+            if (left < _count && runsBefore(_tasks[left], _tasks[first])) first = left;
+            if (right < _count && runsBefore(_tasks[right], _tasks[first])) first = right;
+            if (first == index) break;
+            swapTasks(index, first);
+            index = first;
+        }
+    }
+};
+
+#endif // TASK_SCHEDULER_H
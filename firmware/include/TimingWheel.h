@@ -0,0 +1,226 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <stdint.h>
+
+// Buckets on the wheel; must be a power of two. Longer delays just go round more than once.
+#ifndef TIMING_WHEEL_SLOTS
+#define TIMING_WHEEL_SLOTS 128
+#endif
+
+// Timers one wheel can hold at once (no heap allocation, at most 255)
+#ifndef TIMING_WHEEL_CAPACITY
+#define TIMING_WHEEL_CAPACITY 32
+#endif
+
+/**
+ * Callback for an expired timer. Context and arg come back unchanged, so a
+ * timer can carry a small payload (a packed action, a CC) without a closure.
+ */
+typedef void (*WheelCallback)(void* context, uint32_t arg);
+
+// Names one scheduled timer; 0 is never a valid handle
+typedef uint16_t WheelTimer;
+
+/**
+ * Hashed timing wheel over an abstract tick count: clock ticks, or
+ * milliseconds, depending on what drives advance().
+ *
+ * A timer due at tick T sits in bucket T % TIMING_WHEEL_SLOTS, in a
+ * doubly-linked list through a fixed pool of nodes. Scheduling links a
+ * node in, cancelling unlinks it, and each tick only looks at its own
+ * bucket, so all three are O(1) however many timers are waiting. Timers
+ * more than one turn away share a bucket with nearer ones and are skipped
+ * until their tick comes round.
+ *
+ * Handles carry a generation count, so cancelling a timer that has
+ * already fired (and whose node has been reused) does nothing. Callbacks
+ * may schedule and cancel freely, including other timers due on the same
+ * tick. Timers due on the same tick fire in the order they were scheduled.
+ */
+class TimingWheel {
+public:
+    TimingWheel() {
+        for (uint16_t i = 0; i < TIMING_WHEEL_SLOTS; i++) _heads[i] = NONE;
+        for (uint8_t i = 0; i < TIMING_WHEEL_CAPACITY; i++) {
+            _nodes[i].next = (i + 1 < TIMING_WHEEL_CAPACITY) ? i + 1 : NONE;
+            _nodes[i].generation = 1;
+            _nodes[i].bucket = FREE;
+        }
+        _free = 0;
+        _due = NONE;
+    }
+
+    /**
+     * Run callback after delay ticks (at least one: a timer never fires
+     * inside the call that scheduled it).
+     * @return handle for cancel(), or 0 if the wheel is full
+     */
+    WheelTimer schedule(uint32_t delay, WheelCallback callback, void* context, uint32_t arg = 0) {
+        if (callback == nullptr) return 0;
+        if (_free == NONE) {
+            _dropped++;
+            return 0;
+        }
+        uint8_t index = _free;
+        Node& node = _nodes[index];
+        _free = node.next;
+
+        node.deadline = _now + (delay ? delay : 1);
+        node.callback = callback;
+        node.context = context;
+        node.arg = arg;
+        link(index, node.deadline & (TIMING_WHEEL_SLOTS - 1));
+        if (++_count > _maxCount) _maxCount = _count;
+        return handleOf(index);
+    }
+
+    /**
+     * Drop a timer before it fires.
+     * @return false if it already fired, was cancelled, or never existed
+     */
+    bool cancel(WheelTimer timer) {
+        uint8_t index = indexOf(timer);
+        if (index == NONE) return false;
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    bool pending(WheelTimer timer) const { return indexOf(timer) != NONE; }
+
+    // Ticks left until a pending timer fires, 0 if it isn't pending
+    uint32_t remaining(WheelTimer timer) const {
+        uint8_t index = indexOf(timer);
+        return index == NONE ? 0 : _nodes[index].deadline - _now;
+    }
+
+    /**
+     * Move time on by ticks, firing everything that comes due on the way.
+     * A jump of a whole turn or more sweeps every bucket once instead of
+     * stepping tick by tick; timers in it still fire, bucket by bucket.
+     */
+    void advance(uint32_t ticks) {
+        if (ticks >= TIMING_WHEEL_SLOTS) {
+            _now += ticks;   // First, so callbacks schedule from the new time
+            for (uint16_t b = 0; b < TIMING_WHEEL_SLOTS; b++) expire(b, _now);
+            return;
+        }
+        while (ticks--) {
+            _now++;
+            expire(_now & (TIMING_WHEEL_SLOTS - 1), _now);
+        }
+    }
+
+    // Same, to an absolute tick count (millis(), a clock's ticks())
+    void advanceTo(uint32_t now) { advance(now - _now); }
+
+    uint32_t now() const { return _now; }
+    uint8_t count() const { return _count; }
+    uint8_t maxCount() const { return _maxCount; }
+    uint32_t fired() const { return _fired; }
+    uint32_t dropped() const { return _dropped; }   // schedule() calls refused because the wheel was full
+
+private:
+    static const uint8_t NONE = 0xFF;
+    static const uint16_t FREE = 0xFFFF;                 // Node's bucket while it's in the free list
+    static const uint16_t DUE = TIMING_WHEEL_SLOTS;      // ...while it's waiting to fire this tick
+
+    static_assert((TIMING_WHEEL_SLOTS & (TIMING_WHEEL_SLOTS - 1)) == 0, "TIMING_WHEEL_SLOTS must be a power of two");
+    static_assert(TIMING_WHEEL_CAPACITY < NONE, "Node indices are 8 bits");
+
+    struct Node {
+        uint32_t deadline;
+        WheelCallback callback;
+        void* context;
+        uint32_t arg;
+        uint16_t bucket;
+        uint8_t next;
+        uint8_t prev;
+        uint8_t generation;
+    };
+
+    Node _nodes[TIMING_WHEEL_CAPACITY];
+    uint8_t _heads[TIMING_WHEEL_SLOTS];
+    uint8_t _free;
+    uint8_t _due;   // Timers taken off the wheel this tick, not run yet
+    uint32_t _now = 0;
+    uint8_t _count = 0;
+    uint8_t _maxCount = 0;
+    uint32_t _fired = 0;
+    uint32_t _dropped = 0;
+
+    WheelTimer handleOf(uint8_t index) const {
+        return static_cast<WheelTimer>(_nodes[index].generation << 8 | index);
+    }
+
+    uint8_t indexOf(WheelTimer timer) const {
+        uint8_t index = timer & 0xFF;
+        if (timer == 0 || index >= TIMING_WHEEL_CAPACITY) return NONE;
+        const Node& node = _nodes[index];
+        if (node.bucket == FREE || node.generation != (timer >> 8)) return NONE;
+        return index;
+    }
+
+    uint8_t& headOf(uint16_t bucket) { return bucket == DUE ? _due : _heads[bucket]; }
+
+    void link(uint8_t index, uint16_t bucket) {
+        Node& node = _nodes[index];
+        uint8_t& head = headOf(bucket);
+        node.bucket = bucket;
+        node.prev = NONE;
+        node.next = head;
+        if (head != NONE) _nodes[head].prev = index;
+        head = index;
+    }
+
+    void unlink(uint8_t index) {
+        Node& node = _nodes[index];
+        if (node.prev != NONE) {
+            _nodes[node.prev].next = node.next;
+        } else {
+            headOf(node.bucket) = node.next;
+        }
+        if (node.next != NONE) _nodes[node.next].prev = node.prev;
+    }
+
+    void release(uint8_t index) {
+        Node& node = _nodes[index];
+        node.bucket = FREE;
+        if (++node.generation == 0) node.generation = 1;   // Old handles stop matching
+        node.next = _free;
+        _free = index;
+        _count--;
+    }
+
+    /**
+     * Fire the timers in one bucket that are due by tick `until`. They move
+     * to the due list first (newest scheduled first in the bucket, so moving
+     * them flips them back into order), then run one at a time; a callback
+     * that cancels another due timer just unlinks it from there.
+     */
+    void expire(uint16_t bucket, uint32_t until) {
+        uint8_t index = _heads[bucket];
+        while (index != NONE) {
+            uint8_t next = _nodes[index].next;
+            if (static_cast<int32_t>(_nodes[index].deadline - until) <= 0) {
+                unlink(index);
+                link(index, DUE);
+            }
+            index = next;
+        }
+        while (_due != NONE) {
+            index = _due;
+            Node& node = _nodes[index];
+            WheelCallback callback = node.callback;
+            void* context = node.context;
+            uint32_t arg = node.arg;
+            unlink(index);
+            release(index);
+            _fired++;
+            callback(context, arg);
+        }
+    }
+};
+
+#endif // TIMING_WHEEL_H
@@ -0,0 +1,80 @@
+#ifndef USB_MIDI_PACKER_H
+#define USB_MIDI_PACKER_H
+
+#include <stdint.h>
+#include "MidiOutQueue.h"
+
+#define USB_MIDI_EVENTS_PER_PACKET 16      // 64-byte full-speed bulk packet / 4-byte event
+#define USB_MIDI_MAX_LATENCY_US 1000UL     // Longest a half-full packet of CCs waits (one USB frame)
+
+/**
+ * Packs outgoing messages into whole USB-MIDI packets.
+ *
+ * Each message becomes a 4-byte USB-MIDI event (cable/CIN byte, then up
+ * to three MIDI bytes), and 16 of them fill a 64-byte bulk packet. A
+ * packet goes out the moment it is full. A partial one is held at the
+ * tick's service() until its oldest CC has waited USB_MIDI_MAX_LATENCY_US,
+ * so a busy pass fills packets instead of sending a transfer per CC. If
+ * it holds anything else (notes), it goes at the next service(). flush()
+ * sends whatever is there right away.
+ *
+ * The sink gets (const uint32_t* events, uint8_t count) per packet. On
+ * the Teensy that is usb_midi_write_packed() per event and one
+ * usb_midi_flush_output().
+ */
+class UsbMidiPacker {
+public:
+    UsbMidiPacker() : _count(0), _urgent(false), _oldest(0), _packets(0), _events(0) {}
+
+    static uint32_t encode(const MidiOutMessage& m, uint8_t cable = 0) {
+        uint8_t cin = m.status >= 0xF0 ? systemCin(m) : static_cast<uint8_t>(m.status >> 4);
+        return static_cast<uint32_t>(((cable & 0x0F) << 4) | cin) |
+               static_cast<uint32_t>(m.status) << 8 |
+               static_cast<uint32_t>(m.size > 1 ? m.data1 & 0x7F : 0) << 16 |
+               static_cast<uint32_t>(m.size > 2 ? m.data2 & 0x7F : 0) << 24;
+    }
+
+    template <typename Sink>
+    void add(const MidiOutMessage& m, uint32_t nowMicros, Sink&& send) {
+        if (!_count) _oldest = nowMicros;
+        if ((m.status & 0xF0) != 0xB0) _urgent = true;
+        _packet[_count++] = encode(m);
+        if (_count == USB_MIDI_EVENTS_PER_PACKET) flush(send);
+    }
+
+    // The once-per-tick flush point: a partial packet goes if it is old enough or urgent
+    template <typename Sink>
+    void service(uint32_t nowMicros, Sink&& send) {
+        if (_count && (_urgent || nowMicros - _oldest >= USB_MIDI_MAX_LATENCY_US)) flush(send);
+    }
+
+    template <typename Sink>
+    void flush(Sink&& send) {
+        if (!_count) return;
+        send(static_cast<const uint32_t*>(_packet), _count);
+        _packets++;
+        _events += _count;
+        _count = 0;
+        _urgent = false;
+    }
+
+    uint8_t pending() const { return _count; }
+    uint32_t packets() const { return _packets; }
+    uint32_t events() const { return _events; }
+    void resetStats() { _packets = _events = 0; }
+
+private:
+    uint32_t _packet[USB_MIDI_EVENTS_PER_PACKET];
+    uint8_t _count;
+    bool _urgent;
+    uint32_t _oldest;
+    uint32_t _packets, _events;
+
+    // Code Index Number for system messages: real-time, or system common by length
+    static uint8_t systemCin(const MidiOutMessage& m) {
+        if (m.status >= 0xF8) return 0x0F;
+        return m.size == 1 ? 0x05 : (m.size == 2 ? 0x02 : 0x03);
+    }
+};
+
+#endif // USB_MIDI_PACKER_H
@@ -2,31 +2,18 @@
 #define UTILITY_H
 
 #include <Arduino.h>
-#include <functional>
 #include <vector>
 #include <queue>
 #include <FastLED.h>
 #include <DisplayManager.h>
 #include <EnvelopeFollower.h>
 #include "EEPROM.h"
+#include "TaskScheduler.h"
+#include "TimingWheel.h"
+#include "BeatTimers.h"
 
 class EnvelopeFollower;
 
-struct ScheduledTask {
-    std::function<void()> callback;
-    unsigned long interval;
-    unsigned long lastRun;
-    ScheduledTask(std::function<void()> cb, unsigned long intv);
-};
-
-class TaskScheduler {
-public:
-    void addTask(std::function<void()> callback, unsigned long interval);
-    void update();
-private:
-    std::vector<ScheduledTask> tasks;
-};
-
 class Utility {
 public:
     // Mapping and Value Transformations
@@ -54,6 +41,9 @@ public:
     // Filtering
     static int exponentialMovingAverage(int currentValue, int previousValue, float alpha);
 
+    // ADC
+    static uint8_t adcChannelForPin(uint8_t pin);
+
     // System Operations
     static void rebootTeensy();
 
@@ -75,6 +65,9 @@ public:
     static TaskScheduler schedulerHigh;
     static TaskScheduler schedulerMid;
     static TaskScheduler schedulerLow;
+    // One-shot timers: in clock ticks of the leading clock (quantized actions), and in millis() (UI timeouts)
+    static BeatTimers beatTimers;
+    static TimingWheel msTimers;
 
     static uint16_t readEEPROMWord(int address);
     static void writeEEPROMWord(int address, uint16_t value);
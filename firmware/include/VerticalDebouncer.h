@@ -0,0 +1,42 @@
+#ifndef VERTICAL_DEBOUNCER_H
+#define VERTICAL_DEBOUNCER_H
+
+#include <stdint.h>
+
+/**
+ * Debounces up to 64 inputs at once with a 2-bit vertical counter.
+ *
+ * Bit i of every word belongs to input i. An input's debounced state flips
+ * only after it has disagreed with that state on 4 consecutive samples, so
+ * call update() on a fixed period of (debounce time / 4). A sample that
+ * agrees with the debounced state resets that input's counter.
+ */
+class VerticalDebouncer {
+public:
+    /**
+     * Feed one raw sample of all inputs.
+     * @return Mask of inputs whose debounced state changed on this sample
+     */
+    uint64_t update(uint64_t raw) {
+        uint64_t delta = raw ^ _state;
+        _count1 = (_count1 ^ _count0) & delta;
+        _count0 = ~_count0 & delta;
+        uint64_t toggled = delta & ~(_count0 | _count1);
+        _state ^= toggled;
+        return toggled;
+    }
+
+    uint64_t state() const { return _state; }
+
+    void reset(uint64_t state = 0) {
+        _state = state;
+        _count0 = _count1 = 0;
+    }
+
+private:
+    uint64_t _state = 0;
+    uint64_t _count0 = 0; // Low bit of each input's counter
+    uint64_t _count1 = 0; // High bit of each input's counter
+};
+
+#endif // VERTICAL_DEBOUNCER_H
@@ -4,6 +4,7 @@
 #include "ConfigManager.h"
 #include "Utility.h"
 #include <map>
+#include <stdarg.h>
 
 extern std::vector<EnvelopeFollower> envelopeFollowers;
 extern ButtonManagerContext buttonContext;
@@ -19,42 +20,62 @@ extern ConfigManager configManager;
   #define BM_DBG_PRINTLN(x)
 #endif
 
-static const unsigned long LONG_PRESS_DELAY   = 500;
-static const unsigned long DOUBLE_PRESS_DELAY = 300;
-
 static const int NUM_ARG_PAIRS = sizeof(ARG_PAIRS) / sizeof(ARG_PAIRS[0]);
 
 // We also need a quick reference to the analog pins used by each EF index:
 static const int EF_PINS[6] = { A0, A1, A2, A3, A6, A7 };
 
+// Bit for control button n in the debounced button mask
+#define CTRL_BIT(n) (1ULL << (NUM_VIRTUAL_BUTTONS + (n)))
+
+/**
+ * Combo presses. Chord n runs the CHORDn row of the action table; earlier
+ * entries win if two chords complete on the same scan. Masks can mix slot
+ * and control buttons.
+ */
+#define NUM_CHORDS (ACTION_ROW_COUNT - ACTION_ROW_CHORD0)
+static const uint64_t CHORD_MASKS[NUM_CHORDS] = {
+    CTRL_BIT(0) | CTRL_BIT(1),  // CHORD0
+    CTRL_BIT(2) | CTRL_BIT(3),  // CHORD1
+    CTRL_BIT(4) | CTRL_BIT(5),  // CHORD2
+    CTRL_BIT(2) | CTRL_BIT(5),  // CHORD3
+};
+
+static_assert(ACTION_SLOT_BUTTONS == NUM_VIRTUAL_BUTTONS, "Action table slot row must cover every slot button");
+static_assert(ACTION_ROW_CHORD0 - ACTION_ROW_CTRL0 == NUM_CONTROL_BUTTONS, "One action row per control button");
+
 static const EnvelopeFollower::FilterType ALL_FILTERS[] = {
     EnvelopeFollower::LINEAR,
     EnvelopeFollower::OPPOSITE_LINEAR,
     EnvelopeFollower::EXPONENTIAL,
+    EnvelopeFollower::LOGARITHMIC,
+    EnvelopeFollower::S_CURVE,
+    EnvelopeFollower::CUSTOM,
     EnvelopeFollower::RANDOM,
     EnvelopeFollower::LOWPASS,
     EnvelopeFollower::HIGHPASS,
     EnvelopeFollower::BANDPASS
 };
 static const char* FILTER_TYPE_NAMES[] = {
-    "LINEAR", "OPPOSITE_LINEAR", "EXPONENTIAL", "RANDOM",
-    "LOWPASS", "HIGHPASS", "BANDPASS"
+    "LINEAR", "OPPOSITE_LINEAR", "EXPONENTIAL", "LOGARITHMIC", "S_CURVE", "CUSTOM",
+    "RANDOM", "LOWPASS", "HIGHPASS", "BANDPASS"
 };
 
 static const int NUM_FILTER_TYPES = sizeof(ALL_FILTERS) / sizeof(ALL_FILTERS[0]);
 
-// We'll track which filter index each EnvelopeFollower (e.g. 6 total) is using:
-static int filterTypeIndexForEF[6] = {0, 0, 0, 0, 0, 0};
+// Position of an EF's current type in the cycle above (SET_CURVE can change it too)
+static int filterCycleIndex(EnvelopeFollower::FilterType type) {
+    for (int i = 0; i < NUM_FILTER_TYPES; i++) {
+        if (ALL_FILTERS[i] == type) return i;
+    }
+    return 0;
+}
 
 // Constructor
-ButtonManager::ButtonManager(const uint8_t* primaryMuxPins,
-                             const uint8_t* secondaryMuxPins,
-                             uint8_t muxAnalogPin,
+ButtonManager::ButtonManager(MuxBus* muxBus,
                              const uint8_t* controlPins,
                              PotentiometerManager* potentiometerManager)
-    : _primaryMuxPins(primaryMuxPins),
-      _secondaryMuxPins(secondaryMuxPins),
-      _muxAnalogPin(muxAnalogPin),
+    : _muxBus(muxBus),
       _controlPins(controlPins),
       _potentiometerManager(potentiometerManager),
       activeMode(0),
@@ -62,461 +83,304 @@ ButtonManager::ButtonManager(const uint8_t* primaryMuxPins,
       argEnvelopeA(0),
       argEnvelopeB(1)
 {
-    for (int i = 0; i < NUM_VIRTUAL_BUTTONS + NUM_CONTROL_BUTTONS; i++) {
-        buttonStates[i] = false;
-        lastDebounceTimes[i] = 0;
-    }
+    _gestures.setHandler(onGesture, this);
+    _gestures.setChords(CHORD_MASKS, NUM_CHORDS);
 }
 
 // We call this once at setup, just like your original approach:
+// Mux select lines and outputs are set up by MuxBus::begin().
 void ButtonManager::initButtons() {
-    for (int i = 0; i < 3; i++) {
-        pinMode(_primaryMuxPins[i], OUTPUT);
-        pinMode(_secondaryMuxPins[i], OUTPUT);
-    }
-    pinMode(analogPin, INPUT);
-
     for (int i = 0; i < NUM_CONTROL_BUTTONS; i++) {
         pinMode(_controlPins[i], INPUT_PULLUP);
     }
 
-    // optional: initialize each state machine for each button
-    for (int i = 0; i < (NUM_VIRTUAL_BUTTONS + NUM_CONTROL_BUTTONS); i++) {
-        _buttonMachines[i].state = ButtonState::IDLE;
-        _buttonMachines[i].pressTimestamp = 0;
-        _buttonMachines[i].releaseTimestamp = 0;
-        _buttonMachines[i].longPressFired = false;
-        _buttonMachines[i].lastShortRelease = 0;
-    }
+    _debouncer.reset();
 }
 
 /**
  * One unified processButtons loop:
- *  - For each virtual (mux) button, read & debounce
- *    -> update state machine
- *  - For each control (direct) button, read & debounce
- *    -> update state machine
+ *  - Every DEBOUNCE_SAMPLE_MS, pack all 48 raw button states into one mask
+ *    and run it through the vertical-counter debouncer
+ *  - Gesture detection only visits buttons whose debounced bit changed
+ *    (plus any still waiting for their long-press time)
+ *  - Gestures go into the event queue; dispatchEvents() acts on them
  */
-void ButtonManager::processButtons(ButtonManagerContext& context) {
+void ButtonManager::processButtons() {
     unsigned long now = millis();
+    uint64_t changed = 0;
 
-    // Process virtual (multiplexer) buttons
-    for (uint8_t i = 0; i < NUM_VIRTUAL_BUTTONS; i++) {
-        uint8_t rawState = readMuxButton(i);
-        bool stableReading = Utility::debounce(buttonStates[i], rawState,
-                                               lastDebounceTimes[i], now,
-                                               DEBOUNCE_DELAY);
-
-        if (stableReading) {
-            // interpret 'pressed' as buttonStates[i] == HIGH or LOW, whichever is your design
-            bool pressed = (buttonStates[i] == HIGH);
-            updateButtonStateMachine(i, pressed, context);
-        }
+    // Wait for the first mux sweep so the virtual buttons have real readings
+    if (_muxBus->fullScans() > 0 && now - _lastDebounceSample >= DEBOUNCE_SAMPLE_MS) {
+        _lastDebounceSample = now;
+        changed = _debouncer.update(readRawButtons());
     }
 
-    // Process direct control buttons
-    for (uint8_t i = 0; i < NUM_CONTROL_BUTTONS; i++) {
-        bool currentState = readControlButton(i);
-        bool stableReading = Utility::debounce(buttonStates[NUM_VIRTUAL_BUTTONS + i],
-                                               currentState,
-                                               lastDebounceTimes[NUM_VIRTUAL_BUTTONS + i],
-                                               now, DEBOUNCE_DELAY);
-        if (stableReading) {
-            bool pressed = buttonStates[NUM_VIRTUAL_BUTTONS + i];
-            updateButtonStateMachine(NUM_VIRTUAL_BUTTONS + i, pressed, context);
-        }
-    }
+    _gestures.update(changed, _debouncer.state(), now);
 }
 
-/**
- * The new state machine approach for short vs. long press.
- */
-void ButtonManager::updateButtonStateMachine(uint8_t index, bool pressed, ButtonManagerContext& context) {
-    ButtonStateMachine &sm = _buttonMachines[index];
-    unsigned long now = millis();
+void ButtonManager::onGesture(void* context, uint8_t index, ButtonGesture gesture, uint32_t timestamp) {
+    ButtonManager* self = static_cast<ButtonManager*>(context);
+    self->_events.push(ButtonEvent{ timestamp, index, gesture });
+}
 
-    switch (sm.state) {
-    case ButtonState::IDLE:
-        if (pressed) {
-            sm.state = ButtonState::PRESSED;
-            sm.pressTimestamp = now;
-            sm.longPressFired = false;
-        }
-        break;
-
-    case ButtonState::PRESSED:
-        if (!pressed) {
-            // short release
-            sm.state = ButtonState::RELEASED;
-            sm.releaseTimestamp = now;
-            context.displayManager.registerInteraction();
-        } else {
-            // still pressed, check for long press
-            if (!sm.longPressFired && (now - sm.pressTimestamp >= LONG_PRESS_DELAY)) {
-                sm.state = ButtonState::LONG_PRESS;
-                sm.longPressFired = true;
-                onLongPress(index, context); // handle immediate logic for a recognized long press
-            }
-        }
-        break;
-
-    case ButtonState::LONG_PRESS:
-        // remains pressed
-        if (!pressed) {
-            // user just released after a long press
-            sm.state = ButtonState::RELEASED;
-            sm.releaseTimestamp = now;
-            context.displayManager.registerInteraction();
-        }
-        break;
+void ButtonManager::onActionDue(void* context, uint32_t packed) {
+    ButtonManager* self = static_cast<ButtonManager*>(context);
+    self->_deferred--;
+    // Full only if dispatchEvents() fell behind by a whole wheel; the drop is counted
+    self->_dueActions.push(DeferredAction{ static_cast<uint8_t>(packed),
+                                           static_cast<uint8_t>(packed >> 8),
+                                           static_cast<int8_t>(packed >> 16) });
+}
 
-    case ButtonState::RELEASED:
-        onRelease(index, context);
-        sm.state = ButtonState::IDLE;
-        break;
+void ButtonManager::dispatchEvents(ButtonManagerContext& context, uint32_t budgetMicros) {
+    uint32_t start = micros();
+    DeferredAction due;
+    while (_dueActions.pop(due)) {
+        (this->*ACTION_HANDLERS[due.id])(due.slot, due.param, context);
+        if (micros() - start >= budgetMicros) break;
+    }
+    // Even if the due actions took the whole budget, one gesture still goes
+    ButtonEvent event;
+    while (_events.pop(event)) {
+        handleEvent(event, context);
+        if (micros() - start >= budgetMicros) break;
     }
 }
 
 /**
- * Called as soon as we confirm a long press.
+ * Single-press, double-press, long-press and chord gestures all go through the
+ * action table: look up (button, gesture), then call that action's handler.
+ * Slot buttons act on their own slot; control buttons and chords act on the
+ * active slot. A quantized action waits on Utility::beatTimers for the next
+ * beat or bar, unless the song isn't running.
  */
-void ButtonManager::onLongPress(uint8_t index, ButtonManagerContext& context)
-{
-    if (index < NUM_VIRTUAL_BUTTONS) {
-        // Long Press (Slot Button): Assign the selected slot to an EF, or cycle which EF is assigned
-        auto it = context.potToEnvelopeMap.find(index);
-        if (it == context.potToEnvelopeMap.end()) {
-            context.potToEnvelopeMap[index] = 0; // Assign EF0
-        } else {
-            int currentEF = it->second;
-            int nextEF = (currentEF + 1) % context.envelopes.size();
-            it->second = nextEF;
-        }
-        int assigned = context.potToEnvelopeMap[index];
-        context.envelopes[assigned].toggleActive(true);
-
-        char buf[32];
-        sprintf(buf, "Long: Slot %d->EF %d", index, assigned);
-        context.displayManager.displayStatus(buf, 1500);
+void ButtonManager::handleEvent(const ButtonEvent& event, ButtonManagerContext& context) {
+    if (event.gesture == GESTURE_PRESS) {
+        _lastPressButton = event.button;
+        _lastPressMs = event.timestamp;
     }
-    else {
-        // Could do something else if a control button is long-pressed
-        char msg[32];
-        sprintf(msg, "LongPress Ctrl %d", index - NUM_VIRTUAL_BUTTONS);
-        context.displayManager.displayStatus(msg, 1000);
+    if (event.gesture == GESTURE_RELEASE) {
+        context.displayManager.registerInteraction();
+        return;
     }
-}
 
-/**
- * Called after the user releases (short or long). If it wasn't a long press, we treat it as short press.
- */
-void ButtonManager::onRelease(uint8_t index, ButtonManagerContext& context) {
-    auto &sm = _buttonMachines[index];
-    if (!sm.longPressFired) {
-        // It's a short press
-        handleShortPress(index, context);
-    } else {
-        // We had a long press
-        // If you want a separate 'long press release' action, do it here.
+    ButtonAction action = _actions.lookup(event.button, event.gesture);
+    if (action.id == ACTION_NONE) return;
+
+    uint8_t slot = (event.gesture != GESTURE_CHORD && event.button < NUM_VIRTUAL_BUTTONS)
+                       ? event.button
+                       : context.activePot;
+    _gesturePressedMs = (event.gesture != GESTURE_CHORD && event.button == _lastPressButton)
+                            ? _lastPressMs
+                            : event.timestamp;
+    BM_DBG_PRINT("Button "); BM_DBG_PRINT(event.button);
+    BM_DBG_PRINT(" => "); BM_DBG_PRINTLN(ACTION_NAMES[action.id]);
+
+    ActionQuantize quantize = _actions.quantize(action.id);
+    if (quantize != QUANTIZE_NOW) {
+        uint32_t unit = (quantize == QUANTIZE_BAR) ? CLOCK_PPQN * BEATS_PER_BAR : CLOCK_PPQN;
+        uint32_t packed = action.id | slot << 8 | static_cast<uint8_t>(action.param) << 16;
+        if (Utility::beatTimers.scheduleOnNext(unit, onActionDue, this, packed)) {
+            _deferred++;
+            showStatus(context, 500, "%s: %s", QUANTIZE_NAMES[quantize], ACTION_NAMES[action.id]);
+            return;
+        }
     }
+    (this->*ACTION_HANDLERS[action.id])(slot, action.param, context);
 }
 
-/**
- * If short press, we see if it's a double press or single press.
- */
-void ButtonManager::handleShortPress(uint8_t index, ButtonManagerContext& context) {
-    auto &sm = _buttonMachines[index];
-    unsigned long now = millis();
+const ButtonManager::ActionHandler ButtonManager::ACTION_HANDLERS[ACTION_COUNT] = {
+    &ButtonManager::actionNone,
+    &ButtonManager::actionSelectSlot,
+    &ButtonManager::actionNextSlot,
+    &ButtonManager::actionToggleEF,
+    &ButtonManager::actionCycleEF,
+    &ButtonManager::actionCycleFilter,
+    &ButtonManager::actionCycleChannel,
+    &ButtonManager::actionCycleCC,
+    &ButtonManager::actionTapTempo,
+    &ButtonManager::actionReloadConfig,
+    &ButtonManager::actionSaveConfig,
+    &ButtonManager::actionARGMethod,
+    &ButtonManager::actionLightMode,
+    &ButtonManager::actionRandomEF,
+    &ButtonManager::actionARGPair,
+};
 
-    // Double-press detection
-    if ((now - sm.lastShortRelease) < DOUBLE_PRESS_DELAY) {
-        handleDoublePress(index, context);
-        sm.lastShortRelease = 0;
-    } else {
-        doSinglePressAction(index, context);
-        sm.lastShortRelease = now;
+// Formats into a fixed buffer; no String temporaries in the action handlers
+void ButtonManager::showStatus(ButtonManagerContext& context, int duration, const char* format, ...) {
+    char msg[32];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(msg, sizeof(msg), format, args);
+    va_end(args);
+    context.displayManager.displayStatus(msg, duration);
+}
+
+// Main EF modulating a slot (deepest cell), or -1 (with a message) if there isn't one
+int ButtonManager::assignedEnvelope(uint8_t slot, ButtonManagerContext& context) {
+    int envelopeIndex = context.modMatrix.primarySource(slot);
+    if (envelopeIndex < 0) {
+        context.displayManager.displayStatus("No EF assigned", 1000);
     }
+    return envelopeIndex;
 }
 
-/**
- * Double press logic
- */
-void ButtonManager::handleDoublePress(uint8_t index, ButtonManagerContext& context)
-{
-    // If user double-pressed a slot button (0..41)
-    if (index < NUM_VIRTUAL_BUTTONS) {
-        auto it = context.potToEnvelopeMap.find(index);
-        if (it == context.potToEnvelopeMap.end()) {
-            context.displayManager.displayStatus("No EF assigned", 1000);
-            return;
-        }
-        int efIndex = it->second;
+void ButtonManager::actionNone(uint8_t, int8_t, ButtonManagerContext&) {}
 
-        // Move to next filter index for that EF
-        filterTypeIndexForEF[efIndex] = (filterTypeIndexForEF[efIndex] + 1) % NUM_FILTER_TYPES;
+void ButtonManager::actionSelectSlot(uint8_t slot, int8_t param, ButtonManagerContext& context) {
+    // Make that pot (slot) the “active slot.”
+    context.activePot = (param >= 0 && param < NUM_POTS) ? param : slot;
+    showStatus(context, 1000, "Active Slot=%d", context.activePot);
+}
 
-        // Retrieve the new filter type
-        EnvelopeFollower::FilterType newType = ALL_FILTERS[filterTypeIndexForEF[efIndex]];
-        // Apply it
-        context.envelopes[efIndex].setFilterType(newType);
+void ButtonManager::actionNextSlot(uint8_t, int8_t param, ButtonManagerContext& context) {
+    context.activePot = (context.activePot + NUM_POTS + param % NUM_POTS) % NUM_POTS;
+    showStatus(context, 1500, "Next Slot=%d", context.activePot);
+}
 
-        // Feedback
-        const char* filterName = FILTER_TYPE_NAMES[filterTypeIndexForEF[efIndex]];
-        char msg[32];
-        sprintf(msg, "Slot %d => %s", index, filterName);
-        context.displayManager.displayStatus(msg, 1500);
-    }
-    else {
-        // Double-press on a control button
-        uint8_t cIndex = index - NUM_VIRTUAL_BUTTONS;
-        switch (cIndex) {
-            case 0: {
-                // Double Press (Ctrl #0): Cycle EF filter forward
-                auto it = context.potToEnvelopeMap.find(context.activePot);
-                if (it == context.potToEnvelopeMap.end()) {
-                    context.displayManager.displayStatus("No EF assigned", 1000);
-                    return;
-                }
-                int efIndex = it->second;
-                filterTypeIndexForEF[efIndex] = (filterTypeIndexForEF[efIndex] + 1) % NUM_FILTER_TYPES;
-
-                EnvelopeFollower::FilterType newType = ALL_FILTERS[filterTypeIndexForEF[efIndex]];
-                context.envelopes[efIndex].setFilterType(newType);
-
-                const char* name = FILTER_TYPE_NAMES[filterTypeIndexForEF[efIndex]];
-                char msg[32];
-                sprintf(msg, "Slot %d => %s", context.activePot, name);
-                context.displayManager.displayStatus(msg, 1500);
-                break;
-            }
-
-            case 1: {
-                // Double Press (Ctrl #1): Cycle EF filter backward
-                // [CHANGED] => use activePot instead of 'index', and properly wrap negative
-                auto it = context.potToEnvelopeMap.find(context.activePot);
-                if (it == context.potToEnvelopeMap.end()) {
-                    context.displayManager.displayStatus("No EF assigned", 1000);
-                    return;
-                }
-                int efIndex = it->second;
-
-                // Safely move backward by adding NUM_FILTER_TYPES - 1
-                filterTypeIndexForEF[efIndex] =
-                    (filterTypeIndexForEF[efIndex] + NUM_FILTER_TYPES - 1) % NUM_FILTER_TYPES;
-
-                EnvelopeFollower::FilterType newType = ALL_FILTERS[filterTypeIndexForEF[efIndex]];
-                context.envelopes[efIndex].setFilterType(newType);
-
-                const char* name = FILTER_TYPE_NAMES[filterTypeIndexForEF[efIndex]];
-                char msg[32];
-                sprintf(msg, "Slot %d => %s", context.activePot, name);
-                context.displayManager.displayStatus(msg, 1500);
-                break; // <--- ensure we break out of case 1
-            }
-
-            case 4: {
-                // Double Press (Ctrl #4): Undo unsaved changes (reset EEPROM)
-                context.configManager.loadConfiguration(context.potChannels);
-                context.displayManager.displayStatus("EEPROM Reset!", 1500);
-                break;
-            }
-
-            case 5: {
-                // Double Press (Ctrl #5): Save configuration
-                context.configManager.saveConfiguration();
-                context.configManager.saveEnvelopeSettings(context.potToEnvelopeMap, context.envelopes);
-                context.displayManager.displayStatus("Config Saved!", 1500);
-                break;
-            }
-
-            default:
-                context.displayManager.displayStatus("DoublePress ???", 1000);
-                break;
-        }
+void ButtonManager::actionToggleEF(uint8_t, int8_t, ButtonManagerContext& context) {
+    context.envelopeFollowMode = !context.envelopeFollowMode;
+    context.displayManager.displayStatus(context.envelopeFollowMode ? "EF: ON" : "EF: OFF", 1500);
+}
+
+void ButtonManager::actionCycleEF(uint8_t slot, int8_t param, ButtonManagerContext& context) {
+    if (param == 1 && !context.envelopeFollowMode) {
+        context.displayManager.displayStatus("EF is OFF", 1000);
+        return;
     }
+
+    // Not assigned yet => assign EF0, otherwise move to the next EF
+    // (a blend set up over serial collapses to that one EF at full depth)
+    int current = context.modMatrix.primarySource(slot);
+    int assigned = (current < 0) ? 0 : (current + 1) % context.envelopes.size();
+    context.modMatrix.route(slot, assigned);
+    context.envelopes[assigned].toggleActive(true);
+    showStatus(context, 1500, "Slot %d -> EF %d", slot, assigned);
 }
 
-/**
- * The real single-press logic calls your *original* handleSingleButtonPress.
- */
-void ButtonManager::doSinglePressAction(uint8_t index, ButtonManagerContext& context) {
-    BM_DBG_PRINTLN("Single Press on button " + String(index));
+void ButtonManager::actionCycleFilter(uint8_t slot, int8_t param, ButtonManagerContext& context) {
+    int efIndex = assignedEnvelope(slot, context);
+    if (efIndex < 0) return;
 
-    // old logic:
-    handleSingleButtonPress(index, context);
+    // Wrap negative steps too
+    int step = param % NUM_FILTER_TYPES;
+    int index = (filterCycleIndex(context.envelopes[efIndex].getFilterType()) + NUM_FILTER_TYPES + step) % NUM_FILTER_TYPES;
+    context.envelopes[efIndex].setFilterType(ALL_FILTERS[index]);
+    showStatus(context, 1500, "Slot %d => %s", slot, FILTER_TYPE_NAMES[index]);
 }
 
-void ButtonManager::handleSingleButtonPress(uint8_t buttonIndex, ButtonManagerContext& context)
-{
-    // If it's a virtual "slot" button (0..41)
-    if (buttonIndex < NUM_VIRTUAL_BUTTONS) {
-        // Make that pot (slot) the “active slot.”
-        context.activePot = buttonIndex;
-        context.displayManager.displayStatus(("Active Slot=" + String(buttonIndex)).c_str(), 1000);
-        return;
-    }
+void ButtonManager::actionCycleChannel(uint8_t slot, int8_t param, ButtonManagerContext& context) {
+    // Channels are 1..16
+    uint8_t oldChan = context.configManager.getPotChannel(slot);
+    uint8_t newChan = (oldChan - 1 + 16 + param % 16) % 16 + 1;
+    context.configManager.setPotChannel(slot, newChan);
+    showStatus(context, 1500, "Slot %d => Ch %d", slot, newChan);
+}
 
-    // Otherwise, it's a control button
-    uint8_t controlIndex = buttonIndex - NUM_VIRTUAL_BUTTONS;
-    switch (controlIndex) {
-        case 0:
-            // Short Press (Control Button #0): Toggle EF On/Off
-            context.envelopeFollowMode = !context.envelopeFollowMode;
-            context.displayManager.displayStatus(
-                context.envelopeFollowMode ? "EF: ON" : "EF: OFF",
-                1500
-            );
-            break;
+void ButtonManager::actionCycleCC(uint8_t slot, int8_t param, ButtonManagerContext& context) {
+    uint8_t oldCC = context.configManager.getPotCCNumber(slot);
+    uint8_t newCC = (oldCC + 128 + param % 128) % 128; // 0..127
+    context.configManager.setPotCCNumber(slot, newCC);
+    showStatus(context, 1500, "Slot %d => CC %d", slot, newCC);
+}
 
-        case 1: {
-            // Short Press (Control Button #1): Select next slot
-            context.activePot = (context.activePot + 1) % NUM_POTS;
-            context.displayManager.displayStatus(
-                ("Next Slot=" + String(context.activePot)).c_str(), 1500);
-        }
+void ButtonManager::actionTapTempo(uint8_t, int8_t, ButtonManagerContext& context) {
+    // The beat is when the button went down, not when the gesture reached us
+    uint32_t tapMicros = micros() - (millis() - _gesturePressedMs) * 1000UL;
+    switch (_tapTempo.tap(tapMicros)) {
+        case TAP_TEMPO:
+            g_tappedBPM = _tapTempo.bpm();   // processInternalClock() ramps the clock to it
+            showStatus(context, 1500, "Tapped BPM=%.1f", g_tappedBPM);
             break;
+        case TAP_COUNTING:
+        case TAP_FIRST:
+            showStatus(context, 1500, "Tap %d/%d", _tapTempo.taps(), TAP_TEMPO_MIN_INTERVALS + 1);
+            break;
+        case TAP_OUTLIER:
+            showStatus(context, 1500, "Tap off beat, BPM=%.1f", _tapTempo.bpm());
+            break;
+        case TAP_IGNORED:
+            break;
+    }
+}
 
-        case 2: {
-            // Short Press (Control Button #2): Cycle Envelope to follow [if EF on]
-            if (!context.envelopeFollowMode) {
-                context.displayManager.displayStatus("EF is OFF", 1000);
-                break;
-            }
-
-            // If EF is on, cycle to the next EF for the active slot
-            auto it = context.potToEnvelopeMap.find(context.activePot);
-            if (it == context.potToEnvelopeMap.end()) {
-                // not assigned yet => assign EF0
-                context.potToEnvelopeMap[context.activePot] = 0;
-            } else {
-                int currentEF = it->second;
-                int nextEF = (currentEF + 1) % context.envelopes.size();
-                it->second = nextEF;
-            }
-            int assigned = context.potToEnvelopeMap[context.activePot];
-            context.envelopes[assigned].toggleActive(true);
-
-            char buf[32];
-            sprintf(buf, "Slot %d -> EF %d", context.activePot, assigned);
-            context.displayManager.displayStatus(buf, 1500);
-        }
-        break;
+void ButtonManager::actionReloadConfig(uint8_t, int8_t, ButtonManagerContext& context) {
+    // Undo unsaved changes
+    context.configManager.loadConfiguration(context.potChannels);
+    context.displayManager.displayStatus("EEPROM Reset!", 1500);
+}
 
-        case 3: {
-            // Short Press (Control Button #3): Cycle the active slot’s MIDI channel 1..16
-            uint8_t oldChan = context.configManager.getPotChannel(context.activePot);
-            uint8_t newChan = (oldChan % 16) + 1;  // cycles 1..16
-            context.configManager.setPotChannel(context.activePot, newChan);
+void ButtonManager::actionSaveConfig(uint8_t, int8_t, ButtonManagerContext& context) {
+    context.configManager.saveConfiguration();
+    context.configManager.saveModulationMatrix(context.modMatrix);
+    context.displayManager.displayStatus("Config Saved!", 1500);
+}
 
-            char buf[32];
-            sprintf(buf, "Slot %d => Ch %d", context.activePot, newChan);
-            context.displayManager.displayStatus(buf, 1500);
-        }
-        break;
+void ButtonManager::actionARGMethod(uint8_t slot, int8_t, ButtonManagerContext& context) {
+    // Put the slot's EF into ARG mode, then cycle ARG methods
+    int efIndex = assignedEnvelope(slot, context);
+    if (efIndex < 0) return;
 
-        case 4: {
-            // Short Press (Control Button #4): Cycle the active slot’s CC number
-            uint8_t oldCC = context.configManager.getPotCCNumber(context.activePot);
-            uint8_t newCC = (oldCC + 1) % 128; // 0..127
-            context.configManager.setPotCCNumber(context.activePot, newCC);
+    EnvelopeFollower &env = context.envelopes[efIndex];
+    if (env.getMode() != EnvelopeFollower::ARG) {
+        env.setMode(EnvelopeFollower::ARG);
+        showStatus(context, 1500, "EF %d=>ARG", efIndex);
+        return;
+    }
+    static EnvelopeFollower::ARG_Method ALL_METHODS[] = {
+        EnvelopeFollower::PLUS, EnvelopeFollower::MIN,
+        EnvelopeFollower::PECK, EnvelopeFollower::SHAV,
+        EnvelopeFollower::SQAR, EnvelopeFollower::BABS,
+        EnvelopeFollower::TABS
+    };
+    static const char* NAMES[] = {"PLUS", "MIN", "PECK", "SHAV", "SQAR", "BABS", "TABS"};
+    static int argMethodPos[6] = {0,0,0,0,0,0};
+
+    argMethodPos[efIndex] = (argMethodPos[efIndex] + 1) % (sizeof(ALL_METHODS)/sizeof(ALL_METHODS[0]));
+    env.setARGMethod(ALL_METHODS[argMethodPos[efIndex]]);
+    showStatus(context, 1500, "EF %d=>%s", efIndex, NAMES[argMethodPos[efIndex]]);
+}
 
-            char buf[32];
-            sprintf(buf, "Slot %d => CC %d", context.activePot, newCC);
-            context.displayManager.displayStatus(buf, 1500);
-        }
-        break;
-
-        case 5: {
-            // Short Press (Control Button #5): Tapped BPM
-            static unsigned long lastTap = 0;
-            unsigned long now = millis();
-            if (lastTap != 0) {
-                float intervalMs = (float)(now - lastTap);
-                float newBPM = 60000.0f / intervalMs;
-                char buf[32];
-                snprintf(buf, sizeof(buf), "Tapped BPM=%.1f", newBPM);
-                context.displayManager.displayStatus(buf, 1500);
-            }
-            lastTap = now;
-        }
-        break;
+void ButtonManager::actionLightMode(uint8_t, int8_t, ButtonManagerContext& context) {
+    static uint8_t currentLightMode = 0;
+    currentLightMode = (currentLightMode + 1) % 4;
+    context.ledManager.setModeDisplay(currentLightMode);
+    showStatus(context, 1500, "LightMode=%d", currentLightMode);
+}
 
-        default:
-            context.displayManager.displayStatus("UNKNOWN CTRL BTN", 1000);
-            break;
+void ButtonManager::actionRandomEF(uint8_t slot, int8_t, ButtonManagerContext& context) {
+    if (!context.envelopeFollowMode) {
+        context.envelopeFollowMode = true;
+        context.displayManager.displayStatus("EF turned ON", 1000);
     }
+    int randomEF = random(context.envelopes.size());
+    context.modMatrix.route(slot, randomEF);
+    context.envelopes[randomEF].toggleActive(true);
+    showStatus(context, 1500, "Slot %d->RandomEF %d", slot, randomEF);
 }
 
-void ButtonManager::handleMultiButtonPress(uint8_t pressedButtons, ButtonManagerContext& context) {
-    // Define bit masks for the control buttons
-    const uint8_t maskCtrl0 = 1 << 0;
-    const uint8_t maskCtrl1 = 1 << 1;
-    const uint8_t maskCtrl2 = 1 << 2;
-    const uint8_t maskCtrl3 = 1 << 3;
-    const uint8_t maskCtrl4 = 1 << 4;
-    const uint8_t maskCtrl5 = 1 << 5;
-
-    // (1) Ctrl0 + Ctrl1: Cycle EF’s ARG method if in ARG mode
-    if ((pressedButtons & (maskCtrl0 | maskCtrl1)) == (maskCtrl0 | maskCtrl1)) {
-        auto it = context.potToEnvelopeMap.find(context.activePot);
-        if (it == context.potToEnvelopeMap.end()) {
-            context.displayManager.displayStatus("No EF assigned", 1000);
-            return;
-        }
-        int efIndex = it->second;
-        EnvelopeFollower &env = context.envelopes[efIndex];
-        if (env.getMode() != EnvelopeFollower::ARG) {
-            context.displayManager.displayStatus("Not in ARG mode", 1000);
-            return;
-        }
-        // Cycle through ARG methods (using similar logic as before)
-        static EnvelopeFollower::ARG_Method ALL_METHODS[] = {
-            EnvelopeFollower::PLUS, EnvelopeFollower::MIN,
-            EnvelopeFollower::PECK, EnvelopeFollower::SHAV,
-            EnvelopeFollower::SQAR, EnvelopeFollower::BABS,
-            EnvelopeFollower::TABS
-        };
-        static const char* NAMES[] = {"PLUS", "MIN", "PECK", "SHAV", "SQAR", "BABS", "TABS"};
-        static int argMethodPos[6] = {0,0,0,0,0,0};
-
-        argMethodPos[efIndex] = (argMethodPos[efIndex] + 1) % (sizeof(ALL_METHODS)/sizeof(ALL_METHODS[0]));
-        env.setARGMethod(ALL_METHODS[argMethodPos[efIndex]]);
-        char msg[32];
-        sprintf(msg, "EF %d=>%s", efIndex, NAMES[argMethodPos[efIndex]]);
-        context.displayManager.displayStatus(msg, 1500);
-    }
-    // (2) Ctrl2 + Ctrl3: Cycle light modes (unchanged)
-    else if ((pressedButtons & (maskCtrl2 | maskCtrl3)) == (maskCtrl2 | maskCtrl3)) {
-        static uint8_t currentLightMode = 0;
-        currentLightMode = (currentLightMode + 1) % 4;
-        context.ledManager.setModeDisplay(currentLightMode);
-        char buf[32];
-        sprintf(buf, "LightMode=%d", currentLightMode);
-        context.displayManager.displayStatus(buf, 1500);
-    }
-    // (3) Ctrl4 + Ctrl5: Toggle EF on and randomly assign envelope
-    else if ((pressedButtons & (maskCtrl4 | maskCtrl5)) == (maskCtrl4 | maskCtrl5)) {
-        if (!context.envelopeFollowMode) {
-            context.envelopeFollowMode = true;
-            context.displayManager.displayStatus("EF turned ON", 1000);
-        }
-        int randomEF = random(context.envelopes.size());
-        context.potToEnvelopeMap[context.activePot] = randomEF;
-        context.envelopes[randomEF].toggleActive(true);
-        char buf[32];
-        sprintf(buf, "Slot %d->RandomEF %d", context.activePot, randomEF);
-        context.displayManager.displayStatus(buf, 1500);
+void ButtonManager::actionARGPair(uint8_t slot, int8_t, ButtonManagerContext& context) {
+    // Step the slot's EF through every (A, B) input pair
+    int efIndex = assignedEnvelope(slot, context);
+    if (efIndex < 0) return;
+    if (context.envelopes[efIndex].getMode() != EnvelopeFollower::ARG) {
+        context.displayManager.displayStatus("Not in ARG mode", 1000);
+        return;
     }
+    static int argPairPos[6] = {0,0,0,0,0,0};
+    argPairPos[efIndex] = (argPairPos[efIndex] + 1) % NUM_ARG_PAIRS;
+    const std::pair<int,int>& pair = ARG_PAIRS[argPairPos[efIndex]];
+    context.envelopes[efIndex].setEnvelopePair(pair.first, pair.second);
+    _potentiometerManager->setArgEnvelopePair(pair.first, pair.second);
+    showStatus(context, 1500, "EF %d: A%d/B%d", efIndex, pair.first - A0, pair.second - A0);
 }
 
 /**
  * Implementation of reading from multiplexer (same as your old code).
  */
 uint8_t ButtonManager::readMuxButton(uint8_t buttonIndex) {
-    uint8_t row = buttonIndex / 8;
-    uint8_t col = buttonIndex % 8;
-    selectMux(row, col);
-    int value = analogRead(_muxAnalogPin);
+    int value = _muxBus->read(MUX_CHANNEL_BUTTONS, buttonIndex);
     return (value < 512) ? HIGH : LOW; // or invert if needed
 }
 
@@ -527,13 +391,20 @@ bool ButtonManager::readControlButton(uint8_t buttonIndex) {
     return (digitalRead(_controlPins[buttonIndex]) == LOW);
 }
 
-void ButtonManager::selectMux(uint8_t row, uint8_t col) {
-    for (int i = 0; i < 3; i++) {
-        digitalWrite(_primaryMuxPins[i], (row >> i) & 1);
-        digitalWrite(_secondaryMuxPins[i], (col >> i) & 1);
+uint64_t ButtonManager::readRawButtons() {
+    uint64_t raw = 0;
+    for (uint8_t i = 0; i < NUM_VIRTUAL_BUTTONS; i++) {
+        // Same sense as before: readMuxButton() == HIGH means pressed
+        if (readMuxButton(i) == HIGH) raw |= 1ULL << i;
+    }
+    for (uint8_t i = 0; i < NUM_CONTROL_BUTTONS; i++) {
+        if (readControlButton(i)) raw |= 1ULL << (NUM_VIRTUAL_BUTTONS + i);
     }
+    return raw;
 }
 
+// Polled in tight loops by the bench tests, so read the mux directly rather than the snapshot
 bool ButtonManager::isMuxButtonPressed(uint8_t index) {
-    return readMuxButton(index) == LOW;  // assuming LOW means pressed
+    int value = _muxBus->readBlocking(MUX_CHANNEL_BUTTONS, index);
+    return value >= 512;  // same sense as readMuxButton(index) == LOW
 }
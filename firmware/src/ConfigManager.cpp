@@ -1,6 +1,7 @@
 // ConfigManager.cpp — Updated with EEPROM robustness and backup handling, preserving development comments
 
 #include "ConfigManager.h"
+#include "ButtonActions.h"
 
 //eeprom update parameters
 //break that single expression into separate s += …; calls, so each step is clearly a String operation:
@@ -34,7 +35,9 @@ static String makeSchema() {
 
 // Constructor
 ConfigManager::ConfigManager(uint8_t numPots, uint8_t numButtons)
-    : _numPots(numPots), _numButtons(numButtons) {}
+    : _numPots(numPots), _numButtons(numButtons) {
+    _ccIndex.assignDefaults(numPots);   // Until the EEPROM is read
+}
 
 // Centralized EEPROM health check
 bool ConfigManager::checkEEPROMHealth(bool backup) {
@@ -71,7 +74,7 @@ bool ConfigManager::loadConfiguration(std::vector<uint8_t>& potChannels) {
         readEEPROM(false);
         potChannels.clear();
         for (uint8_t i = 0; i < _numPots; i++) {
-            potChannels.push_back(_potChannels[i]);
+            potChannels.push_back(getPotChannel(i));
         }
         return true;
     }
@@ -85,7 +88,7 @@ bool ConfigManager::loadBackupConfiguration(std::vector<uint8_t>& potChannels) {
         readEEPROM(true);
         potChannels.clear();
         for (uint8_t i = 0; i < _numPots; i++) {
-            potChannels.push_back(_potChannels[i]);
+            potChannels.push_back(getPotChannel(i));
         }
         return true;
     }
@@ -98,8 +101,7 @@ bool ConfigManager::loadBackupConfiguration(std::vector<uint8_t>& potChannels) {
 void ConfigManager::readEEPROM(bool backup) {
     int offset = backup ? EEPROM_BACKUP_START : EEPROM_START_ADDRESS;
     for (uint8_t i = 0; i < _numPots; i++) {
-        _potChannels[i] = EEPROM.read(offset + EEPROM_POT_CHANNELS + i);
-        _potCCNumbers[i] = EEPROM.read(offset + EEPROM_POT_CC + i);
+        _ccIndex.assign(i, EEPROM.read(offset + EEPROM_POT_CHANNELS + i), EEPROM.read(offset + EEPROM_POT_CC + i));
     }
 }
 
@@ -107,8 +109,8 @@ void ConfigManager::readEEPROM(bool backup) {
 void ConfigManager::writeEEPROM(bool backup) {
     int offset = backup ? EEPROM_BACKUP_START : EEPROM_START_ADDRESS;
     for (uint8_t i = 0; i < _numPots; i++) {
-        EEPROM.update(offset + EEPROM_POT_CHANNELS + i, _potChannels[i]);
-        EEPROM.update(offset + EEPROM_POT_CC + i, _potCCNumbers[i]);
+        EEPROM.update(offset + EEPROM_POT_CHANNELS + i, _ccIndex.channel(i));
+        EEPROM.update(offset + EEPROM_POT_CC + i, _ccIndex.cc(i));
     }
 }
 
@@ -119,37 +121,57 @@ void ConfigManager::begin(std::vector<uint8_t>& potChannels) {
 
 // Potentiometer accessors
 uint8_t ConfigManager::getPotChannel(uint8_t potIndex) const {
-    return _potChannels.at(potIndex);
+    return _ccIndex.channel(potIndex);
 }
 
 uint8_t ConfigManager::getPotCCNumber(uint8_t potIndex) const {
-    return _potCCNumbers.at(potIndex);
+    return _ccIndex.cc(potIndex);
 }
 
 void ConfigManager::setPotChannel(uint8_t potIndex, uint8_t channel) {
     if (potIndex < _numPots) {
-        _potChannels[potIndex] = channel;
+        _ccIndex.assign(potIndex, channel, _ccIndex.cc(potIndex));
     }
 }
 
 void ConfigManager::setPotCCNumber(uint8_t potIndex, uint8_t ccNumber) {
     if (potIndex < _numPots) {
-        _potCCNumbers[potIndex] = ccNumber;
+        _ccIndex.assign(potIndex, _ccIndex.channel(potIndex), ccNumber);
     }
 }
 
-// Envelope settings
-void ConfigManager::loadEnvelopeSettings(std::map<int, int>& potToEnvelopeMap, std::vector<EnvelopeFollower>& envelopeFollowers) {
-    for (size_t i = 0; i < envelopeFollowers.size(); i++) {
-        int envelopeIndex = EEPROM.read(EEPROM_ENVELOPE_ASSIGNMENTS + i);
-        potToEnvelopeMap[i] = envelopeIndex;
+// Modulation matrix
+void ConfigManager::saveModulationMatrix(const SlotModMatrix& matrix) {
+    uint8_t image[SlotModMatrix::BYTES];
+    matrix.serialize(image);
+    for (uint16_t i = 0; i < SlotModMatrix::BYTES; i++) {
+        EEPROM.update(EEPROM_MOD_MATRIX + i, image[i]);
     }
+    EEPROM.update(EEPROM_MOD_MATRIX_MAGIC_ADDRESS, (EEPROM_MAGIC_MOD_MATRIX >> 8) & 0xFF);
+    EEPROM.update(EEPROM_MOD_MATRIX_MAGIC_ADDRESS + 1, EEPROM_MAGIC_MOD_MATRIX & 0xFF);
 }
 
-void ConfigManager::saveEnvelopeSettings(const std::map<int, int>& potToEnvelopeMap, const std::vector<EnvelopeFollower>& envelopes) {
-    for (const auto& [potIndex, envelopeIndex] : potToEnvelopeMap) {
-        EEPROM.update(EEPROM_ENVELOPE_ASSIGNMENTS + potIndex, envelopeIndex);
+bool ConfigManager::loadModulationMatrix(SlotModMatrix& matrix) {
+    matrix.clear();
+    uint16_t magic = EEPROM.read(EEPROM_MOD_MATRIX_MAGIC_ADDRESS) << 8 |
+                     EEPROM.read(EEPROM_MOD_MATRIX_MAGIC_ADDRESS + 1);
+    if (magic != EEPROM_MAGIC_MOD_MATRIX) {
+        // Older firmware kept one EF index per slot; bring those over at full depth
+        for (uint8_t slot = 0; slot < NUM_POTS; slot++) {
+            uint8_t envelopeIndex = EEPROM.read(EEPROM_ENVELOPE_ASSIGNMENTS + slot);
+            if (envelopeIndex < NUM_ENVELOPES) {
+                matrix.route(slot, envelopeIndex);
+            }
+        }
+        return false;
+    }
+
+    uint8_t image[SlotModMatrix::BYTES];
+    for (uint16_t i = 0; i < SlotModMatrix::BYTES; i++) {
+        image[i] = EEPROM.read(EEPROM_MOD_MATRIX + i);
     }
+    matrix.deserialize(image);
+    return true;
 }
 
 // LED settings
@@ -167,13 +189,86 @@ void ConfigManager::saveLEDSettings(uint8_t brightness, CRGB color) {
     EEPROM.update(EEPROM_LED_COLOR + 2, color.b);
 }
 
+// Button action table
+void ConfigManager::saveButtonActions(const ButtonActionMap& actions) {
+    uint8_t image[ACTION_TABLE_BYTES];
+    actions.serialize(image);
+    for (uint16_t i = 0; i < ACTION_TABLE_BYTES; i++) {
+        EEPROM.update(EEPROM_BUTTON_ACTIONS + i, image[i]);
+    }
+    EEPROM.update(EEPROM_BUTTON_ACTIONS_MAGIC_ADDRESS, (EEPROM_MAGIC_BUTTON_ACTIONS >> 8) & 0xFF);
+    EEPROM.update(EEPROM_BUTTON_ACTIONS_MAGIC_ADDRESS + 1, EEPROM_MAGIC_BUTTON_ACTIONS & 0xFF);
+
+    uint8_t quantize[ACTION_QUANTIZE_BYTES];
+    actions.serializeQuantize(quantize);
+    for (uint16_t i = 0; i < ACTION_QUANTIZE_BYTES; i++) {
+        EEPROM.update(EEPROM_ACTION_QUANTIZE + i, quantize[i]);
+    }
+    EEPROM.update(EEPROM_ACTION_QUANTIZE_MAGIC_ADDRESS, (EEPROM_MAGIC_ACTION_QUANTIZE >> 8) & 0xFF);
+    EEPROM.update(EEPROM_ACTION_QUANTIZE_MAGIC_ADDRESS + 1, EEPROM_MAGIC_ACTION_QUANTIZE & 0xFF);
+}
+
+bool ConfigManager::loadButtonActions(ButtonActionMap& actions) {
+    uint16_t magic = EEPROM.read(EEPROM_BUTTON_ACTIONS_MAGIC_ADDRESS) << 8 |
+                     EEPROM.read(EEPROM_BUTTON_ACTIONS_MAGIC_ADDRESS + 1);
+    if (magic != EEPROM_MAGIC_BUTTON_ACTIONS) return false;
+
+    uint8_t image[ACTION_TABLE_BYTES];
+    for (uint16_t i = 0; i < ACTION_TABLE_BYTES; i++) {
+        image[i] = EEPROM.read(EEPROM_BUTTON_ACTIONS + i);
+    }
+    if (!actions.deserialize(image)) {
+        Serial.println("Stored button actions invalid, using defaults.");
+        return false;
+    }
+
+    // Saved before quantize settings existed: everything stays QUANTIZE_NOW
+    magic = EEPROM.read(EEPROM_ACTION_QUANTIZE_MAGIC_ADDRESS) << 8 |
+            EEPROM.read(EEPROM_ACTION_QUANTIZE_MAGIC_ADDRESS + 1);
+    if (magic == EEPROM_MAGIC_ACTION_QUANTIZE) {
+        uint8_t quantize[ACTION_QUANTIZE_BYTES];
+        for (uint16_t i = 0; i < ACTION_QUANTIZE_BYTES; i++) {
+            quantize[i] = EEPROM.read(EEPROM_ACTION_QUANTIZE + i);
+        }
+        if (!actions.deserializeQuantize(quantize)) {
+            Serial.println("Stored action quantize settings invalid, using NOW.");
+        }
+    }
+    return true;
+}
+
+// Custom response curves
+void ConfigManager::saveCustomCurves(const std::vector<EnvelopeFollower>& envelopes) {
+    for (size_t ef = 0; ef < envelopes.size() && ef < NUM_ENVELOPES; ef++) {
+        const uint8_t* points = envelopes[ef].getCustomCurve();
+        for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) {
+            EEPROM.update(EEPROM_CUSTOM_CURVES + ef * CURVE_BREAKPOINTS + k, points[k]);
+        }
+    }
+    EEPROM.update(EEPROM_CUSTOM_CURVES_MAGIC_ADDRESS, (EEPROM_MAGIC_CUSTOM_CURVES >> 8) & 0xFF);
+    EEPROM.update(EEPROM_CUSTOM_CURVES_MAGIC_ADDRESS + 1, EEPROM_MAGIC_CUSTOM_CURVES & 0xFF);
+}
+
+bool ConfigManager::loadCustomCurves(std::vector<EnvelopeFollower>& envelopes) {
+    uint16_t magic = EEPROM.read(EEPROM_CUSTOM_CURVES_MAGIC_ADDRESS) << 8 |
+                     EEPROM.read(EEPROM_CUSTOM_CURVES_MAGIC_ADDRESS + 1);
+    if (magic != EEPROM_MAGIC_CUSTOM_CURVES) return false;
+
+    for (size_t ef = 0; ef < envelopes.size() && ef < NUM_ENVELOPES; ef++) {
+        uint8_t points[CURVE_BREAKPOINTS];
+        for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) {
+            uint8_t level = EEPROM.read(EEPROM_CUSTOM_CURVES + ef * CURVE_BREAKPOINTS + k);
+            points[k] = level > 127 ? 127 : level;
+        }
+        envelopes[ef].setCustomCurve(points);
+    }
+    return true;
+}
+
 // Reset configuration to defaults
 void ConfigManager::resetConfiguration(std::vector<uint8_t>& potChannels) {
     potChannels.clear();
-    for (uint8_t i = 0; i < _numPots; i++) {
-        setPotChannel(i, 1); // Default to channel 1
-        setPotCCNumber(i, 0); // Default to CC 0
-    }
+    _ccIndex.assignDefaults(_numPots); // Channel 1, pot n on CC n
     saveConfiguration();
 }
 
@@ -237,9 +332,9 @@ String ConfigManager::serializeAll() const {
     for (uint8_t i = 0; i < _numPots; ++i) {
         output += "{";
         output += "\"channel\": ";
-        output += _potChannels.at(i);
+        output += getPotChannel(i);
         output += ", \"cc\": ";
-        output += _potCCNumbers.at(i);
+        output += getPotCCNumber(i);
         output += "}";
 
         if (i < _numPots - 1) {
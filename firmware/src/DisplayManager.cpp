@@ -6,6 +6,7 @@
 #include "ButtonManager.h"
 #include <vector>
 #include "Globals.h"
+#include "Utility.h"
 
 DisplayManager::DisplayManager(uint8_t i2cAddress,
                                uint16_t screenWidth,
@@ -121,13 +122,26 @@ bool DisplayManager::shouldRunScreensaver() const {
     return (millis() - _lastInteractionTime > 90000);
 }
 
+// A status message keeps the screen until its timer on Utility::msTimers fires; a newer one restarts it
+void DisplayManager::holdStatus(unsigned long durationMs) {
+    Utility::msTimers.cancel(_statusTimer);
+    _statusTimer = Utility::msTimers.schedule(durationMs, releaseStatus, this);
+    _statusHeld = _statusTimer != 0;
+}
+
+void DisplayManager::releaseStatus(void* context, uint32_t) {
+    DisplayManager* self = static_cast<DisplayManager*>(context);
+    self->_statusHeld = false;
+    self->_statusTimer = 0;
+}
+
 
 void DisplayManager::drawBorder() {
     _display.drawRect(0, 0, _display.width(), _display.height(), SSD1306_WHITE);
 }
 
 void DisplayManager::showText(const char* line1, const char* line2, const char* line3) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     clear();
     _display.setTextSize(1);
@@ -151,7 +165,7 @@ void DisplayManager::showText(const char* line1, const char* line2, const char*
 }
 
 void DisplayManager::showValue(uint8_t value, bool clearDisplay) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     if (clearDisplay) {
         _display.clearDisplay();
@@ -191,11 +205,11 @@ void DisplayManager::showEnvelopeAssignment(int potIndex, int efIndex, const cha
     }
     drawBorder();
     _display.display();
-    _statusTimeout = millis() + NORMAL_DISPLAY_TIME;
+    holdStatus(NORMAL_DISPLAY_TIME);
 }
 
 void DisplayManager::showMode(const char *mode, bool clearDisplay) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     if (clearDisplay) {
         _display.clearDisplay();
@@ -211,14 +225,14 @@ void DisplayManager::showMode(const char *mode, bool clearDisplay) {
 }
 
 void DisplayManager::clear() {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     _display.clearDisplay();
     _display.display();
 }
 
 void DisplayManager::showFilterTuning(float frequency, float q) {
-    if (millis() < _statusTimeout) return;  // Added timeout check for consistency
+    if (_statusHeld) return;  // Added timeout check for consistency
 
     _display.clearDisplay();
     _display.setTextSize(1);
@@ -235,7 +249,7 @@ void DisplayManager::showFilterTuning(float frequency, float q) {
 }
 
 void DisplayManager::updateDisplay(uint8_t beatPosition, const std::vector<uint8_t>& envelopeLevels, const char* statusMessage, uint8_t activePot, uint8_t activeChannel, const char* envelopeMode){
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     _display.clearDisplay();
     _display.setTextSize(1);
@@ -268,13 +282,13 @@ void DisplayManager::updateDisplay(uint8_t beatPosition, const std::vector<uint8
     _display.display();
 
     if (statusMessage && statusMessage[0] != '\0') {
-        _statusTimeout = millis() + NORMAL_DISPLAY_TIME;
+        holdStatus(NORMAL_DISPLAY_TIME);
     }
 }
 
 void DisplayManager::displayStatus(const char *status, unsigned long duration) {
     _statusMessage = status;
-    _statusTimeout = millis() + duration;
+    holdStatus(duration);
 
     _display.clearDisplay();
     _display.setTextSize(2);
@@ -285,7 +299,7 @@ void DisplayManager::displayStatus(const char *status, unsigned long duration) {
 }
 
 void DisplayManager::updateFromContext(const ButtonManagerContext& context) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     _display.clearDisplay();
     _display.setCursor(0, 0);
@@ -297,18 +311,24 @@ void DisplayManager::updateFromContext(const ButtonManagerContext& context) {
     _display.print("EF: ");
     _display.println(context.envelopeFollowMode ? "ON" : "OFF");
 
-    if (context.potToEnvelopeMap.count(context.activePot)) {
-        int envelopeIndex = context.potToEnvelopeMap.at(context.activePot);
+    int envelopeIndex = context.modMatrix.primarySource(context.activePot);
+    if (envelopeIndex >= 0) {
         _display.setCursor(0, 20);
         _display.print("ENV->POT: ");
-        _display.println(envelopeIndex);
+        _display.print(envelopeIndex);
+        // '+' when the slot blends more than one EF
+        int sources = 0;
+        for (uint8_t ef = 0; ef < NUM_ENVELOPES; ef++) {
+            if (context.modMatrix.depth(context.activePot, ef)) sources++;
+        }
+        _display.println(sources > 1 ? "+" : "");
     }
 
     _display.display();
 }
 
 void DisplayManager::showARGInfo(const char* methodName, int envA, int envB) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     clear();
 
@@ -329,12 +349,12 @@ void DisplayManager::showARGInfo(const char* methodName, int envA, int envB) {
     _display.println(envB);
 
     _display.display();
-    _statusTimeout = millis() + NORMAL_DISPLAY_TIME;
+    holdStatus(NORMAL_DISPLAY_TIME);
 }
 
 void DisplayManager::setTemporaryMessage(const char* message, unsigned long duration) {
     _statusMessage = message;
-    _statusTimeout = millis() + duration;
+    holdStatus(duration);
     clear();
     _display.setTextSize(1);
     _display.setTextColor(SSD1306_WHITE);
@@ -356,11 +376,11 @@ void DisplayManager::showMIDIMessage(uint8_t cc, uint8_t value, uint8_t channel)
     _display.print("Ch: ");
     _display.println(channel);
     _display.display();
-    _statusTimeout = millis() + SHORT_DISPLAY_TIME;
+    holdStatus(SHORT_DISPLAY_TIME);
 }
 
 void DisplayManager::updateBeat(uint8_t beatPosition, bool clockRunning) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     _display.clearDisplay();
     _display.setTextSize(1);
@@ -377,6 +397,22 @@ void DisplayManager::updateBeat(uint8_t beatPosition, bool clockRunning) {
     _display.display();
 }
 
+void DisplayManager::showBeat(uint8_t beatInBar, bool running) {
+    if (_statusHeld) return;
+
+    // Four squares in the top-right corner; the current beat is filled while the song runs
+    const int size = 5;
+    const int step = 7;
+    for (uint8_t b = 0; b < 4; b++) {
+        int x = _display.width() - (4 - b) * step;
+        if (running && b == beatInBar) {
+            _display.fillRect(x, 0, size, size, SSD1306_WHITE);
+        } else {
+            _display.drawRect(x, 0, size, size, SSD1306_WHITE);
+        }
+    }
+}
+
 void DisplayManager::beginDraw() {
     _display.clearDisplay();
     _isDrawing = true;
@@ -388,7 +424,7 @@ void DisplayManager::endDraw() {
 }
 
 void DisplayManager::showError(const char* errorMessage, bool persistent) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     beginDraw();
     _display.setTextSize(1);
@@ -403,7 +439,7 @@ void DisplayManager::showError(const char* errorMessage, bool persistent) {
 }
 
 void DisplayManager::showEnvelopeLevel(uint8_t level) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     const int barHeight = 10;
     const int barY = _display.height() - barHeight;
@@ -413,7 +449,7 @@ void DisplayManager::showEnvelopeLevel(uint8_t level) {
 }
 
 void DisplayManager::showEnvelopeLevels(uint8_t envA, uint8_t envB) {
-    if (millis() < _statusTimeout) return;
+    if (_statusHeld) return;
 
     const int barHeight = 5;
     const int gap = 2;
@@ -11,18 +11,35 @@ extern MIDIHandler midiHandler;
  */
 EnvelopeFollower::EnvelopeFollower(int pin, PotentiometerManager* pm)
     : audioInputPin(pin),
+      inputIndex(0),
       currentEnvelopeLevel(0),
-      modulationTargetCC(-1),
       isActive(false),
       filterType(LINEAR),     // initialize filterType first
       mode(SEF),             // then mode
       argMethod(PLUS),
       envelopeA(0),
       envelopeB(1),
-      potManager(pm)
+      potManager(pm),
+      bank(nullptr),
+      bankIndex(0)
 {
-    // default low-pass at 1kHz
-    filter.configure(BiquadFilter::LOWPASS, 1000, 44100, 0.707);
+    int index = inputIndexForPin(pin);
+    if (index >= 0) {
+        inputIndex = index;
+    }
+    // default low-pass at 1kHz (clamped below Nyquist of the control rate)
+    filter.configure(BiquadFilter::LOWPASS, 1000, ENVELOPE_CONTROL_RATE, 0.707);
+    linearBreakpoints(customCurve);
+    rebuildCurve();
+}
+
+int EnvelopeFollower::inputIndexForPin(int pin) {
+    for (uint8_t i = 0; i < NUM_ENVELOPES; i++) {
+        if (ENVELOPE_INPUT_PINS[i] == pin) {
+            return i;
+        }
+    }
+    return -1;
 }
 
 /**
@@ -36,13 +53,30 @@ int EnvelopeFollower::readEnvelopeLevel() {
 }
 
 /**
- * processEnvelopeLevel(int level)
+ * readARGInput(pin, levels)
+ * - The level of an envelope input from a shared frame, or a raw read
+ *   of the pin when there is none (bench update()). Bound EFs never get
+ *   here: the bank combines its own conditioned frame
+ */
+int EnvelopeFollower::readARGInput(int pin, const uint8_t* levels) {
+    if (pin < 0) {
+        return 0;
+    }
+    int index = inputIndexForPin(pin);
+    if (levels && index >= 0) {
+        return levels[index];
+    }
+    return map(analogRead(pin), 0, 1023, 0, 127);
+}
+
+/**
+ * processEnvelopeLevel(int level, levels)
  * - If mode == SEF, it behaves exactly like your original code:
  *   filtering (low, high, band) or curve (linear, opposite, etc.).
  * - If mode == ARG, it uses your math combos (PLUS, MIN, etc.)
- *   reading from envelopeA and envelopeB.
+ *   on the envelopes of inputs envelopeA and envelopeB.
  */
-int EnvelopeFollower::processEnvelopeLevel(int level) {
+int EnvelopeFollower::processEnvelopeLevel(int level, const uint8_t* levels) {
     level = constrain(level, 0, 127);
 
     // Original envelope follower mode
@@ -51,34 +85,17 @@ int EnvelopeFollower::processEnvelopeLevel(int level) {
         if (filterType == LOWPASS || filterType == HIGHPASS || filterType == BANDPASS) {
             return filter.process(level);
         }
-        // Original processing logic
-        switch (filterType) {
-            case LINEAR:
-                return level;
-            case OPPOSITE_LINEAR:
-                return 127 - level;
-            case EXPONENTIAL:
-                return pow(level / 127.0, 2) * 127;
-            case RANDOM:
-                return random(level);
-            default:
-                return level;
+        if (filterType == RANDOM) {
+            return random(level);
         }
+        // Every curve is one table read
+        return curve[level];
     }
     else {
-        // ARG mode: read two envelope pins, do your math combos
-        int A = 0;
-        int B = 0;
-
+        // ARG mode: take two envelope inputs, do your math combos
         // If envelopeA/B >= 0, treat them as valid analog pins
-        if (envelopeA >= 0) {
-            int rawA = analogRead(envelopeA);
-            A = map(rawA, 0, 1023, 0, 127);
-        }
-        if (envelopeB >= 0) {
-            int rawB = analogRead(envelopeB);
-            B = map(rawB, 0, 1023, 0, 127);
-        }
+        int A = readARGInput(envelopeA, levels);
+        int B = readARGInput(envelopeB, levels);
 
         switch (argMethod) {
             case PLUS: return constrain(A + B, 0, 127);
@@ -96,33 +113,46 @@ int EnvelopeFollower::processEnvelopeLevel(int level) {
 /**
  * update()
  * updates envelope level each loop if active
+ * - ARG only converts its A/B pins; its own pin would go unused
  */
 void EnvelopeFollower::update() {
     if (isActive) {
-        int rawLevel = readEnvelopeLevel();
-        currentEnvelopeLevel = processEnvelopeLevel(rawLevel);
+        int rawLevel = (mode == SEF) ? readEnvelopeLevel() : 0;
+        currentEnvelopeLevel = processEnvelopeLevel(rawLevel, nullptr);
     }
 }
 
 /**
- * applyToCC()
- * final step where envelope modifies CC
- * - Just adds or subtracts the new envelope level
- * - Avoids redundant MIDI messages
+ * bind()
+ * - From here on the bank does the processing; push all current settings
  */
-void EnvelopeFollower::applyToCC(int potIndex, uint8_t& ccValue) {
-    static uint8_t lastSentCC[NUM_POTS] = {255}; // same as original
-
-    if (isActive && modulationTargetCC >= 0) {
-        int modulatedValue = ccValue + currentEnvelopeLevel;
-        ccValue = constrain(modulatedValue, 0, 127);
+void EnvelopeFollower::bind(EnvelopeBank<NUM_ENVELOPES>* envelopeBank, uint8_t index) {
+    bank = envelopeBank;
+    bankIndex = index;
+    bank->setInput(bankIndex, inputIndex);
+    syncBank();
+}
 
-        // Original redundancy check
-        if (ccValue != lastSentCC[potIndex]) {
-            lastSentCC[potIndex] = ccValue;
-            midiHandler.sendControlChange(modulationTargetCC, ccValue, potManager->getChannel(potIndex));
-        }
+/**
+ * syncBank()
+ * - Mirror mode, filter type/coefficients, ARG method and inputs into the bank
+ */
+void EnvelopeFollower::syncBank() {
+    if (!bank) {
+        return;
     }
+    static const EnvelopeShape SHAPES[] = {
+        SHAPE_CURVE, SHAPE_CURVE, SHAPE_CURVE, SHAPE_RANDOM,    // LINEAR, OPPOSITE_LINEAR, EXPONENTIAL, RANDOM
+        SHAPE_FILTER, SHAPE_FILTER, SHAPE_FILTER,               // LOWPASS, HIGHPASS, BANDPASS
+        SHAPE_CURVE, SHAPE_CURVE, SHAPE_CURVE                   // LOGARITHMIC, S_CURVE, CUSTOM
+    };
+    bank->setFilter(bankIndex, filter.coefficients(), filter.sections(), filter.rampSamples());
+    bank->setCurve(bankIndex, curve);
+    bank->setShape(bankIndex, SHAPES[filterType]);
+    bank->setArgMode(bankIndex, mode == ARG);
+    bank->setArgOp(bankIndex, static_cast<EnvelopeArgOp>(argMethod));
+    bank->setArgInputs(bankIndex, inputIndexForPin(envelopeA), inputIndexForPin(envelopeB));
+    bank->setActive(bankIndex, isActive);
 }
 
 /**
@@ -131,6 +161,7 @@ void EnvelopeFollower::applyToCC(int potIndex, uint8_t& ccValue) {
 void EnvelopeFollower::toggleActive(bool state) {
     if (isActive != state) {
         isActive = state;
+        syncBank();
     }
 }
 
@@ -141,13 +172,6 @@ bool EnvelopeFollower::getActiveState() const {
     return isActive;
 }
 
-/**
- * setModulationTarget()
- */
-void EnvelopeFollower::setModulationTarget(int cc) {
-    modulationTargetCC = cc;
-}
-
 /**
  * setFilterType()
  */
@@ -156,18 +180,20 @@ void EnvelopeFollower::setFilterType(FilterType type) {
     // Reapply default config based on new filter type
     switch (type) {
         case LOWPASS:
-            filter.configure(BiquadFilter::LOWPASS, 1000, 44100, 0.707);
+            filter.configure(BiquadFilter::LOWPASS, 1000, ENVELOPE_CONTROL_RATE, 0.707);
             break;
         case HIGHPASS:
-            filter.configure(BiquadFilter::HIGHPASS, 1000, 44100, 0.707);
+            filter.configure(BiquadFilter::HIGHPASS, 1000, ENVELOPE_CONTROL_RATE, 0.707);
             break;
         case BANDPASS:
-            filter.configure(BiquadFilter::BANDPASS, 1000, 44100, 0.707);
+            filter.configure(BiquadFilter::BANDPASS, 1000, ENVELOPE_CONTROL_RATE, 0.707);
             break;
         default:
-            // LINEAR, OPPOSITE_LINEAR, EXPONENTIAL, RANDOM -> no filter usage
+            // Curves and RANDOM -> no filter usage
             break;
     }
+    rebuildCurve();
+    syncBank();
 }
 
 /**
@@ -177,18 +203,94 @@ void EnvelopeFollower::setFilterType(FilterType type) {
 void EnvelopeFollower::configureFilter(float frequency, float q) {
     switch (filterType) {
         case LOWPASS:
-            filter.configure(BiquadFilter::LOWPASS, frequency, 44100, q);
+            filter.configure(BiquadFilter::LOWPASS, frequency, ENVELOPE_CONTROL_RATE, q);
             break;
         case HIGHPASS:
-            filter.configure(BiquadFilter::HIGHPASS, frequency, 44100, q);
+            filter.configure(BiquadFilter::HIGHPASS, frequency, ENVELOPE_CONTROL_RATE, q);
             break;
         case BANDPASS:
-            filter.configure(BiquadFilter::BANDPASS, frequency, 44100, q);
+            filter.configure(BiquadFilter::BANDPASS, frequency, ENVELOPE_CONTROL_RATE, q);
             break;
         default:
             // Non-filter types skip
             break;
     }
+    syncBank();
+}
+
+/**
+ * tuneFilter()
+ * - Same as configureFilter(), from the live-tuning table (pot steps)
+ *   instead of designing the coefficients here
+ */
+void EnvelopeFollower::tuneFilter(const FilterTuningTable& table, uint16_t freqStep, uint16_t qStep) {
+    switch (filterType) {
+        case LOWPASS:
+            filter.setTarget(table.lookup(BiquadFilter::LOWPASS, freqStep, qStep));
+            break;
+        case HIGHPASS:
+            filter.setTarget(table.lookup(BiquadFilter::HIGHPASS, freqStep, qStep));
+            break;
+        case BANDPASS:
+            filter.setTarget(table.lookup(BiquadFilter::BANDPASS, freqStep, qStep));
+            break;
+        default:
+            // Non-filter types skip
+            return;
+    }
+    syncBank();
+}
+
+/**
+ * curveForType()
+ * - Which response table a type uses
+ */
+CurveType EnvelopeFollower::curveForType(FilterType type) {
+    switch (type) {
+        case LINEAR:          return CURVE_LINEAR;
+        case OPPOSITE_LINEAR: return CURVE_INVERTED;
+        case EXPONENTIAL:     return CURVE_EXPONENTIAL;
+        case LOGARITHMIC:     return CURVE_LOGARITHMIC;
+        case S_CURVE:         return CURVE_S_CURVE;
+        case CUSTOM:          return CURVE_CUSTOM;
+        default:              return CURVE_COUNT;
+    }
+}
+
+/**
+ * typeForCurve()
+ * - Inverse of curveForType()
+ */
+EnvelopeFollower::FilterType EnvelopeFollower::typeForCurve(CurveType curve) {
+    for (int type = LINEAR; type <= CUSTOM; type++) {
+        if (curveForType(static_cast<FilterType>(type)) == curve) {
+            return static_cast<FilterType>(type);
+        }
+    }
+    return LINEAR;
+}
+
+/**
+ * rebuildCurve()
+ * - Refill the response table for the current type (settings changes only)
+ */
+void EnvelopeFollower::rebuildCurve() {
+    CurveType type = curveForType(filterType);
+    if (type != CURVE_COUNT) {
+        buildCurve(type, curve, customCurve);
+    }
+}
+
+/**
+ * setCustomCurve()
+ * - CURVE_BREAKPOINTS levels, one every 8 input levels; takes effect as CUSTOM
+ */
+void EnvelopeFollower::setCustomCurve(const uint8_t* points) {
+    memcpy(customCurve, points, CURVE_BREAKPOINTS);
+    if (filterType == CUSTOM) {
+        rebuildCurve();
+        syncBank();
+    }
 }
 
 /**
@@ -204,6 +306,7 @@ EnvelopeFollower::FilterType EnvelopeFollower::getFilterType() const {
  */
 void EnvelopeFollower::setMode(Mode newMode) {
     mode = newMode;
+    syncBank();
 }
 
 /**
@@ -212,6 +315,7 @@ void EnvelopeFollower::setMode(Mode newMode) {
  */
 void EnvelopeFollower::setARGMethod(ARG_Method method) {
     argMethod = method;
+    syncBank();
 }
 
 /**
@@ -221,11 +325,12 @@ void EnvelopeFollower::setARGMethod(ARG_Method method) {
 void EnvelopeFollower::setEnvelopePair(int envA, int envB) {
     envelopeA = envA;
     envelopeB = envB;
+    syncBank();
 }
 
 /**
  * getEnvelopeLevel()
  */
 int EnvelopeFollower::getEnvelopeLevel() const {
-    return currentEnvelopeLevel;
+    return bank ? bank->level(bankIndex) : currentEnvelopeLevel;
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "EnvelopeSampler.h"
+#include <TimerOne.h>
+#include "Utility.h"
+
+EnvelopeSampler* EnvelopeSampler::_instance = nullptr;
+
+EnvelopeSampler::EnvelopeSampler(const uint8_t* pins)
+    : _pins(pins), _periodMicros(ENVELOPE_SAMPLE_PERIOD_US)
+{
+    for (uint8_t i = 0; i < NUM_ENVELOPES; i++) {
+        _channels[i] = Utility::adcChannelForPin(_pins[i]);
+    }
+}
+
+void EnvelopeSampler::begin(uint32_t periodMicros) {
+    _periodMicros = periodMicros;
+    _instance = this;
+    for (uint8_t i = 0; i < NUM_ENVELOPES; i++) {
+        pinMode(_pins[i], INPUT);
+    }
+    Timer1.initialize(periodMicros);
+    Timer1.attachInterrupt(timerISR);
+}
+
+bool EnvelopeSampler::read(EnvelopeFrame& frame) {
+    return _frames.pop(frame);
+}
+
+void EnvelopeSampler::timerISR() {
+    if (_instance) {
+        _instance->sampleFrame();
+    }
+}
+
+void EnvelopeSampler::sampleFrame() {
+    EnvelopeFrame frame;
+    frame.timestamp = micros();
+    for (uint8_t i = 0; i < NUM_ENVELOPES; i++) {
+        ADC2_HC0 = _channels[i];
+        while (!(ADC2_HS & ADC_HS_COCO0)) {
+            // ~2 us per conversion at the core's default ADC settings
+        }
+        frame.samples[i] = ADC2_R0;
+    }
+    _frames.push(frame);
+}
@@ -3,83 +3,219 @@
 
 MIDI_CREATE_INSTANCE(HardwareSerial, Serial1, MIDI);
 
-MIDIHandler::MIDIHandler() {}
+static IntervalTimer clockTimer;
+static MIDIHandler* clockTimerOwner = nullptr;
+
+// The clock timer writes to Serial1 from its interrupt. Our own writes
+// hold it off (only the PIT interrupt; Serial1.write() re-enables the
+// rest) so the two never interleave inside the core's buffer.
+struct ClockTimerLock {
+    ClockTimerLock() { NVIC_DISABLE_IRQ(IRQ_PIT); }
+    ~ClockTimerLock() { NVIC_ENABLE_IRQ(IRQ_PIT); }
+};
+
+// Serial1 as MidiDinTransmitter sees it
+struct DinPort {
+    int availableForWrite() { return Serial1.availableForWrite(); }
+    size_t write(const uint8_t* data, size_t size) {
+        ClockTimerLock lock;
+        return Serial1.write(data, size);
+    }
+};
+
+MIDIHandler::MIDIHandler() {
+    _input.setRoute(MIDI_ROUTE_NOTE, onNote, this);
+    _input.setRoute(MIDI_ROUTE_CLOCK, onClock, this);
+    _input.setRoute(MIDI_ROUTE_TRANSPORT, onTransport, this);
+}
 
 void MIDIHandler::begin() {
     MIDI.begin(MIDI_CHANNEL_OMNI);
+    MIDI.turnThruOff();   // Note thru goes through our queue; the library's would bypass the DIN transmitter
     usbMIDI.begin();
+
+    // Internal clock: the interval after the first one is loaded up front, see ClockGenerator
+    clockTimerOwner = this;
+    clockTimer.begin(onClockTimer, _clockOut.nextInterval());
+    clockTimer.update(_clockOut.nextInterval());
+}
+
+void MIDIHandler::onClockTimer() {
+    MIDIHandler* self = clockTimerOwner;
+    uint8_t bytes[2];
+    uint8_t count = self->_clockOut.tick(micros(), bytes);
+    clockTimer.update(self->_clockOut.nextInterval());
+    for (uint8_t i = 0; i < count; i++) {
+        self->sendRealTimeNow(bytes[i]);
+    }
+}
+
+void MIDIHandler::setClockOutTempo(float bpm) {
+    ClockTimerLock lock;   // The ramp is planned from the timer's own state
+    _clockOut.rampTo(bpm);
+}
+
+void MIDIHandler::syncClockOut(float bpm, uint32_t beatAtMicros) {
+    ClockTimerLock lock;
+    _clockOut.syncTo(bpm, beatAtMicros);
+}
+
+// Interrupt context: around the queues (real-time bytes may go between any others).
+// DIN gets it straight away. USB doesn't: usb_midi_write_packed() waits (and
+// yields) for a free TX buffer when the host isn't reading, which would stall
+// the timer and everything else on the PIT. So it is handed to loop().
+void MIDIHandler::sendRealTimeNow(uint8_t status) {
+    Serial1.write(status);   // MidiDinTransmitter keeps room for it
+    _usbRealTime.push(status);   // Full (loop() stuck): dropped and counted
+}
+
+void MIDIHandler::flushRealTime() {
+    if (_usbRealTime.empty()) return;
+    uint32_t events[MIDI_USB_REALTIME_QUEUE];
+    uint8_t count = 0;
+    uint8_t status;
+    while (count < MIDI_USB_REALTIME_QUEUE && _usbRealTime.pop(status)) {
+        MidiOutMessage m = { status, 0, 0, 1, 0 };
+        events[count++] = UsbMidiPacker::encode(m);
+    }
+    writeUsbPacket(events, count);
 }
 
 void MIDIHandler::sendControlChange(uint8_t control, uint8_t value, uint8_t channel) {
     // Validate before sending
     if (control > 127 || value > 127 || channel < 1 || channel > 16)
         return;
-    MIDI.sendControlChange(control, value, channel);
-    usbMIDI.sendControlChange(control, value, channel);  // USB MIDI
+    uint32_t now = micros();
+    _dinOut.pushControlChange(control, value, channel, now);
+    _usbOut.pushControlChange(control, value, channel, now);  // USB MIDI
 }
 
 void MIDIHandler::sendNoteOn(uint8_t note, uint8_t velocity, uint8_t channel) {
     if (note > 127 || velocity > 127 || channel < 1 || channel > 16)
         return;
-    MIDI.sendNoteOn(note, velocity, channel);
-    usbMIDI.sendNoteOn(note, velocity, channel);
+    uint32_t now = micros();
+    _dinOut.pushMessage(midi::NoteOn | (channel - 1), note, velocity, 3, now);
+    _usbOut.pushMessage(midi::NoteOn | (channel - 1), note, velocity, 3, now);
 }
 
 void MIDIHandler::sendNoteOff(uint8_t note, uint8_t velocity, uint8_t channel) {
     if (note > 127 || velocity > 127 || channel < 1 || channel > 16)
         return;
-    MIDI.sendNoteOff(note, velocity, channel);
-    usbMIDI.sendNoteOff(note, velocity, channel);
+    uint32_t now = micros();
+    _dinOut.pushMessage(midi::NoteOff | (channel - 1), note, velocity, 3, now);
+    _usbOut.pushMessage(midi::NoteOff | (channel - 1), note, velocity, 3, now);
 }
 
-void MIDIHandler::processIncomingMIDI() {
-    // Process Serial MIDI
-    if (MIDI.read()) {
-        handleMIDI(MIDI.getType(), MIDI.getChannel(), MIDI.getData1(), MIDI.getData2());
+void MIDIHandler::flushOutput() {
+    uint32_t now = micros();
+    // DIN: only what fits in the UART's TX buffer, the rest waits (and merges)
+    DinPort din;
+    _dinTx.service(_dinOut, din, now);
+    _dinTx.update(now);
+    // USB: whole packets as they fill, a partial one once it has waited long enough
+    auto writePacket = [this](const uint32_t* events, uint8_t count) { writeUsbPacket(events, count); };
+    _usbOut.drain([&](const MidiOutMessage& m) { _usbPacker.add(m, now, writePacket); });
+    _usbPacker.service(now, writePacket);
+    _usbMeter.update(now);
+}
+
+void MIDIHandler::flush() {
+    uint32_t now = micros();
+    auto writePacket = [this](const uint32_t* events, uint8_t count) { writeUsbPacket(events, count); };
+    _usbOut.drain([&](const MidiOutMessage& m) { _usbPacker.add(m, now, writePacket); });
+    _usbPacker.flush(writePacket);
+}
+
+// May wait for the host; only ever called from loop(), so the clock timer keeps running meanwhile
+void MIDIHandler::writeUsbPacket(const uint32_t* events, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        usb_midi_write_packed(events[i]);
     }
+    usbMIDI.send_now();   // One transfer for the lot
+    _usbMeter.add(count * 4, count);
+}
 
-    // Process USB MIDI (single loop; removed duplicate read)
+void MIDIHandler::resetOutputStats() {
+    uint32_t now = micros();
+    _dinOut.resetStats();
+    _usbOut.resetStats();
+    _dinTx.resetStats(now);
+    _usbPacker.resetStats();
+    _usbMeter.reset(now);
+    _input.resetStats();
+}
+
+void MIDIHandler::processIncomingMIDI() {
+    bool activity = false;   // Anything a person did, i.e. not clock or other real-time bytes
+
+    // Drain both ports completely, so a dense stream can't back up in them
+    // Each message is stamped as it is read, so clock ticks read in one pass keep their spacing
+    while (MIDI.read()) {
+        uint32_t now = micros();
+        uint8_t type = MIDI.getType();
+        if (type == midi::SystemExclusive) {
+            unsigned length = MIDI.getSysExArrayLength();
+            queueInput(type, 0, length & 0x7F, (length >> 7) & 0x7F, MIDI_IN_DIN, now);
+        } else {
+            queueInput(type, MIDI.getChannel(), MIDI.getData1(), MIDI.getData2(), MIDI_IN_DIN, now);
+        }
+        activity |= type < midi::Clock;
+    }
     while (usbMIDI.read()) {
-        handleMIDI(usbMIDI.getType(), usbMIDI.getChannel(), usbMIDI.getData1(), usbMIDI.getData2());
+        uint32_t now = micros();
+        uint8_t type = usbMIDI.getType();
+        if (type == usbMIDI.SystemExclusive) {
+            uint16_t length = usbMIDI.getSysExArrayLength();
+            queueInput(type, 0, length & 0x7F, (length >> 7) & 0x7F, MIDI_IN_USB, now);
+        } else {
+            queueInput(type, usbMIDI.getChannel(), usbMIDI.getData1(), usbMIDI.getData2(), MIDI_IN_USB, now);
+        }
+        activity |= type < usbMIDI.Clock;
     }
-    if (_displayManager) {
-    _displayManager->registerInteraction();
-  }
-}
-
-void MIDIHandler::handleMIDI(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2) {
-    switch (type) {
-        case midi::ControlChange:
-            Serial.printf("CC: %d, Value: %d, Channel: %d\n", data1, data2, channel);
-            break;
-        case midi::NoteOn:
-            handleNoteOn(channel, data1, data2);
-            break;
-        case midi::NoteOff:
-            handleNoteOff(channel, data1, data2);
-            break;
-        default:
-            Serial.println("Unhandled MIDI message");
-            break;
+
+    _input.dispatch();
+    if (activity && _displayManager) {
+        _displayManager->registerInteraction();
     }
 }
 
-void MIDIHandler::handleNoteOn(uint8_t channel, uint8_t note, uint8_t velocity) {
-    Serial.printf("Note On: %d, Velocity: %d, Channel: %d\n", note, velocity, channel);
-    MIDI.sendNoteOn(note, velocity, channel);
-    usbMIDI.sendNoteOn(note, velocity, channel);
+void MIDIHandler::queueInput(uint8_t type, uint8_t channel, uint8_t data1, uint8_t data2, MidiInSource source, uint32_t now) {
+    if (!_input.push(type, channel, data1, data2, source, now)) {
+        // Ring full: route what we have and make room rather than drop
+        _input.dispatch();
+        _input.push(type, channel, data1, data2, source, now);
+    }
 }
 
-void MIDIHandler::handleNoteOff(uint8_t channel, uint8_t note, uint8_t velocity) {
-    Serial.printf("Note Off: %d, Velocity: %d, Channel: %d\n", note, velocity, channel);
-    MIDI.sendNoteOff(note, velocity, channel);
-    usbMIDI.sendNoteOff(note, velocity, channel);
+void MIDIHandler::onNote(void* context, const MidiInEvent& event) {
+    MIDIHandler* self = static_cast<MIDIHandler*>(context);
+    if (event.type() == midi::NoteOn) {
+        self->handleNoteOn(event.channel(), event.data1, event.data2);
+    } else {
+        self->handleNoteOff(event.channel(), event.data1, event.data2);
+    }
+}
+
+void MIDIHandler::onClock(void* context, const MidiInEvent& event) {
+    static_cast<MIDIHandler*>(context)->_clock.onClock(event.timestamp);
+}
+
+void MIDIHandler::onTransport(void* context, const MidiInEvent& event) {
+    ClockFollower& clock = static_cast<MIDIHandler*>(context)->_clock;
+    switch (event.status) {
+        case midi::Start:        clock.onStart(); break;
+        case midi::Continue:     clock.onContinue(); break;
+        case midi::Stop:         clock.onStop(); break;
+        case midi::SongPosition: clock.onSongPosition(event.data1 | (event.data2 << 7)); break;
+        default: break;
+    }
 }
 
-bool MIDIHandler::isClockTick() {
-    return MIDI.getType() == midi::Clock;
+void MIDIHandler::handleNoteOn(uint8_t channel, uint8_t note, uint8_t velocity) {
+    sendNoteOn(note, velocity, channel);   // Thru
 }
 
-void MIDIHandler::clearClockTick() {
-    clockTick = false;
+void MIDIHandler::handleNoteOff(uint8_t channel, uint8_t note, uint8_t velocity) {
+    sendNoteOff(note, velocity, channel);
 }
+
@@ -0,0 +1,54 @@
+#include "MuxBus.h"
+#include "Utility.h"
+
+MuxBus::MuxBus(const uint8_t* primaryPins, const uint8_t* secondaryPins,
+               uint8_t potAnalogPin, uint8_t buttonAnalogPin)
+    : _hal{primaryPins, secondaryPins,
+           {Utility::adcChannelForPin(potAnalogPin), Utility::adcChannelForPin(buttonAnalogPin)},
+           0xFF},
+      _scanner(_hal),
+      _analogPins{potAnalogPin, buttonAnalogPin}
+{
+    // A button only needs one conversion against a threshold
+    _scanner.setSamples(MUX_CHANNEL_BUTTONS, 1);
+}
+
+void MuxBus::begin() {
+    for (int i = 0; i < PRIMARY_MUX_PINS; i++) {
+        pinMode(_hal.primaryPins[i], OUTPUT);
+    }
+    for (int i = 0; i < SECONDARY_MUX_PINS; i++) {
+        pinMode(_hal.secondaryPins[i], OUTPUT);
+    }
+    for (int c = 0; c < MUX_CHANNEL_COUNT; c++) {
+        pinMode(_analogPins[c], INPUT);
+    }
+}
+
+uint8_t MuxBus::service(uint32_t budgetMicros) {
+    return _scanner.service(budgetMicros);
+}
+
+void MuxBus::setSampleCallback(MuxSampleCallback callback, void* context) {
+    _scanner.setCallback(callback, context);
+}
+
+uint16_t MuxBus::read(MuxBusChannel channel, uint8_t address) const {
+    return _scanner.value(channel, address);
+}
+
+uint32_t MuxBus::fullScans() const {
+    return _scanner.fullScans();
+}
+
+int MuxBus::readBlocking(MuxBusChannel channel, uint8_t address) {
+    _hal.select(address);
+    _scanner.abortConversion(); // The sweep re-selects its own address next time
+    delayMicroseconds(MUX_SCAN_SETTLE_US);
+    return analogRead(_analogPins[channel]);
+}
+
+int MuxBus::readPin(uint8_t pin) {
+    _scanner.abortConversion(); // analogRead() takes over ADC1 and clears the sweep's result
+    return analogRead(pin);
+}
@@ -8,58 +8,26 @@ const float alpha = 0.1; // Smoothing factor
 static int smoothedValue[NUM_POTS] = {0};
 #define CHANGE_THRESHOLD 2  // Adjust based on your noise tolerance
 
-PotentiometerManager::PotentiometerManager(
-    const uint8_t* primaryPins,
-    const uint8_t* secondaryPins,
-    uint8_t analogPin
-) : primaryMuxPins(primaryPins), secondaryMuxPins(secondaryPins), analogPin(analogPin) {
-    // Initialize pot default values
+PotentiometerManager::PotentiometerManager(MuxBus* muxBus, ConfigManager* configManager)
+  : muxBus(muxBus),
+    configManager(configManager),
+    takeoverArmed(0),
+    takeoverFromBelow(0),
+    scanBudgetMicros(POT_SCAN_BUDGET_US),
+    scanLedManager(nullptr) {
     for (int i = 0; i < NUM_POTS; i++) {
-        potChannels[i] = 1;       // Default MIDI channel
-        potCCNumbers[i] = i;      // Default MIDI CC number
         potLastValues[i] = -1;    // Ensure the first read updates
     }
+    muxBus->setSampleCallback(onMuxSample, this);
 }
 
 void PotentiometerManager::setMidiCallback(std::function<void(uint8_t, uint8_t, uint8_t)> callback) {
     midiCallback = callback;
 }
 
-void PotentiometerManager::selectMuxBank(uint8_t bank) {
-    static uint8_t lastBank = 255; // Track the last selected bank
-    if (bank != lastBank) {
-        for (int i = 0; i < PRIMARY_MUX_PINS; i++) {
-            digitalWrite(primaryMuxPins[i], (bank >> i) & 1);
-        }
-        lastBank = bank;
-    }
-}
-
-void PotentiometerManager::selectPotBank(uint8_t pot) {
-    static uint8_t lastPot = 255; // Track the last selected pot
-    if (pot != lastPot) {
-        for (int i = 0; i < SECONDARY_MUX_PINS; i++) {
-            digitalWrite(secondaryMuxPins[i], (pot >> i) & 1);
-        }
-        lastPot = pot;
-    }
-}
-
-int PotentiometerManager::readAnalogFiltered(uint8_t pin) {
-    int total = 0;
-    const int numSamples = 4; // Number of samples for averaging
-
-    for (int i = 0; i < numSamples; i++) {
-        total += analogRead(pin); // Read analog value
-        delayMicroseconds(10);    // Small delay for stability
-    }
-
-    return total / numSamples; // Return the averaged value
-}
-
 void PotentiometerManager::setChannel(int potIndex, uint8_t channel) {
     if (potIndex < NUM_POTS) {
-        potChannels[potIndex] = channel;
+        configManager->setPotChannel(potIndex, channel);
     }
 }
 
@@ -73,81 +41,102 @@ int PotentiometerManager::getLastValue(int potIndex) const {
 
 void PotentiometerManager::setCCNumber(int potIndex, uint8_t ccNumber) {
     if (potIndex < NUM_POTS) {
-        potCCNumbers[potIndex] = ccNumber;
+        configManager->setPotCCNumber(potIndex, ccNumber);
     }
 }
 
 uint8_t PotentiometerManager::getChannel(int potIndex) {
-    return (potIndex < NUM_POTS) ? potChannels[potIndex] : 0;
+    return (potIndex < NUM_POTS) ? configManager->getPotChannel(potIndex) : 0;
 }
 
 uint8_t PotentiometerManager::getCCNumber(int potIndex) {
-    return (potIndex < NUM_POTS) ? potCCNumbers[potIndex] : 0;
+    return (potIndex < NUM_POTS) ? configManager->getPotCCNumber(potIndex) : 0;
 }
 
+void PotentiometerManager::takeOver(uint8_t potIndex, uint8_t midiValue) {
+    if (potIndex >= NUM_POTS) return;
+    uint64_t bit = 1ULL << potIndex;
+    int target = Utility::mapToRange(midiValue, 0, 127, 0, 1023);
+    potLastValues[potIndex] = target;
+    takeoverArmed |= bit;
+    if (smoothedValue[potIndex] < target) {
+        takeoverFromBelow |= bit;
+    } else {
+        takeoverFromBelow &= ~bit;
+    }
+}
 
-void PotentiometerManager::processPots(LEDManager& ledManager, std::vector<EnvelopeFollower>& envelopes) {
-    for (uint8_t primaryBank = 0; primaryBank < (1 << PRIMARY_MUX_PINS); primaryBank++) {
-        selectMuxBank(primaryBank);
+void PotentiometerManager::setScanBudget(uint32_t micros) {
+    scanBudgetMicros = micros;
+}
 
-        for (uint8_t secondaryBank = 0; secondaryBank < (1 << SECONDARY_MUX_PINS); secondaryBank++) {
-            selectPotBank(secondaryBank);
+uint32_t PotentiometerManager::getFullScans() const {
+    return muxBus->fullScans();
+}
 
-            uint8_t potIndex = (primaryBank << SECONDARY_MUX_PINS) | secondaryBank;
+void PotentiometerManager::processPots(LEDManager& ledManager) {
+    scanLedManager = &ledManager;
+    muxBus->service(scanBudgetMicros);
+    scanLedManager = nullptr;
+}
 
-            if (potIndex >= NUM_POTS) break;
+void PotentiometerManager::onMuxSample(void* context, uint8_t address, const uint16_t* values) {
+    if (address < NUM_POTS) {
+        static_cast<PotentiometerManager*>(context)->handlePotSample(address, values[MUX_CHANNEL_POTS]);
+    }
+}
 
-            // Use filtered analog read
-            int rawValue = readAnalogFiltered(analogPin);
+// Runs while the mux settles on the next pot
+void PotentiometerManager::handlePotSample(uint8_t potIndex, int rawValue) {
+    // Apply EWMA smoothing
+    smoothedValue[potIndex] = Utility::exponentialMovingAverage(rawValue, smoothedValue[potIndex], alpha);
 
-            // Apply EWMA smoothing
-           smoothedValue[potIndex] = Utility::exponentialMovingAverage(rawValue, smoothedValue[potIndex], alpha);
+    // After an incoming CC: wait for the knob to reach (or cross) the value it set
+    uint64_t bit = 1ULL << potIndex;
+    if (takeoverArmed & bit) {
+        bool below = smoothedValue[potIndex] < potLastValues[potIndex];
+        bool near = abs(smoothedValue[potIndex] - potLastValues[potIndex]) <= CHANGE_THRESHOLD;
+        if (below == ((takeoverFromBelow & bit) != 0) && !near) return;
+        takeoverArmed &= ~bit;
+    }
 
-            // Smarter change detection
-            if (abs(smoothedValue[potIndex] - potLastValues[potIndex]) > CHANGE_THRESHOLD) {
-                potLastValues[potIndex] = smoothedValue[potIndex]; // Update last known value
-                dirtyFlags[potIndex] = true;
+    // Smarter change detection
+    if (abs(smoothedValue[potIndex] - potLastValues[potIndex]) > CHANGE_THRESHOLD) {
+        potLastValues[potIndex] = smoothedValue[potIndex]; // Update last known value
+        dirtyFlags[potIndex] = true;
 
-                // Update LEDs to reflect the new value
-                ledManager.setPotValue(potIndex, smoothedValue[potIndex]);
+        // Update LEDs to reflect the new value
+        if (scanLedManager) {
+            scanLedManager->setPotValue(potIndex, smoothedValue[potIndex]);
+        }
 
-                // Send the MIDI update if a callback is set
-                if (midiCallback) {
-                    midiCallback(
-                        potCCNumbers[potIndex],               // CC number for this pot
-                        Utility::mapToMidiValue(smoothedValue[potIndex]), // Map value to MIDI range
-                        potChannels[potIndex]                // Channel for this pot
-                    );
-                }
-            }
+        // Send the MIDI update if a callback is set
+        if (midiCallback) {
+            midiCallback(
+                configManager->getPotCCNumber(potIndex),          // CC number for this pot
+                Utility::mapToMidiValue(smoothedValue[potIndex]), // Map value to MIDI range
+                configManager->getPotChannel(potIndex)            // Channel for this pot
+            );
         }
     }
 }
 
+// The pot mapping used to be kept here too, stored at i*2 on top of ConfigManager's
+// layout; ConfigManager is now the only copy, so these just go through it
 void PotentiometerManager::loadFromEEPROM() {
     Serial.println("Loading potentiometer settings from EEPROM...");
-    for (uint8_t i = 0; i < NUM_POTS; i++) {
-        int address = i * 2;
-        potChannels[i] = EEPROM.read(address);
-        potCCNumbers[i] = EEPROM.read(address + 1);
-    }
+    std::vector<uint8_t> channels;
+    configManager->loadConfiguration(channels);
 }
 
 void PotentiometerManager::resetEEPROM() {
     Serial.println("Resetting EEPROM settings for potentiometers...");
-    for (uint8_t i = 0; i < NUM_POTS; i++) {
-        potChannels[i] = 1;  // Default MIDI channel
-        potCCNumbers[i] = i;  // Default CC number
-        EEPROM.update(i * 2, potChannels[i]);
-        EEPROM.update(i * 2 + 1, potCCNumbers[i]);
-    }
+    std::vector<uint8_t> channels;
+    configManager->resetConfiguration(channels);
 }
 
 void PotentiometerManager::saveToEEPROM() {
-    for (uint8_t i = 0; i < NUM_POTS; i++) {
-        EEPROM.update(i*2,    potChannels[i]);
-        EEPROM.update(i*2+1,  potCCNumbers[i]);
-    }
+    configManager->saveConfiguration();
 }
 
 void PotentiometerManager::setArgEnvelopePair(int a, int b) {
@@ -161,13 +150,5 @@ void PotentiometerManager::getArgEnvelopePair(int &a, int &b) const {
 }
 
 int PotentiometerManager::readRawPot(uint8_t potIndex) {
-    // decode into bank and pot bits
-    uint8_t bank = potIndex >> SECONDARY_MUX_PINS;
-    uint8_t pot  = potIndex & ((1 << SECONDARY_MUX_PINS) - 1);
-
-    // do the private selects
-    selectMuxBank(bank);
-    selectPotBank(pot);
-    delayMicroseconds(5);           // settle time
-    return analogRead(analogPin);   // direct raw read
+    return muxBus->readBlocking(MUX_CHANNEL_POTS, potIndex); // direct raw read
 }
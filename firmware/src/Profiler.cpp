@@ -0,0 +1,137 @@
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+
+static const char* PROFILE_SLOT_NAMES[PROFILE_SLOT_COUNT] = {
+    "loop", "serialCmd", "schedHigh", "schedMid", "schedLow",
+    "buttons", "pots", "midi", "intClock", "serial",
+    "envelopes", "leds", "display", "btnEvents"
+};
+
+ProfileStats Profiler::_stats[PROFILE_SLOT_COUNT];
+
+static inline uint32_t cyclesPerMicro() {
+    return F_CPU_ACTUAL / 1000000;
+}
+
+// Log-spaced bucket: 4 sub-buckets per power of two
+static uint8_t bucketFor(uint32_t cycles) {
+    if (cycles < PROFILER_BUCKETS_PER_OCTAVE) return cycles;
+    uint8_t octave = 31 - __builtin_clz(cycles);
+    uint8_t sub = (cycles >> (octave - 2)) & (PROFILER_BUCKETS_PER_OCTAVE - 1);
+    uint16_t index = octave * PROFILER_BUCKETS_PER_OCTAVE + sub;
+    return (index < PROFILER_NUM_BUCKETS) ? index : PROFILER_NUM_BUCKETS - 1;
+}
+
+// Largest cycle count that still lands in the bucket
+static uint32_t bucketUpperBound(uint8_t index) {
+    if (index < PROFILER_BUCKETS_PER_OCTAVE) return index;
+    uint8_t octave = index / PROFILER_BUCKETS_PER_OCTAVE;
+    uint8_t sub = index % PROFILER_BUCKETS_PER_OCTAVE;
+    return ((uint32_t)(PROFILER_BUCKETS_PER_OCTAVE + sub + 1) << (octave - 2)) - 1;
+}
+
+void Profiler::begin() {
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+    reset();
+}
+
+void Profiler::reset() {
+    for (uint8_t i = 0; i < PROFILE_SLOT_COUNT; i++) {
+        uint32_t budget = _stats[i].budgetCycles;
+        _stats[i] = ProfileStats();
+        _stats[i].budgetCycles = budget; // Budgets survive a reset
+    }
+}
+
+void Profiler::setBudgetMicros(ProfileSlot slot, uint32_t micros) {
+    if (slot < PROFILE_SLOT_COUNT) {
+        _stats[slot].budgetCycles = micros * cyclesPerMicro();
+    }
+}
+
+void Profiler::record(ProfileSlot slot, uint32_t elapsedCycles) {
+    ProfileStats& s = _stats[slot];
+    s.count++;
+    s.totalCycles += elapsedCycles;
+    if (elapsedCycles < s.minCycles) s.minCycles = elapsedCycles;
+    if (elapsedCycles > s.maxCycles) s.maxCycles = elapsedCycles;
+    if (s.budgetCycles && elapsedCycles > s.budgetCycles) s.overruns++;
+    s.histogram[bucketFor(elapsedCycles)]++;
+}
+
+uint32_t Profiler::percentileCycles(ProfileSlot slot, uint8_t percent) {
+    const ProfileStats& s = _stats[slot];
+    if (s.count == 0) return 0;
+
+    uint32_t target = ((uint64_t)s.count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < PROFILER_NUM_BUCKETS; i++) {
+        seen += s.histogram[i];
+        if (seen >= target) {
+            uint32_t bound = bucketUpperBound(i);
+            return (bound < s.maxCycles) ? bound : s.maxCycles;
+        }
+    }
+    return s.maxCycles;
+}
+
+void Profiler::printReport(Print& out) {
+    const uint32_t cpm = cyclesPerMicro();
+    out.println("PROFILE (us)     count      min      avg      max      p99  overruns");
+    for (uint8_t i = 0; i < PROFILE_SLOT_COUNT; i++) {
+        const ProfileStats& s = _stats[i];
+        uint32_t avg = s.count ? (uint32_t)(s.totalCycles / s.count) : 0;
+        out.printf("%-12s %9lu %8lu %8lu %8lu %8lu %9lu\n",
+                   PROFILE_SLOT_NAMES[i],
+                   (unsigned long)s.count,
+                   (unsigned long)(s.count ? s.minCycles / cpm : 0),
+                   (unsigned long)(avg / cpm),
+                   (unsigned long)(s.maxCycles / cpm),
+                   (unsigned long)(percentileCycles((ProfileSlot)i, 99) / cpm),
+                   (unsigned long)s.overruns);
+    }
+}
+
+static void putU32(uint8_t* buf, uint32_t value) {
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    buf[2] = (value >> 16) & 0xFF;
+    buf[3] = (value >> 24) & 0xFF;
+}
+
+/**
+ * Binary frame, little endian:
+ *   "PRF1" | u8 slotCount | u32 cyclesPerMicro
+ *   slotCount x { u32 count, u32 minUs, u32 avgUs, u32 maxUs, u32 p99Us, u32 overruns }
+ *   u8 checksum (XOR of every byte after the magic)
+ */
+void Profiler::writeBinaryReport(Print& out) {
+    const uint32_t cpm = cyclesPerMicro();
+    uint8_t checksum = 0;
+    uint8_t buf[24];
+
+    out.write((const uint8_t*)"PRF1", 4);
+
+    buf[0] = PROFILE_SLOT_COUNT;
+    putU32(buf + 1, cpm);
+    for (uint8_t b = 0; b < 5; b++) checksum ^= buf[b];
+    out.write(buf, 5);
+
+    for (uint8_t i = 0; i < PROFILE_SLOT_COUNT; i++) {
+        const ProfileStats& s = _stats[i];
+        uint32_t avg = s.count ? (uint32_t)(s.totalCycles / s.count) : 0;
+        putU32(buf + 0,  s.count);
+        putU32(buf + 4,  s.count ? s.minCycles / cpm : 0);
+        putU32(buf + 8,  avg / cpm);
+        putU32(buf + 12, s.maxCycles / cpm);
+        putU32(buf + 16, percentileCycles((ProfileSlot)i, 99) / cpm);
+        putU32(buf + 20, s.overruns);
+        for (uint8_t b = 0; b < sizeof(buf); b++) checksum ^= buf[b];
+        out.write(buf, sizeof(buf));
+    }
+    out.write(&checksum, 1);
+}
+
+#endif // PROFILER_ENABLED
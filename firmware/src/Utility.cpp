@@ -72,6 +72,18 @@ int Utility::exponentialMovingAverage(int currentValue, int previousValue, float
     return alpha * currentValue + (1 - alpha) * previousValue;
 }
 
+// ADC
+/**
+ * Teensy 4.0 ADC channel for analog pins A0..A9.
+ * These pads use the same channel number on ADC1 and ADC2.
+ */
+uint8_t Utility::adcChannelForPin(uint8_t pin) {
+    static const uint8_t CHANNELS[] = { 7, 8, 12, 11, 6, 5, 15, 0, 13, 14 };
+    if (pin >= A0 && pin <= A9) return CHANNELS[pin - A0];
+    if (pin <= 9) return CHANNELS[pin]; // analogRead() also accepts 0..9 as A0..A9
+    return CHANNELS[0];
+}
+
 // System Operations
 void Utility::rebootTeensy() {
     SCB_AIRCR = 0x05FA0004; // System reset for ARM Cortex-M
@@ -209,25 +221,11 @@ void Utility::processBulkUpdate(const String& command, uint8_t numPots) {
     }
 }
 
-// --- Task Struct ---
-ScheduledTask::ScheduledTask(std::function<void()> cb, unsigned long intv)
-    : callback(cb), interval(intv), lastRun(0) {}
-
-// --- Task Scheduler ---
-void TaskScheduler::addTask(std::function<void()> callback, unsigned long interval) {
-    tasks.emplace_back(callback, interval);
-}
-
-void TaskScheduler::update() {
-    unsigned long now = millis();
-    for (auto& task : tasks) {
-        if (now - task.lastRun >= task.interval) {
-            task.callback();
-            task.lastRun = now;
-        }
-    }
-}
-
+// --- Task Schedulers ---
 TaskScheduler Utility::schedulerHigh;
 TaskScheduler Utility::schedulerMid;
 TaskScheduler Utility::schedulerLow;
+
+// --- One-shot timer wheels ---
+BeatTimers Utility::beatTimers;
+TimingWheel Utility::msTimers;
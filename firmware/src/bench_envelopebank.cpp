@@ -0,0 +1,268 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "BiquadFilter.h"
+#include "EnvelopeBank.h"
+
+// Host-side benchmark: cost per control-rate frame for all six EFs, the old
+// way (one EnvelopeFollower object at a time) vs. EnvelopeBank in one pass.
+// Also checks both give the same levels, frame by frame, and that ARG
+// combines conditioned inputs.
+
+#define BENCH_EFS 6
+#define BENCH_FRAMES 1000000
+#define BENCH_CONTROL_RATE 200.0f
+
+static const int BENCH_PINS[BENCH_EFS] = { 14, 15, 16, 17, 20, 21 }; // A0..A3, A6, A7 on Teensy 4.0
+
+// Shared with the bank's generator so RANDOM matches sample for sample
+static uint32_t legacyRandomState = 0x2545F491u;
+static int legacyRandom(int max) {
+    if (max <= 0) return 0;
+    legacyRandomState ^= legacyRandomState << 13;
+    legacyRandomState ^= legacyRandomState >> 17;
+    legacyRandomState ^= legacyRandomState << 5;
+    return static_cast<int>(legacyRandomState % static_cast<uint32_t>(max));
+}
+
+static int clampLevel(int x) { return x < 0 ? 0 : (x > 127 ? 127 : x); }
+
+/**
+ * EnvelopeFollower's per-object path: the mode, filter type and ARG
+ * method are switched on every frame, and the ARG inputs are found by
+ * searching the pin table. Two passes like the bank: condition() shapes
+ * the object's own input, update() reads the conditioned frame.
+ */
+struct LegacyEnvelopeFollower {
+    enum FilterType { LINEAR, OPPOSITE_LINEAR, EXPONENTIAL, RANDOM, LOWPASS, HIGHPASS, BANDPASS };
+    enum Mode { SEF, ARG };
+    enum ARG_Method { PLUS, MIN, PECK, SHAV, SQAR, BABS, TABS };
+
+    int audioInputPin;
+    uint8_t inputIndex = 0;
+    int currentEnvelopeLevel = 0;
+    int conditionedLevel = 0;
+    bool isActive = true;
+    FilterType filterType = LINEAR;
+    Mode mode = SEF;
+    ARG_Method argMethod = PLUS;
+    int envelopeA = 0;
+    int envelopeB = 1;
+    BiquadFilter filter;
+
+    explicit LegacyEnvelopeFollower(int pin) : audioInputPin(pin) {
+        int index = inputIndexForPin(pin);
+        if (index >= 0) inputIndex = index;
+    }
+
+    static int inputIndexForPin(int pin) {
+        for (uint8_t i = 0; i < BENCH_EFS; i++) {
+            if (BENCH_PINS[i] == pin) return i;
+        }
+        return -1;
+    }
+
+    int readARGInput(int pin, const uint8_t* levels) {
+        if (pin < 0) return 0;
+        int index = inputIndexForPin(pin);
+        return index >= 0 ? levels[index] : 0;
+    }
+
+    int shapeLevel(int level) {
+        level = clampLevel(level);
+        if (filterType == LOWPASS || filterType == HIGHPASS || filterType == BANDPASS) {
+            return filter.process(level);
+        }
+        switch (filterType) {
+            case LINEAR:          return level;
+            case OPPOSITE_LINEAR: return 127 - level;
+            case EXPONENTIAL:     return pow(level / 127.0, 2) * 127;
+            case RANDOM:          return legacyRandom(level);
+            default:              return level;
+        }
+    }
+
+    int combineLevels(const uint8_t* levels) {
+        int A = readARGInput(envelopeA, levels);
+        int B = readARGInput(envelopeB, levels);
+        switch (argMethod) {
+            case PLUS: return clampLevel(A + B);
+            case MIN:  return clampLevel(A - B);
+            case PECK: return clampLevel(B - A);
+            case SHAV: return clampLevel((A - B) / 10);
+            case SQAR: return clampLevel((int) sqrt((float)(A * A + B * B)));
+            case BABS: return (B != 0) ? clampLevel(A / abs(B)) : 0;
+            case TABS: return (B != 0) ? clampLevel((10 * A) / abs(B)) : 0;
+            default:   return 0;
+        }
+    }
+
+    void condition(const uint8_t* levels) {
+        if (isActive) {
+            conditionedLevel = shapeLevel(levels[inputIndex]);
+        }
+    }
+
+    void update(const uint8_t* conditioned) {
+        if (isActive) {
+            currentEnvelopeLevel = (mode == SEF) ? conditionedLevel : combineLevels(conditioned);
+        }
+    }
+};
+
+// One frame through every object: shape each input, then combine
+static void updateLegacy(std::vector<LegacyEnvelopeFollower>& efs, const uint8_t* levels) {
+    uint8_t conditioned[BENCH_EFS];
+    for (uint8_t i = 0; i < BENCH_EFS; i++) conditioned[i] = levels[i];
+    for (auto& ef : efs) {
+        ef.condition(levels);
+        if (ef.isActive) conditioned[ef.inputIndex] = static_cast<uint8_t>(clampLevel(ef.conditionedLevel));
+    }
+    for (auto& ef : efs) ef.update(conditioned);
+}
+
+struct BenchSetup {
+    std::vector<LegacyEnvelopeFollower> legacy;
+    EnvelopeBank<BENCH_EFS> bank;
+};
+
+/**
+ * A mixed patch touching every path: two filters (one a 2-section cascade), three curves, ARG.
+ */
+static void configure(BenchSetup& setup) {
+    typedef LegacyEnvelopeFollower L;
+    for (uint8_t i = 0; i < BENCH_EFS; i++) setup.legacy.push_back(L(BENCH_PINS[i]));
+
+    const L::FilterType types[BENCH_EFS] = { L::LOWPASS, L::EXPONENTIAL, L::LINEAR, L::HIGHPASS, L::RANDOM, L::OPPOSITE_LINEAR };
+    const EnvelopeShape shapes[BENCH_EFS] = { SHAPE_FILTER, SHAPE_CURVE, SHAPE_CURVE, SHAPE_FILTER, SHAPE_RANDOM, SHAPE_CURVE };
+    const CurveType curves[BENCH_EFS] = { CURVE_LINEAR, CURVE_EXPONENTIAL, CURVE_LINEAR, CURVE_LINEAR, CURVE_LINEAR, CURVE_INVERTED };
+    for (uint8_t i = 0; i < BENCH_EFS; i++) {
+        L& ef = setup.legacy[i];
+        ef.filterType = types[i];
+        if (types[i] == L::LOWPASS) ef.filter.configure(BiquadFilter::LOWPASS, 20.0f, BENCH_CONTROL_RATE, 0.707f);
+        if (types[i] == L::HIGHPASS) {
+            ef.filter.configure(BiquadFilter::HIGHPASS, 40.0f, BENCH_CONTROL_RATE, 0.707f);
+            ef.filter.setSections(2);
+        }
+
+        setup.bank.setInput(i, i);
+        setup.bank.setFilter(i, ef.filter.coefficients(), ef.filter.sections(), ef.filter.rampSamples());
+        uint8_t table[CURVE_SIZE];
+        buildCurve(curves[i], table);
+        setup.bank.setCurve(i, table);
+        setup.bank.setShape(i, shapes[i]);
+        setup.bank.setActive(i, true);
+    }
+
+    // EF2: ARG SQAR of A2/A6, EF5: ARG TABS of A0/A7
+    setup.legacy[2].mode = L::ARG;
+    setup.legacy[2].argMethod = L::SQAR;
+    setup.legacy[2].envelopeA = BENCH_PINS[2];
+    setup.legacy[2].envelopeB = BENCH_PINS[4];
+    setup.bank.setArgMode(2, true);
+    setup.bank.setArgOp(2, ARG_OP_SQAR);
+    setup.bank.setArgInputs(2, 2, 4);
+
+    setup.legacy[5].mode = L::ARG;
+    setup.legacy[5].argMethod = L::TABS;
+    setup.legacy[5].envelopeA = BENCH_PINS[0];
+    setup.legacy[5].envelopeB = BENCH_PINS[5];
+    setup.bank.setArgMode(5, true);
+    setup.bank.setArgOp(5, ARG_OP_TABS);
+    setup.bank.setArgInputs(5, 0, 5);
+}
+
+// Slowly moving envelopes with some jitter, like the detector produces
+static void makeFrame(uint32_t n, uint8_t* levels) {
+    for (uint8_t i = 0; i < BENCH_EFS; i++) {
+        float phase = (n * (i + 1)) * 0.013f;
+        levels[i] = static_cast<uint8_t>(64 + 60 * sinf(phase) + ((n * 2654435761u >> (i + 20)) & 3));
+    }
+}
+
+void test_bank_matches_per_object_path() {
+    BenchSetup setup;
+    configure(setup);
+    uint8_t levels[BENCH_EFS];
+    uint32_t mismatches = 0;
+    for (uint32_t n = 0; n < 100000; n++) {
+        if (n == 50000) {
+            // Retune EF0 mid-run; both sides glide to the new coefficients
+            setup.legacy[0].filter.configure(BiquadFilter::LOWPASS, 35.0f, BENCH_CONTROL_RATE, 1.5f);
+            setup.bank.setFilter(0, setup.legacy[0].filter.coefficients(), 1, setup.legacy[0].filter.rampSamples());
+        }
+        makeFrame(n, levels);
+        updateLegacy(setup.legacy, levels);
+        setup.bank.process(levels);
+        for (uint8_t i = 0; i < BENCH_EFS; i++) {
+            if (setup.legacy[i].currentEnvelopeLevel != setup.bank.level(i)) mismatches++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+void test_arg_combines_conditioned_inputs() {
+    EnvelopeBank<BENCH_EFS> bank;
+    uint8_t inverted[CURVE_SIZE];
+    buildCurve(CURVE_INVERTED, inverted);
+    bank.setCurve(1, inverted);                  // EF1 inverts input 1, EF0 stays linear
+    for (uint8_t i = 0; i < 3; i++) bank.setActive(i, true);
+    bank.setArgMode(2, true);                    // EF2 = input 0 + input 1, as conditioned
+    bank.setArgOp(2, ARG_OP_PLUS);
+    bank.setArgInputs(2, 0, 1);
+
+    const uint8_t levels[BENCH_EFS] = { 30, 100, 0, 0, 0, 0 };
+    bank.process(levels);
+    TEST_ASSERT_EQUAL_INT(30 + (127 - 100), bank.level(2));
+
+    // Input 1 with its EF off: nothing conditions it, so ARG sees it raw
+    bank.setActive(1, false);
+    bank.process(levels);
+    TEST_ASSERT_EQUAL_INT(127, bank.level(2));
+
+    // An ARG EF still conditions its own input for others to read
+    bank.setActive(1, true);
+    bank.setArgMode(1, true);
+    bank.setArgInputs(1, 5, 5);
+    bank.process(levels);
+    TEST_ASSERT_EQUAL_INT(0, bank.level(1));
+    TEST_ASSERT_EQUAL_INT(30 + (127 - 100), bank.level(2));
+}
+
+void test_bank_cost_per_frame() {
+    BenchSetup setup;
+    configure(setup);
+    static uint8_t frames[1024][BENCH_EFS];
+    for (uint32_t n = 0; n < 1024; n++) makeFrame(n, frames[n]);
+    volatile int sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+        updateLegacy(setup.legacy, frames[n & 1023]);
+        sink = sink + setup.legacy[n % BENCH_EFS].currentEnvelopeLevel;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+        setup.bank.process(frames[n & 1023]);
+        sink = sink + setup.bank.level(n % BENCH_EFS);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double legacyNs = std::chrono::duration<double, std::nano>(middle - start).count() / BENCH_FRAMES;
+    double bankNs = std::chrono::duration<double, std::nano>(end - middle).count() / BENCH_FRAMES;
+    printf("all %d EFs, per frame: per-object %.1f ns, EnvelopeBank %.1f ns (%.2fx)\n",
+           BENCH_EFS, legacyNs, bankNs, legacyNs / bankNs);
+    // Host timings are noisy; only fail if the bank is clearly slower
+    TEST_ASSERT_TRUE(bankNs < legacyNs * 1.25);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bank_matches_per_object_path);
+    RUN_TEST(test_arg_combines_conditioned_inputs);
+    RUN_TEST(test_bank_cost_per_frame);
+    return UNITY_END();
+}
@@ -6,36 +6,51 @@
 #include "DisplayManager.h"
 #include "ButtonManager.h"
 #include "PotentiometerManager.h"
+#include "MuxBus.h"
 #include "name.c"
 #include "Globals.h"
-#include "BiquadFilter.h"
-#include <TimerOne.h>
+#include "Profiler.h"
+#include "EnvelopeSampler.h"
+#include "EnvelopeDetector.h"
+#include "EnvelopeBank.h"
+#include "FilterTuningTable.h"
+#include "ModulationMatrix.h"
 #include <queue>
-#include <map> // For tracking pot-to-envelope associations
 
-uint8_t midiBeatPosition = 0;
 char serialBuffer[SERIAL_BUFFER_SIZE];
 uint8_t serialBufferIndex = 0;
 
 // Global objects
 std::vector<uint8_t> potChannels;
-std::map<int, int> potToEnvelopeMap; // Map pot index to envelope index
+SlotModMatrix modMatrix; // Which EFs modulate which pot, and by how much
 std::queue<String> commandQueue; // Queue to store incoming commands
 MIDIHandler midiHandler;
 LEDManager ledManager(LED_PIN, NUM_LEDS);
 DisplayManager displayManager(SSD1306_I2C_ADDRESS, 128, 64); // 128x64 for SSD1306
 ConfigManager configManager(NUM_POTS, NUM_BUTTONS);
-BiquadFilter filter;
 TaskScheduler scheduler;
 
-//tempo
-unsigned long lastClockTime = 0;
+//tempo (external clock lives in midiHandler.clock(), ours in midiHandler.clockOut())
 float g_tappedBPM = 120.0f; // Default to 120 BPM
 
+// One sweep of the mux tree feeds both pots and virtual buttons
+MuxBus muxBus(primaryMuxPins, secondaryMuxPins, potMuxAnalogPin, buttonMuxAnalogPin);
+
 // Declare PotentiometerManager before ButtonManager
 const uint8_t controlPins[NUM_CONTROL_BUTTONS] = {2, 3, 4, 5, 6, 13}; // Add actual GPIO pins
-PotentiometerManager potentiometerManager(primaryMuxPins, secondaryMuxPins, analogPin);
-ButtonManager buttonManager(primaryMuxPins, secondaryMuxPins, analogPin, controlPins, &potentiometerManager);
+PotentiometerManager potentiometerManager(&muxBus, &configManager);
+ButtonManager buttonManager(&muxBus, controlPins, &potentiometerManager);
+
+// Timer-driven sampler feeding the envelope followers
+EnvelopeSampler envelopeSampler(ENVELOPE_INPUT_PINS);
+// Audio-rate envelope detection, decimated to the EFs' control rate
+EnvelopeDetector<NUM_ENVELOPES> envelopeDetector(ENVELOPE_SAMPLE_RATE, ENVELOPE_DECIMATION);
+// All six EFs' filter state and settings, processed in one pass per control-rate frame
+EnvelopeBank<NUM_ENVELOPES> envelopeBank;
+// Filter coefficients for the freq/Q pots, designed once in setup()
+FilterTuningTable filterTuningTable;
+TuningPot filterFreqPot(FILTER_TUNE_FREQ_STEPS);
+TuningPot filterQPot(FILTER_TUNE_Q_STEPS);
 
 // Envelope followers - assign to analog inputs
 std::vector<EnvelopeFollower> envelopeFollowers = {
@@ -72,59 +87,67 @@ ButtonManagerContext buttonContext = {
     ledManager,
     displayManager,
     envelopeFollowers,
-    potToEnvelopeMap
+    modMatrix
 };
 
 void processInternalClock() {
-    // For 24 PPQN (like MIDI clock), you multiply BPM * 24 = pulses per minute
-    // So each pulse is 60000 / (BPM*24) milliseconds
-    static unsigned long lastTick = 0;
-    static float msPerTick = 60000.0f / (g_tappedBPM * 24.0f);
-
-    unsigned long now = millis();
-    msPerTick = 60000.0f / (g_tappedBPM * 24.0f); // recalc in case BPM changed
-
-    if (now - lastTick >= msPerTick) {
-        lastTick += msPerTick; // schedule the next tick
-
-        // do the same code you do on external MIDI Clock:
-        midiBeatPosition = (midiBeatPosition + 1) % 8;
-
-        // Optionally call display update or other “beat-based” logic:
-        displayManager.updateDisplay(
-            midiBeatPosition,
-            std::vector<uint8_t>(), // envelope levels if desired
-            envelopeFollowMode ? "EF ON" : "EF OFF",
-            activePot,
-            activeChannel,
-            envelopeMode
-        );
+    // The clock timer does the ticking (and sends it); this only picks the master and steers the tempo
+    midiHandler.clockOut().setEnabled(!midiHandler.clock().present(micros(), CLOCK_TIMEOUT_MS * 1000UL));
+    static uint32_t syncedTaps = 0;
+    const TapTempo& tapTempo = buttonManager.tapTempo();
+    if (tapTempo.estimates() != syncedTaps) {
+        // A fresh tap estimate: new tempo, and the beat back on the tap
+        syncedTaps = tapTempo.estimates();
+        midiHandler.syncClockOut(g_tappedBPM, tapTempo.lastBeatMicros());
+    } else {
+        midiHandler.setClockOutTempo(g_tappedBPM);
+    }
+}
+
+// Moves the one-shot timer wheels on: clock ticks of whichever clock leads, and millis()
+void processTimers() {
+    const ClockGenerator& clockOut = midiHandler.clockOut();
+    if (clockOut.enabled()) {
+        // The clock timer interrupt counts these; read again if it ticked in between
+        uint32_t ticks, position;
+        do {
+            ticks = clockOut.ticks();
+            position = clockOut.position();
+        } while (ticks != clockOut.ticks());
+        Utility::beatTimers.follow(CLOCK_SOURCE_INTERNAL, ticks, position, clockOut.running());
+    } else {
+        const ClockFollower& clock = midiHandler.clock();
+        Utility::beatTimers.follow(CLOCK_SOURCE_EXTERNAL, clock.ticks(), clock.position(), clock.running());
+    }
+    Utility::msTimers.advanceTo(millis());
+}
+
+/**
+ * Incoming CC (the DAW's automation, or a preset recall): every slot sending
+ * that channel/CC takes the value, shows it on its LED, and its knob waits
+ * to pick it up. One table lookup per message.
+ */
+static void onIncomingCC(void*, const MidiInEvent& event) {
+    uint64_t slots = configManager.ccIndex().slotsFor(event.channel(), event.data1);
+    while (slots) {
+        uint8_t slot = __builtin_ctzll(slots);
+        slots &= slots - 1;
+        potentiometerManager.takeOver(slot, event.data2);
+        ledManager.setPotValue(slot, event.data2);
     }
 }
 
+// Beat timer callback for SEND_CC ... BEAT|BAR: channel, CC and value packed into arg
+static void sendQuantizedCC(void*, uint32_t packed) {
+    midiHandler.sendControlChange((packed >> 8) & 0x7F, packed & 0x7F, (packed >> 16) & 0x1F);
+}
+
 void processMIDI() {
+    // Clock and transport go to midiHandler.clock(); the display picks the beat up on its own task
     midiHandler.processIncomingMIDI();
 
-    if (midiHandler.isClockTick()) {
-        // Record the time we received an external clock
-        lastClockTime = millis();
-
-        // Advance beat
-        midiBeatPosition = (midiBeatPosition + 1) % 8;
-
-        // Perform clock-tied updates
-        displayManager.updateDisplay(
-            midiBeatPosition,
-            std::vector<uint8_t>(), // Pass envelope levels if applicable
-            envelopeFollowMode ? "EF ON" : "EF OFF",
-            activePot,
-            activeChannel,
-            envelopeMode
-        );
-
-        // Clear the clock flag
-        midiHandler.clearClockTick();
-    }
+    // Everything queued since the last tick: DIN paced to the wire, USB at once
+    midiHandler.flushOutput();
 }
 
 void processSerial() {
@@ -185,7 +208,7 @@ String command = String(serialBuffer);
             // Send all pot settings
             Serial.print("POTS:");
             for (int i = 0; i < NUM_POTS; i++) {
-                int envelopeValue = (potToEnvelopeMap.count(i)) ? potToEnvelopeMap[i] : -1;
+                int envelopeValue = modMatrix.primarySource(i);
                 Serial.print(configManager.getPotCCNumber(i));
                 Serial.print(",");
                 Serial.print(configManager.getPotChannel(i));
@@ -213,25 +236,42 @@ String command = String(serialBuffer);
 
 
 void processEnvelopes() {
-    for (const auto& [potIndex, envelopeIndex] : potToEnvelopeMap) {
-        if (envelopeIndex < static_cast<int>(envelopeFollowers.size())) {
-            EnvelopeFollower* envelope = &envelopeFollowers[envelopeIndex];
-
-            if (envelope->getActiveState()) { // Process only active envelopes
-                envelope->update(); // Update envelope values
-                uint8_t ccValue = potentiometerManager.getCCNumber(potIndex);
-                envelope->applyToCC(potIndex, ccValue); // Modulate CC value
-
-                if (ccValue != potentiometerManager.getLastValue(potIndex)) { // Avoid redundant MIDI messages
-                    midiHandler.sendControlChange(
-                        potentiometerManager.getCCNumber(potIndex),
-                        ccValue,
-                        potentiometerManager.getChannel(potIndex)
-                    );
-
-                    ledManager.setPotValue(potIndex, ccValue); // Update corresponding LED
-                }
-            }
+    // Drain the block of frames the sampler ISR captured since the last tick.
+    // The detector sees every audio-rate sample; the EF bank (filters, curves,
+    // ARG methods) runs once per decimated level, at the constant control rate
+    EnvelopeFrame frame;
+    while (envelopeSampler.read(frame)) {
+        if (envelopeDetector.process(frame.samples)) {
+            envelopeBank.process(envelopeDetector.levels());
+        }
+    }
+
+    // One matrix-vector pass: every slot's modulation from all six EF levels,
+    // the same work however many slots/EFs are routed
+    modMatrix.process(envelopeBank.levels());
+
+    static uint8_t lastSentCC[NUM_POTS];
+    static bool sentOnce[NUM_POTS] = {false};
+    for (uint8_t potIndex = 0; potIndex < NUM_POTS; potIndex++) {
+        if (!modMatrix.routed(potIndex)) {
+            sentOnce[potIndex] = false;
+            continue;
+        }
+        // Knob position plus modulation
+        int potValue = potentiometerManager.getLastValue(potIndex);
+        int base = potValue < 0 ? 0 : Utility::mapToMidiValue(potValue);
+        uint8_t ccValue = modMatrix.apply(potIndex, base);
+
+        if (!sentOnce[potIndex] || ccValue != lastSentCC[potIndex]) { // Avoid redundant MIDI messages
+            lastSentCC[potIndex] = ccValue;
+            sentOnce[potIndex] = true;
+            midiHandler.sendControlChange(
+                potentiometerManager.getCCNumber(potIndex),
+                ccValue,
+                potentiometerManager.getChannel(potIndex)
+            );
+
+            ledManager.setPotValue(potIndex, ccValue); // Update corresponding LED
         }
     }
 }
@@ -249,31 +289,29 @@ void monitorSystemLoad() {
 }
 
 void updateFilterTuning(ButtonManagerContext& context) {
-    // 1. Read raw ADC from freq pot
-    int rawFreq = analogRead(FILTER_FREQ_POT_PIN);  // 0..1023
-    // 2. Read raw ADC from Q pot
-    int rawQ = analogRead(FILTER_RES_POT_PIN);        // 0..1023
-
-    // 3. Map rawFreq => 20..5000 Hz (pick a range that feels good)
-    float freq = map(rawFreq, 0, 1023, 20, 5000);
-
-    // 4. Map rawQ => 0.5..4.0 (a typical resonance range)
-    //    - For instance, map from 0..1023 => 50..400, then /100
-    float q = map(rawQ, 0, 1023, 50, 400) / 100.0f; // => 0.50..4.00
+    // 1. Smooth and quantize both pots (freq log-spaced 20..5000 Hz, Q 0.5..4.0).
+    //    Nothing to do until one of them crosses a step.
+    //    Both pots are on ADC1 with the mux sweep, so read them through MuxBus.
+    bool freqMoved = filterFreqPot.update(muxBus.readPin(FILTER_FREQ_POT_PIN));
+    bool qMoved = filterQPot.update(muxBus.readPin(FILTER_RES_POT_PIN));
+    if (!freqMoved && !qMoved) {
+        return;
+    }
 
-    // 5. Which EF are we tuning?
+    // 2. Which EF are we tuning?
     //    We'll tune the EF assigned to the “activePot” in the context
-    auto it = context.potToEnvelopeMap.find(context.activePot);
-    if (it == context.potToEnvelopeMap.end()) {
+    int efIndex = context.modMatrix.primarySource(context.activePot); // e.g. 0..5 if you have 6 EFs total
+    if (efIndex < 0) {
         // If no EF assigned to active pot, do nothing
         return;
     }
-    int efIndex = it->second; // e.g. 0..5 if you have 6 EFs total
 
-    // 6. Actually set that EF’s filter freq/Q
+    // 3. Actually set that EF’s filter freq/Q: a table read, no trig
     //    BUT remember, it only affects EFs whose filterType is
     //    LOWPASS, HIGHPASS, or BANDPASS.
-    context.envelopes[efIndex].configureFilter(freq, q);
+    context.envelopes[efIndex].tuneFilter(filterTuningTable, filterFreqPot.step(), filterQPot.step());
+    float freq = filterTuningTable.frequencyAt(filterFreqPot.step());
+    float q = FilterTuningTable::qAt(filterQPot.step());
     EEPROM.put(EEPROM_FILTER_FREQ, freq);
     EEPROM.put(EEPROM_FILTER_Q, q);
 
@@ -284,9 +322,14 @@ void updateFilterTuning(ButtonManagerContext& context) {
 void setup() {
     Serial.begin(31250);
     configManager.begin(potChannels);
-    configManager.loadEnvelopeSettings(potToEnvelopeMap, envelopeFollowers);
+    configManager.loadModulationMatrix(modMatrix);
+    configManager.loadCustomCurves(envelopeFollowers);
+    for (size_t i = 0; i < envelopeFollowers.size(); i++) {
+        envelopeFollowers[i].bind(&envelopeBank, i);
+    }
     midiHandler.begin();
     midiHandler.setDisplayManager(&displayManager);
+    midiHandler.inputRouter().setRoute(MIDI_ROUTE_CC, onIncomingCC, nullptr);
 
     ledManager.begin();
     uint8_t ledBrightness;
@@ -297,27 +340,30 @@ void setup() {
 
     displayManager.begin();
     displayManager.showText("Initializing...");
-    potentiometerManager.loadFromEEPROM();
-    Timer1.initialize(1000); // 1ms interrupt
+    envelopeSampler.begin(ENVELOPE_SAMPLE_PERIOD_US); // 8 kHz sampling interrupt
     pinMode(FILTER_FREQ_POT_PIN, INPUT);
     pinMode(FILTER_RES_POT_PIN, INPUT);
-    filter.configure(BiquadFilter::LOWPASS, 1000, 44100);
 
     for (auto& envelope : envelopeFollowers) {
         envelope.toggleActive(true);
     }
 
+    filterTuningTable.build(ENVELOPE_CONTROL_RATE);
     float savedFreq, savedQ;
     EEPROM.get(EEPROM_FILTER_FREQ, savedFreq);
     EEPROM.get(EEPROM_FILTER_Q, savedQ);
-    savedFreq = constrain(savedFreq, 20.0f, 5000.0f);
-    savedQ    = constrain(savedQ, 0.5f, 4.0f);
+    savedFreq = constrain(savedFreq, FILTER_TUNE_MIN_HZ, FILTER_TUNE_MAX_HZ);
+    savedQ    = constrain(savedQ, FILTER_TUNE_MIN_Q, FILTER_TUNE_MAX_Q);
     for (auto& ef : envelopeFollowers) {
         ef.configureFilter(savedFreq, savedQ);
     }
 
+    // The pots send on ConfigManager's mapping; a corrupted one is reset to defaults in there
+    if (!configManager.loadConfiguration(potChannels)) {
+        Serial.println("EEPROM data corrupted, resetting to defaults.");
+    }
     for (int i = 0; i < NUM_POTS; i++) {
-        if (potentiometerManager.getChannel(i) == 0) {
+        if (potentiometerManager.getChannel(i) == 0 || potentiometerManager.getChannel(i) > 16) {
             potentiometerManager.setChannel(i, 1);
         }
         if (potentiometerManager.getCCNumber(i) > 127) {
@@ -325,12 +371,9 @@ void setup() {
         }
     }
 
-    if (!configManager.loadConfiguration(potChannels)) {
-        Serial.println("EEPROM data corrupted, resetting to defaults.");
-        potentiometerManager.resetEEPROM();
-    }
-
+    muxBus.begin();
     buttonManager.initButtons();
+    configManager.loadButtonActions(buttonManager.actions());
     delay(1000);
     displayManager.clear();
     displayManager.showText("MOAR");
@@ -344,46 +387,85 @@ void setup() {
     }
     Serial.println("Setup complete!");
 
+#if PROFILER_ENABLED
+    Profiler::begin();
+    Profiler::setBudgetMicros(PROFILE_LOOP, MIDI_TASK_INTERVAL * 1000UL);
+    Profiler::setBudgetMicros(PROFILE_MIDI, MIDI_TASK_INTERVAL * 1000UL);
+    Profiler::setBudgetMicros(PROFILE_INTERNAL_CLOCK, MIDI_TASK_INTERVAL * 1000UL);
+    Profiler::setBudgetMicros(PROFILE_SERIAL, SERIAL_TASK_INTERVAL * 1000UL);
+    Profiler::setBudgetMicros(PROFILE_ENVELOPES, ENVELOPE_TASK_INTERVAL * 1000UL);
+    Profiler::setBudgetMicros(PROFILE_LEDS, LED_TASK_INTERVAL * 1000UL);
+    Profiler::setBudgetMicros(PROFILE_DISPLAY, DISPLAY_TASK_INTERVAL * 1000UL);
+    Profiler::setBudgetMicros(PROFILE_BUTTON_EVENTS, BUTTON_EVENT_BUDGET_US);
+#endif
+
     // --- Schedule repeating tasks ---
+    // Intervals are in microseconds; deadlines are phase-locked, so periods don't drift
     // High-priority tasks (1ms interval)
-      Utility::schedulerHigh.addTask([] { processMIDI(); }, MIDI_TASK_INTERVAL);
-      Utility::schedulerHigh.addTask([] {
-        if (millis() - lastClockTime > CLOCK_TIMEOUT_MS) {
-          processInternalClock();
-        }
-      }, MIDI_TASK_INTERVAL);
+      Utility::schedulerHigh.addTask([](void*) {
+        PROFILE_SCOPE(PROFILE_MIDI);
+        processMIDI();
+      }, nullptr, MIDI_TASK_INTERVAL * 1000UL);
+      Utility::schedulerHigh.addTask([](void*) {
+        PROFILE_SCOPE(PROFILE_INTERNAL_CLOCK);
+        processInternalClock();
+        processTimers();
+      }, nullptr, MIDI_TASK_INTERVAL * 1000UL);
 
       // Mid-priority tasks (~5-10ms intervals)
-      Utility::schedulerMid.addTask([] { processSerial(); }, SERIAL_TASK_INTERVAL);
-      Utility::schedulerMid.addTask([] { processEnvelopes(); }, ENVELOPE_TASK_INTERVAL);
+      Utility::schedulerMid.addTask([](void*) {
+        PROFILE_SCOPE(PROFILE_SERIAL);
+        processSerial();
+      }, nullptr, SERIAL_TASK_INTERVAL * 1000UL);
+      Utility::schedulerMid.addTask([](void*) {
+        PROFILE_SCOPE(PROFILE_ENVELOPES);
+        processEnvelopes();
+      }, nullptr, ENVELOPE_TASK_INTERVAL * 1000UL);
+      // Button actions run here, not inside the button scan
+      Utility::schedulerMid.addTask([](void*) {
+        PROFILE_SCOPE(PROFILE_BUTTON_EVENTS);
+        buttonManager.dispatchEvents(buttonContext, BUTTON_EVENT_BUDGET_US);
+      }, nullptr, BUTTON_EVENT_TASK_INTERVAL * 1000UL);
 
       // Low-priority tasks (~30-100ms intervals)
-      Utility::schedulerLow.addTask([] {
+      Utility::schedulerLow.addTask([](void*) {
+        PROFILE_SCOPE(PROFILE_LEDS);
         ledManager.update();
         updateFilterTuning(buttonContext);
-      }, LED_TASK_INTERVAL);
+      }, nullptr, LED_TASK_INTERVAL * 1000UL);
 
-      Utility::schedulerLow.addTask([] {
+      Utility::schedulerLow.addTask([](void*) {
+        PROFILE_SCOPE(PROFILE_DISPLAY);
         if (!displayManager.shouldRunScreensaver()) {
           displayManager.beginDraw();
           displayManager.updateFromContext(buttonContext);
 
-          auto it = potToEnvelopeMap.find(activePot);
-          if (it != potToEnvelopeMap.end()) {
-            uint8_t lvl = envelopeFollowers[it->second].getEnvelopeLevel();
+          int ef = modMatrix.primarySource(activePot);
+          if (ef >= 0) {
+            uint8_t lvl = envelopeFollowers[ef].getEnvelopeLevel();
             displayManager.showEnvelopeLevel(lvl);
           }
 
           displayManager.highlightActivePot(activePot);
           displayManager.highlightActiveMode(envelopeMode);
+          const ClockFollower& clock = midiHandler.clock();
+          const ClockGenerator& clockOut = midiHandler.clockOut();
+          if (clock.present(micros(), CLOCK_TIMEOUT_MS * 1000UL)) {
+            displayManager.showBeat(clock.beat() % 4, clock.running());
+          } else if (clockOut.enabled()) {
+            displayManager.showBeat(clockOut.beat() % 4, clockOut.running());
+          }
           displayManager.endDraw();
         } else {
           displayManager.runIdleScreensaver();
         }
-      }, 100);
+      }, nullptr, DISPLAY_TASK_INTERVAL * 1000UL);
 }
 
 void loop() {
+  PROFILE_SCOPE(PROFILE_LOOP);
+  {
+   PROFILE_SCOPE(PROFILE_SERIAL_COMMANDS);
    if (Serial.available()) {
     // read up to newline, drop the '\n'
     String command = Serial.readStringUntil('\n');
@@ -395,6 +477,240 @@ void loop() {
     }
     else if (command == "GET_ALL") {
       Serial.println(configManager.serializeAll());
+    }
+    else if (command.startsWith("GET_PROFILE")) {
+      // GET_PROFILE = table, GET_PROFILE BIN = binary frame, GET_PROFILE RESET = clear stats
+#if PROFILER_ENABLED
+      if (command.endsWith("BIN")) {
+        Profiler::writeBinaryReport(Serial);
+      } else if (command.endsWith("RESET")) {
+        Profiler::reset();
+        Serial.println("Profile reset");
+      } else {
+        Profiler::printReport(Serial);
+      }
+#else
+      Serial.println("Error: Profiler disabled in this build");
+#endif
+    }
+    else if (command.startsWith("GET_MIDI_STATS")) {
+      // GET_MIDI_STATS = one line per port, GET_MIDI_STATS RESET = clear counters
+      if (command.endsWith("RESET")) {
+        midiHandler.resetOutputStats();
+        Serial.println("MIDI stats reset");
+      } else {
+        const MidiOutQueue& din = midiHandler.dinQueue();
+        const MidiDinTransmitter& tx = midiHandler.dinTransmitter();
+        Serial.printf("DIN %lu B/s (peak %lu) %lu msg/s sent %lu merged %lu dropped %lu depth %u/%u status saved %lu\n",
+                      tx.meter().bytesPerSecond(), tx.meter().peakBytesPerSecond(), tx.meter().messagesPerSecond(),
+                      din.sent(), din.merged(), din.dropped(), din.depth(), din.maxDepth(), tx.statusBytesSaved());
+        const MidiOutQueue& usb = midiHandler.usbQueue();
+        const MidiRateMeter& usbMeter = midiHandler.usbMeter();
+        const UsbMidiPacker& packer = midiHandler.usbPacker();
+        Serial.printf("USB %lu B/s (peak %lu) %lu msg/s sent %lu merged %lu dropped %lu depth %u/%u packets %lu (%.1f events each)\n",
+                      usbMeter.bytesPerSecond(), usbMeter.peakBytesPerSecond(), usbMeter.messagesPerSecond(),
+                      usb.sent(), usb.merged(), usb.dropped(), usb.depth(), usb.maxDepth(),
+                      packer.packets(), packer.packets() ? (float)packer.events() / packer.packets() : 0.0f);
+        const MidiInputRouter& in = midiHandler.inputRouter();
+        Serial.printf("IN received %lu (notes %lu CC %lu clock %lu transport %lu sysex %lu other %lu) unrouted %lu dropped %lu backlog max %u\n",
+                      in.received(), in.routed(MIDI_ROUTE_NOTE), in.routed(MIDI_ROUTE_CC), in.routed(MIDI_ROUTE_CLOCK),
+                      in.routed(MIDI_ROUTE_TRANSPORT), in.routed(MIDI_ROUTE_SYSEX), in.routed(MIDI_ROUTE_OTHER),
+                      in.ignored(), in.dropped(), in.maxBacklog());
+        const ClockFollower& clock = midiHandler.clock();
+        Serial.printf("CLOCK %s %.2f BPM jitter %.0f us position %lu (beat %lu) %s\n",
+                      clock.present(micros(), CLOCK_TIMEOUT_MS * 1000UL) ? (clock.locked() ? "locked" : "locking") : "none",
+                      clock.bpm(), clock.jitterMicros(), clock.position(), clock.beat(),
+                      clock.running() ? "running" : "stopped");
+        const ClockGenerator& clockOut = midiHandler.clockOut();
+        Serial.printf("CLOCK OUT %s %.2f BPM ticks %lu position %lu (beat %lu) %s, USB late drops %lu\n",
+                      clockOut.enabled() ? "master" : "off (external clock)", clockOut.bpm(), clockOut.ticks(),
+                      clockOut.position(), clockOut.beat(), clockOut.running() ? "running" : "stopped",
+                      midiHandler.usbRealTimeDropped());
+        const TimingWheel& beatWheel = Utility::beatTimers.wheel();
+        Serial.printf("BEAT TIMERS pending %u (max %u) fired %lu dropped %lu, actions due dropped %lu\n",
+                      beatWheel.count(), beatWheel.maxCount(), beatWheel.fired(), beatWheel.dropped(),
+                      buttonManager.droppedActions());
+      }
+    }
+    else if (command.startsWith("CLOCK ")) {
+      // CLOCK START | STOP | CONTINUE: transport for the internal clock, sent on the next tick
+      ClockGenerator& clockOut = midiHandler.clockOut();
+      if (command == "CLOCK START") {
+        clockOut.start();
+      } else if (command == "CLOCK STOP") {
+        clockOut.stop();
+      } else if (command == "CLOCK CONTINUE") {
+        clockOut.resume();
+      } else {
+        Serial.println("Error: Usage CLOCK <START|STOP|CONTINUE>");
+      }
+    }
+    else if (command == "GET_ACTIONS") {
+      // One "ROW GESTURE ACTION PARAM" line per table entry
+      for (uint8_t r = 0; r < ACTION_ROW_COUNT; r++) {
+        for (uint8_t c = 0; c < ACTION_COL_COUNT; c++) {
+          const ButtonAction& action = buttonManager.actions().get(r, c);
+          Serial.printf("%s %s %s %d\n", ACTION_ROW_NAMES[r], ACTION_COLUMN_NAMES[c],
+                        ACTION_NAMES[action.id], action.param);
+        }
+      }
+    }
+    else if (command.startsWith("SET_ACTION")) {
+      // SET_ACTION <row> <gesture> <action> [param], or SET_ACTION RESET for the defaults
+      char row[8], gesture[8], action[16];
+      int param = 0;
+      int fields = sscanf(command.c_str(), "SET_ACTION %7s %7s %15s %d", row, gesture, action, &param);
+      bool ok = true;
+      if (command == "SET_ACTION RESET") {
+        buttonManager.actions().reset();
+      } else {
+        ok = fields >= 3 && buttonManager.actions().set(row, gesture, action, param);
+      }
+      if (ok) {
+        configManager.saveButtonActions(buttonManager.actions());
+        Serial.println("Button actions saved");
+      } else {
+        Serial.println("Error: Usage SET_ACTION <SLOT|CTRL0-5|CHORD0-3> <LONG|SINGLE|DOUBLE> <action> [param]");
+      }
+    }
+    else if (command == "GET_QUANTIZE") {
+      // One "ACTION NOW|BEAT|BAR" line per action
+      for (uint8_t id = ACTION_NONE + 1; id < ACTION_COUNT; id++) {
+        Serial.printf("%s %s\n", ACTION_NAMES[id], QUANTIZE_NAMES[buttonManager.actions().quantize(id)]);
+      }
+    }
+    else if (command.startsWith("SET_QUANTIZE")) {
+      // SET_QUANTIZE <action> <NOW|BEAT|BAR>: when that action takes effect, whichever button runs it
+      char action[16], when[8];
+      if (sscanf(command.c_str(), "SET_QUANTIZE %15s %7s", action, when) == 2 &&
+          buttonManager.actions().setQuantize(action, when)) {
+        configManager.saveButtonActions(buttonManager.actions());
+        Serial.println("Button actions saved");
+      } else {
+        Serial.println("Error: Usage SET_QUANTIZE <action> <NOW|BEAT|BAR> (not TAP_TEMPO)");
+      }
+    }
+    else if (command.startsWith("SEND_CC")) {
+      // SEND_CC <channel 1-16> <cc> <value> [NOW|BEAT|BAR]: one CC out, now or on the next beat / bar
+      int channel = 0, cc = -1, value = -1;
+      char when[8] = "NOW";
+      int fields = sscanf(command.c_str(), "SEND_CC %d %d %d %7s", &channel, &cc, &value, when);
+      bool ok = fields >= 3 && channel >= 1 && channel <= 16 && cc >= 0 && cc <= 127 && value >= 0 && value <= 127;
+      uint32_t unit = 0;
+      if (strcmp(when, "BEAT") == 0) {
+        unit = CLOCK_PPQN;
+      } else if (strcmp(when, "BAR") == 0) {
+        unit = CLOCK_PPQN * BEATS_PER_BAR;
+      } else if (strcmp(when, "NOW") != 0) {
+        ok = false;
+      }
+      if (ok) {
+        uint32_t packed = value | cc << 8 | channel << 16;
+        if (unit && Utility::beatTimers.scheduleOnNext(unit, sendQuantizedCC, nullptr, packed)) {
+          Serial.printf("CC %d on ch %d in %lu ticks\n", cc, channel, Utility::beatTimers.ticksToNext(unit));
+        } else {
+          midiHandler.sendControlChange(cc, value, channel);
+          Serial.printf("CC %d on ch %d sent\n", cc, channel);
+        }
+      } else {
+        Serial.println("Error: Usage SEND_CC <channel 1-16> <cc 0-127> <value 0-127> [NOW|BEAT|BAR]");
+      }
+    }
+    else if (command.startsWith("GET_CURVE")) {
+      // GET_CURVE <ef>: the EF's curve (NONE for RANDOM/filters), then its custom points
+      int ef = -1;
+      if (sscanf(command.c_str(), "GET_CURVE %d", &ef) == 1 && ef >= 0 && ef < (int)envelopeFollowers.size()) {
+        CurveType curve = EnvelopeFollower::curveForType(envelopeFollowers[ef].getFilterType());
+        Serial.printf("EF %d %s", ef, curve < CURVE_COUNT ? CURVE_NAMES[curve] : "NONE");
+        const uint8_t* points = envelopeFollowers[ef].getCustomCurve();
+        for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) {
+          Serial.printf(" %d", points[k]);
+        }
+        Serial.println();
+      } else {
+        Serial.println("Error: Usage GET_CURVE <ef>");
+      }
+    }
+    else if (command.startsWith("SET_CURVE")) {
+      // SET_CURVE <ef> <17 levels>: upload (and save) a custom curve and select it
+      // SET_CURVE <ef> <name>: select a built-in curve (or CUSTOM for the stored one)
+      int ef = -1;
+      int consumed = 0;
+      bool ok = sscanf(command.c_str(), "SET_CURVE %d %n", &ef, &consumed) == 1 &&
+                ef >= 0 && ef < (int)envelopeFollowers.size() && consumed > 0;
+      if (ok) {
+        const char* args = command.c_str() + consumed;
+        uint8_t points[CURVE_BREAKPOINTS];
+        CurveType builtin = curveByName(args);
+        if (parseCurveBreakpoints(args, points)) {
+          envelopeFollowers[ef].setCustomCurve(points);
+          envelopeFollowers[ef].setFilterType(EnvelopeFollower::CUSTOM);
+          configManager.saveCustomCurves(envelopeFollowers);
+          Serial.println("Custom curve saved");
+        } else if (builtin != CURVE_COUNT) {
+          envelopeFollowers[ef].setFilterType(EnvelopeFollower::typeForCurve(builtin));
+          Serial.printf("EF %d => %s\n", ef, CURVE_NAMES[builtin]);
+        } else {
+          ok = false;
+        }
+      }
+      if (!ok) {
+        Serial.println("Error: Usage SET_CURVE <ef> <17 levels 0-127> | SET_CURVE <ef> <LINEAR|INVERTED|EXPONENTIAL|LOGARITHMIC|S_CURVE|CUSTOM>");
+      }
+    }
+    else if (command.startsWith("GET_MOD")) {
+      // GET_MOD <slot>: offset, then depth (64 = 100%) and polarity for each EF
+      int slot = -1;
+      if (sscanf(command.c_str(), "GET_MOD %d", &slot) == 1 && slot >= 0 && slot < NUM_POTS) {
+        Serial.printf("SLOT %d OFFSET %d", slot, modMatrix.offset(slot));
+        for (uint8_t ef = 0; ef < NUM_ENVELOPES; ef++) {
+          Serial.printf(" EF%d %d %s", ef, modMatrix.depth(slot, ef), modMatrix.bipolar(slot, ef) ? "BI" : "UNI");
+        }
+        Serial.println();
+      } else {
+        Serial.println("Error: Usage GET_MOD <slot>");
+      }
+    }
+    else if (command.startsWith("SET_MOD_OFFSET")) {
+      // SET_MOD_OFFSET <slot> <-127..127>
+      int slot = -1, offset = 0;
+      if (sscanf(command.c_str(), "SET_MOD_OFFSET %d %d", &slot, &offset) == 2 &&
+          slot >= 0 && slot < NUM_POTS && offset >= -127 && offset <= 127) {
+        modMatrix.setOffset(slot, offset);
+        configManager.saveModulationMatrix(modMatrix);
+        Serial.println("Modulation saved");
+      } else {
+        Serial.println("Error: Usage SET_MOD_OFFSET <slot> <-127..127>");
+      }
+    }
+    else if (command.startsWith("SET_MOD")) {
+      // SET_MOD <slot> <ef> <depth -128..127, 64 = 100%> [BI|UNI], or SET_MOD <slot> CLEAR
+      int slot = -1, ef = -1, depth = 0;
+      char polarity[4] = "UNI";
+      char clear[6] = "";
+      bool ok = false;
+      if (sscanf(command.c_str(), "SET_MOD %d %5s", &slot, clear) == 2 && strcmp(clear, "CLEAR") == 0 &&
+          slot >= 0 && slot < NUM_POTS) {
+        modMatrix.clearSlot(slot);
+        ok = true;
+      } else {
+        int fields = sscanf(command.c_str(), "SET_MOD %d %d %d %3s", &slot, &ef, &depth, polarity);
+        ok = fields >= 3 && slot >= 0 && slot < NUM_POTS && ef >= 0 && ef < NUM_ENVELOPES &&
+             depth >= -128 && depth <= 127 && (strcmp(polarity, "UNI") == 0 || strcmp(polarity, "BI") == 0);
+        if (ok) {
+          modMatrix.setDepth(slot, ef, depth);
+          modMatrix.setBipolar(slot, ef, strcmp(polarity, "BI") == 0);
+          if (depth != 0) {
+            envelopeFollowers[ef].toggleActive(true);
+          }
+        }
+      }
+      if (ok) {
+        configManager.saveModulationMatrix(modMatrix);
+        Serial.println("Modulation saved");
+      } else {
+        Serial.println("Error: Usage SET_MOD <slot> <ef> <depth -128..127> [BI|UNI] | SET_MOD <slot> CLEAR");
+      }
     } else {
       // end of line reached
       serialBuffer[serialBufferIndex] = '\0';
@@ -406,12 +722,14 @@ void loop() {
       // clear buffer for next command
       memset(serialBuffer, 0, SERIAL_BUFFER_SIZE);
     }
+  }
   }
 
-    Utility::schedulerHigh.update();
-    Utility::schedulerMid.update();
-    Utility::schedulerLow.update();
-    buttonManager.processButtons(buttonContext);
-    potentiometerManager.processPots(ledManager, envelopeFollowers);
+    midiHandler.flushRealTime();   // Internal clock ticks for USB, as soon as the timer has sent them on DIN
+    { PROFILE_SCOPE(PROFILE_SCHEDULER_HIGH); Utility::schedulerHigh.update(); }
+    { PROFILE_SCOPE(PROFILE_SCHEDULER_MID);  Utility::schedulerMid.update(); }
+    { PROFILE_SCOPE(PROFILE_SCHEDULER_LOW);  Utility::schedulerLow.update(); }
+    { PROFILE_SCOPE(PROFILE_BUTTONS); buttonManager.processButtons(); }
+    { PROFILE_SCOPE(PROFILE_POTS);    potentiometerManager.processPots(ledManager); }
     monitorSystemLoad();
 }
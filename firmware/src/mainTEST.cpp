@@ -5,6 +5,7 @@
 #include "DisplayManager.h"
 #include "ButtonManager.h"
 #include "PotentiometerManager.h"
+#include "MuxBus.h"
 #include "EnvelopeFollower.h"
 std::vector<uint8_t> potChannels; // EEPROM-loaded channels
 
@@ -14,8 +15,9 @@ std::vector<uint8_t> potChannels; // EEPROM-loaded channels
 ConfigManager configManager(NUM_POTS, NUM_BUTTONS);
 LEDManager ledManager(LED_PIN, NUM_LEDS);
 DisplayManager displayManager(SSD1306_I2C_ADDRESS, OLED_WIDTH, OLED_HEIGHT);
-PotentiometerManager potentiometerManager(primaryMuxPins, secondaryMuxPins, potMuxAnalogPin);
-ButtonManager buttonManager(primaryMuxPins, secondaryMuxPins, buttonMuxAnalogPin, (const uint8_t[]){2,3,4,5,6,13}, &potentiometerManager);
+MuxBus muxBus(primaryMuxPins, secondaryMuxPins, potMuxAnalogPin, buttonMuxAnalogPin);
+PotentiometerManager potentiometerManager(&muxBus, &configManager);
+ButtonManager buttonManager(&muxBus, (const uint8_t[]){2,3,4,5,6,13}, &potentiometerManager);
 std::vector<EnvelopeFollower> envelopeFollowers = {
   EnvelopeFollower(A0, &potentiometerManager),
   EnvelopeFollower(A1, &potentiometerManager),
@@ -126,10 +128,8 @@ void setup() {
   ledManager.begin();
   displayManager.begin();
   potentiometerManager.loadFromEEPROM();
+  muxBus.begin();
   buttonManager.initButtons();
-
-  pinMode(potMuxAnalogPin, INPUT);
-  pinMode(buttonMuxAnalogPin, INPUT);
   
   // Run each test individually:
   testLEDManager();
@@ -1,7 +1,17 @@
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 #include <unity.h>
+#include <stdio.h>
+#include <math.h>
 #include "BiquadFilter.h"
 
+// Runs on the Teensy (env:teensy40_biquadfilter_test) or natively (env:native_biquadfilter_test)
+
+#define TEST_CONTROL_RATE 200.0f   // What the envelope filters actually run at
+#define TEST_SETTLE 2000           // Samples before measuring
+#define TEST_MEASURE 2000          // 10 s at 200 Hz: any multiple of 0.1 Hz fits whole periods
+
 void test_frequency_clamps_to_20hz() {
     const float sampleRate = 48000.0f;
     BiquadFilter filtered_low;
@@ -17,10 +27,156 @@ void test_frequency_clamps_to_20hz() {
     }
 }
 
-void setup() {
+/**
+ * |H(e^jw)| of one section, straight from the coefficients.
+ */
+static float analyticalGain(const BiquadCoefficients& c, float hz, float sampleRate) {
+    float w = 2.0f * static_cast<float>(M_PI) * hz / sampleRate;
+    float numRe = c.b0 + c.b1 * cosf(w) + c.b2 * cosf(2.0f * w);
+    float numIm = -(c.b1 * sinf(w) + c.b2 * sinf(2.0f * w));
+    float denRe = 1.0f + c.a1 * cosf(w) + c.a2 * cosf(2.0f * w);
+    float denIm = -(c.a1 * sinf(w) + c.a2 * sinf(2.0f * w));
+    return sqrtf((numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm));
+}
+
+/**
+ * Drive a unit sine through the filter and measure the output amplitude
+ * by correlating with sin/cos over whole periods.
+ */
+static float measuredGain(BiquadFilter& filter, float hz, float sampleRate) {
+    double re = 0.0;
+    double im = 0.0;
+    for (int n = 0; n < TEST_SETTLE + TEST_MEASURE; n++) {
+        double phase = 2.0 * M_PI * hz * n / sampleRate;
+        float y = filter.process(static_cast<float>(sin(phase)));
+        if (n >= TEST_SETTLE) {
+            re += y * sin(phase);
+            im += y * cos(phase);
+        }
+    }
+    return static_cast<float>(2.0 * sqrt(re * re + im * im) / TEST_MEASURE);
+}
+
+static void checkResponse(BiquadFilter::FilterType type, float cutoff, float q, uint8_t sections) {
+    const float freqs[] = { 0.5f, 2.0f, 5.0f, 10.0f, 15.0f, 20.0f, 30.0f, 45.0f, 60.0f, 80.0f, 95.0f };
+    for (float hz : freqs) {
+        BiquadFilter filter;
+        filter.configure(type, cutoff, TEST_CONTROL_RATE, q);
+        filter.setSections(sections);
+        float expected = powf(analyticalGain(filter.coefficients(), hz, TEST_CONTROL_RATE), sections);
+        float measured = measuredGain(filter, hz, TEST_CONTROL_RATE);
+        TEST_ASSERT_FLOAT_WITHIN(0.002f + 0.01f * expected, expected, measured);
+    }
+}
+
+void test_lowpass_response_matches_analytical() {
+    checkResponse(BiquadFilter::LOWPASS, 20.0f, 0.707f, 1);
+    checkResponse(BiquadFilter::LOWPASS, 40.0f, 3.0f, 1);
+}
+
+void test_highpass_response_matches_analytical() {
+    checkResponse(BiquadFilter::HIGHPASS, 20.0f, 0.707f, 1);
+}
+
+void test_bandpass_response_matches_analytical() {
+    checkResponse(BiquadFilter::BANDPASS, 30.0f, 2.0f, 1);
+}
+
+void test_cascade_response_matches_analytical() {
+    checkResponse(BiquadFilter::LOWPASS, 20.0f, 0.707f, 2);
+    checkResponse(BiquadFilter::HIGHPASS, 40.0f, 0.707f, 3);
+}
+
+// Design targets that don't depend on the coefficient formula at all
+void test_butterworth_lowpass_landmarks() {
+    BiquadFilter dc;
+    dc.configure(BiquadFilter::LOWPASS, 20.0f, TEST_CONTROL_RATE, 0.7071f);
+    float y = 0.0f;
+    for (int n = 0; n < 500; n++) y = dc.process(100.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, y);   // Unity gain at DC
+
+    BiquadFilter one;
+    one.configure(BiquadFilter::LOWPASS, 20.0f, TEST_CONTROL_RATE, 0.7071f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.7071f, measuredGain(one, 20.0f, TEST_CONTROL_RATE));  // -3 dB at cutoff
+
+    // Two sections: twice the attenuation (in dB) an octave up
+    BiquadFilter two;
+    two.configure(BiquadFilter::LOWPASS, 20.0f, TEST_CONTROL_RATE, 0.7071f);
+    two.setSections(2);
+    float single = 20.0f * log10f(measuredGain(one, 40.0f, TEST_CONTROL_RATE));
+    float cascade = 20.0f * log10f(measuredGain(two, 40.0f, TEST_CONTROL_RATE));
+    printf("lowpass 20 Hz, one octave up: 1 section %.1f dB, 2 sections %.1f dB\n", single, cascade);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 2.0f * single, cascade);
+}
+
+void test_retune_glides_to_new_coefficients() {
+    BiquadFilter filter;
+    filter.configure(BiquadFilter::LOWPASS, 20.0f, TEST_CONTROL_RATE);
+    BiquadCoefficients start = filter.current();
+    filter.configure(BiquadFilter::LOWPASS, 60.0f, TEST_CONTROL_RATE);
+    BiquadCoefficients end = filter.coefficients();
+
+    // Still on the old coefficients until the first sample
+    TEST_ASSERT_EQUAL_FLOAT(start.b0, filter.current().b0);
+    float previous = start.b0;
+    for (uint16_t n = 0; n < filter.rampSamples(); n++) {
+        filter.process(0.0f);
+        TEST_ASSERT_TRUE(filter.current().b0 > previous);   // Moves every sample
+        TEST_ASSERT_TRUE(filter.current().b0 <= end.b0);     // Never overshoots
+        previous = filter.current().b0;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(end.b0, filter.current().b0);
+    TEST_ASSERT_EQUAL_FLOAT(end.a1, filter.current().a1);
+    TEST_ASSERT_EQUAL_FLOAT(end.a2, filter.current().a2);
+}
+
+/**
+ * Largest excursion away from a held level (the lowpass passes DC at unity
+ * gain, so any ripple is the retune itself) when the cutoff moves from
+ * 20 to 80 Hz.
+ */
+static float retuneGlitch(uint16_t rampSamples) {
+    BiquadFilter filter;
+    filter.setRampSamples(rampSamples);
+    filter.configure(BiquadFilter::LOWPASS, 20.0f, TEST_CONTROL_RATE, 2.0f);
+    for (int n = 0; n < 500; n++) filter.process(100.0f);
+    filter.configure(BiquadFilter::LOWPASS, 80.0f, TEST_CONTROL_RATE, 2.0f);
+    float largest = 0.0f;
+    for (int n = 0; n < 500; n++) {
+        float error = fabsf(filter.process(100.0f) - 100.0f);
+        if (error > largest) largest = error;
+    }
+    return largest;
+}
+
+void test_retune_glide_softens_the_step() {
+    float jump = retuneGlitch(0);
+    float glide = retuneGlitch(BIQUAD_DEFAULT_RAMP_SAMPLES);
+    printf("held level of 100, 20 -> 80 Hz retune: jump glitch %.2f, glide glitch %.2f\n", jump, glide);
+    TEST_ASSERT_TRUE(glide < 0.5f * jump);
+}
+
+static int runAll() {
     UNITY_BEGIN();
     RUN_TEST(test_frequency_clamps_to_20hz);
-    UNITY_END();
+    RUN_TEST(test_lowpass_response_matches_analytical);
+    RUN_TEST(test_highpass_response_matches_analytical);
+    RUN_TEST(test_bandpass_response_matches_analytical);
+    RUN_TEST(test_cascade_response_matches_analytical);
+    RUN_TEST(test_butterworth_lowpass_landmarks);
+    RUN_TEST(test_retune_glides_to_new_coefficients);
+    RUN_TEST(test_retune_glide_softens_the_step);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    runAll();
 }
 
 void loop() {}
+#else
+int main() {
+    return runAll();
+}
+#endif
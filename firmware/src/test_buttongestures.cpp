@@ -0,0 +1,293 @@
+#include <unity.h>
+#include <stdint.h>
+#include <vector>
+#include "VerticalDebouncer.h"
+#include "ButtonGestures.h"
+
+// Host-side test: feed the same bouncy button signals to a model of the old
+// per-button debounce + state machine and to the vertical counter + gesture
+// engine, and check both produce the same gestures per button.
+
+#define DEBOUNCE_DELAY 50
+#define DEBOUNCE_SAMPLE_MS (DEBOUNCE_DELAY / 4)
+#define NUM_BUTTONS 48
+
+struct Event {
+    uint8_t button;
+    ButtonGesture gesture;
+};
+
+// ---- Reference: the old ButtonManager logic, one object per button, run every loop pass ----
+struct LegacyButton {
+    // Time-based debounce: adopt the raw level once it has been stable for DEBOUNCE_DELAY
+    bool lastRaw = false;
+    uint32_t lastChange = 0;
+    bool stable = false;
+
+    enum State { IDLE, PRESSED, LONG_PRESS, RELEASED } state = IDLE;
+    uint32_t pressTimestamp = 0;
+    bool longPressFired = false;
+    uint32_t lastShortRelease = 0;
+
+    void update(uint8_t button, bool raw, uint32_t now, std::vector<Event>& out) {
+        if (raw != lastRaw) {
+            lastRaw = raw;
+            lastChange = now;
+        }
+        if (now - lastChange > DEBOUNCE_DELAY) stable = raw;
+        bool pressed = stable;
+
+        switch (state) {
+        case IDLE:
+            if (pressed) {
+                state = PRESSED;
+                pressTimestamp = now;
+                longPressFired = false;
+            }
+            break;
+        case PRESSED:
+            if (!pressed) {
+                state = RELEASED;
+            } else if (!longPressFired && now - pressTimestamp >= GESTURE_LONG_PRESS_MS) {
+                state = LONG_PRESS;
+                longPressFired = true;
+                out.push_back({button, GESTURE_LONG});
+            }
+            break;
+        case LONG_PRESS:
+            if (!pressed) state = RELEASED;
+            break;
+        case RELEASED:
+            if (!longPressFired) {
+                if (now - lastShortRelease < GESTURE_DOUBLE_PRESS_MS) {
+                    out.push_back({button, GESTURE_DOUBLE});
+                    lastShortRelease = 0;
+                } else {
+                    out.push_back({button, GESTURE_SINGLE});
+                    lastShortRelease = now;
+                }
+            }
+            state = IDLE;
+            break;
+        }
+    }
+};
+
+// ---- Input generator: scripted presses with contact bounce on every edge ----
+static uint32_t lcgState = 98765;
+static uint32_t nextRandom() {
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return lcgState >> 8;
+}
+
+struct Script {
+    uint8_t button;
+    std::vector<uint32_t> edges;   // Alternating press/release times
+    std::vector<uint32_t> glitches; // Start of short spikes that must be ignored
+};
+
+// Raw level of one button at time t, with up to 8 ms of bounce after each edge
+static bool rawLevel(const Script& s, uint32_t t, const std::vector<uint32_t>& bounceSeeds) {
+    bool level = false;
+    for (size_t i = 0; i < s.edges.size(); i++) {
+        if (t < s.edges[i]) break;
+        level = (i % 2 == 0);
+        uint32_t since = t - s.edges[i];
+        if (since < 8 && ((bounceSeeds[i] >> since) & 1)) level = !level;
+    }
+    for (uint32_t g : s.glitches) {
+        if (t >= g && t < g + 9) level = !level;
+    }
+    return level;
+}
+
+static std::vector<Script> makeScripts() {
+    const uint32_t t0 = 10000;
+    std::vector<Script> scripts = {
+        // single, then a lone glitch
+        { 0,  { t0, t0 + 120 },                                  { t0 + 2000 } },
+        // long press
+        { 17, { t0, t0 + 800 },                                  {} },
+        // double press
+        { 41, { t0, t0 + 100, t0 + 200, t0 + 300 },              {} },
+        // two singles, too far apart for a double
+        { 42, { t0, t0 + 100, t0 + 600, t0 + 700 },              {} },
+        // triple tap: single, double, single
+        { 45, { t0, t0 + 70, t0 + 140, t0 + 210, t0 + 280, t0 + 350 }, {} },
+        // long press, then a quick tap
+        { 47, { t0, t0 + 700, t0 + 900, t0 + 1000 },             { t0 + 1600 } },
+        // chatter-only input never registers
+        { 30, {},                                                { t0, t0 + 40, t0 + 300 } },
+    };
+    return scripts;
+}
+
+static std::vector<Event> filterButton(const std::vector<Event>& events, uint8_t button, bool gesturesOnly) {
+    std::vector<Event> out;
+    for (const Event& e : events) {
+        if (e.button != button) continue;
+        if (gesturesOnly && (e.gesture == GESTURE_PRESS || e.gesture == GESTURE_RELEASE)) continue;
+        out.push_back(e);
+    }
+    return out;
+}
+
+static void recordGesture(void* context, uint8_t button, ButtonGesture gesture, uint32_t) {
+    static_cast<std::vector<Event>*>(context)->push_back({button, gesture});
+}
+
+void test_same_gestures_as_legacy_state_machine() {
+    std::vector<Script> scripts = makeScripts();
+    std::vector<std::vector<uint32_t>> seeds(scripts.size());
+    for (size_t s = 0; s < scripts.size(); s++) {
+        for (size_t e = 0; e < scripts[s].edges.size(); e++) seeds[s].push_back(nextRandom());
+    }
+
+    LegacyButton legacy[NUM_BUTTONS];
+    std::vector<Event> legacyEvents;
+
+    VerticalDebouncer debouncer;
+    ButtonGestures gestures;
+    std::vector<Event> newEvents;
+    gestures.setHandler(recordGesture, &newEvents);
+    uint32_t lastSample = 0;
+
+    for (uint32_t now = 9000; now < 14000; now++) {
+        uint64_t raw = 0;
+        for (size_t s = 0; s < scripts.size(); s++) {
+            if (rawLevel(scripts[s], now, seeds[s])) raw |= 1ULL << scripts[s].button;
+        }
+
+        for (uint8_t b = 0; b < NUM_BUTTONS; b++) {
+            legacy[b].update(b, (raw >> b) & 1, now, legacyEvents);
+        }
+
+        uint64_t changed = 0;
+        if (now - lastSample >= DEBOUNCE_SAMPLE_MS) {
+            lastSample = now;
+            changed = debouncer.update(raw);
+        }
+        gestures.update(changed, debouncer.state(), now);
+    }
+
+    for (const Script& s : scripts) {
+        std::vector<Event> expected = filterButton(legacyEvents, s.button, false);
+        std::vector<Event> actual = filterButton(newEvents, s.button, true);
+        TEST_ASSERT_EQUAL_UINT32(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            TEST_ASSERT_EQUAL_UINT8(expected[i].gesture, actual[i].gesture);
+        }
+    }
+
+    // Spot-check the scripted expectations themselves
+    std::vector<Event> b41 = filterButton(newEvents, 41, true);
+    TEST_ASSERT_EQUAL_UINT32(2, b41.size());
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_SINGLE, b41[0].gesture);
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_DOUBLE, b41[1].gesture);
+    TEST_ASSERT_EQUAL_UINT32(0, filterButton(newEvents, 30, false).size());
+}
+
+void test_debouncer_needs_four_agreeing_samples() {
+    VerticalDebouncer debouncer;
+    uint64_t all = ~0ULL;
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)debouncer.update(all));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)debouncer.update(all));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)debouncer.update(0));   // bounce resets the count
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)debouncer.update(all));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)debouncer.update(all));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)debouncer.update(all));
+    TEST_ASSERT_TRUE(debouncer.update(all) == all);                // all 64 flip together
+    TEST_ASSERT_TRUE(debouncer.state() == all);
+}
+
+void test_press_and_release_events_bracket_gestures() {
+    ButtonGestures gestures;
+    std::vector<Event> events;
+    gestures.setHandler(recordGesture, &events);
+
+    uint64_t bit = 1ULL << 47;
+    gestures.update(bit, bit, 1000);
+    for (uint32_t t = 1001; t < 1600; t++) gestures.update(0, bit, t);
+    gestures.update(bit, 0, 1600);
+
+    TEST_ASSERT_EQUAL_UINT32(3, events.size());
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_PRESS, events[0].gesture);
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_LONG, events[1].gesture);
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_RELEASE, events[2].gesture);
+    TEST_ASSERT_EQUAL_UINT8(47, events[1].button);
+}
+
+static std::vector<Event> gesturesOnly(const std::vector<Event>& events) {
+    std::vector<Event> out;
+    for (const Event& e : events) {
+        if (e.gesture != GESTURE_PRESS && e.gesture != GESTURE_RELEASE) out.push_back(e);
+    }
+    return out;
+}
+
+// Press a at +aDown ms and b at +bDown ms, release both at upAt, one update per ms
+static std::vector<Event> playChord(const uint64_t* chords, uint8_t count,
+                                    uint8_t a, uint32_t aDown, uint8_t b, uint32_t bDown,
+                                    uint32_t upAt) {
+    ButtonGestures gestures;
+    std::vector<Event> events;
+    gestures.setHandler(recordGesture, &events);
+    gestures.setChords(chords, count);
+
+    uint64_t pressed = 0;
+    for (uint32_t t = 1000; t < upAt + 50; t++) {
+        uint64_t next = pressed;
+        if (t == 1000 + aDown) next |= 1ULL << a;
+        if (t == 1000 + bDown) next |= 1ULL << b;
+        if (t == upAt) next = 0;
+        gestures.update(next ^ pressed, next, t);
+        pressed = next;
+    }
+    return gesturesOnly(events);
+}
+
+void test_chord_fires_and_suppresses_single_presses() {
+    const uint64_t chords[] = { (1ULL << 42) | (1ULL << 43), (1ULL << 44) | (1ULL << 47), (1ULL << 3) | (1ULL << 47) };
+
+    // Second button 30 ms after the first: chord 1, and no single on release
+    std::vector<Event> events = playChord(chords, 3, 44, 0, 47, 30, 1200);
+    TEST_ASSERT_EQUAL_UINT32(1, events.size());
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_CHORD, events[0].gesture);
+    TEST_ASSERT_EQUAL_UINT8(1, events[0].button);
+
+    // Slot + control chords work the same way
+    events = playChord(chords, 3, 3, 0, 47, 10, 1200);
+    TEST_ASSERT_EQUAL_UINT32(1, events.size());
+    TEST_ASSERT_EQUAL_UINT8(2, events[0].button);
+
+    // Held long: still just the chord, no long presses
+    events = playChord(chords, 3, 42, 0, 43, 5, 2500);
+    TEST_ASSERT_EQUAL_UINT32(1, events.size());
+    TEST_ASSERT_EQUAL_UINT8(0, events[0].button);
+}
+
+void test_presses_outside_window_are_not_a_chord() {
+    const uint64_t chords[] = { (1ULL << 42) | (1ULL << 43) };
+
+    // 200 ms apart: plain single presses on release
+    std::vector<Event> events = playChord(chords, 1, 42, 0, 43, 200, 1400);
+    TEST_ASSERT_EQUAL_UINT32(2, events.size());
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_SINGLE, events[0].gesture);
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_SINGLE, events[1].gesture);
+
+    // First button held past the long-press time before the second: long, then single
+    events = playChord(chords, 1, 42, 0, 43, 600, 1700);
+    TEST_ASSERT_EQUAL_UINT32(2, events.size());
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_LONG, events[0].gesture);
+    TEST_ASSERT_EQUAL_UINT8(GESTURE_SINGLE, events[1].gesture);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_gestures_as_legacy_state_machine);
+    RUN_TEST(test_debouncer_needs_four_agreeing_samples);
+    RUN_TEST(test_press_and_release_events_bracket_gestures);
+    RUN_TEST(test_chord_fires_and_suppresses_single_presses);
+    RUN_TEST(test_presses_outside_window_are_not_a_chord);
+    return UNITY_END();
+}
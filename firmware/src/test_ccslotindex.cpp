@@ -0,0 +1,168 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "CcSlotIndex.h"
+
+// Host-side test: the slot <-> (channel, CC) map the pots send on and incoming
+// CCs are looked up in, against scanning every slot's mapping per message.
+
+#define SIM_SLOTS 42
+#define SIM_MESSAGES 1000000
+
+struct Mapping {
+    uint8_t channel[SIM_SLOTS];
+    uint8_t cc[SIM_SLOTS];
+};
+
+// What looking up an incoming CC costs without the index
+static uint64_t scanSlots(const Mapping& map, uint8_t channel, uint8_t cc) {
+    uint64_t slots = 0;
+    for (uint8_t s = 0; s < SIM_SLOTS; s++) {
+        if (map.channel[s] == channel && map.cc[s] == cc) slots |= 1ULL << s;
+    }
+    return slots;
+}
+
+void test_slots_move_with_their_mapping() {
+    CcSlotIndex index;
+    TEST_ASSERT_TRUE(index.slotsFor(1, 0) == 0);
+    index.assign(0, 1, 20);
+    index.assign(5, 1, 20);   // Two slots on one CC: both come back
+    index.assign(7, 16, 127);
+    TEST_ASSERT_TRUE(index.slotsFor(1, 20) == ((1ULL << 0) | (1ULL << 5)));
+    TEST_ASSERT_TRUE(index.slotsFor(16, 127) == 1ULL << 7);
+
+    index.assign(5, 2, 20);   // setPotChannel
+    TEST_ASSERT_TRUE(index.slotsFor(1, 20) == 1ULL << 0);
+    TEST_ASSERT_TRUE(index.slotsFor(2, 20) == 1ULL << 5);
+    index.assign(5, 2, 21);   // setPotCCNumber
+    TEST_ASSERT_TRUE(index.slotsFor(2, 20) == 0);
+    TEST_ASSERT_TRUE(index.slotsFor(2, 21) == 1ULL << 5);
+    index.assign(5, 2, 21);   // Same again: no change
+    TEST_ASSERT_TRUE(index.slotsFor(2, 21) == 1ULL << 5);
+
+    index.assign(7, 0, 127);  // Out of range takes it out
+    TEST_ASSERT_FALSE(index.mapped(7));
+    TEST_ASSERT_TRUE(index.slotsFor(16, 127) == 0);
+    index.assign(7, 3, 128);
+    TEST_ASSERT_FALSE(index.mapped(7));
+    TEST_ASSERT_TRUE(index.slotsFor(0, 20) == 0);
+    TEST_ASSERT_TRUE(index.slotsFor(17, 20) == 0);
+    index.assign(CC_INDEX_MAX_SLOTS, 1, 20);   // Not a slot
+    TEST_ASSERT_TRUE(index.slotsFor(1, 20) == 1ULL << 0);
+
+    index.assign(63, 1, 20);
+    TEST_ASSERT_TRUE(index.slotsFor(1, 20) == ((1ULL << 0) | (1ULL << 63)));
+    index.clear();
+    TEST_ASSERT_TRUE(index.slotsFor(1, 20) == 0);
+    TEST_ASSERT_FALSE(index.mapped(0));
+}
+
+// What ConfigManager::setPotChannel() / setPotCCNumber() do: change one half, keep the other
+static void setChannel(CcSlotIndex& index, uint8_t slot, uint8_t channel) { index.assign(slot, channel, index.cc(slot)); }
+static void setCC(CcSlotIndex& index, uint8_t slot, uint8_t cc) { index.assign(slot, index.channel(slot), cc); }
+
+// Send what a pot sends (ConfigManager::getPotChannel / getPotCCNumber) back in
+static uint64_t echo(const CcSlotIndex& index, uint8_t slot) {
+    return index.slotsFor(index.channel(slot), index.cc(slot));
+}
+
+/**
+ * The pots send on the index's own forward map, so a pot's CC echoed back
+ * by the DAW finds that pot and nothing else: out of the box, after a
+ * remap, and after raw EEPROM values are cleaned up.
+ */
+void test_outgoing_cc_comes_back_to_its_pot() {
+    CcSlotIndex index;
+    index.assignDefaults(SIM_SLOTS);   // ConfigManager's constructor and resetConfiguration()
+    for (uint8_t s = 0; s < SIM_SLOTS; s++) {
+        TEST_ASSERT_EQUAL_UINT8(1, index.channel(s));
+        TEST_ASSERT_EQUAL_UINT8(s, index.cc(s));
+        TEST_ASSERT_TRUE(echo(index, s) == 1ULL << s);
+    }
+    TEST_ASSERT_TRUE(index.slotsFor(1, 0) == 1ULL << 0);   // Not all 42 slots
+
+    setChannel(index, 5, 3);
+    setCC(index, 5, 77);
+    TEST_ASSERT_EQUAL_UINT8(3, index.channel(5));
+    TEST_ASSERT_EQUAL_UINT8(77, index.cc(5));
+    TEST_ASSERT_TRUE(echo(index, 5) == 1ULL << 5);
+    TEST_ASSERT_TRUE(index.slotsFor(1, 5) == 0);
+
+    setCC(index, 6, 77);   // Two pots on one CC: either one's echo moves both
+    setChannel(index, 6, 3);
+    TEST_ASSERT_TRUE(echo(index, 5) == ((1ULL << 5) | (1ULL << 6)));
+    TEST_ASSERT_TRUE(echo(index, 6) == echo(index, 5));
+
+    // Raw EEPROM garbage is kept as read, sends nowhere valid and matches nothing...
+    index.assign(9, 0, 200);
+    TEST_ASSERT_EQUAL_UINT8(0, index.channel(9));
+    TEST_ASSERT_EQUAL_UINT8(200, index.cc(9));
+    TEST_ASSERT_TRUE(echo(index, 9) == 0);
+    // ...until setup() puts it back in range
+    setChannel(index, 9, 1);
+    setCC(index, 9, 9);
+    TEST_ASSERT_TRUE(echo(index, 9) == 1ULL << 9);
+}
+
+/**
+ * Dense automation: a million CCs on random channels and numbers, a quarter
+ * of them hitting a slot, with the slots remapped now and then. The index
+ * must agree with a full scan every time, and cost less.
+ */
+void test_index_agrees_with_a_scan_and_is_faster() {
+    srand(25);
+    Mapping map;
+    CcSlotIndex index;
+    for (uint8_t s = 0; s < SIM_SLOTS; s++) {
+        map.channel[s] = 1 + s / 16;
+        map.cc[s] = s % 16 + 20;
+        index.assign(s, map.channel[s], map.cc[s]);
+    }
+
+    static uint8_t channels[SIM_MESSAGES], ccs[SIM_MESSAGES];
+    for (int i = 0; i < SIM_MESSAGES; i++) {
+        if (rand() % 4 == 0) {
+            uint8_t s = rand() % SIM_SLOTS;
+            channels[i] = map.channel[s];
+            ccs[i] = map.cc[s];
+        } else {
+            channels[i] = 1 + rand() % 16;
+            ccs[i] = rand() % 128;
+        }
+    }
+
+    for (int i = 0; i < SIM_MESSAGES; i++) {
+        if (i % 1000 == 0) {
+            uint8_t s = rand() % SIM_SLOTS;
+            map.channel[s] = 1 + rand() % 16;
+            map.cc[s] = rand() % 128;
+            index.assign(s, map.channel[s], map.cc[s]);
+        }
+        if (index.slotsFor(channels[i], ccs[i]) != scanSlots(map, channels[i], ccs[i])) {
+            TEST_FAIL_MESSAGE("Index and scan disagree");
+        }
+    }
+
+    volatile uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < SIM_MESSAGES; i++) sink = sink + scanSlots(map, channels[i], ccs[i]);
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < SIM_MESSAGES; i++) sink = sink + index.slotsFor(channels[i], ccs[i]);
+    auto end = std::chrono::steady_clock::now();
+    double scanNs = std::chrono::duration<double, std::nano>(middle - start).count() / SIM_MESSAGES;
+    double indexNs = std::chrono::duration<double, std::nano>(end - middle).count() / SIM_MESSAGES;
+    printf("Incoming CC -> slots over %d slots: scan %.1f ns, index %.1f ns per message\n",
+           SIM_SLOTS, scanNs, indexNs);
+    TEST_ASSERT_TRUE(indexNs < scanNs);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_slots_move_with_their_mapping);
+    RUN_TEST(test_outgoing_cc_comes_back_to_its_pot);
+    RUN_TEST(test_index_agrees_with_a_scan_and_is_faster);
+    return UNITY_END();
+}
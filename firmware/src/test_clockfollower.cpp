@@ -0,0 +1,150 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ClockFollower.h"
+
+// Host-side test: the MIDI clock follower against jittery tick timestamps.
+
+#define SIM_PASS_US 1000         // Ticks are timestamped when the 1 ms MIDI task reads them
+#define SIM_SENDER_JITTER_US 400 // Plus up to this much from the sender / USB
+
+static double periodFor(double bpm) { return 60000000.0 / (bpm * CLOCK_PPQN); }
+
+// When the firmware sees a tick that was sent at `sent`
+static uint32_t readAt(double sent) {
+    double arrived = sent + (rand() % (SIM_SENDER_JITTER_US + 1));
+    return static_cast<uint32_t>(ceil(arrived / SIM_PASS_US) * SIM_PASS_US);
+}
+
+static double stddev(const double* x, int n) {
+    double mean = 0.0, var = 0.0;
+    for (int i = 0; i < n; i++) mean += x[i];
+    mean /= n;
+    for (int i = 0; i < n; i++) var += (x[i] - mean) * (x[i] - mean);
+    return sqrt(var / n);
+}
+
+void test_steady_clock_is_smoothed() {
+    srand(3);
+    ClockFollower clock;
+    const double period = periodFor(120.0);
+    const int N = 24 * 64;
+    static double rawError[N], filteredError[N];
+    double sent = 12345.0;
+    int kept = 0;
+    for (int i = 0; i < N; i++, sent += period) {
+        uint32_t raw = readAt(sent);
+        clock.onClock(raw);
+        if (i >= 48) {   // After two beats to settle
+            rawError[kept] = raw - sent;
+            filteredError[kept] = static_cast<int32_t>(clock.lastTickMicros() - static_cast<uint32_t>(sent));
+            kept++;
+        }
+    }
+    double rawJitter = stddev(rawError, kept);
+    double filteredJitter = stddev(filteredError, kept);
+    printf("120 BPM, read every %d us + %d us sender jitter: tick time jitter raw %.0f us, filtered %.0f us; %.3f BPM\n",
+           SIM_PASS_US, SIM_SENDER_JITTER_US, rawJitter, filteredJitter, clock.bpm());
+    TEST_ASSERT_TRUE(filteredJitter * 2.5 < rawJitter);
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, 120.0f, clock.bpm());
+    TEST_ASSERT_TRUE(clock.locked());
+}
+
+void test_tempo_change_settles_within_two_beats() {
+    srand(4);
+    ClockFollower clock;
+    double sent = 0.0;
+    for (int i = 0; i < 24 * 8; i++, sent += periodFor(120.0)) clock.onClock(readAt(sent));
+    int settled = -1;
+    for (int i = 0; i < 24 * 8; i++, sent += periodFor(140.0)) {
+        clock.onClock(readAt(sent));
+        bool close = fabs(clock.bpm() - 140.0) < 1.4;   // Within 1%
+        if (close && settled < 0) settled = i;
+        if (!close) settled = -1;
+    }
+    printf("120 -> 140 BPM: within 1%% after %d ticks and stays there\n", settled);
+    TEST_ASSERT_TRUE(settled >= 0 && settled <= 2 * CLOCK_PPQN);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 140.0f, clock.bpm());
+}
+
+void test_transport_keeps_song_position() {
+    ClockFollower clock;
+    uint32_t t = 0;
+    const uint32_t period = 20833;
+    for (int i = 0; i < 10; i++) clock.onClock(t += period);   // Clock before Start: tempo only
+    TEST_ASSERT_FALSE(clock.running());
+    TEST_ASSERT_EQUAL_UINT32(0, clock.position());
+
+    clock.onStart();
+    clock.onClock(t += period);
+    TEST_ASSERT_EQUAL_UINT32(0, clock.position());   // First clock after Start is the downbeat
+    for (int i = 0; i < CLOCK_PPQN; i++) clock.onClock(t += period);
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN, clock.position());
+    TEST_ASSERT_EQUAL_UINT32(1, clock.beat());
+
+    clock.onStop();
+    for (int i = 0; i < 5; i++) clock.onClock(t += period);
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN, clock.position());
+    clock.onContinue();
+    clock.onClock(t += period);
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN + 1, clock.position());
+
+    clock.onStop();
+    clock.onSongPosition(8);   // 8 sixteenths = 2 beats
+    clock.onContinue();
+    clock.onClock(t += period);
+    TEST_ASSERT_EQUAL_UINT32(2 * CLOCK_PPQN, clock.position());
+    clock.onClock(t += period);
+    TEST_ASSERT_EQUAL_UINT32(2 * CLOCK_PPQN + 1, clock.position());
+    TEST_ASSERT_EQUAL_UINT32(10 + 1 + CLOCK_PPQN + 5 + 1 + 2, clock.ticks());
+}
+
+void test_beat_phase_moves_between_ticks() {
+    ClockFollower clock;
+    uint32_t t = 0;
+    const uint32_t period = 20000;
+    clock.onStart();
+    for (int i = 0; i < 30; i++) clock.onClock(t += period);   // Position 29 = tick 5 of beat 1
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.0f / CLOCK_PPQN, clock.beatPhase(t));
+    TEST_ASSERT_FLOAT_WITHIN(0.002f, 5.5f / CLOCK_PPQN, clock.beatPhase(t + period / 2));
+    TEST_ASSERT_TRUE(clock.beatPhase(t + 5 * period) < 6.0f / CLOCK_PPQN);   // Never runs past the next tick
+    clock.onStop();
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.0f / CLOCK_PPQN, clock.beatPhase(t + period / 2));
+}
+
+void test_dropouts_and_a_lost_tick() {
+    ClockFollower clock;
+    uint32_t t = 1000;
+    const uint32_t period = 20833;
+    for (int i = 0; i < 48; i++) clock.onClock(t += period);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 120.0f, clock.bpm());
+
+    clock.onClock(t += 2 * period);   // One tick lost on the way: ignored for tempo
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 120.0f, clock.bpm());
+    for (int i = 0; i < 24; i++) clock.onClock(t += period);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 120.0f, clock.bpm());
+
+    t += 1000000;   // Clock gone for a second
+    TEST_ASSERT_FALSE(clock.present(t, 500000));
+    const uint32_t faster = 15625;   // 160 BPM when it comes back
+    for (int i = 0; i < 3; i++) clock.onClock(t += faster);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 160.0f, clock.bpm());
+    TEST_ASSERT_TRUE(clock.present(t, 500000));
+
+    for (int i = 0; i < 24; i++) clock.onClock(t += faster);
+    const uint32_t doubled = faster / 2;   // Jumps straight to 320 BPM
+    for (int i = 0; i < 2; i++) clock.onClock(t += doubled);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 320.0f, clock.bpm());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_clock_is_smoothed);
+    RUN_TEST(test_tempo_change_settles_within_two_beats);
+    RUN_TEST(test_transport_keeps_song_position);
+    RUN_TEST(test_beat_phase_moves_between_ticks);
+    RUN_TEST(test_dropouts_and_a_lost_tick);
+    return UNITY_END();
+}
@@ -0,0 +1,298 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "ClockGenerator.h"
+
+// Host-side test: the timer-driven internal clock on a virtual periodic
+// timer, against the old millis() poll.
+
+#define SIM_TASK_US 1000           // The old poll ran on the 1 ms MIDI task...
+#define SIM_TASK_LATE_US 300       // ...up to this late behind the other tasks
+#define SIM_MASKED_US 20           // Longest stretch the main loop keeps the timer interrupt masked (a MIDI write)
+#define SIM_MASKED_SHARE 10        // Percent of the time it's in one
+#define SIM_SECONDS 600
+
+static double periodFor(double bpm) { return 60000000.0 / (bpm * CLOCK_PPQN); }
+
+/**
+ * A PIT channel as IntervalTimer drives it: when it expires it reloads
+ * from the load register at once, then runs the interrupt, so update()
+ * inside the interrupt sets the interval after the one already running.
+ */
+struct VirtualTimer {
+    uint64_t nextFire = 0;
+    uint32_t load = 0;
+    void begin(uint64_t now, uint32_t interval) {
+        nextFire = now + interval;
+        load = interval;
+    }
+    void update(uint32_t interval) { load = interval; }
+    uint64_t expire() {
+        uint64_t fired = nextFire;
+        nextFire += load;
+        return fired;
+    }
+};
+
+struct Emitted {
+    double at;       // When the interrupt wrote the byte, µs
+    uint8_t byte;
+};
+
+// The firmware's clock interrupt, with the delay of a masked stretch in front of it
+static void runTimer(ClockGenerator& gen, VirtualTimer& timer, uint64_t until, std::vector<Emitted>& out) {
+    while (timer.nextFire < until) {
+        double at = static_cast<double>(timer.expire());
+        if (rand() % 100 < SIM_MASKED_SHARE) at += rand() % (SIM_MASKED_US + 1);
+        uint8_t bytes[2];
+        uint8_t n = gen.tick(static_cast<uint32_t>(at), bytes);
+        timer.update(gen.nextInterval());
+        for (uint8_t i = 0; i < n; i++) out.push_back({ at, bytes[i] });
+    }
+}
+
+static void startTimer(ClockGenerator& gen, VirtualTimer& timer, uint64_t now) {
+    timer.begin(now, gen.nextInterval());
+    timer.update(gen.nextInterval());
+}
+
+void test_intervals_carry_the_fraction() {
+    ClockGenerator gen;
+    gen.setBpm(120.0f);
+    uint64_t total = 0;
+    for (int i = 0; i < 2 * 60 * CLOCK_PPQN; i++) {   // One minute
+        uint32_t interval = gen.nextInterval();
+        TEST_ASSERT_TRUE(interval == 20833 || interval == 20834);
+        total += interval;
+    }
+    TEST_ASSERT_UINT32_WITHIN(1, 60000000UL, static_cast<uint32_t>(total));
+
+    gen.setBpm(133.7f);
+    double exact = periodFor(133.7f);
+    total = 0;
+    const int n = 100000;
+    for (int i = 0; i < n; i++) total += gen.nextInterval();
+    TEST_ASSERT_TRUE(fabs(total - exact * n) < 1.0 + n / 8192.0);   // Only the 1/4096 µs rounding of the period is left
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 133.7f, gen.bpm());
+
+    gen.setBpm(1000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, CLOCK_GEN_MAX_BPM, gen.bpm());
+    gen.setBpm(1.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, CLOCK_GEN_MIN_BPM, gen.bpm());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 125000.0f, gen.periodMicros());
+}
+
+void test_transport_goes_out_on_the_next_tick() {
+    ClockGenerator gen;
+    uint8_t bytes[2];
+    TEST_ASSERT_EQUAL_UINT8(1, gen.tick(0, bytes));   // Clock runs before Start: tempo only
+    TEST_ASSERT_EQUAL_HEX8(0xF8, bytes[0]);
+    TEST_ASSERT_FALSE(gen.running());
+
+    gen.start();
+    TEST_ASSERT_EQUAL_UINT8(2, gen.tick(0, bytes));
+    TEST_ASSERT_EQUAL_HEX8(0xFA, bytes[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xF8, bytes[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, gen.position());   // The clock after Start is the downbeat
+    for (int i = 0; i < CLOCK_PPQN; i++) gen.tick(0, bytes);
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN, gen.position());
+    TEST_ASSERT_EQUAL_UINT32(1, gen.beat());
+
+    gen.stop();
+    TEST_ASSERT_EQUAL_UINT8(2, gen.tick(0, bytes));
+    TEST_ASSERT_EQUAL_HEX8(0xFC, bytes[0]);
+    TEST_ASSERT_EQUAL_UINT8(1, gen.tick(0, bytes));
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN, gen.position());
+
+    gen.resume();
+    gen.setEnabled(false);   // An external clock took over: nothing goes out, Continue waits
+    TEST_ASSERT_EQUAL_UINT8(0, gen.tick(0, bytes));
+    gen.setEnabled(true);
+    TEST_ASSERT_EQUAL_UINT8(2, gen.tick(0, bytes));
+    TEST_ASSERT_EQUAL_HEX8(0xFB, bytes[0]);
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN + 1, gen.position());
+    TEST_ASSERT_EQUAL_UINT32(1 + 1 + CLOCK_PPQN + 2 + 1, gen.ticks());
+}
+
+struct Timing {
+    double bpm;          // From the first and last tick
+    double maxError;     // Worst |tick - ideal|, µs
+    double jitter;       // Std dev of tick - ideal, µs
+};
+
+static Timing measure(const std::vector<double>& ticks, double period) {
+    Timing r = { 0.0, 0.0, 0.0 };
+    size_t n = ticks.size();
+    r.bpm = 60000000.0 / ((ticks[n - 1] - ticks[0]) / (n - 1) * CLOCK_PPQN);
+    double mean = 0.0;
+    for (size_t i = 0; i < n; i++) mean += ticks[i] - (ticks[0] + i * period);
+    mean /= n;
+    double var = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double error = ticks[i] - (ticks[0] + i * period);
+        if (fabs(error) > r.maxError) r.maxError = fabs(error);
+        var += (error - mean) * (error - mean);
+    }
+    r.jitter = sqrt(var / n);
+    return r;
+}
+
+// The old processInternalClock(): a float period added to an unsigned long, polled against millis()
+static std::vector<double> oldPoll(double bpm) {
+    std::vector<double> ticks;
+    unsigned long lastTick = 0;
+    float msPerTick = 60000.0f / (static_cast<float>(bpm) * 24.0f);
+    for (uint64_t t = 0; t < SIM_SECONDS * 1000000ULL; t += SIM_TASK_US) {
+        uint64_t ran = t + rand() % (SIM_TASK_LATE_US + 1);
+        unsigned long now = static_cast<unsigned long>(ran / 1000);
+        if (now - lastTick >= msPerTick) {
+            lastTick += msPerTick;
+            ticks.push_back(static_cast<double>(ran));
+        }
+    }
+    return ticks;
+}
+
+void test_timer_clock_keeps_exact_tempo() {
+    srand(5);
+    const double bpm = 120.0;
+    std::vector<double> old = oldPoll(bpm);
+
+    ClockGenerator gen;
+    gen.setBpm(bpm);
+    VirtualTimer timer;
+    std::vector<Emitted> out;
+    startTimer(gen, timer, 0);
+    runTimer(gen, timer, SIM_SECONDS * 1000000ULL + 1, out);   // The last tick lands on the 600 s mark
+    std::vector<double> ticks;
+    for (const Emitted& e : out) ticks.push_back(e.at);
+
+    Timing before = measure(old, 1000.0 * 60000.0 / (bpm * 24.0) * (1.0 - 1.0 / 25.0));   // Its own (fast) grid
+    Timing after = measure(ticks, periodFor(bpm));
+    printf("%.0f BPM for %d s: %lu ticks expected\n", bpm, SIM_SECONDS, (unsigned long)(SIM_SECONDS * bpm / 60 * CLOCK_PPQN));
+    printf("  millis() poll: %lu ticks, %.2f BPM (%.1f%% fast), jitter %.0f us\n", (unsigned long)old.size(),
+           before.bpm, (before.bpm / bpm - 1.0) * 100.0, before.jitter);
+    printf("  timer:         %lu ticks, %.4f BPM, jitter %.1f us, worst %.1f us off the grid\n", (unsigned long)ticks.size(),
+           after.bpm, after.jitter, after.maxError);
+
+    TEST_ASSERT_EQUAL_UINT32(SIM_SECONDS * 120 / 60 * CLOCK_PPQN, ticks.size());
+    TEST_ASSERT_TRUE(after.maxError < 100.0);
+    TEST_ASSERT_TRUE(after.jitter < 10.0);
+    TEST_ASSERT_TRUE(fabs(after.bpm - bpm) < 0.001);
+    TEST_ASSERT_TRUE(before.bpm > bpm * 1.03);   // The old clock really was about 4% fast
+}
+
+void test_tempo_change_and_start_stay_on_the_grid() {
+    srand(6);
+    ClockGenerator gen;
+    VirtualTimer timer;
+    std::vector<Emitted> out;
+    startTimer(gen, timer, 0);
+    runTimer(gen, timer, 1000000, out);
+
+    gen.setBpm(97.3f);   // Takes effect one tick later (that interval was already loaded)
+    runTimer(gen, timer, timer.nextFire + 1, out);
+    double from = timer.nextFire;
+    gen.start();
+    size_t first = out.size();
+    runTimer(gen, timer, from + 60 * 1000000.0, out);
+
+    TEST_ASSERT_EQUAL_HEX8(0xFA, out[first].byte);
+    TEST_ASSERT_EQUAL_HEX8(0xF8, out[first + 1].byte);
+    std::vector<double> ticks;
+    for (size_t i = first; i < out.size(); i++) {
+        if (out[i].byte == 0xF8) ticks.push_back(out[i].at);
+    }
+    Timing after = measure(ticks, periodFor(97.3f));
+    printf("97.3 BPM after Start: %.4f BPM, worst %.1f us off the grid\n", after.bpm, after.maxError);
+    TEST_ASSERT_TRUE(after.maxError < 100.0);
+    TEST_ASSERT_TRUE(fabs(after.bpm - 97.3) < 0.005);
+    TEST_ASSERT_EQUAL_UINT32(ticks.size() - 1, gen.position());
+}
+
+// Tick times (0xF8 only) from out[from..]
+static std::vector<double> clockTimes(const std::vector<Emitted>& out, size_t from) {
+    std::vector<double> ticks;
+    for (size_t i = from; i < out.size(); i++) {
+        if (out[i].byte == 0xF8) ticks.push_back(out[i].at);
+    }
+    return ticks;
+}
+
+void test_ramp_glides_and_ends_on_a_beat() {
+    srand(7);
+    ClockGenerator gen;
+    VirtualTimer timer;
+    std::vector<Emitted> out;
+    startTimer(gen, timer, 0);
+    gen.start();
+    runTimer(gen, timer, 1000000, out);
+
+    size_t from = out.size();
+    gen.rampTo(90.0f);
+    TEST_ASSERT_TRUE(gen.ramping());
+    uint32_t landedAt = 0;
+    while (gen.ramping() || landedAt == 0) {
+        if (!gen.ramping() && landedAt == 0) landedAt = gen.position() + 2;   // Last ramp interval handed out: its tick is two on
+        runTimer(gen, timer, timer.nextFire + 1, out);
+    }
+    runTimer(gen, timer, timer.nextFire + 5 * 1000000ULL, out);
+    std::vector<double> ticks = clockTimes(out, from);
+    double biggestStep = 0.0;
+    for (size_t i = 2; i < ticks.size(); i++) {
+        double step = fabs((ticks[i] - ticks[i - 1]) - (ticks[i - 1] - ticks[i - 2]));
+        if (step > biggestStep) biggestStep = step;
+    }
+    double jump = periodFor(90.0) - periodFor(120.0);
+    printf("120 -> 90 BPM: biggest change between intervals %.0f us (a jump would be %.0f us), lands on position %lu\n",
+           biggestStep, jump, (unsigned long)landedAt);
+    TEST_ASSERT_TRUE(biggestStep < jump / 10.0);
+    TEST_ASSERT_EQUAL_UINT32(0, landedAt % CLOCK_PPQN);
+    Timing after = measure(std::vector<double>(ticks.end() - 4 * CLOCK_PPQN, ticks.end()), periodFor(90.0));
+    TEST_ASSERT_TRUE(fabs(after.bpm - 90.0) < 0.01);
+}
+
+void test_sync_moves_the_beat_onto_the_reference() {
+    srand(8);
+    ClockGenerator gen;
+    VirtualTimer timer;
+    std::vector<Emitted> out;
+    startTimer(gen, timer, 0);
+    gen.start();
+    runTimer(gen, timer, 1000000, out);
+
+    uint32_t tap = static_cast<uint32_t>(timer.nextFire) - 123457;   // A tap a little while ago, off our grid
+    gen.syncTo(100.0f, tap);
+    size_t from = out.size();
+    runTimer(gen, timer, timer.nextFire + 10 * 1000000ULL, out);
+
+    // Every downbeat once the ramp is done sits on tap + k beats
+    const double beat = periodFor(100.0) * CLOCK_PPQN;
+    std::vector<double> ticks = clockTimes(out, from);
+    uint32_t position = gen.position() - (ticks.size() - 1);
+    double worst = 0.0;
+    int beats = 0;
+    for (size_t i = 0; i < ticks.size(); i++, position++) {
+        if (position % CLOCK_PPQN || ticks[i] < tap + 3 * beat) continue;
+        double off = fmod(ticks[i] - tap + beat / 2, beat) - beat / 2;
+        if (fabs(off) > worst) worst = fabs(off);
+        beats++;
+    }
+    printf("Sync to a tap at 100 BPM: %d downbeats, worst %.1f us off the tap grid\n", beats, worst);
+    TEST_ASSERT_TRUE(beats > 10);
+    TEST_ASSERT_TRUE(worst < SIM_MASKED_US + 10);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_intervals_carry_the_fraction);
+    RUN_TEST(test_transport_goes_out_on_the_next_tick);
+    RUN_TEST(test_timer_clock_keeps_exact_tempo);
+    RUN_TEST(test_tempo_change_and_start_stay_on_the_grid);
+    RUN_TEST(test_ramp_glides_and_ends_on_a_beat);
+    RUN_TEST(test_sync_moves_the_beat_onto_the_reference);
+    return UNITY_END();
+}
@@ -0,0 +1,165 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include "EnvelopeDetector.h"
+
+// Host-side test: feed synthetic audio through EnvelopeDetector at 8 kHz and
+// compare it with the old approach of mapping one raw sample every 5 ms.
+
+#define TEST_INPUTS 6
+#define TEST_SAMPLE_RATE 8000.0f
+#define TEST_DECIMATION 40          // 200 Hz control rate
+#define TEST_BIAS 512
+
+static float expectedLevel(float amplitude) {
+    return amplitude * 127.0f / ENVELOPE_FULL_SCALE;
+}
+
+// A one-pole follower on a rectified sine settles a little off the true peak
+static int levelTolerance(float amplitude) {
+    return 1 + (int)(0.08f * expectedLevel(amplitude));
+}
+
+static uint16_t sineSample(float amplitude, float hz, uint32_t n) {
+    return static_cast<uint16_t>(lroundf(TEST_BIAS + amplitude * sinf(2.0f * (float)M_PI * hz * n / TEST_SAMPLE_RATE)));
+}
+
+struct LevelStats {
+    int minLevel = 255;
+    int maxLevel = 0;
+};
+
+/**
+ * Run `seconds` of a sine on every input (input i gets amplitude[i]) and
+ * collect min/max of the control-rate levels over the last half.
+ */
+static void runSine(EnvelopeDetector<TEST_INPUTS>& detector, const float* amplitude, float hz,
+                    float seconds, LevelStats* stats) {
+    uint32_t total = static_cast<uint32_t>(seconds * TEST_SAMPLE_RATE);
+    uint16_t frame[TEST_INPUTS];
+    for (uint32_t n = 0; n < total; n++) {
+        for (uint8_t i = 0; i < TEST_INPUTS; i++) frame[i] = sineSample(amplitude[i], hz, n);
+        if (detector.process(frame) && n >= total / 2) {
+            for (uint8_t i = 0; i < TEST_INPUTS; i++) {
+                int level = detector.level(i);
+                if (level < stats[i].minLevel) stats[i].minLevel = level;
+                if (level > stats[i].maxLevel) stats[i].maxLevel = level;
+            }
+        }
+    }
+}
+
+void test_peak_level_tracks_amplitude_without_aliasing() {
+    const float amplitude[TEST_INPUTS] = { 400, 300, 200, 100, 50, 0 };
+    EnvelopeDetector<TEST_INPUTS> detector(TEST_SAMPLE_RATE, TEST_DECIMATION);
+    LevelStats stats[TEST_INPUTS];
+    runSine(detector, amplitude, 997.0f, 2.0f, stats);
+
+    for (uint8_t i = 0; i < TEST_INPUTS; i++) {
+        int expected = (int)lroundf(expectedLevel(amplitude[i]));
+        TEST_ASSERT_INT_WITHIN(levelTolerance(amplitude[i]), expected, stats[i].minLevel);
+        TEST_ASSERT_INT_WITHIN(levelTolerance(amplitude[i]), expected, stats[i].maxLevel);
+        TEST_ASSERT_LESS_OR_EQUAL(2, stats[i].maxLevel - stats[i].minLevel);
+    }
+
+    // The old path: map(analogRead, 0, 1023, 0, 127) once per 5 ms tick
+    int legacyMin = 255, legacyMax = 0;
+    for (uint32_t tick = 0; tick < 400; tick++) {
+        uint32_t n = tick * TEST_DECIMATION;
+        int level = sineSample(amplitude[1], 997.0f, n) * 127 / 1023;
+        if (level < legacyMin) legacyMin = level;
+        if (level > legacyMax) legacyMax = level;
+    }
+    printf("steady 997 Hz tone, amplitude 300: detector %d..%d, point-sampled %d..%d\n",
+           stats[1].minLevel, stats[1].maxLevel, legacyMin, legacyMax);
+    TEST_ASSERT_GREATER_THAN(50, legacyMax - legacyMin);
+}
+
+void test_rms_mode_is_sine_calibrated() {
+    const float amplitude[TEST_INPUTS] = { 400, 300, 200, 100, 50, 0 };
+    EnvelopeDetector<TEST_INPUTS> detector(TEST_SAMPLE_RATE, TEST_DECIMATION);
+    detector.setMode(ENVELOPE_RMS);
+    LevelStats stats[TEST_INPUTS];
+    runSine(detector, amplitude, 440.0f, 2.0f, stats);
+
+    for (uint8_t i = 0; i < TEST_INPUTS; i++) {
+        TEST_ASSERT_INT_WITHIN(levelTolerance(amplitude[i]), (int)lroundf(expectedLevel(amplitude[i])), stats[i].minLevel);
+        TEST_ASSERT_INT_WITHIN(levelTolerance(amplitude[i]), (int)lroundf(expectedLevel(amplitude[i])), stats[i].maxLevel);
+    }
+}
+
+// 200 Hz square around the bias; |x| is constant, so the ballistics see a clean step
+static uint16_t squareSample(float amplitude, uint32_t n) {
+    return static_cast<uint16_t>(((n / 20) % 2) ? TEST_BIAS + amplitude : TEST_BIAS - amplitude);
+}
+
+void test_rms_reads_higher_than_peak_on_square_wave() {
+    EnvelopeDetector<TEST_INPUTS> peak(TEST_SAMPLE_RATE, TEST_DECIMATION);
+    EnvelopeDetector<TEST_INPUTS> rms(TEST_SAMPLE_RATE, TEST_DECIMATION);
+    rms.setMode(ENVELOPE_RMS);
+
+    uint16_t frame[TEST_INPUTS];
+    for (uint32_t n = 0; n < 16000; n++) {
+        for (uint8_t i = 0; i < TEST_INPUTS; i++) frame[i] = squareSample(150, n);
+        peak.process(frame);
+        rms.process(frame);
+    }
+    // Square: peak = amplitude, sine-calibrated RMS = amplitude * sqrt(2)
+    TEST_ASSERT_INT_WITHIN(3, (int)lroundf(expectedLevel(150)), peak.level(0));
+    TEST_ASSERT_INT_WITHIN(3, (int)lroundf(expectedLevel(150 * sqrtf(2.0f))), rms.level(0));
+}
+
+/**
+ * Milliseconds from the start of a square wave (or from silence) until
+ * input 0 crosses `threshold`, measured at the control rate.
+ */
+static float crossingMs(EnvelopeDetector<TEST_INPUTS>& detector, float amplitude, int threshold, bool rising) {
+    uint16_t frame[TEST_INPUTS];
+    for (uint32_t n = 0; n < 8000; n++) {
+        for (uint8_t i = 0; i < TEST_INPUTS; i++) frame[i] = squareSample(amplitude, n);
+        if (detector.process(frame)) {
+            int level = detector.level(0);
+            if (rising ? level >= threshold : level <= threshold) {
+                return (n + 1) * 1000.0f / TEST_SAMPLE_RATE;
+            }
+        }
+    }
+    return -1.0f;
+}
+
+void test_attack_and_release_time_constants() {
+    EnvelopeDetector<TEST_INPUTS> detector(TEST_SAMPLE_RATE, TEST_DECIMATION);
+    detector.setBallistics(20.0f, 200.0f);
+
+    // One time constant = 63% of the way there; 37% left after one release time constant
+    int full = (int)lroundf(expectedLevel(400));
+    float attackMs = crossingMs(detector, 400, (int)lroundf(0.63f * full), true);
+    crossingMs(detector, 400, full, true);
+    float releaseMs = crossingMs(detector, 0, (int)lroundf(0.37f * full), false);
+    printf("attack 20 ms -> %.1f ms, release 200 ms -> %.1f ms\n", attackMs, releaseMs);
+
+    // Levels are only published every 5 ms
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, 20.0f, attackMs);
+    TEST_ASSERT_FLOAT_WITHIN(10.0f, 200.0f, releaseMs);
+}
+
+void test_dc_offset_is_not_an_envelope() {
+    EnvelopeDetector<TEST_INPUTS> detector(TEST_SAMPLE_RATE, TEST_DECIMATION);
+    uint16_t frame[TEST_INPUTS];
+    for (uint8_t i = 0; i < TEST_INPUTS; i++) frame[i] = 300 + 100 * i; // Bias drifted off mid-rail
+    for (uint32_t n = 0; n < 16000; n++) detector.process(frame);
+    for (uint8_t i = 0; i < TEST_INPUTS; i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(1, detector.level(i));
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_peak_level_tracks_amplitude_without_aliasing);
+    RUN_TEST(test_rms_mode_is_sine_calibrated);
+    RUN_TEST(test_rms_reads_higher_than_peak_on_square_wave);
+    RUN_TEST(test_attack_and_release_time_constants);
+    RUN_TEST(test_dc_offset_is_not_an_envelope);
+    return UNITY_END();
+}
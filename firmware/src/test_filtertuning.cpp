@@ -0,0 +1,146 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include "FilterTuningTable.h"
+
+// Host-side test: the boot-time freq/Q coefficient table and the quantized
+// tuning pots that replace designing a biquad on every 50 ms tick.
+
+#define TEST_CONTROL_RATE 200.0f   // What the envelope filters run at
+#define TEST_AUDIO_RATE 44100.0f   // Fast enough for the full 20..5000 Hz range
+
+static FilterTuningTable controlTable;
+static FilterTuningTable audioTable;
+
+static const BiquadFilter::FilterType TYPES[] = { BiquadFilter::LOWPASS, BiquadFilter::HIGHPASS, BiquadFilter::BANDPASS };
+
+static float gainDb(const BiquadCoefficients& c, float hz, float sampleRate) {
+    float w = 2.0f * static_cast<float>(M_PI) * hz / sampleRate;
+    float numRe = c.b0 + c.b1 * cosf(w) + c.b2 * cosf(2.0f * w);
+    float numIm = -(c.b1 * sinf(w) + c.b2 * sinf(2.0f * w));
+    float denRe = 1.0f + c.a1 * cosf(w) + c.a2 * cosf(2.0f * w);
+    float denIm = -(c.a1 * sinf(w) + c.a2 * sinf(2.0f * w));
+    return 10.0f * log10f((numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm) + 1e-20f);
+}
+
+void test_grid_points_match_the_designed_filter() {
+    for (uint16_t f = 0; f <= FILTER_TUNE_FREQ_STEPS; f += FILTER_TUNE_SUBSTEPS) {
+        for (uint16_t q = 0; q <= FILTER_TUNE_Q_STEPS; q += FILTER_TUNE_SUBSTEPS) {
+            for (BiquadFilter::FilterType type : TYPES) {
+                BiquadCoefficients table = controlTable.lookup(type, f, q);
+                BiquadCoefficients design = BiquadFilter::design(type, controlTable.frequencyAt(f),
+                                                                 TEST_CONTROL_RATE, FilterTuningTable::qAt(q));
+                TEST_ASSERT_FLOAT_WITHIN(1e-6f, design.b0, table.b0);
+                TEST_ASSERT_FLOAT_WITHIN(1e-6f, design.b1, table.b1);
+                TEST_ASSERT_FLOAT_WITHIN(1e-6f, design.b2, table.b2);
+                TEST_ASSERT_FLOAT_WITHIN(1e-6f, design.a1, table.a1);
+                TEST_ASSERT_FLOAT_WITHIN(1e-6f, design.a2, table.a2);
+            }
+        }
+    }
+}
+
+/**
+ * Worst gap (dB) between the interpolated and the directly designed
+ * response over every pot step, probed at the tuned frequency and an
+ * octave either side. Also checks every interpolated filter is stable.
+ */
+static float worstInterpolationErrorDb(const FilterTuningTable& table, float sampleRate) {
+    float worst = 0.0f;
+    for (uint16_t f = 0; f <= FILTER_TUNE_FREQ_STEPS; f++) {
+        for (uint16_t q = 0; q <= FILTER_TUNE_Q_STEPS; q += 3) {
+            float hz = table.frequencyAt(f);
+            for (BiquadFilter::FilterType type : TYPES) {
+                BiquadCoefficients lookedUp = table.lookup(type, f, q);
+                BiquadCoefficients design = BiquadFilter::design(type, hz, sampleRate, FilterTuningTable::qAt(q));
+                TEST_ASSERT_TRUE(fabsf(lookedUp.a2) < 1.0f);
+                TEST_ASSERT_TRUE(fabsf(lookedUp.a1) < 1.0f + lookedUp.a2);
+                const float probes[] = { 0.5f * hz, hz, 1.9f * hz };
+                for (float probe : probes) {
+                    if (probe >= 0.5f * sampleRate) continue;
+                    float error = fabsf(gainDb(lookedUp, probe, sampleRate) - gainDb(design, probe, sampleRate));
+                    if (error > worst) worst = error;
+                }
+            }
+        }
+    }
+    return worst;
+}
+
+void test_interpolated_steps_stay_close_to_the_design() {
+    float control = worstInterpolationErrorDb(controlTable, TEST_CONTROL_RATE);
+    float audio = worstInterpolationErrorDb(audioTable, TEST_AUDIO_RATE);
+    printf("worst interpolation error: %.2f dB at 200 Hz, %.2f dB at 44.1 kHz\n", control, audio);
+    TEST_ASSERT_TRUE(control < 1.0f);
+    TEST_ASSERT_TRUE(audio < 1.0f);
+}
+
+void test_still_knob_never_retunes() {
+    TuningPot pot(FILTER_TUNE_FREQ_STEPS);
+    srand(42);
+    TEST_ASSERT_TRUE(pot.update(600));   // First reading always tunes
+    uint16_t settled = pot.step();
+    uint32_t retunes = 0;
+    for (int tick = 0; tick < 12000; tick++) {   // 10 minutes of 50 ms ticks, +-3 LSB of noise
+        if (pot.update(600 + (rand() % 7) - 3)) retunes++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, retunes);
+    TEST_ASSERT_EQUAL_UINT(settled, pot.step());
+}
+
+void test_sweep_steps_through_every_position_in_order() {
+    TuningPot pot(FILTER_TUNE_Q_STEPS);
+    pot.update(0);
+    TEST_ASSERT_EQUAL_UINT(0, pot.step());
+    uint32_t retunes = 0;
+    uint16_t last = 0;
+    for (int tick = 0; tick < 4000; tick++) {   // 0 -> 1023 over 200 s, slow enough to land on each step
+        if (pot.update(tick * 1023 / 3999)) {
+            TEST_ASSERT_TRUE(pot.step() > last);
+            last = pot.step();
+            retunes++;
+        }
+    }
+    for (int tick = 0; tick < 20; tick++) pot.update(1023);
+    TEST_ASSERT_EQUAL_UINT(FILTER_TUNE_Q_STEPS, pot.step());
+    TEST_ASSERT_TRUE(retunes <= FILTER_TUNE_Q_STEPS);
+    printf("0 -> 1023 sweep: %u retunes for %d steps\n", (unsigned)retunes, FILTER_TUNE_Q_STEPS);
+}
+
+void test_table_read_is_cheaper_than_designing() {
+    const int N = 200000;
+    volatile float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < N; n++) {
+        uint16_t f = n % (FILTER_TUNE_FREQ_STEPS + 1);
+        uint16_t q = n % (FILTER_TUNE_Q_STEPS + 1);
+        sink = sink + BiquadFilter::design(BiquadFilter::LOWPASS, audioTable.frequencyAt(f),
+                                           TEST_AUDIO_RATE, FilterTuningTable::qAt(q)).b0;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int n = 0; n < N; n++) {
+        uint16_t f = n % (FILTER_TUNE_FREQ_STEPS + 1);
+        uint16_t q = n % (FILTER_TUNE_Q_STEPS + 1);
+        sink = sink + audioTable.lookup(BiquadFilter::LOWPASS, f, q).b0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double designNs = std::chrono::duration<double, std::nano>(middle - start).count() / N;
+    double lookupNs = std::chrono::duration<double, std::nano>(end - middle).count() / N;
+    printf("per retune: pot map + design %.1f ns, table lookup %.1f ns\n", designNs, lookupNs);
+    TEST_ASSERT_TRUE(lookupNs < designNs);
+}
+
+int main() {
+    controlTable.build(TEST_CONTROL_RATE);
+    audioTable.build(TEST_AUDIO_RATE);
+    UNITY_BEGIN();
+    RUN_TEST(test_grid_points_match_the_designed_filter);
+    RUN_TEST(test_interpolated_steps_stay_close_to_the_design);
+    RUN_TEST(test_still_knob_never_retunes);
+    RUN_TEST(test_sweep_steps_through_every_position_in_order);
+    RUN_TEST(test_table_read_is_cheaper_than_designing);
+    return UNITY_END();
+}
@@ -0,0 +1,259 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "MidiDinTransmitter.h"
+
+// Host-side test: running status and TX-buffer pacing on the DIN port,
+// against a fake 31250 baud UART with Serial1's 64-byte buffer.
+
+#define SIM_TICK_US 1000
+#define SIM_SOURCES 48
+#define SIM_CHANNELS 3           // Pots spread over a few channels, the worst case for running status
+#define SIM_UPDATE_HZ 200
+#define SIM_SECONDS 10
+
+struct FakeUart {
+    uint8_t buffer[MIDI_DIN_TX_BUFFER];
+    uint16_t head = 0, used = 0;
+    uint32_t credit = 0;            // Wire time owed, in byte-microseconds
+    uint32_t overfilled = 0;        // write() calls that would have blocked
+    std::vector<uint8_t> wire;
+
+    int availableForWrite() { return MIDI_DIN_TX_BUFFER - used; }
+
+    size_t write(const uint8_t* data, size_t n) {
+        if (n > static_cast<size_t>(availableForWrite())) overfilled++;
+        for (size_t i = 0; i < n && used < MIDI_DIN_TX_BUFFER; i++) {
+            buffer[(head + used) % MIDI_DIN_TX_BUFFER] = data[i];
+            used++;
+        }
+        return n;
+    }
+
+    // Shift bytes out at the line rate
+    void run(uint32_t micros) {
+        credit += micros * MIDI_DIN_BYTES_PER_SEC;
+        while (used && credit >= 1000000UL) {
+            wire.push_back(buffer[head]);
+            head = (head + 1) % MIDI_DIN_TX_BUFFER;
+            used--;
+            credit -= 1000000UL;
+        }
+        if (!used) credit = 0;   // An idle line doesn't bank time
+    }
+};
+
+struct Decoded {
+    uint8_t status, data1, data2;
+};
+
+/**
+ * What a receiver makes of the byte stream, running status included.
+ */
+static std::vector<Decoded> decode(const std::vector<uint8_t>& bytes) {
+    std::vector<Decoded> out;
+    uint8_t running = 0;
+    uint8_t data[2];
+    uint8_t have = 0;
+    for (uint8_t b : bytes) {
+        if (b >= 0xF8) continue;
+        if (b & 0x80) {
+            running = b < 0xF0 ? b : 0;
+            have = 0;
+            continue;
+        }
+        if (!running) continue;
+        data[have++] = b;
+        uint8_t need = ((running & 0xF0) == 0xC0 || (running & 0xF0) == 0xD0) ? 1 : 2;
+        if (have == need) {
+            out.push_back({ running, data[0], need > 1 ? data[1] : static_cast<uint8_t>(0) });
+            have = 0;
+        }
+    }
+    return out;
+}
+
+static void drainAll(MidiDinTransmitter& tx, MidiOutQueue& q, FakeUart& uart, uint32_t& t) {
+    while (q.depth() || uart.used) {
+        tx.service(q, uart, t);
+        uart.run(SIM_TICK_US);
+        t += SIM_TICK_US;
+    }
+}
+
+void test_one_channel_costs_two_bytes_per_cc() {
+    MidiOutQueue q;
+    MidiDinTransmitter tx;
+    FakeUart uart;
+    for (uint8_t cc = 0; cc < 20; cc++) q.pushControlChange(cc, cc + 1, 1, 0);
+    uint16_t n = tx.service(q, uart, 0);
+    TEST_ASSERT_EQUAL_UINT(3 + 19 * 2, n);
+    TEST_ASSERT_EQUAL_UINT32(19, tx.statusBytesSaved());
+
+    uint32_t t = 0;
+    drainAll(tx, q, uart, t);
+    std::vector<Decoded> got = decode(uart.wire);
+    TEST_ASSERT_EQUAL_UINT(20, got.size());
+    for (uint8_t cc = 0; cc < 20; cc++) {
+        TEST_ASSERT_EQUAL_HEX8(0xB0, got[cc].status);
+        TEST_ASSERT_EQUAL_UINT8(cc, got[cc].data1);
+        TEST_ASSERT_EQUAL_UINT8(cc + 1, got[cc].data2);
+    }
+}
+
+void test_channels_are_grouped_and_running_one_goes_first() {
+    MidiOutQueue q;
+    MidiDinTransmitter tx;
+    FakeUart uart;
+    q.pushControlChange(100, 1, 2, 0);
+    tx.service(q, uart, 0);   // Channel 2 is now running
+
+    for (uint8_t i = 0; i < 12; i++) q.pushControlChange(i, i, 1 + i % 3, 0);   // 1, 2, 3, 1, 2, 3, ...
+    uint16_t n = tx.service(q, uart, 0);
+    TEST_ASSERT_EQUAL_UINT(12 * 2 + 2, n);   // Ungrouped it would be 12 * 3
+
+    uart.run(1000000);
+    std::vector<Decoded> got = decode(uart.wire);
+    TEST_ASSERT_EQUAL_UINT(13, got.size());
+    const uint8_t order[12] = { 1, 4, 7, 10, 0, 3, 6, 9, 2, 5, 8, 11 };   // Channel 2, then 1, then 3
+    for (uint8_t i = 0; i < 12; i++) TEST_ASSERT_EQUAL_UINT8(order[i], got[i + 1].data1);
+}
+
+void test_notes_keep_their_order() {
+    MidiOutQueue q;
+    MidiDinTransmitter tx;
+    FakeUart uart;
+    q.pushControlChange(7, 1, 1, 0);
+    q.pushMessage(0x90, 60, 100, 3, 0);
+    q.pushMessage(0x90, 64, 100, 3, 0);
+    q.pushMessage(0x80, 60, 0, 3, 0);
+    q.pushMessage(0x90, 60, 90, 3, 0);
+    tx.service(q, uart, 0);
+    uart.run(1000000);
+
+    const uint8_t expected[] = { 0x90, 60, 100, 64, 100, 0x80, 60, 0, 0x90, 60, 90, 0xB0, 7, 1 };
+    TEST_ASSERT_EQUAL_UINT(sizeof(expected), uart.wire.size());
+    for (size_t i = 0; i < sizeof(expected); i++) TEST_ASSERT_EQUAL_HEX8(expected[i], uart.wire[i]);
+}
+
+void test_status_is_refreshed() {
+    MidiOutQueue q;
+    MidiDinTransmitter tx;
+    FakeUart uart;
+    q.pushControlChange(1, 1, 1, 0);
+    TEST_ASSERT_EQUAL_UINT(3, tx.service(q, uart, 0));
+    q.pushControlChange(1, 2, 1, 1000);
+    TEST_ASSERT_EQUAL_UINT(2, tx.service(q, uart, 1000));
+    q.pushControlChange(1, 3, 1, MIDI_RUNNING_STATUS_REFRESH_US + 1000);
+    TEST_ASSERT_EQUAL_UINT(3, tx.service(q, uart, MIDI_RUNNING_STATUS_REFRESH_US + 1000));
+
+    tx.setRunningStatus(false);
+    q.pushControlChange(1, 4, 1, 0);
+    q.pushControlChange(2, 4, 1, 0);
+    TEST_ASSERT_EQUAL_UINT(6, tx.service(q, uart, MIDI_RUNNING_STATUS_REFRESH_US + 2000));
+}
+
+void test_random_traffic_round_trips_without_blocking() {
+    srand(5);
+    MidiOutQueue q;
+    MidiDinTransmitter tx;
+    FakeUart uart;
+    uint8_t last[16][128];
+    bool touched[16][128] = { { false } };
+    std::vector<Decoded> notes;
+    uint32_t t = 0;
+    for (; t < 2000000UL; t += SIM_TICK_US) {
+        for (int k = rand() % 6; k > 0; k--) {
+            uint8_t ch = rand() % 4, cc = rand() % 24, v = rand() % 128;
+            q.pushControlChange(cc, v, ch + 1, t);
+            last[ch][cc] = v;
+            touched[ch][cc] = true;
+        }
+        if (rand() % 50 == 0) {
+            Decoded note = { static_cast<uint8_t>((rand() % 2 ? 0x90 : 0x80) | (rand() % 4)),
+                             static_cast<uint8_t>(rand() % 128), static_cast<uint8_t>(rand() % 128) };
+            if (q.pushMessage(note.status, note.data1, note.data2, 3, t)) notes.push_back(note);
+        }
+        tx.service(q, uart, t);
+        uart.run(SIM_TICK_US);
+    }
+    drainAll(tx, q, uart, t);
+    TEST_ASSERT_EQUAL_UINT32(0, uart.overfilled);
+
+    uint8_t final[16][128];
+    bool seen[16][128] = { { false } };
+    size_t noteIndex = 0;
+    for (const Decoded& d : decode(uart.wire)) {
+        if ((d.status & 0xF0) == 0xB0) {
+            final[d.status & 0x0F][d.data1] = d.data2;
+            seen[d.status & 0x0F][d.data1] = true;
+        } else {
+            TEST_ASSERT_TRUE(noteIndex < notes.size());
+            TEST_ASSERT_EQUAL_HEX8(notes[noteIndex].status, d.status);
+            TEST_ASSERT_EQUAL_UINT8(notes[noteIndex].data1, d.data1);
+            TEST_ASSERT_EQUAL_UINT8(notes[noteIndex].data2, d.data2);
+            noteIndex++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(notes.size(), noteIndex);
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        for (uint8_t cc = 0; cc < 128; cc++) {
+            TEST_ASSERT_EQUAL(touched[ch][cc], seen[ch][cc]);
+            if (touched[ch][cc]) TEST_ASSERT_EQUAL_UINT8(last[ch][cc], final[ch][cc]);   // Latest value got there
+        }
+    }
+}
+
+/**
+ * Every source moving at SIM_UPDATE_HZ for SIM_SECONDS, with and without
+ * running status. Reports CCs per second on the wire and bytes per CC.
+ */
+static void simulate(bool runningStatus, uint32_t& delivered, uint32_t& bytes, uint32_t& overfilled) {
+    MidiOutQueue q;
+    MidiDinTransmitter tx;
+    tx.setRunningStatus(runningStatus);
+    FakeUart uart;
+    const uint32_t period = 1000000UL / SIM_UPDATE_HZ;
+    for (uint32_t t = 0; t < SIM_SECONDS * 1000000UL; t += SIM_TICK_US) {
+        for (uint8_t s = 0; s < SIM_SOURCES; s++) {
+            uint32_t phase = (s * period) / SIM_SOURCES;
+            if ((t + period - phase) % period < SIM_TICK_US) {
+                q.pushControlChange(s, (t / period + s) & 127, 1 + s % SIM_CHANNELS, t);
+            }
+        }
+        tx.service(q, uart, t);
+        uart.run(SIM_TICK_US);
+    }
+    delivered = decode(uart.wire).size();
+    bytes = uart.wire.size();
+    overfilled = uart.overfilled;
+}
+
+void test_running_status_raises_throughput() {
+    uint32_t plainMessages, plainBytes, plainOverfilled;
+    uint32_t rsMessages, rsBytes, rsOverfilled;
+    simulate(false, plainMessages, plainBytes, plainOverfilled);
+    simulate(true, rsMessages, rsBytes, rsOverfilled);
+    printf("%d sources on %d channels x %d Hz for %d s\n", SIM_SOURCES, SIM_CHANNELS, SIM_UPDATE_HZ, SIM_SECONDS);
+    printf("  status every message: %lu CC/s, %.2f bytes/CC\n",
+           (unsigned long)(plainMessages / SIM_SECONDS), (double)plainBytes / plainMessages);
+    printf("  running status:       %lu CC/s, %.2f bytes/CC\n",
+           (unsigned long)(rsMessages / SIM_SECONDS), (double)rsBytes / rsMessages);
+    TEST_ASSERT_EQUAL_UINT32(0, plainOverfilled);
+    TEST_ASSERT_EQUAL_UINT32(0, rsOverfilled);
+    TEST_ASSERT_TRUE(rsBytes * 100 <= rsMessages * 220);          // Under 2.2 bytes per CC
+    TEST_ASSERT_TRUE(rsMessages * 100 >= plainMessages * 130);    // At least 30% more CCs through
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_one_channel_costs_two_bytes_per_cc);
+    RUN_TEST(test_channels_are_grouped_and_running_one_goes_first);
+    RUN_TEST(test_notes_keep_their_order);
+    RUN_TEST(test_status_is_refreshed);
+    RUN_TEST(test_random_traffic_round_trips_without_blocking);
+    RUN_TEST(test_running_status_raises_throughput);
+    return UNITY_END();
+}
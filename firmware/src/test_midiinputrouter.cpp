@@ -0,0 +1,174 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include "MidiInputRouter.h"
+
+// Host-side test: the drain-all MIDI input stage and its routing table,
+// against the old one-DIN-message-per-pass read.
+
+#define SIM_TICK_US 1000
+#define SIM_SECONDS 10
+#define SIM_BPM 300                          // Fast clock: 120 bytes/s at 24 PPQN
+#define SIM_DIN_CC_PER_SEC 1000              // About all a 31250 baud cable carries next to the clock
+#define SIM_USB_BURST 40                     // A DAW dumping automation every 10 ms
+#define SIM_USB_BURST_EVERY_US 10000
+
+struct Recorder {
+    std::vector<MidiInEvent> events;
+};
+
+static void record(void* context, const MidiInEvent& event) {
+    static_cast<Recorder*>(context)->events.push_back(event);
+}
+
+void test_events_reach_their_route() {
+    MidiInputRouter router;
+    Recorder notes, ccs, clock, sysex;
+    router.setRoute(MIDI_ROUTE_NOTE, record, &notes);
+    router.setRoute(MIDI_ROUTE_CC, record, &ccs);
+    router.setRoute(MIDI_ROUTE_CLOCK, record, &clock);
+    router.setRoute(MIDI_ROUTE_SYSEX, record, &sysex);
+
+    router.push(0x90, 3, 60, 100, MIDI_IN_DIN, 10);
+    router.push(0xF8, 0, 0, 0, MIDI_IN_USB, 11);
+    router.push(0xB0, 16, 7, 99, MIDI_IN_USB, 12);
+    router.push(0x80, 3, 60, 0, MIDI_IN_DIN, 13);
+    router.push(0xF0, 0, 300 & 0x7F, 300 >> 7, MIDI_IN_USB, 14);
+    router.push(0xE0, 1, 0, 64, MIDI_IN_DIN, 15);   // Pitch bend: nobody listens
+    router.push(0x12, 1, 0, 0, MIDI_IN_DIN, 16);    // Not a status byte: refused
+    TEST_ASSERT_EQUAL_UINT8(6, router.backlog());
+    TEST_ASSERT_EQUAL_UINT(6, router.dispatch());
+    TEST_ASSERT_EQUAL_UINT8(0, router.backlog());
+
+    TEST_ASSERT_EQUAL_UINT(2, notes.events.size());
+    TEST_ASSERT_EQUAL_HEX8(0x92, notes.events[0].status);
+    TEST_ASSERT_EQUAL_HEX8(0x90, notes.events[0].type());
+    TEST_ASSERT_EQUAL_UINT8(3, notes.events[0].channel());
+    TEST_ASSERT_EQUAL_HEX8(0x80, notes.events[1].type());
+    TEST_ASSERT_EQUAL_UINT(1, ccs.events.size());
+    TEST_ASSERT_EQUAL_UINT8(16, ccs.events[0].channel());
+    TEST_ASSERT_EQUAL_UINT8(99, ccs.events[0].data2);
+    TEST_ASSERT_EQUAL_UINT8(MIDI_IN_USB, ccs.events[0].source);
+    TEST_ASSERT_EQUAL_UINT(1, clock.events.size());
+    TEST_ASSERT_EQUAL_UINT8(0, clock.events[0].channel());
+    TEST_ASSERT_EQUAL_UINT32(11, clock.events[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT(300, sysex.events[0].data1 | sysex.events[0].data2 << 7);
+
+    TEST_ASSERT_EQUAL_UINT32(6, router.received());
+    TEST_ASSERT_EQUAL_UINT32(1, router.ignored());
+    TEST_ASSERT_EQUAL_UINT32(1, router.routed(MIDI_ROUTE_OTHER));
+    TEST_ASSERT_EQUAL_UINT32(2, router.routed(MIDI_ROUTE_NOTE));
+}
+
+void test_transport_and_routes_by_type() {
+    TEST_ASSERT_EQUAL_INT(MIDI_ROUTE_TRANSPORT, MidiInputRouter::routeOf(0xFA));
+    TEST_ASSERT_EQUAL_INT(MIDI_ROUTE_TRANSPORT, MidiInputRouter::routeOf(0xFB));
+    TEST_ASSERT_EQUAL_INT(MIDI_ROUTE_TRANSPORT, MidiInputRouter::routeOf(0xFC));
+    TEST_ASSERT_EQUAL_INT(MIDI_ROUTE_TRANSPORT, MidiInputRouter::routeOf(0xF2));
+    TEST_ASSERT_EQUAL_INT(MIDI_ROUTE_OTHER, MidiInputRouter::routeOf(0xFE));   // Active sensing
+    TEST_ASSERT_EQUAL_INT(MIDI_ROUTE_CC, MidiInputRouter::routeOf(0xBF));
+    TEST_ASSERT_EQUAL_INT(MIDI_ROUTE_OTHER, MidiInputRouter::routeOf(0xC0));
+}
+
+void test_full_ring_drops_and_keeps_order() {
+    MidiInputRouter router;
+    Recorder ccs;
+    router.setRoute(MIDI_ROUTE_CC, record, &ccs);
+    for (int i = 0; i < MIDI_IN_QUEUE_SIZE + 10; i++) router.push(0xB0, 1, i & 127, 0, MIDI_IN_DIN, i);
+    TEST_ASSERT_EQUAL_UINT32(10, router.dropped());
+    TEST_ASSERT_EQUAL_UINT8(MIDI_IN_QUEUE_SIZE, router.maxBacklog());
+    router.dispatch();
+    TEST_ASSERT_EQUAL_UINT(MIDI_IN_QUEUE_SIZE, ccs.events.size());
+    for (int i = 0; i < MIDI_IN_QUEUE_SIZE; i++) TEST_ASSERT_EQUAL_UINT32(i, ccs.events[i].timestamp);
+}
+
+struct ClockLag {
+    uint32_t worst = 0;
+    uint64_t total = 0;
+    uint32_t count = 0;
+    uint32_t now = 0;
+};
+
+static void measureClock(void* context, const MidiInEvent& event) {
+    ClockLag* lag = static_cast<ClockLag*>(context);
+    uint32_t waited = lag->now - event.timestamp;
+    if (waited > lag->worst) lag->worst = waited;
+    lag->total += waited;
+    lag->count++;
+}
+
+/**
+ * Clock plus a CC stream on DIN and bursts on USB, arriving into the
+ * port buffers; each 1 ms pass reads them. drainAll = false reads one DIN
+ * message per pass, like the old processIncomingMIDI(). Event timestamps
+ * here are arrival times, so the handler sees how long each clock byte
+ * sat in the port before it was routed.
+ */
+static void simulate(bool drainAll, ClockLag& lag, uint32_t& maxPortBacklog, uint32_t& dinLeft) {
+    MidiInputRouter router;
+    router.setRoute(MIDI_ROUTE_CLOCK, measureClock, &lag);
+    std::deque<MidiInEvent> din, usb;
+    const uint32_t clockEvery = 60000000UL / (SIM_BPM * 24);
+    const uint32_t ccEvery = 1000000UL / SIM_DIN_CC_PER_SEC;
+    uint32_t nextClock = 0, nextCC = 0;
+    maxPortBacklog = 0;
+    for (uint32_t t = 0; t < SIM_SECONDS * 1000000UL; t += SIM_TICK_US) {
+        for (; nextClock < t + SIM_TICK_US; nextClock += clockEvery) din.push_back({ 0xF8, 0, 0, MIDI_IN_DIN, nextClock });
+        for (; nextCC < t + SIM_TICK_US; nextCC += ccEvery) din.push_back({ 0xB0, 1, 64, MIDI_IN_DIN, nextCC });
+        if (t % SIM_USB_BURST_EVERY_US == 0) {
+            for (int i = 0; i < SIM_USB_BURST; i++) usb.push_back({ 0xB1, static_cast<uint8_t>(i), 1, MIDI_IN_USB, t });
+        }
+        if (din.size() > maxPortBacklog) maxPortBacklog = din.size();
+
+        lag.now = t + SIM_TICK_US;   // The pass runs at the end of the tick
+        auto take = [&](std::deque<MidiInEvent>& port) {
+            const MidiInEvent& e = port.front();
+            uint8_t type = e.status < 0xF0 ? (e.status & 0xF0) : e.status;
+            if (!router.push(type, (e.status & 0x0F) + 1, e.data1, e.data2, static_cast<MidiInSource>(e.source), e.timestamp)) {
+                router.dispatch();
+                router.push(type, (e.status & 0x0F) + 1, e.data1, e.data2, static_cast<MidiInSource>(e.source), e.timestamp);
+            }
+            port.pop_front();
+        };
+        if (drainAll) {
+            while (!din.empty()) take(din);
+        } else if (!din.empty()) {
+            take(din);
+        }
+        while (!usb.empty()) take(usb);   // USB was already drained
+        router.dispatch();
+    }
+    dinLeft = din.size();
+}
+
+void test_drain_all_keeps_up_with_dense_input() {
+    ClockLag oldLag, newLag;
+    uint32_t oldBacklog, newBacklog, oldLeft, newLeft;
+    simulate(false, oldLag, oldBacklog, oldLeft);
+    simulate(true, newLag, newBacklog, newLeft);
+    printf("%d BPM clock + %d CC/s on DIN, %d-message USB bursts every %d ms, %d s\n",
+           SIM_BPM, SIM_DIN_CC_PER_SEC, SIM_USB_BURST, SIM_USB_BURST_EVERY_US / 1000, SIM_SECONDS);
+    printf("  one DIN message per pass: port backlog %lu, clock wait avg %.1f ms, worst %.1f ms, %lu clocks routed\n",
+           (unsigned long)oldBacklog, oldLag.count ? oldLag.total / 1000.0 / oldLag.count : 0.0,
+           oldLag.worst / 1000.0, (unsigned long)oldLag.count);
+    printf("  drain all:                port backlog %lu, clock wait avg %.1f ms, worst %.1f ms, %lu clocks routed\n",
+           (unsigned long)newBacklog, newLag.total / 1000.0 / newLag.count, newLag.worst / 1000.0,
+           (unsigned long)newLag.count);
+
+    TEST_ASSERT_EQUAL_UINT32(0, newLeft);
+    const uint32_t clockEvery = 60000000UL / (SIM_BPM * 24);
+    TEST_ASSERT_EQUAL_UINT32((SIM_SECONDS * 1000000UL - 1) / clockEvery + 1, newLag.count);   // Every clock byte, none stuck
+    TEST_ASSERT_TRUE(newLag.worst <= SIM_TICK_US);                              // Routed in the pass it arrived
+    TEST_ASSERT_TRUE(oldLeft > 1000);                                           // The old read never catches up
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_events_reach_their_route);
+    RUN_TEST(test_transport_and_routes_by_type);
+    RUN_TEST(test_full_ring_drops_and_keeps_order);
+    RUN_TEST(test_drain_all_keeps_up_with_dense_input);
+    return UNITY_END();
+}
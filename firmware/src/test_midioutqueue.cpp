@@ -0,0 +1,197 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "MidiOutQueue.h"
+#include "MidiDinTransmitter.h"
+
+// Host-side simulation: the coalescing outbound MIDI queue against the old
+// send-everything behaviour, on a 31250 baud DIN line.
+
+#define SIM_SOURCES 48           // 42 pots + 6 EFs, each its own (channel, CC)
+#define SIM_UPDATE_HZ 200        // Every source moving, at the envelope control rate
+#define SIM_SECONDS 10
+#define SIM_TICK_US 1000         // flushOutput() runs in the 1 ms MIDI task
+#define SIM_MESSAGE_US (3 * 1000000UL / MIDI_DIN_BYTES_PER_SEC)   // 960 us per CC on the wire
+
+/**
+ * A 31250 baud line behind Serial1's TX buffer. The queue is only pulled
+ * while the buffer has room, which is all the pacing DIN gets (running
+ * status is left to test_mididintransmitter).
+ */
+struct DinLine {
+    uint32_t buffered = 0;   // Bytes waiting in the TX buffer
+    uint32_t credit = 0;     // Wire time owed, in byte-microseconds
+    uint32_t lastRun = 0;
+
+    template <typename Sink>
+    uint16_t drain(MidiOutQueue& q, uint32_t nowMicros, Sink&& send) {
+        credit += (nowMicros - lastRun) * MIDI_DIN_BYTES_PER_SEC;
+        lastRun = nowMicros;
+        while (buffered && credit >= 1000000UL) {
+            buffered--;
+            credit -= 1000000UL;
+        }
+        if (!buffered) credit = 0;   // An idle line doesn't bank time
+
+        uint16_t count = 0;
+        MidiOutMessage m;
+        while (q.peek(m) && buffered + m.size <= MIDI_DIN_TX_BUFFER) {
+            q.pop();
+            buffered += m.size;
+            send(m);
+            count++;
+        }
+        return count;
+    }
+};
+
+void test_newer_value_overwrites_pending() {
+    MidiOutQueue q;
+    for (uint8_t v = 0; v < 100; v++) q.pushControlChange(7, v, 1, v);
+    q.pushControlChange(8, 5, 1, 200);
+    TEST_ASSERT_EQUAL_UINT(2, q.depth());
+    TEST_ASSERT_EQUAL_UINT32(99, q.merged());
+
+    std::vector<MidiOutMessage> out;
+    q.drain([&](const MidiOutMessage& m) { out.push_back(m); });
+    TEST_ASSERT_EQUAL_UINT(2, out.size());
+    TEST_ASSERT_EQUAL_HEX8(0xB0, out[0].status);
+    TEST_ASSERT_EQUAL_UINT8(7, out[0].data1);
+    TEST_ASSERT_EQUAL_UINT8(99, out[0].data2);        // Latest value...
+    TEST_ASSERT_EQUAL_UINT32(0, out[0].queuedAt);      // ...but it waited since the first
+    TEST_ASSERT_EQUAL_UINT8(8, out[1].data1);
+    TEST_ASSERT_EQUAL_UINT(0, q.depth());
+
+    // Same CC on another channel is another pair
+    q.pushControlChange(7, 1, 1, 400);
+    q.pushControlChange(7, 2, 16, 400);
+    TEST_ASSERT_EQUAL_UINT(2, q.depth());
+}
+
+void test_pairs_take_turns() {
+    MidiOutQueue q;
+    DinLine line;
+    std::vector<MidiOutMessage> out;
+    auto sink = [&](const MidiOutMessage& m) { out.push_back(m); };
+    for (uint8_t cc = 0; cc < 40; cc++) q.pushControlChange(cc, 1, 1, 0);
+    line.drain(q, 0, sink);   // An empty TX buffer takes a burst
+    uint16_t burst = out.size();
+    TEST_ASSERT_EQUAL_UINT(MIDI_DIN_TX_BUFFER / 3, burst);
+
+    // CC 0 moves again after it went out: it goes to the back, behind 1..39
+    q.pushControlChange(0, 2, 1, 10);
+    for (uint32_t t = SIM_TICK_US; out.size() < 41; t += SIM_TICK_US) line.drain(q, t, sink);
+    for (uint8_t i = 0; i < 40; i++) TEST_ASSERT_EQUAL_UINT8(i, out[i].data1);
+    TEST_ASSERT_EQUAL_UINT8(0, out[40].data1);
+    TEST_ASSERT_EQUAL_UINT8(2, out[40].data2);
+}
+
+void test_notes_are_never_merged_and_go_first() {
+    MidiOutQueue q;
+    q.pushControlChange(1, 10, 1, 0);
+    q.pushMessage(0x90, 60, 100, 3, 0);
+    q.pushMessage(0x80, 60, 0, 3, 0);
+    q.pushMessage(0x90, 60, 90, 3, 0);
+    std::vector<MidiOutMessage> out;
+    q.drain([&](const MidiOutMessage& m) { out.push_back(m); });
+    TEST_ASSERT_EQUAL_UINT(4, out.size());
+    TEST_ASSERT_EQUAL_HEX8(0x90, out[0].status);
+    TEST_ASSERT_EQUAL_HEX8(0x80, out[1].status);
+    TEST_ASSERT_EQUAL_HEX8(0x90, out[2].status);
+    TEST_ASSERT_EQUAL_UINT8(90, out[2].data2);
+    TEST_ASSERT_EQUAL_HEX8(0xB0, out[3].status);
+
+    for (int i = 0; i < MIDI_OUT_MESSAGE_QUEUE_SIZE; i++) TEST_ASSERT_TRUE(q.pushMessage(0x90, 1, 1, 3, 0));
+    TEST_ASSERT_FALSE(q.pushMessage(0x90, 1, 1, 3, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, q.dropped());
+}
+
+void test_din_drain_keeps_to_the_line_rate() {
+    MidiOutQueue q;
+    DinLine line;
+    uint32_t bytes = 0;
+    for (uint32_t t = 0; t <= 1000000; t += SIM_TICK_US) {
+        for (uint8_t cc = 0; cc < 100; cc++) q.pushControlChange(cc, t & 127, 1, t);
+        line.drain(q, t, [&](const MidiOutMessage& m) { bytes += m.size; });
+    }
+    printf("1 s flat out: %u bytes sent (line rate %d)\n", (unsigned)bytes, MIDI_DIN_BYTES_PER_SEC);
+    TEST_ASSERT_TRUE(bytes <= MIDI_DIN_BYTES_PER_SEC + MIDI_DIN_TX_BUFFER);
+    TEST_ASSERT_TRUE(bytes >= MIDI_DIN_BYTES_PER_SEC - 3);
+}
+
+static uint32_t percentile(std::vector<uint32_t>& v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[static_cast<size_t>(p * (v.size() - 1))];
+}
+
+/**
+ * Every source sends SIM_UPDATE_HZ new values (phases staggered) for
+ * SIM_SECONDS; the line takes one CC per SIM_MESSAGE_US. Reports the
+ * queue depth and how old each value is when it reaches the wire.
+ */
+void test_load_simulation_bounds_latency() {
+    const uint32_t period = 1000000UL / SIM_UPDATE_HZ;
+    const uint32_t end = SIM_SECONDS * 1000000UL;
+
+    // Old behaviour: every call is written, so the UART backlog just grows
+    std::deque<uint32_t> backlog;
+    std::vector<uint32_t> fifoAges;
+    uint32_t fifoMaxDepth = 0;
+    uint32_t lineFreeAt = 0;
+
+    MidiOutQueue q;
+    DinLine line;
+    std::vector<uint32_t> ages;
+    uint32_t maxDepth = 0;
+
+    for (uint32_t t = 0; t < end; t += SIM_TICK_US) {
+        for (uint8_t s = 0; s < SIM_SOURCES; s++) {
+            uint32_t phase = (s * period) / SIM_SOURCES;
+            uint32_t since = (t + period - phase) % period;
+            if (since < SIM_TICK_US) {
+                uint8_t value = static_cast<uint8_t>((t / period + s) & 127);
+                q.pushControlChange(s, value, 1 + s / 16, t);
+                backlog.push_back(t);
+            }
+        }
+        line.drain(q, t, [&](const MidiOutMessage& m) { ages.push_back(t - m.queuedAt); });
+        if (q.depth() > maxDepth) maxDepth = q.depth();
+
+        while (!backlog.empty() && lineFreeAt <= t) {
+            fifoAges.push_back(t - backlog.front());
+            backlog.pop_front();
+            lineFreeAt += SIM_MESSAGE_US;
+        }
+        if (lineFreeAt < t) lineFreeAt = t;
+        if (backlog.size() > fifoMaxDepth) fifoMaxDepth = backlog.size();
+    }
+
+    uint32_t fifoP50 = percentile(fifoAges, 0.5), fifoP99 = percentile(fifoAges, 0.99), fifoMax = percentile(fifoAges, 1.0);
+    uint32_t p50 = percentile(ages, 0.5), p99 = percentile(ages, 0.99), worst = percentile(ages, 1.0);
+    printf("%d sources x %d Hz into DIN for %d s\n", SIM_SOURCES, SIM_UPDATE_HZ, SIM_SECONDS);
+    printf("  send-everything: max depth %u, age p50 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+           (unsigned)fifoMaxDepth, fifoP50 / 1000.0, fifoP99 / 1000.0, fifoMax / 1000.0);
+    printf("  coalescing:      max depth %u, age p50 %.1f ms, p99 %.1f ms, max %.1f ms (%u sent, %u merged)\n",
+           (unsigned)maxDepth, p50 / 1000.0, p99 / 1000.0, worst / 1000.0, (unsigned)q.sent(), (unsigned)q.merged());
+
+    // At most one entry per source, so at most one full round of the line
+    TEST_ASSERT_TRUE(maxDepth <= SIM_SOURCES);
+    TEST_ASSERT_TRUE(worst <= SIM_SOURCES * SIM_MESSAGE_US + 2 * SIM_TICK_US);
+    TEST_ASSERT_EQUAL_UINT32(0, q.dropped());
+    TEST_ASSERT_TRUE(fifoMax > 10 * worst);   // The old way falls seconds behind
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_newer_value_overwrites_pending);
+    RUN_TEST(test_pairs_take_turns);
+    RUN_TEST(test_notes_are_never_merged_and_go_first);
+    RUN_TEST(test_din_drain_keeps_to_the_line_rate);
+    RUN_TEST(test_load_simulation_bounds_latency);
+    return UNITY_END();
+}
@@ -0,0 +1,165 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include "ModulationMatrix.h"
+
+// Host-side test: the slot x EF modulation matrix that replaces the
+// one-EF-per-slot map in processEnvelopes().
+
+#define TEST_SLOTS 42
+#define TEST_EFS 6
+
+typedef ModulationMatrix<TEST_SLOTS, TEST_EFS> TestMatrix;
+
+static int clampLevel(int x) { return x < 0 ? 0 : (x > 127 ? 127 : x); }
+
+/**
+ * The matrix formula written out in floats, one cell at a time.
+ */
+static int referenceValue(const TestMatrix& m, uint8_t slot, int base, const int* levels) {
+    float amount = m.offset(slot);
+    for (uint8_t ef = 0; ef < TEST_EFS; ef++) {
+        float level = m.bipolar(slot, ef) ? levels[ef] - MOD_BIPOLAR_CENTER : levels[ef];
+        amount += level * m.depth(slot, ef) / MOD_DEPTH_FULL;
+    }
+    return clampLevel(base + static_cast<int>(floorf(amount + 0.5f)));
+}
+
+void test_full_depth_route_adds_the_level() {
+    TestMatrix m;
+    m.route(5, 2);
+    TEST_ASSERT_TRUE(m.routed(5));
+    TEST_ASSERT_FALSE(m.routed(4));
+    TEST_ASSERT_EQUAL_INT(2, m.primarySource(5));
+    TEST_ASSERT_EQUAL_INT(-1, m.primarySource(4));
+
+    int levels[TEST_EFS] = { 0 };
+    for (int level = 0; level <= 127; level++) {
+        levels[2] = level;
+        m.process(levels);
+        TEST_ASSERT_EQUAL_INT(level, m.amount(5));
+        TEST_ASSERT_EQUAL_INT(0, m.amount(4));
+        TEST_ASSERT_EQUAL_INT(clampLevel(40 + level), m.apply(5, 40));   // Knob value plus the EF level
+    }
+
+    // Re-routing replaces, it doesn't add
+    m.route(5, 3);
+    m.process(levels);
+    TEST_ASSERT_EQUAL_INT(0, m.amount(5));
+}
+
+void test_bipolar_swings_around_the_center() {
+    TestMatrix m;
+    m.setDepth(0, 1, MOD_DEPTH_FULL);
+    m.setBipolar(0, 1, true);
+    m.setDepth(1, 1, -MOD_DEPTH_FULL / 2);   // -50%
+    int levels[TEST_EFS] = { 0 };
+
+    levels[1] = MOD_BIPOLAR_CENTER;
+    m.process(levels);
+    TEST_ASSERT_EQUAL_INT(0, m.amount(0));
+    levels[1] = 0;
+    m.process(levels);
+    TEST_ASSERT_EQUAL_INT(-MOD_BIPOLAR_CENTER, m.amount(0));
+    TEST_ASSERT_EQUAL_INT(0, m.amount(1));
+    levels[1] = 127;
+    m.process(levels);
+    TEST_ASSERT_EQUAL_INT(127 - MOD_BIPOLAR_CENTER, m.amount(0));
+    TEST_ASSERT_EQUAL_INT(-63, m.amount(1));   // -63.5 rounds up
+    TEST_ASSERT_EQUAL_INT(37, m.apply(1, 100));
+    TEST_ASSERT_EQUAL_INT(0, m.apply(1, 10));   // Clamped
+}
+
+void test_random_blends_match_the_formula() {
+    srand(11);
+    TestMatrix m;
+    for (int trial = 0; trial < 200; trial++) {
+        for (uint8_t slot = 0; slot < TEST_SLOTS; slot++) {
+            if (rand() % 4 == 0) {
+                m.clearSlot(slot);
+                continue;
+            }
+            m.setOffset(slot, (rand() % 81) - 40);
+            for (uint8_t ef = 0; ef < TEST_EFS; ef++) {
+                m.setDepth(slot, ef, rand() % 3 ? 0 : (rand() % 256) - 128);
+                m.setBipolar(slot, ef, rand() % 2);
+            }
+        }
+        int levels[TEST_EFS];
+        for (uint8_t ef = 0; ef < TEST_EFS; ef++) levels[ef] = rand() % 128;
+        m.process(levels);
+        for (uint8_t slot = 0; slot < TEST_SLOTS; slot++) {
+            int base = rand() % 128;
+            TEST_ASSERT_EQUAL_INT(referenceValue(m, slot, base, levels), m.apply(slot, base));
+        }
+    }
+}
+
+void test_eeprom_image_round_trips() {
+    TEST_ASSERT_EQUAL_UINT(336, TestMatrix::BYTES);
+    TestMatrix a;
+    a.setDepth(0, 0, 127);
+    a.setDepth(41, 5, -128);
+    a.setBipolar(41, 5, true);
+    a.setOffset(17, -99);
+    a.setDepth(17, 3, 32);
+    uint8_t image[TestMatrix::BYTES];
+    a.serialize(image);
+
+    TestMatrix b;
+    b.route(3, 3);   // Overwritten by the load
+    b.deserialize(image);
+    TEST_ASSERT_FALSE(b.routed(3));
+    int levels[TEST_EFS] = { 100, 7, 55, 90, 3, 120 };
+    a.process(levels);
+    b.process(levels);
+    for (uint8_t slot = 0; slot < TEST_SLOTS; slot++) {
+        TEST_ASSERT_EQUAL_INT(a.amount(slot), b.amount(slot));
+        for (uint8_t ef = 0; ef < TEST_EFS; ef++) {
+            TEST_ASSERT_EQUAL_INT(a.depth(slot, ef), b.depth(slot, ef));
+            TEST_ASSERT_EQUAL(a.bipolar(slot, ef), b.bipolar(slot, ef));
+        }
+    }
+}
+
+static double nsPerTick(TestMatrix& m) {
+    const int N = 200000;
+    int levels[TEST_EFS];
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < N; n++) {
+        for (uint8_t ef = 0; ef < TEST_EFS; ef++) levels[ef] = (n + 19 * ef) & 127;
+        m.process(levels);
+        sink = sink + m.amount(n % TEST_SLOTS);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / N;
+}
+
+void test_cost_does_not_depend_on_routing() {
+    TestMatrix sparse;
+    sparse.route(0, 0);
+    TestMatrix dense;
+    for (uint8_t slot = 0; slot < TEST_SLOTS; slot++) {
+        for (uint8_t ef = 0; ef < TEST_EFS; ef++) dense.setDepth(slot, ef, 16 + slot + ef);
+    }
+    double sparseNs = nsPerTick(sparse);
+    double denseNs = nsPerTick(dense);
+    printf("all %d slots per tick: 1 route %.1f ns, %d routes %.1f ns\n",
+           TEST_SLOTS, sparseNs, TEST_SLOTS * TEST_EFS, denseNs);
+    // Same instructions either way; only fail on something far outside host noise
+    TEST_ASSERT_TRUE(denseNs < sparseNs * 2.0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_depth_route_adds_the_level);
+    RUN_TEST(test_bipolar_swings_around_the_center);
+    RUN_TEST(test_random_blends_match_the_formula);
+    RUN_TEST(test_eeprom_image_round_trips);
+    RUN_TEST(test_cost_does_not_depend_on_routing);
+    return UNITY_END();
+}
@@ -0,0 +1,302 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "MuxScanner.h"
+
+// Host-side test: run MuxScanner against a fake mux + ADC on a virtual clock
+// and compare it with the old blocking processPots() sweep.
+
+#define TEST_NUM_POTS 42
+#define SELECT_COST_NS 600        // Six digitalWrite() calls
+#define CONVERSION_NS 2000        // One ADC conversion
+#define POLL_COST_NS 50           // One status register read / micros() call
+#define SETTLE_NS (MUX_SCAN_SETTLE_US * 1000u)
+#define SAMPLE_WINDOW_NS 1500     // Input is held this long after a conversion starts
+#define OTHER_LOOP_WORK_NS 150000 // Rest of loop(): buttons, MIDI, tasks
+
+// Channel 0 is the pot mux output, channel 1 the button mux output
+static uint16_t muxLevel(uint8_t address, uint8_t channel = 0) {
+    return 100 + address * 20 + channel * 1000;
+}
+
+/**
+ * The conversion reads whatever the mux output was at the end of the sample
+ * window. An address that hasn't settled reads as the previous one.
+ */
+struct FakeMuxAdc {
+    uint64_t nowNs = 0;
+    uint8_t selected = 0;
+    uint8_t previous = 0;
+    uint64_t selectedAtNs = 0;
+    uint32_t selects = 0;
+
+    bool converting = false;
+    uint8_t conversionChannel = 0;
+    uint64_t conversionStartNs = 0;
+    uint16_t heldValue = 0;
+    bool held = false;
+    uint32_t corruptSamples = 0;
+    uint64_t conversionNs = CONVERSION_NS;
+    uint32_t conversionsStarted = 0;
+    uint32_t conversionsRead = 0;
+
+    void capture() {
+        if (converting && !held && nowNs >= conversionStartNs + SAMPLE_WINDOW_NS) {
+            uint64_t captureNs = conversionStartNs + SAMPLE_WINDOW_NS;
+            bool settled = captureNs >= selectedAtNs + SETTLE_NS;
+            heldValue = muxLevel(settled ? selected : previous, conversionChannel);
+            if (!settled) corruptSamples++;
+            held = true;
+        }
+    }
+    void select(uint8_t address) {
+        capture();
+        // Switching before the sample window closes corrupts the in-flight conversion
+        if (converting && !held) {
+            heldValue = 0;
+            held = true;
+            corruptSamples++;
+        }
+        previous = selected;
+        selected = address;
+        selects++;
+        nowNs += SELECT_COST_NS;
+        selectedAtNs = nowNs;
+    }
+    void startConversion(uint8_t channel) {
+        converting = true;
+        conversionChannel = channel;
+        held = false;
+        conversionStartNs = nowNs;
+        conversionsStarted++;
+        nowNs += POLL_COST_NS;
+    }
+    bool conversionDone() {
+        nowNs += POLL_COST_NS;
+        capture();
+        return converting && nowNs >= conversionStartNs + conversionNs;
+    }
+    uint16_t conversionResult() {
+        conversionsRead++;
+        converting = false;
+        return heldValue;
+    }
+    uint32_t micros() {
+        nowNs += POLL_COST_NS;
+        return static_cast<uint32_t>(nowNs / 1000);
+    }
+    void delayMicroseconds(uint32_t us) { nowNs += us * 1000ull; }
+    uint16_t analogRead(uint8_t channel = 0) {
+        startConversion(channel);
+        while (!conversionDone()) {}
+        return conversionResult();
+    }
+};
+
+struct SampleLog {
+    uint32_t samples = 0;
+    uint32_t wrongValues = 0;
+};
+
+static void logSample(void* context, uint8_t address, const uint16_t* values) {
+    SampleLog* log = static_cast<SampleLog*>(context);
+    log->samples++;
+    if (values[0] != muxLevel(address)) log->wrongValues++;
+}
+
+// The blocking sweep processPots() used to do: select, then 4 x (analogRead + 10 us delay)
+static void legacySweep(FakeMuxAdc& adc, SampleLog& log) {
+    for (uint8_t address = 0; address < TEST_NUM_POTS; address++) {
+        adc.select(address);
+        uint32_t total = 0;
+        for (int i = 0; i < 4; i++) {
+            total += adc.analogRead();
+            adc.delayMicroseconds(10);
+        }
+        uint16_t value = total / 4;
+        logSample(&log, address, &value);
+    }
+}
+
+struct LoopResult {
+    uint64_t worstCallNs = 0;
+    double scansPerSecond = 0;
+};
+
+static LoopResult runLegacyLoop(uint32_t passes) {
+    FakeMuxAdc adc;
+    SampleLog log;
+    LoopResult result;
+    for (uint32_t i = 0; i < passes; i++) {
+        uint64_t start = adc.nowNs;
+        legacySweep(adc, log);
+        uint64_t elapsed = adc.nowNs - start;
+        if (elapsed > result.worstCallNs) result.worstCallNs = elapsed;
+        adc.nowNs += OTHER_LOOP_WORK_NS;
+    }
+    result.scansPerSecond = passes / (adc.nowNs / 1e9);
+    return result;
+}
+
+static LoopResult runScannerLoop(uint32_t budgetMicros, uint32_t scans, SampleLog& log,
+                                 uint32_t& corruptSamples) {
+    FakeMuxAdc adc;
+    MuxScanner<FakeMuxAdc, TEST_NUM_POTS> scanner(adc);
+    scanner.setCallback(logSample, &log);
+    LoopResult result;
+    while (scanner.fullScans() < scans) {
+        uint64_t start = adc.nowNs;
+        scanner.service(budgetMicros);
+        uint64_t elapsed = adc.nowNs - start;
+        if (elapsed > result.worstCallNs) result.worstCallNs = elapsed;
+        adc.nowNs += OTHER_LOOP_WORK_NS;
+    }
+    result.scansPerSecond = scans / (adc.nowNs / 1e9);
+    corruptSamples = adc.corruptSamples;
+    return result;
+}
+
+void test_pipelined_scan_reads_every_pot_correctly() {
+    SampleLog log;
+    uint32_t corrupt = 0;
+    runScannerLoop(100, 50, log, corrupt);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(50 * TEST_NUM_POTS, log.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, log.wrongValues);
+    TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+}
+
+void test_worst_case_call_drops_and_scan_rate_holds() {
+    LoopResult legacy = runLegacyLoop(50);
+
+    SampleLog log;
+    uint32_t corrupt = 0;
+    LoopResult pipelined = runScannerLoop(100, 50, log, corrupt);
+
+    printf("legacy:    worst call %6.1f us, %6.1f scans/s\n",
+           legacy.worstCallNs / 1000.0, legacy.scansPerSecond);
+    printf("pipelined: worst call %6.1f us, %6.1f scans/s\n",
+           pipelined.worstCallNs / 1000.0, pipelined.scansPerSecond);
+
+    // Each call stays within the budget plus at most one address
+    TEST_ASSERT_LESS_THAN_UINT32(130000, (uint32_t)pipelined.worstCallNs);
+    TEST_ASSERT_LESS_THAN_UINT32((uint32_t)legacy.worstCallNs / 10, (uint32_t)pipelined.worstCallNs);
+    // ...and the whole bank is still swept at least as often
+    TEST_ASSERT_TRUE(pipelined.scansPerSecond >= legacy.scansPerSecond);
+}
+
+void test_settle_that_does_not_fit_is_deferred() {
+    FakeMuxAdc adc;
+    SampleLog log;
+    MuxScanner<FakeMuxAdc, TEST_NUM_POTS> scanner(adc);
+    scanner.setCallback(logSample, &log);
+
+    // A budget shorter than the settle time returns without converting anything
+    TEST_ASSERT_EQUAL_UINT8(0, scanner.service(5));
+    TEST_ASSERT_LESS_THAN_UINT32(6000, (uint32_t)adc.nowNs);
+
+    // Once the loop has been away long enough, the settle has already happened
+    adc.nowNs += OTHER_LOOP_WORK_NS;
+    TEST_ASSERT_GREATER_THAN_UINT8(0, scanner.service(20));
+    TEST_ASSERT_EQUAL_UINT32(0, log.wrongValues);
+}
+
+void test_slow_conversion_stays_in_flight_between_calls() {
+    FakeMuxAdc adc;
+    adc.conversionNs = 30000;   // Longer than a whole call
+    SampleLog log;
+    MuxScanner<FakeMuxAdc, TEST_NUM_POTS> scanner(adc);
+    scanner.setCallback(logSample, &log);
+
+    uint64_t worstCallNs = 0;
+    while (scanner.fullScans() < 2) {
+        uint64_t start = adc.nowNs;
+        scanner.service(20);
+        if (adc.nowNs - start > worstCallNs) worstCallNs = adc.nowNs - start;
+        adc.nowNs += 5000;
+    }
+    // No call waits for the ADC...
+    TEST_ASSERT_LESS_THAN_UINT32(21000, (uint32_t)worstCallNs);
+    // ...and no conversion is restarted or lost across calls
+    TEST_ASSERT_UINT32_WITHIN(1, adc.conversionsStarted, adc.conversionsRead);
+    TEST_ASSERT_EQUAL_UINT32(2 * TEST_NUM_POTS, log.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, log.wrongValues);
+    TEST_ASSERT_EQUAL_UINT32(0, adc.corruptSamples);
+}
+
+void test_invalidate_select_recovers_from_foreign_select() {
+    FakeMuxAdc adc;
+    SampleLog log;
+    MuxScanner<FakeMuxAdc, TEST_NUM_POTS> scanner(adc);
+    scanner.setCallback(logSample, &log);
+
+    for (int i = 0; i < 200; i++) {
+        scanner.service(60);
+        adc.select(7); // A blocking bench read moves the select lines between calls
+        scanner.invalidateSelect();
+        adc.nowNs += OTHER_LOOP_WORK_NS;
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, log.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, log.wrongValues);
+}
+
+/**
+ * A filter pot read on the same ADC between two calls, with a sweep
+ * conversion in flight: the foreign read clears the result the scanner was
+ * waiting for. After abortConversion() the sweep starts the address over and
+ * keeps going, with nothing read from the wrong address.
+ */
+void test_foreign_conversion_between_calls_does_not_stall_the_sweep() {
+    FakeMuxAdc adc;
+    SampleLog log;
+    MuxScanner<FakeMuxAdc, TEST_NUM_POTS, 2> scanner(adc);
+    scanner.setSamples(1, 1);
+    scanner.setCallback(logSample, &log);
+
+    uint32_t foreignReads = 0;
+    for (int i = 0; i < 5000 && scanner.fullScans() < 10; i++) {
+        scanner.service(20);
+        if (i % 3 == 0) {
+            bool inFlight = adc.converting;
+            adc.analogRead(2);   // MuxBus::readPin(FILTER_FREQ_POT_PIN)
+            scanner.abortConversion();
+            if (inFlight) foreignReads++;
+        }
+        adc.nowNs += 5000;
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, foreignReads);
+    TEST_ASSERT_EQUAL_UINT32(10, scanner.fullScans());
+    TEST_ASSERT_EQUAL_UINT32(0, log.wrongValues);
+    TEST_ASSERT_EQUAL_UINT32(0, adc.corruptSamples);
+}
+
+void test_one_select_serves_pots_and_buttons() {
+    FakeMuxAdc adc;
+    MuxScanner<FakeMuxAdc, TEST_NUM_POTS, 2> scanner(adc);
+    scanner.setSamples(1, 1); // Buttons only need one conversion
+
+    while (scanner.fullScans() < 10) {
+        scanner.service(100);
+        adc.nowNs += OTHER_LOOP_WORK_NS;
+    }
+
+    for (uint8_t address = 0; address < TEST_NUM_POTS; address++) {
+        TEST_ASSERT_EQUAL_UINT16(muxLevel(address, 0), scanner.value(0, address));
+        TEST_ASSERT_EQUAL_UINT16(muxLevel(address, 1), scanner.value(1, address));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, adc.corruptSamples);
+
+    // Separate pot and button sweeps selected every address twice per pass
+    TEST_ASSERT_UINT32_WITHIN(TEST_NUM_POTS, 10 * TEST_NUM_POTS, adc.selects);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pipelined_scan_reads_every_pot_correctly);
+    RUN_TEST(test_worst_case_call_drops_and_scan_rate_holds);
+    RUN_TEST(test_settle_that_does_not_fit_is_deferred);
+    RUN_TEST(test_slow_conversion_stays_in_flight_between_calls);
+    RUN_TEST(test_invalidate_select_recovers_from_foreign_select);
+    RUN_TEST(test_foreign_conversion_between_calls_does_not_stall_the_sweep);
+    RUN_TEST(test_one_select_serves_pots_and_buttons);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ResponseCurve.h"
+#include "EnvelopeBank.h"
+
+// Host-side test: the per-EF response tables that replace pow() and the
+// curve switch, and the SET_CURVE breakpoint format.
+
+void test_builtin_curves_match_their_formulas() {
+    uint8_t linear[CURVE_SIZE], inverted[CURVE_SIZE], exponential[CURVE_SIZE];
+    buildCurve(CURVE_LINEAR, linear);
+    buildCurve(CURVE_INVERTED, inverted);
+    buildCurve(CURVE_EXPONENTIAL, exponential);
+    for (int x = 0; x < CURVE_SIZE; x++) {
+        TEST_ASSERT_EQUAL_INT(x, linear[x]);
+        TEST_ASSERT_EQUAL_INT(127 - x, inverted[x]);
+        // Exactly what EnvelopeFollower computed per sample before
+        TEST_ASSERT_EQUAL_INT((int)(pow(x / 127.0, 2) * 127), exponential[x]);
+    }
+}
+
+void test_log_and_s_curves_have_the_right_shape() {
+    uint8_t logCurve[CURVE_SIZE], s[CURVE_SIZE];
+    buildCurve(CURVE_LOGARITHMIC, logCurve);
+    buildCurve(CURVE_S_CURVE, s);
+    TEST_ASSERT_EQUAL_INT(0, logCurve[0]);
+    TEST_ASSERT_EQUAL_INT(127, logCurve[127]);
+    TEST_ASSERT_EQUAL_INT(0, s[0]);
+    TEST_ASSERT_EQUAL_INT(127, s[127]);
+    for (int x = 1; x < CURVE_SIZE; x++) {
+        TEST_ASSERT_TRUE(logCurve[x] >= logCurve[x - 1]);
+        TEST_ASSERT_TRUE(s[x] >= s[x - 1]);
+    }
+    for (int x = 1; x < 127; x++) {
+        TEST_ASSERT_TRUE(logCurve[x] >= x);                  // Opens up early
+        TEST_ASSERT_INT_WITHIN(1, 127, s[x] + s[127 - x]);   // Point-symmetric about the middle
+        if (x < 64) TEST_ASSERT_TRUE(s[x] <= x);             // Soft start
+    }
+    printf("level 32: linear 32, log %d, S %d\n", logCurve[32], s[32]);
+}
+
+void test_custom_curve_passes_through_every_breakpoint() {
+    uint8_t identity[CURVE_BREAKPOINTS];
+    linearBreakpoints(identity);
+    uint8_t table[CURVE_SIZE];
+    buildCurve(CURVE_CUSTOM, table, identity);
+    for (int x = 0; x < CURVE_SIZE; x++) TEST_ASSERT_EQUAL_INT(x, table[x]);
+
+    srand(7);
+    for (int trial = 0; trial < 200; trial++) {
+        uint8_t points[CURVE_BREAKPOINTS];
+        for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) points[k] = rand() % 128;
+        buildCurve(CURVE_CUSTOM, table, points);
+        for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) {
+            TEST_ASSERT_EQUAL_INT(points[k], table[curveBreakpointLevel(k)]);
+        }
+        // In between: a straight line, so never outside the two neighbours
+        for (int x = 0; x < CURVE_SIZE; x++) {
+            uint8_t k = x / CURVE_BREAKPOINT_SPACING;
+            int lo = points[k] < points[k + 1] ? points[k] : points[k + 1];
+            int hi = points[k] < points[k + 1] ? points[k + 1] : points[k];
+            TEST_ASSERT_TRUE(table[x] >= lo && table[x] <= hi);
+        }
+    }
+}
+
+void test_set_curve_arguments_are_checked() {
+    uint8_t points[CURVE_BREAKPOINTS];
+    TEST_ASSERT_TRUE(parseCurveBreakpoints("0 8 16 24 32 40 48 56 64 72 80 88 96 104 112 120 127", points));
+    TEST_ASSERT_EQUAL_INT(120, points[15]);
+    TEST_ASSERT_TRUE(parseCurveBreakpoints("127 0 127 0 127 0 127 0 127 0 127 0 127 0 127 0 127  ", points));
+    TEST_ASSERT_FALSE(parseCurveBreakpoints("0 8 16", points));                                                  // Too few
+    TEST_ASSERT_FALSE(parseCurveBreakpoints("0 8 16 24 32 40 48 56 64 72 80 88 96 104 112 120 127 127", points)); // Too many
+    TEST_ASSERT_FALSE(parseCurveBreakpoints("0 8 16 24 32 40 48 56 64 72 80 88 96 104 112 120 128", points));     // Out of range
+    TEST_ASSERT_FALSE(parseCurveBreakpoints("0 8 16 24 32 40 48 56 64 72 80 88 96 104 112 120 -1", points));
+    TEST_ASSERT_FALSE(parseCurveBreakpoints("LOGARITHMIC", points));
+
+    TEST_ASSERT_EQUAL_INT(CURVE_S_CURVE, curveByName("S_CURVE"));
+    TEST_ASSERT_EQUAL_INT(CURVE_COUNT, curveByName("WIGGLY"));
+}
+
+void test_bank_reads_each_efs_own_table() {
+    EnvelopeBank<6> bank;
+    const CurveType curves[6] = { CURVE_LINEAR, CURVE_INVERTED, CURVE_EXPONENTIAL, CURVE_LOGARITHMIC, CURVE_S_CURVE, CURVE_CUSTOM };
+    uint8_t steps[CURVE_BREAKPOINTS];
+    for (uint8_t k = 0; k < CURVE_BREAKPOINTS; k++) steps[k] = (k / 4) * 40;   // A staircase nobody ships
+    uint8_t tables[6][CURVE_SIZE];
+    for (uint8_t ef = 0; ef < 6; ef++) {
+        buildCurve(curves[ef], tables[ef], steps);
+        bank.setCurve(ef, tables[ef]);
+        bank.setShape(ef, SHAPE_CURVE);
+        bank.setInput(ef, ef);
+        bank.setActive(ef, true);
+    }
+    uint8_t levels[6];
+    for (int x = 0; x < CURVE_SIZE; x++) {
+        for (uint8_t i = 0; i < 6; i++) levels[i] = (x + 20 * i) % 128;
+        bank.process(levels);
+        for (uint8_t ef = 0; ef < 6; ef++) {
+            TEST_ASSERT_EQUAL_INT(tables[ef][levels[ef]], bank.level(ef));
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_builtin_curves_match_their_formulas);
+    RUN_TEST(test_log_and_s_curves_have_the_right_shape);
+    RUN_TEST(test_custom_curve_passes_through_every_breakpoint);
+    RUN_TEST(test_set_curve_arguments_are_checked);
+    RUN_TEST(test_bank_reads_each_efs_own_table);
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "TapTempo.h"
+#include "ClockGenerator.h"
+
+// Host-side test: tap tempo from a ring of intervals with median/MAD
+// outlier rejection, against the old two-tap estimate, and handed to the
+// internal clock.
+
+#define SIM_TAP_JITTER_US 15000   // How far a person's taps wander (std dev)
+#define SIM_TAPS 64
+
+static double periodFor(double bpm) { return 60000000.0 / (bpm * CLOCK_PPQN); }
+
+// Normal noise, Box-Muller
+static double gaussian(double sigma) {
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double stddev(const std::vector<double>& x) {
+    double mean = 0.0, var = 0.0;
+    for (double v : x) mean += v;
+    mean /= x.size();
+    for (double v : x) var += (v - mean) * (v - mean);
+    return sqrt(var / x.size());
+}
+
+// Taps on a beat grid, each off by the person's jitter
+static uint32_t humanTap(double beatAt) {
+    return static_cast<uint32_t>(beatAt + gaussian(SIM_TAP_JITTER_US));
+}
+
+void test_ring_estimate_is_steadier_than_two_taps() {
+    srand(11);
+    TapTempo tapTempo;
+    const double beat = 500000.0;   // 120 BPM
+    std::vector<double> twoTap, ring;
+    uint32_t previous = 0;
+    for (int i = 0; i < SIM_TAPS; i++) {
+        uint32_t t = humanTap(1000000.0 + i * beat);
+        if (i > 0) twoTap.push_back(60000000.0 / (t - previous));   // The old actionTapTempo()
+        previous = t;
+        if (tapTempo.tap(t) == TAP_TEMPO && i >= TAP_TEMPO_HISTORY) ring.push_back(tapTempo.bpm());
+    }
+    double oldSpread = stddev(twoTap);
+    double newSpread = stddev(ring);
+    printf("120 BPM tapped with %d ms jitter: two-tap BPM wobbles %.2f (std dev), ring of %d: %.2f\n",
+           SIM_TAP_JITTER_US / 1000, oldSpread, TAP_TEMPO_HISTORY, newSpread);
+    TEST_ASSERT_TRUE(newSpread * 2.5 < oldSpread);
+    TEST_ASSERT_FLOAT_WITHIN(1.5f, 120.0f, tapTempo.bpm());
+}
+
+void test_a_fluffed_tap_is_left_out() {
+    TapTempo tapTempo;
+    uint32_t t = 0;
+    TEST_ASSERT_EQUAL_INT(TAP_FIRST, tapTempo.tap(t));
+    TEST_ASSERT_EQUAL_INT(TAP_COUNTING, tapTempo.tap(t += 500000));
+    TEST_ASSERT_EQUAL_INT(TAP_COUNTING, tapTempo.tap(t += 505000));
+    TEST_ASSERT_EQUAL_INT(TAP_TEMPO, tapTempo.tap(t += 495000));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 120.0f, tapTempo.bpm());
+    TEST_ASSERT_EQUAL_UINT32(t, tapTempo.lastBeatMicros());
+
+    TEST_ASSERT_EQUAL_INT(TAP_OUTLIER, tapTempo.tap(t += 700000));   // 200 ms late...
+    TEST_ASSERT_EQUAL_INT(TAP_OUTLIER, tapTempo.tap(t += 300000));   // ...and back on the beat: they don't agree
+    TEST_ASSERT_EQUAL_INT(TAP_TEMPO, tapTempo.tap(t += 500000));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 120.0f, tapTempo.bpm());
+    TEST_ASSERT_EQUAL_UINT32(2, tapTempo.rejected());
+
+    TEST_ASSERT_EQUAL_INT(TAP_IGNORED, tapTempo.tap(t + 40000));    // Contact bounce
+    TEST_ASSERT_EQUAL_INT(TAP_TEMPO, tapTempo.tap(t += 500000));
+}
+
+void test_a_new_tempo_takes_over() {
+    TapTempo tapTempo;
+    uint32_t t = 0;
+    for (int i = 0; i < 8; i++) tapTempo.tap(t += 500000);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 120.0f, tapTempo.bpm());
+
+    TEST_ASSERT_EQUAL_INT(TAP_OUTLIER, tapTempo.tap(t += 666667));    // 90 BPM: first looks like a mistake
+    TEST_ASSERT_EQUAL_INT(TAP_COUNTING, tapTempo.tap(t += 666667));   // Second agrees: start over from both
+    TEST_ASSERT_EQUAL_UINT8(2, tapTempo.intervals());
+    TEST_ASSERT_EQUAL_INT(TAP_TEMPO, tapTempo.tap(t += 666667));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 90.0f, tapTempo.bpm());
+
+    TEST_ASSERT_EQUAL_INT(TAP_FIRST, tapTempo.tap(t += 4000000));     // Long pause: a new run
+    TEST_ASSERT_EQUAL_UINT8(0, tapTempo.intervals());
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 90.0f, tapTempo.bpm());            // The last tempo stands meanwhile
+}
+
+/**
+ * The whole path: taps at 100 BPM, 40 ms off the clock's current beat,
+ * into the internal clock running at 120 BPM. Each estimate goes to
+ * syncTo(), as processInternalClock() does. The clock's ticks come from a
+ * simple virtual timer (reload, then the interrupt).
+ */
+void test_taps_steer_the_clock_without_jumps() {
+    srand(12);
+    ClockGenerator gen;
+    TapTempo tapTempo;
+    uint64_t nextFire = 0, load = 0;
+    nextFire = gen.nextInterval();
+    load = gen.nextInterval();
+    gen.start();
+
+    std::vector<double> ticks;
+    std::vector<uint32_t> positions;
+    auto runUntil = [&](uint64_t until) {
+        while (nextFire < until) {
+            uint64_t at = nextFire;
+            nextFire += load;
+            uint8_t bytes[2];
+            gen.tick(static_cast<uint32_t>(at), bytes);
+            load = gen.nextInterval();
+            ticks.push_back(static_cast<double>(at));
+            positions.push_back(gen.position());
+        }
+    };
+
+    runUntil(2000000);
+    const double beat = 600000.0;   // 100 BPM
+    const double firstBeat = 2040000.0;
+    const int taps = 12;
+    for (int i = 0; i < taps; i++) {
+        double tapAt = firstBeat + i * beat;
+        runUntil(static_cast<uint64_t>(tapAt) + 30000);   // The action runs a little after the tap
+        uint32_t t = humanTap(tapAt);
+        if (tapTempo.tap(t) == TAP_TEMPO) gen.syncTo(tapTempo.bpm(), tapTempo.lastBeatMicros());
+    }
+    runUntil(static_cast<uint64_t>(firstBeat + (taps + 8) * beat));
+
+    double biggestStep = 0.0;
+    for (size_t i = 2; i < ticks.size(); i++) {
+        double step = fabs((ticks[i] - ticks[i - 1]) - (ticks[i - 1] - ticks[i - 2]));
+        if (step > biggestStep) biggestStep = step;
+    }
+    // The last few downbeats against the last tap, every beat of the tapped tempo from it
+    const double tapped = 60000000.0 / tapTempo.bpm();
+    double worst = 0.0;
+    for (size_t i = ticks.size() - 4 * CLOCK_PPQN; i < ticks.size(); i++) {
+        if (positions[i] % CLOCK_PPQN) continue;
+        double off = fmod(ticks[i] - tapTempo.lastBeatMicros() + tapped / 2, tapped) - tapped / 2;
+        if (fabs(off) > worst) worst = fabs(off);
+    }
+    double settled = 60000000.0 / ((ticks.back() - ticks[ticks.size() - 1 - CLOCK_PPQN]) / CLOCK_PPQN * CLOCK_PPQN);
+    printf("Taps at 100 BPM into a 120 BPM clock: ends at %.2f BPM, downbeats within %.0f us of the last tap's beat, "
+           "biggest change between intervals %.0f us (a jump would be %.0f us)\n",
+           settled, worst, biggestStep, periodFor(100.0) - periodFor(120.0));
+    TEST_ASSERT_FLOAT_WITHIN(1.5f, 100.0f, static_cast<float>(settled));
+    TEST_ASSERT_TRUE(worst < 50.0);
+    TEST_ASSERT_TRUE(biggestStep < (periodFor(100.0) - periodFor(120.0)) / 2.0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_estimate_is_steadier_than_two_taps);
+    RUN_TEST(test_a_fluffed_tap_is_left_out);
+    RUN_TEST(test_a_new_tempo_takes_over);
+    RUN_TEST(test_taps_steer_the_clock_without_jumps);
+    return UNITY_END();
+}
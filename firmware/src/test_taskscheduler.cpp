@@ -0,0 +1,106 @@
+#include <unity.h>
+#include <stdint.h>
+#include "TaskScheduler.h"
+
+// Host-side test: drive the scheduler from a virtual microsecond clock and
+// check that phase-locked deadlines never drift.
+
+struct RunCounter {
+    uint32_t runs = 0;
+    uint32_t firstRun = 0;
+    uint32_t lastRun = 0;
+    uint32_t* clock = nullptr;
+};
+
+static void countRun(void* context) {
+    RunCounter* counter = static_cast<RunCounter*>(context);
+    if (counter->runs == 0) counter->firstRun = *counter->clock;
+    counter->lastRun = *counter->clock;
+    counter->runs++;
+}
+
+// Small deterministic LCG so the "loop time" jitter is reproducible
+static uint32_t lcgState = 12345;
+static uint32_t nextRandom() {
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return lcgState >> 8;
+}
+
+void test_no_drift_over_ten_minutes() {
+    const uint32_t start = 0xFFFFFFFFu - 5000000u; // roll micros() over mid-run
+    const uint32_t duration = 10u * 60u * 1000000u;
+    uint32_t now = start;
+
+    TaskScheduler scheduler;
+    RunCounter midi, envelope, display;
+    midi.clock = envelope.clock = display.clock = &now;
+    TEST_ASSERT_TRUE(scheduler.addTask(countRun, &midi, 1000));
+    TEST_ASSERT_TRUE(scheduler.addTask(countRun, &envelope, 5000));
+    TEST_ASSERT_TRUE(scheduler.addTask(countRun, &display, 100000));
+
+    while (now - start < duration) {
+        scheduler.update(now);
+        // Loop passes of 20..900 us, with an occasional 3 ms stall (OLED flush)
+        uint32_t step = 20 + nextRandom() % 880;
+        if (nextRandom() % 500 == 0) step += 3000;
+        now += step;
+    }
+
+    // Every deadline start + k * interval inside the window must have run exactly once
+    TEST_ASSERT_UINT32_WITHIN(1, duration / 1000, midi.runs);
+    TEST_ASSERT_UINT32_WITHIN(1, duration / 5000, envelope.runs);
+    TEST_ASSERT_UINT32_WITHIN(1, duration / 100000, display.runs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.skippedRuns());
+}
+
+void test_long_stall_resyncs_to_phase_grid() {
+    uint32_t now = 0;
+    TaskScheduler scheduler;
+    RunCounter midi;
+    midi.clock = &now;
+    scheduler.addTask(countRun, &midi, 1000);
+
+    scheduler.update(now);           // first run at t=0
+    now = 250300;                    // 250 ms stall
+    scheduler.update(now);           // runs once, then skips the backlog
+    TEST_ASSERT_EQUAL_UINT32(2, midi.runs);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, scheduler.skippedRuns());
+
+    // The next deadline is still on the original 1 ms grid
+    TEST_ASSERT_EQUAL_UINT32(251000, scheduler.nextDeadline());
+}
+
+void test_earliest_deadline_runs_first() {
+    uint32_t now = 0;
+    TaskScheduler scheduler;
+    RunCounter slow, fast;
+    slow.clock = fast.clock = &now;
+    scheduler.addTask(countRun, &slow, 10000);
+    scheduler.addTask(countRun, &fast, 1000);
+
+    for (now = 0; now <= 20000; now += 100) {
+        scheduler.update(now);
+    }
+    TEST_ASSERT_EQUAL_UINT32(21, fast.runs);
+    TEST_ASSERT_EQUAL_UINT32(3, slow.runs);
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.nextDeadline() - 20000);
+}
+
+void test_capacity_is_fixed() {
+    TaskScheduler scheduler;
+    RunCounter counter;
+    for (int i = 0; i < TASK_SCHEDULER_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(scheduler.addTask(countRun, &counter, 1000));
+    }
+    TEST_ASSERT_FALSE(scheduler.addTask(countRun, &counter, 1000));
+    TEST_ASSERT_FALSE(TaskScheduler().addTask(countRun, &counter, 0));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_drift_over_ten_minutes);
+    RUN_TEST(test_long_stall_resyncs_to_phase_grid);
+    RUN_TEST(test_earliest_deadline_runs_first);
+    RUN_TEST(test_capacity_is_fixed);
+    return UNITY_END();
+}
@@ -0,0 +1,271 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "TimingWheel.h"
+#include "BeatTimers.h"
+#include "ButtonActions.h"
+
+// Host-side test: the timing wheel (schedule / cancel / expire), beat-quantized
+// timers on the leading clock, and the per-action quantize settings.
+
+struct Log {
+    std::vector<uint32_t> args;
+    std::vector<uint32_t> at;
+    TimingWheel* wheel = nullptr;
+};
+
+static void record(void* context, uint32_t arg) {
+    Log* log = static_cast<Log*>(context);
+    log->args.push_back(arg);
+    log->at.push_back(log->wheel ? log->wheel->now() : 0);
+}
+
+void test_timers_fire_on_their_tick_in_order() {
+    TimingWheel wheel;
+    Log log;
+    log.wheel = &wheel;
+    wheel.schedule(5, record, &log, 1);
+    wheel.schedule(3, record, &log, 2);
+    wheel.schedule(5, record, &log, 3);                       // Same tick as the first: after it
+    wheel.schedule(TIMING_WHEEL_SLOTS + 5, record, &log, 4);  // Same bucket, one turn later
+    wheel.schedule(0, record, &log, 5);                       // Next tick, never inside schedule()
+    TEST_ASSERT_EQUAL_UINT8(5, wheel.count());
+    TEST_ASSERT_EQUAL(0, log.args.size());
+
+    wheel.advance(5);
+    TEST_ASSERT_EQUAL(4, log.args.size());
+    TEST_ASSERT_EQUAL_UINT32(5, log.args[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, log.at[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, log.args[1]);
+    TEST_ASSERT_EQUAL_UINT32(3, log.at[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, log.args[2]);
+    TEST_ASSERT_EQUAL_UINT32(3, log.args[3]);
+    TEST_ASSERT_EQUAL_UINT32(5, log.at[3]);
+
+    wheel.advance(TIMING_WHEEL_SLOTS - 1);
+    TEST_ASSERT_EQUAL(4, log.args.size());
+    wheel.advance(1);
+    TEST_ASSERT_EQUAL(5, log.args.size());
+    TEST_ASSERT_EQUAL_UINT32(4, log.args[4]);
+    TEST_ASSERT_EQUAL_UINT32(TIMING_WHEEL_SLOTS + 5, log.at[4]);
+    TEST_ASSERT_EQUAL_UINT8(0, wheel.count());
+    TEST_ASSERT_EQUAL_UINT32(5, wheel.fired());
+}
+
+struct Canceller {
+    TimingWheel* wheel;
+    WheelTimer victim;
+    Log* log;
+};
+
+static void cancelVictim(void* context, uint32_t arg) {
+    Canceller* c = static_cast<Canceller*>(context);
+    c->log->args.push_back(arg);
+    c->wheel->cancel(c->victim);
+}
+
+void test_cancel_is_safe_at_any_time() {
+    TimingWheel wheel;
+    Log log;
+    WheelTimer a = wheel.schedule(10, record, &log, 1);
+    WheelTimer b = wheel.schedule(10, record, &log, 2);
+    TEST_ASSERT_TRUE(wheel.pending(a));
+    TEST_ASSERT_EQUAL_UINT32(10, wheel.remaining(a));
+    TEST_ASSERT_TRUE(wheel.cancel(a));
+    TEST_ASSERT_FALSE(wheel.cancel(a));   // Twice
+    TEST_ASSERT_FALSE(wheel.pending(a));
+    wheel.advance(10);
+    TEST_ASSERT_EQUAL(1, log.args.size());
+    TEST_ASSERT_EQUAL_UINT32(2, log.args[0]);
+    TEST_ASSERT_FALSE(wheel.cancel(b));   // Already fired
+
+    // A stale handle doesn't hit whoever got its node next
+    WheelTimer c = wheel.schedule(1, record, &log, 3);
+    TEST_ASSERT_FALSE(wheel.cancel(b));
+    TEST_ASSERT_FALSE(wheel.cancel(a));
+    TEST_ASSERT_TRUE(wheel.pending(c));
+    TEST_ASSERT_FALSE(wheel.cancel(0));
+
+    // A callback cancelling another timer due on the same tick
+    wheel.advance(1);
+    log.args.clear();
+    Canceller canceller = { &wheel, 0, &log };
+    wheel.schedule(4, cancelVictim, &canceller, 10);
+    canceller.victim = wheel.schedule(4, record, &log, 11);
+    wheel.schedule(4, record, &log, 12);
+    wheel.advance(4);
+    TEST_ASSERT_EQUAL(2, log.args.size());
+    TEST_ASSERT_EQUAL_UINT32(10, log.args[0]);
+    TEST_ASSERT_EQUAL_UINT32(12, log.args[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, wheel.count());
+}
+
+static void reschedule(void* context, uint32_t arg) {
+    Log* log = static_cast<Log*>(context);
+    log->args.push_back(arg);
+    log->at.push_back(log->wheel->now());
+    if (arg < 3) log->wheel->schedule(7, reschedule, log, arg + 1);
+}
+
+void test_callbacks_reschedule_and_big_jumps_catch_up() {
+    TimingWheel wheel;
+    Log log;
+    log.wheel = &wheel;
+    wheel.schedule(7, reschedule, &log, 0);
+    wheel.advance(30);
+    TEST_ASSERT_EQUAL(4, log.args.size());
+    TEST_ASSERT_EQUAL_UINT32(28, log.at[3]);
+
+    // millis() jumping ahead by more than a turn: everything due fires, nothing later does
+    log.args.clear();
+    wheel.schedule(50, record, &log, 1);
+    wheel.schedule(1000, record, &log, 2);
+    wheel.schedule(5000, record, &log, 3);
+    wheel.advanceTo(wheel.now() + 1200);
+    TEST_ASSERT_EQUAL(2, log.args.size());
+    TEST_ASSERT_EQUAL_UINT8(1, wheel.count());
+    wheel.advanceTo(wheel.now() + 3800);
+    TEST_ASSERT_EQUAL(3, log.args.size());
+}
+
+void test_full_wheel_refuses_and_counts() {
+    TimingWheel wheel;
+    Log log;
+    for (int i = 0; i < TIMING_WHEEL_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(wheel.schedule(i + 1, record, &log, i) != 0);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, wheel.schedule(1, record, &log, 99));
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.dropped());
+    TEST_ASSERT_EQUAL_UINT8(TIMING_WHEEL_CAPACITY, wheel.maxCount());
+    wheel.advance(1);
+    TEST_ASSERT_TRUE(wheel.schedule(1, record, &log, 99) != 0);   // A node came free
+}
+
+/**
+ * Schedule + cancel and a tick of expiry, with the wheel nearly empty and
+ * nearly full. A sorted list (the usual alternative) would get slower as
+ * it fills; the wheel shouldn't.
+ */
+void test_cost_does_not_grow_with_pending_timers() {
+    const int rounds = 200000;
+    double perOp[2];
+    for (int fill = 0; fill < 2; fill++) {
+        TimingWheel wheel;
+        Log log;
+        int background = fill ? TIMING_WHEEL_CAPACITY - 1 : 0;
+        for (int i = 0; i < background; i++) wheel.schedule(1000000 + i * 37, record, &log, i);
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            WheelTimer t = wheel.schedule(3 + (r & 63), record, &log, r);
+            wheel.cancel(t);
+            wheel.advance(1);
+        }
+        auto end = std::chrono::steady_clock::now();
+        perOp[fill] = std::chrono::duration<double, std::nano>(end - start).count() / rounds;
+        TEST_ASSERT_EQUAL_UINT8(background, wheel.count());
+    }
+    printf("Schedule + cancel + one tick: %.1f ns with 1 timer pending, %.1f ns with %d\n",
+           perOp[0], perOp[1], TIMING_WHEEL_CAPACITY);
+    TEST_ASSERT_TRUE(perOp[1] < perOp[0] * 3.0 + 20.0);
+}
+
+// Counts beat timer callbacks with the song position they landed on
+struct BeatLog {
+    std::vector<uint32_t> positions;
+    const uint32_t* position;
+};
+
+static void onBeat(void* context, uint32_t) {
+    BeatLog* log = static_cast<BeatLog*>(context);
+    log->positions.push_back(*log->position);
+}
+
+void test_beat_timers_land_on_the_next_beat_and_bar() {
+    BeatTimers timers;
+    uint32_t ticks = 500, position = 0;
+    BeatLog log = { {}, &position };
+    timers.follow(CLOCK_SOURCE_INTERNAL, ticks, position, false);
+    TEST_ASSERT_EQUAL_UINT32(0, timers.ticksToNext(CLOCK_PPQN));   // Stopped: nothing to wait for
+    TEST_ASSERT_EQUAL_UINT16(0, timers.scheduleOnNext(CLOCK_PPQN, onBeat, &log));
+
+    // Running, 10 ticks into the song; the 1 ms pass sees one or two ticks at a time
+    position = 10;
+    ticks += 10;
+    timers.follow(CLOCK_SOURCE_INTERNAL, ticks, position, true);
+    TEST_ASSERT_EQUAL_UINT32(14, timers.ticksToNext(CLOCK_PPQN));
+    TEST_ASSERT_TRUE(timers.scheduleOnNext(CLOCK_PPQN, onBeat, &log) != 0);
+    TEST_ASSERT_TRUE(timers.scheduleOnNext(CLOCK_PPQN * BEATS_PER_BAR, onBeat, &log) != 0);
+    for (int pass = 0; pass < 80; pass++) {
+        int step = (pass % 3 == 0) ? 2 : 1;
+        position += step;
+        ticks += step;
+        timers.follow(CLOCK_SOURCE_INTERNAL, ticks, position, true);
+    }
+    TEST_ASSERT_EQUAL(2, log.positions.size());
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN, log.positions[0]);
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN * BEATS_PER_BAR, log.positions[1]);
+
+    // On a boundary already sent: the next one, not this one
+    position = 5 * CLOCK_PPQN;
+    ticks += 3;
+    timers.follow(CLOCK_SOURCE_INTERNAL, ticks, position, true);
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN, timers.ticksToNext(CLOCK_PPQN));
+}
+
+void test_beat_timers_count_on_across_a_clock_hand_over() {
+    BeatTimers timers;
+    uint32_t position = 0;
+    BeatLog log = { {}, &position };
+    timers.follow(CLOCK_SOURCE_INTERNAL, 1000, position, true);
+    timers.scheduleOnNext(CLOCK_PPQN, onBeat, &log);   // 24 ticks away
+    timers.follow(CLOCK_SOURCE_INTERNAL, 1010, position += 10, true);
+
+    // An external clock takes over with a counter of its own
+    timers.follow(CLOCK_SOURCE_EXTERNAL, 77, position, true);
+    TEST_ASSERT_EQUAL(0, log.positions.size());
+    timers.follow(CLOCK_SOURCE_EXTERNAL, 90, position += 13, true);
+    TEST_ASSERT_EQUAL(0, log.positions.size());
+    timers.follow(CLOCK_SOURCE_EXTERNAL, 91, position += 1, true);
+    TEST_ASSERT_EQUAL(1, log.positions.size());
+    TEST_ASSERT_EQUAL_UINT32(CLOCK_PPQN, log.positions[0]);
+}
+
+void test_action_quantize_settings() {
+    ButtonActionMap actions;
+    TEST_ASSERT_EQUAL_INT(QUANTIZE_NOW, actions.quantize(ACTION_SELECT_SLOT));
+    TEST_ASSERT_TRUE(actions.setQuantize("SELECT_SLOT", "BAR"));
+    TEST_ASSERT_TRUE(actions.setQuantize("CYCLE_FILTER", "BEAT"));
+    TEST_ASSERT_FALSE(actions.setQuantize("TAP_TEMPO", "BEAT"));   // Timed by the press itself
+    TEST_ASSERT_TRUE(actions.setQuantize("TAP_TEMPO", "NOW"));
+    TEST_ASSERT_FALSE(actions.setQuantize("NONE", "BAR"));
+    TEST_ASSERT_FALSE(actions.setQuantize("CYCLE_EF", "SOON"));
+    TEST_ASSERT_EQUAL_INT(QUANTIZE_BAR, actions.quantize(ACTION_SELECT_SLOT));
+    TEST_ASSERT_EQUAL_INT(QUANTIZE_BEAT, actions.quantize(ACTION_CYCLE_FILTER));
+
+    uint8_t image[ACTION_QUANTIZE_BYTES];
+    actions.serializeQuantize(image);
+    ButtonActionMap loaded;
+    TEST_ASSERT_TRUE(loaded.deserializeQuantize(image));
+    for (uint8_t id = 0; id < ACTION_COUNT; id++) {
+        TEST_ASSERT_EQUAL_INT(actions.quantize(id), loaded.quantize(id));
+    }
+    image[ACTION_TAP_TEMPO / 4] |= QUANTIZE_BAR << (2 * (ACTION_TAP_TEMPO % 4));
+    TEST_ASSERT_FALSE(loaded.deserializeQuantize(image));
+    loaded.reset();
+    TEST_ASSERT_EQUAL_INT(QUANTIZE_NOW, loaded.quantize(ACTION_SELECT_SLOT));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_timers_fire_on_their_tick_in_order);
+    RUN_TEST(test_cancel_is_safe_at_any_time);
+    RUN_TEST(test_callbacks_reschedule_and_big_jumps_catch_up);
+    RUN_TEST(test_full_wheel_refuses_and_counts);
+    RUN_TEST(test_cost_does_not_grow_with_pending_timers);
+    RUN_TEST(test_beat_timers_land_on_the_next_beat_and_bar);
+    RUN_TEST(test_beat_timers_count_on_across_a_clock_hand_over);
+    RUN_TEST(test_action_quantize_settings);
+    return UNITY_END();
+}
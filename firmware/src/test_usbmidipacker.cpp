@@ -0,0 +1,154 @@
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "UsbMidiPacker.h"
+
+// Host-side test: USB-MIDI events packed into whole 64-byte packets,
+// against a transfer per message.
+
+#define SIM_TICK_US 1000
+#define SIM_SOURCES 48
+#define SIM_UPDATE_HZ 200
+#define SIM_SECONDS 10
+
+static MidiOutMessage message(uint8_t status, uint8_t data1, uint8_t data2, uint8_t size, uint32_t queuedAt = 0) {
+    MidiOutMessage m;
+    m.status = status;
+    m.data1 = data1;
+    m.data2 = data2;
+    m.size = size;
+    m.queuedAt = queuedAt;
+    return m;
+}
+
+struct PacketLog {
+    std::vector<uint8_t> sizes;
+    std::vector<uint32_t> events;
+    void operator()(const uint32_t* e, uint8_t count) {
+        sizes.push_back(count);
+        events.insert(events.end(), e, e + count);
+    }
+};
+
+void test_events_match_the_usb_midi_format() {
+    // What the Teensy core's usbMIDI.send() packs, for comparison
+    auto teensy = [](uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel, uint8_t cable) {
+        return static_cast<uint32_t>((type >> 4) | ((cable & 0x0F) << 4) | ((type | ((channel - 1) & 0x0F)) << 8) |
+                                     ((data1 & 0x7F) << 16) | ((data2 & 0x7F) << 24));
+    };
+    TEST_ASSERT_EQUAL_HEX32(teensy(0xB0, 7, 100, 1, 0), UsbMidiPacker::encode(message(0xB0, 7, 100, 3)));
+    TEST_ASSERT_EQUAL_HEX32(teensy(0x90, 60, 127, 16, 0), UsbMidiPacker::encode(message(0x9F, 60, 127, 3)));
+    TEST_ASSERT_EQUAL_HEX32(teensy(0x80, 60, 0, 3, 2), UsbMidiPacker::encode(message(0x82, 60, 0, 3), 2));
+    TEST_ASSERT_EQUAL_HEX32(0x0000F80F, UsbMidiPacker::encode(message(0xF8, 0, 0, 1)));   // Clock: CIN 0xF, one byte
+    TEST_ASSERT_EQUAL_HEX32(0x000DC10C, UsbMidiPacker::encode(message(0xC1, 13, 0, 2)));   // Program change: two bytes, zero padded
+    TEST_ASSERT_EQUAL_HEX32(0x0001F302, UsbMidiPacker::encode(message(0xF3, 1, 0, 2)));    // Song select: system common, CIN 0x2
+    TEST_ASSERT_EQUAL_HEX32(0x0000F605, UsbMidiPacker::encode(message(0xF6, 0, 0, 1)));    // Tune request: CIN 0x5
+}
+
+void test_full_packets_go_at_once_partial_ones_wait() {
+    UsbMidiPacker packer;
+    PacketLog log;
+    for (uint8_t cc = 0; cc < 40; cc++) packer.add(message(0xB0, cc, 1, 3), 0, log);
+    TEST_ASSERT_EQUAL_UINT(2, log.sizes.size());
+    TEST_ASSERT_EQUAL_UINT8(USB_MIDI_EVENTS_PER_PACKET, log.sizes[0]);
+    TEST_ASSERT_EQUAL_UINT8(8, packer.pending());
+
+    packer.service(SIM_TICK_US - 1, log);   // Not old enough yet
+    TEST_ASSERT_EQUAL_UINT(2, log.sizes.size());
+    packer.service(USB_MIDI_MAX_LATENCY_US, log);
+    TEST_ASSERT_EQUAL_UINT(3, log.sizes.size());
+    TEST_ASSERT_EQUAL_UINT8(8, log.sizes[2]);
+    for (uint8_t cc = 0; cc < 40; cc++) TEST_ASSERT_EQUAL_UINT8(cc, (log.events[cc] >> 16) & 0x7F);
+    TEST_ASSERT_EQUAL_UINT32(3, packer.packets());
+    TEST_ASSERT_EQUAL_UINT32(40, packer.events());
+}
+
+void test_notes_and_flush_do_not_wait() {
+    UsbMidiPacker packer;
+    PacketLog log;
+    packer.add(message(0xB0, 1, 1, 3), 0, log);
+    packer.add(message(0x90, 60, 100, 3), 0, log);
+    packer.service(0, log);
+    TEST_ASSERT_EQUAL_UINT(1, log.sizes.size());
+    TEST_ASSERT_EQUAL_UINT8(2, log.sizes[0]);
+
+    packer.add(message(0xB0, 1, 2, 3), 10, log);
+    packer.flush(log);
+    TEST_ASSERT_EQUAL_UINT(2, log.sizes.size());
+    packer.flush(log);   // Nothing left: no empty transfer
+    TEST_ASSERT_EQUAL_UINT(2, log.sizes.size());
+}
+
+struct SimResult {
+    uint32_t events, transfers, maxLatency;
+};
+
+/**
+ * Every source moving at SIM_UPDATE_HZ, queued as the pot/EF passes emit
+ * them and flushed at the end of each 1 ms tick. packed = false is the
+ * old path, one transfer per message.
+ */
+static SimResult simulate(bool packed, uint32_t updateHz) {
+    SimResult r = { 0, 0, 0 };
+    UsbMidiPacker packer;
+    std::vector<uint32_t> waiting;   // queuedAt of events in the packer
+    auto sink = [&](const uint32_t*, uint8_t count) {
+        r.transfers++;
+        r.events += count;
+        waiting.erase(waiting.begin(), waiting.begin() + count);
+    };
+    const uint32_t period = 1000000UL / updateHz;
+    for (uint32_t t = 0; t < SIM_SECONDS * 1000000UL; t += SIM_TICK_US) {
+        for (uint8_t s = 0; s < SIM_SOURCES; s++) {
+            uint32_t phase = (s * period) / SIM_SOURCES;
+            if ((t + period - phase) % period >= SIM_TICK_US) continue;
+            if (!packed) {
+                r.transfers++;
+                r.events++;
+                continue;
+            }
+            waiting.push_back(t);
+            uint32_t oldest = waiting.front();
+            size_t before = waiting.size();
+            packer.add(message(0xB0, s, (t / period) & 127, 3, t), t, sink);
+            if (waiting.size() < before && t - oldest > r.maxLatency) r.maxLatency = t - oldest;
+        }
+        if (packed && !waiting.empty()) {
+            uint32_t oldest = waiting.front();
+            packer.service(t, sink);
+            if (waiting.empty() && t - oldest > r.maxLatency) r.maxLatency = t - oldest;
+        }
+    }
+    packer.flush(sink);
+    return r;
+}
+
+void test_packing_fills_transfers() {
+    SimResult old = simulate(false, SIM_UPDATE_HZ);
+    SimResult packed = simulate(true, SIM_UPDATE_HZ);
+    printf("%d sources x %d Hz over USB for %d s\n", SIM_SOURCES, SIM_UPDATE_HZ, SIM_SECONDS);
+    printf("  transfer per message: %lu transfers/s, %.1f events each\n",
+           (unsigned long)(old.transfers / SIM_SECONDS), (double)old.events / old.transfers);
+    printf("  packed:               %lu transfers/s, %.1f events each, worst wait %.1f ms\n",
+           (unsigned long)(packed.transfers / SIM_SECONDS), (double)packed.events / packed.transfers,
+           packed.maxLatency / 1000.0);
+    TEST_ASSERT_EQUAL_UINT32(old.events, packed.events);
+    TEST_ASSERT_TRUE(packed.transfers * 10 <= old.transfers);            // 10x fewer transfers (and interrupts)
+    TEST_ASSERT_TRUE(packed.maxLatency <= USB_MIDI_MAX_LATENCY_US + SIM_TICK_US);
+
+    // A lone knob still gets out within the cap
+    SimResult sparse = simulate(true, 2);
+    printf("  packed, 48 x 2 Hz:    %.1f events each, worst wait %.1f ms\n",
+           (double)sparse.events / sparse.transfers, sparse.maxLatency / 1000.0);
+    TEST_ASSERT_TRUE(sparse.maxLatency <= USB_MIDI_MAX_LATENCY_US + SIM_TICK_US);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_events_match_the_usb_midi_format);
+    RUN_TEST(test_full_packets_go_at_once_partial_ones_wait);
+    RUN_TEST(test_notes_and_flush_do_not_wait);
+    RUN_TEST(test_packing_fills_transfers);
+    return UNITY_END();
+}
@@ -9,6 +9,7 @@
 #include "DisplayManager.h"
 #include "ButtonManager.h"
 #include "PotentiometerManager.h"
+#include "MuxBus.h"
 #include "EnvelopeFollower.h"
 
 #define SERIAL_BAUD 115200
@@ -24,19 +25,15 @@ ConfigManager configManager(NUM_POTS, NUM_BUTTONS);
 LEDManager    ledManager(LED_PIN, NUM_LEDS);
 DisplayManager displayManager(SSD1306_I2C_ADDRESS, OLED_WIDTH, OLED_HEIGHT);
 
-// Mux-1 (U3) for pots + control buttons:
-PotentiometerManager potentiometerManager(
-  primaryMuxPins,
-  secondaryMuxPins,
-  potMuxAnalogPin
-);
+// Mux-1 (U3) for pots + control buttons, Mux-0 (U2) for your “virtual slot” buttons.
+// Both hang off the same select lines:
+MuxBus muxBus(primaryMuxPins, secondaryMuxPins, potMuxAnalogPin, buttonMuxAnalogPin);
+
+PotentiometerManager potentiometerManager(&muxBus, &configManager);
 
-// Mux-0 (U2) for your “virtual slot” buttons:
 const uint8_t controlPins[NUM_CONTROL_BUTTONS] = {2,3,4,5,6,13};
 ButtonManager buttonManager(
-  primaryMuxPins,
-  secondaryMuxPins,
-  buttonMuxAnalogPin,
+  &muxBus,
   controlPins,
   &potentiometerManager
 );